@@ -0,0 +1,424 @@
+#ifndef CYBER_BASE_ATOMIC_RW_LOCK_H_
+#define CYBER_BASE_ATOMIC_RW_LOCK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "common/contention_profiler.h"
+
+template <typename RWLock>
+class ReadLockGuard {
+ public:
+  explicit ReadLockGuard(RWLock& lock) : rw_lock_(lock) { rw_lock_.ReadLock(); }
+
+  ~ReadLockGuard() { rw_lock_.ReadUnlock(); }
+
+ private:
+  ReadLockGuard(const ReadLockGuard& other) = delete;
+  ReadLockGuard& operator=(const ReadLockGuard& other) = delete;
+  RWLock& rw_lock_;
+};
+
+template <typename RWLock>
+class WriteLockGuard {
+ public:
+  explicit WriteLockGuard(RWLock& lock) : rw_lock_(lock) {
+    rw_lock_.WriteLock();
+  }
+
+  ~WriteLockGuard() { rw_lock_.WriteUnlock(); }
+
+ private:
+  WriteLockGuard(const WriteLockGuard& other) = delete;
+  WriteLockGuard& operator=(const WriteLockGuard& other) = delete;
+  RWLock& rw_lock_;
+};
+
+//可升级的读锁：和普通读锁共存，同一时间只有一个持有者，也排斥写者。
+//Upgrade()等其他读者离开后把它原子地升级为写锁，期间没有写者能插进来，
+//所以升级前读到的数据升级后仍然有效，不用像先解读锁再加写锁那样重新检查。
+template <typename RWLock>
+class UpgradeLockGuard {
+ public:
+  explicit UpgradeLockGuard(RWLock& lock) : rw_lock_(lock) {
+    rw_lock_.UpgradeLock();
+  }
+
+  ~UpgradeLockGuard() { rw_lock_.UpgradeUnlock(upgraded_); }
+
+  //升级为写锁，重复调用没有作用
+  void Upgrade() {
+    if (!upgraded_) {
+      rw_lock_.Upgrade();
+      upgraded_ = true;
+    }
+  }
+  bool upgraded() const { return upgraded_; }
+
+ private:
+  UpgradeLockGuard(const UpgradeLockGuard& other) = delete;
+  UpgradeLockGuard& operator=(const UpgradeLockGuard& other) = delete;
+  RWLock& rw_lock_;
+  bool upgraded_ = false;
+};
+
+//READ_FIRST：有读者时写者一直等待；WRITE_FIRST：有写者在等待时新的读者也要等待；
+//PHASE_FAIR：读阶段和写阶段交替，读者最多等一个写者，写者最多等一个读阶段加上排在前面的写者
+enum class RWLockPolicy { READ_FIRST, WRITE_FIRST, PHASE_FAIR };
+
+class AtomicRWLock {
+  friend class ReadLockGuard<AtomicRWLock>;
+  friend class WriteLockGuard<AtomicRWLock>;
+  friend class UpgradeLockGuard<AtomicRWLock>;
+
+ public:
+  static const int32_t RW_LOCK_FREE = 0;
+  static const int32_t WRITE_EXCLUSIVE = -1;
+  static const uint32_t MAX_RETRY_TIMES = 5;
+  AtomicRWLock() {}
+  explicit AtomicRWLock(bool write_first) : write_first_(write_first) {}
+  explicit AtomicRWLock(RWLockPolicy policy)
+      : write_first_(policy == RWLockPolicy::WRITE_FIRST),
+        phase_fair_(policy == RWLockPolicy::PHASE_FAIR) {}
+  //以CYBER_CONTENTION_PROFILE编译时，ContentionProfiler的报告中用这个名字标识这把锁
+  void SetName(const std::string& name) {
+    CYBER_CONTENTION(contention_.SetName(name));
+    (void)name;
+  }
+
+ private:
+  // all these function only can used by ReadLockGuard/WriteLockGuard;
+  void ReadLock();
+  void WriteLock();
+
+  void ReadUnlock();
+  void WriteUnlock();
+
+  // only used by UpgradeLockGuard
+  void UpgradeLock();
+  void Upgrade();
+  void UpgradeUnlock(bool upgraded);
+
+  //相位公平模式（Brandenburg、Anderson的PF-T）：rin_的高位是进入的读者数，
+  //低两位是写者标志：PF_PRESENT表示有写者，PF_PHASE_ID区分相邻两个写者，
+  //读者只要看到写者标志变化就可以进入，不会被紧接着的下一个写者挡住
+  static const uint32_t PF_READER_INC = 0x100;
+  static const uint32_t PF_WRITER_BITS = 0x3;
+  static const uint32_t PF_PRESENT = 0x2;
+  static const uint32_t PF_PHASE_ID = 0x1;
+
+  //等待过程中的计数，只在以CYBER_CONTENTION_PROFILE编译时更新
+  struct WaitCounters {
+    uint64_t wait_begin = 0;
+    uint64_t spins = 0;
+    uint64_t yields = 0;
+  };
+  //自旋直到pred()为true，每MAX_RETRY_TIMES次让出一次CPU
+  template <typename Pred>
+  static void SpinUntil(Pred pred, WaitCounters* counters);
+
+  void PhaseFairReadLock();
+  void PhaseFairWriteLock();
+  //轮到的写者设置写者标志，等待已经进入的读者离开（不算自己持有的readers个读锁）
+  void PhaseFairWaitReaders(uint32_t readers, WaitCounters* counters);
+
+  AtomicRWLock(const AtomicRWLock&) = delete;
+  AtomicRWLock& operator=(const AtomicRWLock&) = delete;
+  std::atomic<uint32_t> write_lock_wait_num_ = {0};
+  std::atomic<int32_t> lock_num_ = {0};
+  bool write_first_ = true;
+  bool phase_fair_ = false;
+  //非相位公平模式下保证只有一个可升级读锁的持有者
+  std::atomic<bool> upgrade_owned_ = {false};
+  //相位公平模式的状态：读者进入/离开的计数，写者的排队ticket和当前轮到的ticket
+  std::atomic<uint32_t> rin_ = {0};
+  std::atomic<uint32_t> rout_ = {0};
+  std::atomic<uint32_t> win_ = {0};
+  std::atomic<uint32_t> wout_ = {0};
+  //已经开始的写阶段数，相邻两个写阶段的PF_PHASE_ID不同。
+  //可升级读锁也占用写者ticket但不一定升级，所以不能用ticket的奇偶区分。只有轮到的写者访问
+  uint32_t write_phases_ = 0;
+
+#ifdef CYBER_CONTENTION_PROFILE
+  //读锁可以嵌套，每个线程按加锁顺序记下各层读锁的加锁时间，解锁时按相反的顺序取出
+  struct ReadHolds {
+    static constexpr int kMaxDepth = 8;
+    uint64_t begin[kMaxDepth];
+    int depth = 0;
+  };
+  static ReadHolds& ThreadReadHolds() {
+    static thread_local ReadHolds holds;
+    return holds;
+  }
+  static void PushReadHold(uint64_t now) {
+    ReadHolds& holds = ThreadReadHolds();
+    if (holds.depth < ReadHolds::kMaxDepth) {
+      holds.begin[holds.depth] = now;
+    }
+    ++holds.depth;
+  }
+  void PopReadHold() {
+    ReadHolds& holds = ThreadReadHolds();
+    if (--holds.depth < ReadHolds::kMaxDepth) {
+      contention_.RecordHold(TscClock::Now() - holds.begin[holds.depth]);
+    }
+  }
+  //第一次遇到竞争时才开始计时，没有竞争的加锁省掉一次读tsc
+  static void BeginWait(uint64_t* wait_begin) {
+    if (*wait_begin == 0) {
+      *wait_begin = TscClock::Now();
+    }
+  }
+  //拿到锁之后一次性记录等待过程中的计数，返回拿到锁的时间
+  uint64_t RecordAcquire(uint64_t wait_begin, uint64_t spins, uint64_t yields,
+                         uint64_t cas_failures) {
+    uint64_t now = TscClock::Now();
+    if (spins != 0) {
+      contention_.Spin(spins);
+    }
+    if (yields != 0) {
+      contention_.Yield(yields);
+    }
+    if (cas_failures != 0) {
+      contention_.CasFailure(cas_failures);
+    }
+    contention_.RecordWait(wait_begin == 0 ? 0 : now - wait_begin);
+    return now;
+  }
+
+  ContentionSite contention_{"AtomicRWLock"};
+  //只有持有写锁的线程访问
+  uint64_t write_begin_ = 0;
+#endif
+};
+
+template <typename Pred>
+inline void AtomicRWLock::SpinUntil(Pred pred, WaitCounters* counters) {
+  uint32_t retry_times = 0;
+  while (!pred()) {
+    CYBER_CONTENTION(++counters->spins; BeginWait(&counters->wait_begin));
+    if (++retry_times == MAX_RETRY_TIMES) {
+      // saving cpu
+      CYBER_CONTENTION(++counters->yields);
+      std::this_thread::yield();
+      retry_times = 0;
+    }
+  }
+  (void)counters;
+}
+
+inline void AtomicRWLock::ReadLock() {
+  if (phase_fair_) {
+    PhaseFairReadLock();
+    return;
+  }
+  CYBER_CONTENTION(uint64_t wait_begin = 0);
+  CYBER_CONTENTION(uint64_t spins = 0);
+  CYBER_CONTENTION(uint64_t yields = 0);
+  CYBER_CONTENTION(uint64_t attempts = 0);
+  uint32_t retry_times = 0;
+  int32_t lock_num = lock_num_.load();
+  if (write_first_) {
+    do {
+      CYBER_CONTENTION(if (++attempts > 1) BeginWait(&wait_begin));
+      while (lock_num < RW_LOCK_FREE || write_lock_wait_num_.load() > 0) {
+        CYBER_CONTENTION(++spins; BeginWait(&wait_begin));
+        if (++retry_times == MAX_RETRY_TIMES) {
+          // saving cpu
+          CYBER_CONTENTION(++yields);
+          std::this_thread::yield();
+          retry_times = 0;
+        }
+        lock_num = lock_num_.load();
+      }
+    } while (!lock_num_.compare_exchange_weak(lock_num, lock_num + 1,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_relaxed));
+  } else {
+    do {
+      CYBER_CONTENTION(if (++attempts > 1) BeginWait(&wait_begin));
+      while (lock_num < RW_LOCK_FREE) {
+        CYBER_CONTENTION(++spins; BeginWait(&wait_begin));
+        if (++retry_times == MAX_RETRY_TIMES) {
+          // saving cpu
+          CYBER_CONTENTION(++yields);
+          std::this_thread::yield();
+          retry_times = 0;
+        }
+        lock_num = lock_num_.load();
+      }
+    } while (!lock_num_.compare_exchange_weak(lock_num, lock_num + 1,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_relaxed));
+  }
+  CYBER_CONTENTION(
+      PushReadHold(RecordAcquire(wait_begin, spins, yields, attempts - 1)));
+}
+
+inline void AtomicRWLock::WriteLock() {
+  if (phase_fair_) {
+    PhaseFairWriteLock();
+    return;
+  }
+  CYBER_CONTENTION(uint64_t wait_begin = 0);
+  CYBER_CONTENTION(uint64_t yields = 0);
+  CYBER_CONTENTION(uint64_t cas_failures = 0);
+  int32_t rw_lock_free = RW_LOCK_FREE;
+  uint32_t retry_times = 0;
+  write_lock_wait_num_.fetch_add(1);
+  while (!lock_num_.compare_exchange_weak(rw_lock_free, WRITE_EXCLUSIVE,
+                                          std::memory_order_acq_rel,
+                                          std::memory_order_relaxed)) {
+    CYBER_CONTENTION(++cas_failures; BeginWait(&wait_begin));
+    // rw_lock_free will change after CAS fail, so init agin
+    rw_lock_free = RW_LOCK_FREE;
+    if (++retry_times == MAX_RETRY_TIMES) {
+      // saving cpu
+      CYBER_CONTENTION(++yields);
+      std::this_thread::yield();
+      retry_times = 0;
+    }
+  }
+  write_lock_wait_num_.fetch_sub(1);
+  //写锁的等待就是CAS失败后的重试，都记为CAS失败
+  CYBER_CONTENTION(write_begin_ =
+                       RecordAcquire(wait_begin, 0, yields, cas_failures));
+}
+
+inline void AtomicRWLock::ReadUnlock() {
+  CYBER_CONTENTION(PopReadHold());
+  if (phase_fair_) {
+    rout_.fetch_add(PF_READER_INC, std::memory_order_release);
+    return;
+  }
+  lock_num_.fetch_sub(1);
+}
+
+inline void AtomicRWLock::WriteUnlock() {
+  CYBER_CONTENTION(contention_.RecordHold(TscClock::Now() - write_begin_));
+  if (phase_fair_) {
+    //清除写者标志，等在这个写阶段的读者一起进入，然后轮到下一个写者
+    rin_.fetch_and(~PF_WRITER_BITS);
+    wout_.fetch_add(1);
+    return;
+  }
+  lock_num_.fetch_add(1);
+}
+
+inline void AtomicRWLock::PhaseFairReadLock() {
+  WaitCounters counters;
+  uint32_t writer = rin_.fetch_add(PF_READER_INC) & PF_WRITER_BITS;
+  //有写者时只等当前这个写者结束：写者标志一变化（清除或者换成下一个写者的相位）就可以进入
+  if (writer != 0) {
+    SpinUntil(
+        [this, writer]() {
+          return (rin_.load(std::memory_order_acquire) & PF_WRITER_BITS) !=
+                 writer;
+        },
+        &counters);
+  }
+  CYBER_CONTENTION(PushReadHold(
+      RecordAcquire(counters.wait_begin, counters.spins, counters.yields, 0)));
+}
+
+inline void AtomicRWLock::PhaseFairWriteLock() {
+  WaitCounters counters;
+  //写者之间按ticket排队
+  uint32_t ticket = win_.fetch_add(1);
+  SpinUntil(
+      [this, ticket]() {
+        return wout_.load(std::memory_order_acquire) == ticket;
+      },
+      &counters);
+  PhaseFairWaitReaders(0, &counters);
+  CYBER_CONTENTION(write_begin_ = RecordAcquire(counters.wait_begin,
+                                                counters.spins,
+                                                counters.yields, 0));
+}
+
+inline void AtomicRWLock::PhaseFairWaitReaders(uint32_t readers,
+                                               WaitCounters* counters) {
+  //设置写者标志之后新来的读者都要等待，只需等标志设置之前进入的读者离开
+  uint32_t phase = PF_PRESENT | (write_phases_++ & PF_PHASE_ID);
+  uint32_t entered = rin_.fetch_add(phase) - readers * PF_READER_INC;
+  SpinUntil(
+      [this, entered]() {
+        return rout_.load(std::memory_order_acquire) == entered;
+      },
+      counters);
+}
+
+inline void AtomicRWLock::UpgradeLock() {
+  WaitCounters counters;
+  if (phase_fair_) {
+    //占用一个写者ticket，排斥其他写者和可升级读锁，但不设置写者标志，读者可以继续进入
+    uint32_t ticket = win_.fetch_add(1);
+    SpinUntil(
+        [this, ticket]() {
+          return wout_.load(std::memory_order_acquire) == ticket;
+        },
+        &counters);
+    //轮到自己时没有写者，不用等待写者标志
+    rin_.fetch_add(PF_READER_INC);
+    CYBER_CONTENTION(PushReadHold(RecordAcquire(
+        counters.wait_begin, counters.spins, counters.yields, 0)));
+    return;
+  }
+  SpinUntil(
+      [this]() {
+        return !upgrade_owned_.load(std::memory_order_relaxed) &&
+               !upgrade_owned_.exchange(true, std::memory_order_acquire);
+      },
+      &counters);
+  //持有读锁期间lock_num_至少为1，写者拿不到锁
+  ReadLock();
+}
+
+inline void AtomicRWLock::Upgrade() {
+  CYBER_CONTENTION(PopReadHold());
+  WaitCounters counters;
+  if (phase_fair_) {
+    PhaseFairWaitReaders(1, &counters);
+  } else {
+    //和写者一样先登记等待，WRITE_FIRST时新的读者不再进入
+    write_lock_wait_num_.fetch_add(1);
+    SpinUntil(
+        [this]() {
+          int32_t only_me = 1;
+          return lock_num_.compare_exchange_weak(only_me, WRITE_EXCLUSIVE,
+                                                 std::memory_order_acq_rel,
+                                                 std::memory_order_relaxed);
+        },
+        &counters);
+    write_lock_wait_num_.fetch_sub(1);
+  }
+  CYBER_CONTENTION(write_begin_ = RecordAcquire(counters.wait_begin,
+                                                counters.spins,
+                                                counters.yields, 0));
+}
+
+inline void AtomicRWLock::UpgradeUnlock(bool upgraded) {
+  if (phase_fair_) {
+    if (upgraded) {
+      CYBER_CONTENTION(contention_.RecordHold(TscClock::Now() - write_begin_));
+      //先归还自己的读锁计数，再清除写者标志，最后轮到下一个写者
+      rout_.fetch_add(PF_READER_INC);
+      rin_.fetch_and(~PF_WRITER_BITS);
+    } else {
+      CYBER_CONTENTION(PopReadHold());
+      rout_.fetch_add(PF_READER_INC);
+    }
+    wout_.fetch_add(1);
+    return;
+  }
+  if (upgraded) {
+    WriteUnlock();
+  } else {
+    ReadUnlock();
+  }
+  upgrade_owned_.store(false, std::memory_order_release);
+}
+
+#endif  // CYBER_BASE_ATOMIC_RW_LOCK_H_
@@ -0,0 +1,202 @@
+//AtomicRWLock三种策略在混合负载下的吞吐量和每类线程的加锁等待时间（p99和最大值）：
+//- read_heavy：4个读者、1个写者；
+//- write_heavy：2个读者、3个写者；
+//- check_write/<方式>：4个读者、2个写者，另有2个"检查后写"的线程，计数为偶数时才加1：
+//  drop是先在读锁下检查，解读锁加写锁后再检查一次，第二次检查失败记为一次重试；
+//  upgrade是在可升级读锁下检查，需要写时直接升级。
+//临界区里读写几个缓存行，每次加锁后在锁外做一小段计算。
+//用法：atomic_rw_lock_benchmark [duration_ms]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "atomic_rw_lock.h"
+#include "common/tsc_clock.h"
+
+namespace {
+
+enum class Role { kReader, kWriter, kChecker };
+enum class CheckMode { kDrop, kUpgrade };
+
+constexpr int kRoles = 3;
+const char* const kRoleNames[kRoles] = {"read", "write", "check"};
+constexpr int kWords = 32;
+
+struct Workload {
+  std::string name;
+  int readers;
+  int writers;
+  int checkers;
+  CheckMode mode;
+};
+
+struct Shared {
+  uint64_t words[kWords] = {0};
+  uint64_t counter = 0;
+};
+
+struct ThreadStats {
+  std::vector<uint64_t> waits;
+  uint64_t ops = 0;
+  uint64_t retries = 0;
+};
+
+void Work(int loops) {
+  volatile uint64_t x = 0;
+  for (int i = 0; i < loops; ++i) {
+    x = x + i;
+  }
+}
+
+//检查后写：计数为偶数时加1，返回加锁等待的时间
+uint64_t CheckThenWrite(AtomicRWLock& lock, Shared& shared, CheckMode mode,
+                        uint64_t* retries) {
+  uint64_t begin = TscClock::Now();
+  uint64_t wait = 0;
+  if (mode == CheckMode::kUpgrade) {
+    UpgradeLockGuard<AtomicRWLock> guard(lock);
+    wait = TscClock::Now() - begin;
+    if (shared.counter % 2 == 0) {
+      uint64_t upgrade_begin = TscClock::Now();
+      guard.Upgrade();
+      wait += TscClock::Now() - upgrade_begin;
+      shared.counter++;
+      shared.words[0]++;
+    }
+    return wait;
+  }
+  bool need_write = false;
+  {
+    ReadLockGuard<AtomicRWLock> guard(lock);
+    wait = TscClock::Now() - begin;
+    need_write = shared.counter % 2 == 0;
+  }
+  if (need_write) {
+    uint64_t write_begin = TscClock::Now();
+    WriteLockGuard<AtomicRWLock> guard(lock);
+    wait += TscClock::Now() - write_begin;
+    //解读锁之后可能有写者改过计数，需要重新检查
+    if (shared.counter % 2 == 0) {
+      shared.counter++;
+      shared.words[0]++;
+    } else {
+      ++*retries;
+    }
+  }
+  return wait;
+}
+
+void Run(const char* policy_name, RWLockPolicy policy, const Workload& workload,
+         int duration_ms) {
+  AtomicRWLock lock(policy);
+  Shared shared;
+  std::atomic<bool> stop = {false};
+  std::vector<Role> roles;
+  roles.insert(roles.end(), workload.readers, Role::kReader);
+  roles.insert(roles.end(), workload.writers, Role::kWriter);
+  roles.insert(roles.end(), workload.checkers, Role::kChecker);
+  std::vector<ThreadStats> stats(roles.size());
+  std::vector<std::thread> threads;
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < roles.size(); ++i) {
+    threads.emplace_back([&, i]() {
+      ThreadStats& st = stats[i];
+      st.waits.reserve(1 << 20);
+      uint64_t sink = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        uint64_t wait = 0;
+        if (roles[i] == Role::kReader) {
+          uint64_t start = TscClock::Now();
+          ReadLockGuard<AtomicRWLock> guard(lock);
+          wait = TscClock::Now() - start;
+          for (int w = 0; w < kWords; ++w) {
+            sink += shared.words[w];
+          }
+        } else if (roles[i] == Role::kWriter) {
+          uint64_t start = TscClock::Now();
+          WriteLockGuard<AtomicRWLock> guard(lock);
+          wait = TscClock::Now() - start;
+          for (int w = 0; w < kWords; ++w) {
+            shared.words[w]++;
+          }
+          shared.counter++;
+        } else {
+          wait = CheckThenWrite(lock, shared, workload.mode, &st.retries);
+        }
+        st.waits.push_back(wait);
+        ++st.ops;
+        Work(200);
+      }
+      volatile uint64_t keep = sink;
+      (void)keep;
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+  stop = true;
+  for (auto& t : threads) {
+    t.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - begin)
+                       .count();
+
+  std::vector<uint64_t> waits[kRoles];
+  uint64_t ops[kRoles] = {0};
+  uint64_t retries = 0;
+  for (size_t i = 0; i < roles.size(); ++i) {
+    int role = static_cast<int>(roles[i]);
+    waits[role].insert(waits[role].end(), stats[i].waits.begin(),
+                       stats[i].waits.end());
+    ops[role] += stats[i].ops;
+    retries += stats[i].retries;
+  }
+  double ns_per_tick = TscClock::NsPerTick();
+  printf("%-18s %-12s", workload.name.c_str(), policy_name);
+  for (int role = 0; role < kRoles; ++role) {
+    auto& w = waits[role];
+    if (w.empty()) {
+      printf(" %8s %9s %9s", "-", "-", "-");
+      continue;
+    }
+    std::sort(w.begin(), w.end());
+    double p99 = w[w.size() * 99 / 100] * ns_per_tick / 1000;
+    double max = w.back() * ns_per_tick / 1000;
+    printf(" %8.0f %9.1f %9.1f", ops[role] / seconds / 1000, p99, max);
+  }
+  if (workload.checkers > 0 && workload.mode == CheckMode::kDrop) {
+    printf("  retries %lu", static_cast<unsigned long>(retries));
+  }
+  printf("\n");
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int duration_ms = argc > 1 ? std::atoi(argv[1]) : 1000;
+  std::vector<Workload> workloads = {
+      {"read_heavy", 4, 1, 0, CheckMode::kDrop},
+      {"write_heavy", 2, 3, 0, CheckMode::kDrop},
+      {"check_write/drop", 4, 2, 2, CheckMode::kDrop},
+      {"check_write/upgrade", 4, 2, 2, CheckMode::kUpgrade},
+  };
+  printf("%-18s %-12s", "workload", "policy");
+  for (int role = 0; role < kRoles; ++role) {
+    std::string name = kRoleNames[role];
+    printf(" %8s %9s %9s", (name + " k/s").c_str(), (name + " p99").c_str(),
+           (name + " max").c_str());
+  }
+  printf("  (us)");
+  printf("\n");
+  for (const auto& workload : workloads) {
+    Run("read_first", RWLockPolicy::READ_FIRST, workload, duration_ms);
+    Run("write_first", RWLockPolicy::WRITE_FIRST, workload, duration_ms);
+    Run("phase_fair", RWLockPolicy::PHASE_FAIR, workload, duration_ms);
+  }
+  return 0;
+}
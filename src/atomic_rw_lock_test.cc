@@ -0,0 +1,169 @@
+#include "atomic_rw_lock.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test_util.h"
+
+namespace {
+
+const RWLockPolicy kPolicies[] = {RWLockPolicy::READ_FIRST,
+                                  RWLockPolicy::WRITE_FIRST,
+                                  RWLockPolicy::PHASE_FAIR};
+
+}  // namespace
+
+//读者、写者、可升级读锁的持有者混在一起：写者和升级后的持有者各自把计数加1，
+//升级前读到的值在升级后直接加1写回，中间如果有写者插进来就会丢失更新
+TEST(AtomicRWLock, MixedUpgradeKeepsReadValid) {
+  constexpr int kLoops = 20000;
+  for (RWLockPolicy policy : kPolicies) {
+    AtomicRWLock lock(policy);
+    uint64_t a = 0;
+    uint64_t b = 0;
+    std::atomic<int> torn = {0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; ++t) {
+      threads.emplace_back([&]() {
+        for (int i = 0; i < kLoops; ++i) {
+          ReadLockGuard<AtomicRWLock> guard(lock);
+          if (a != b) {
+            torn++;
+          }
+        }
+      });
+      threads.emplace_back([&]() {
+        for (int i = 0; i < kLoops; ++i) {
+          WriteLockGuard<AtomicRWLock> guard(lock);
+          a++;
+          b++;
+        }
+      });
+      threads.emplace_back([&]() {
+        for (int i = 0; i < kLoops; ++i) {
+          UpgradeLockGuard<AtomicRWLock> guard(lock);
+          uint64_t value = a;
+          if (a != b) {
+            torn++;
+          }
+          //一半的持有者只读不升级
+          if (i % 2 == 0) {
+            guard.Upgrade();
+            a = value + 1;
+            b = value + 1;
+          }
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    EXPECT_EQ(torn, 0) << static_cast<int>(policy);
+    EXPECT_EQ(a, 2u * kLoops + kLoops) << static_cast<int>(policy);
+    EXPECT_EQ(b, a);
+  }
+}
+
+//可升级读锁和读锁共存，排斥写者和其他可升级读锁
+TEST(AtomicRWLock, UpgradeCoexistsWithReaders) {
+  for (RWLockPolicy policy : kPolicies) {
+    AtomicRWLock lock(policy);
+    std::atomic<bool> read_done = {false};
+    std::atomic<bool> writer_in = {false};
+    std::atomic<bool> upgrader_in = {false};
+    std::thread writer;
+    std::thread upgrader;
+    {
+      UpgradeLockGuard<AtomicRWLock> guard(lock);
+      std::thread reader([&]() {
+        ReadLockGuard<AtomicRWLock> read(lock);
+        read_done = true;
+      });
+      reader.join();
+      EXPECT_TRUE(read_done);
+      writer = std::thread([&]() {
+        WriteLockGuard<AtomicRWLock> write(lock);
+        writer_in = true;
+      });
+      upgrader = std::thread([&]() {
+        UpgradeLockGuard<AtomicRWLock> other(lock);
+        upgrader_in = true;
+      });
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      EXPECT_FALSE(writer_in);
+      EXPECT_FALSE(upgrader_in);
+      guard.Upgrade();
+      EXPECT_TRUE(guard.upgraded());
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      EXPECT_FALSE(writer_in);
+      EXPECT_FALSE(upgrader_in);
+    }
+    writer.join();
+    upgrader.join();
+    EXPECT_TRUE(writer_in);
+    EXPECT_TRUE(upgrader_in);
+  }
+}
+
+//相位公平：读者排在一个写者后面等待时，只等这一个写者，
+//不会被之后才来的写者再挡一次
+TEST(AtomicRWLock, PhaseFairReaderWaitsOneWriter) {
+  AtomicRWLock lock(RWLockPolicy::PHASE_FAIR);
+  std::mutex order_mutex;
+  std::string order;
+  auto record = [&](char c) {
+    std::lock_guard<std::mutex> lk(order_mutex);
+    order.push_back(c);
+  };
+  std::thread reader;
+  std::thread writer;
+  {
+    WriteLockGuard<AtomicRWLock> guard(lock);
+    reader = std::thread([&]() {
+      ReadLockGuard<AtomicRWLock> read(lock);
+      record('R');
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    writer = std::thread([&]() {
+      WriteLockGuard<AtomicRWLock> write(lock);
+      record('W');
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  reader.join();
+  writer.join();
+  EXPECT_EQ(order, "RW");
+}
+
+//写者不会被源源不断的读者饿死
+TEST(AtomicRWLock, PhaseFairWriterNotStarved) {
+  AtomicRWLock lock(RWLockPolicy::PHASE_FAIR);
+  std::atomic<bool> stop = {false};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 3; ++i) {
+    readers.emplace_back([&]() {
+      while (!stop) {
+        ReadLockGuard<AtomicRWLock> read(lock);
+        std::this_thread::yield();
+      }
+    });
+  }
+  std::atomic<int> writes = {0};
+  std::thread writer([&]() {
+    for (int i = 0; i < 100; ++i) {
+      WriteLockGuard<AtomicRWLock> write(lock);
+      writes++;
+    }
+  });
+  EXPECT_TRUE(WaitFor([&]() { return writes == 100; }));
+  stop = true;
+  writer.join();
+  for (auto& t : readers) {
+    t.join();
+  }
+}
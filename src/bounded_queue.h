@@ -1,3 +1,6 @@
+#ifndef CYBER_BASE_BOUNDED_QUEUE_H_
+#define CYBER_BASE_BOUNDED_QUEUE_H_
+
 #include <algorithm>
 #include <atomic>
 #include <cstdint>
@@ -6,12 +9,11 @@
 #include <utility>
 #include <iostream>
 
+#include "common/contention_profiler.h"
+#include "common/macros.h"
+#include "common/trace_recorder.h"
 #include "wait_strategy.h"
 
-#define CACHELINE_SIZE  64
-#define cyber_likely(x) (__builtin_expect((x), 1))
-#define cyber_unlikely(x) (__builtin_expect((x), 0))
-
 template <typename T>
 class BoundedQueue {
  public:
@@ -39,6 +41,11 @@ class BoundedQueue {
   uint64_t Head() { return head_.load(); }
   uint64_t Tail() { return tail_.load(); }
   uint64_t Commit() { return commit_.load(); }
+  //以CYBER_CONTENTION_PROFILE编译时，ContentionProfiler的报告中用这个名字标识本队列
+  void SetName(const std::string& name) {
+    CYBER_CONTENTION(contention_.SetName(name));
+    (void)name;
+  }
 
  private:
   uint64_t GetIndex(uint64_t num);
@@ -55,6 +62,7 @@ class BoundedQueue {
   T* pool_ = nullptr;
   std::unique_ptr<WaitStrategy> wait_strategy_ = nullptr;
   volatile bool break_all_wait_ = false;
+  CYBER_CONTENTION(ContentionSite contention_{"BoundedQueue"};)
 };
 
 //析构函数
@@ -107,15 +115,19 @@ bool BoundedQueue<T>::Enqueue(const T& element) {
   uint64_t old_commit = 0;
   uint64_t old_tail = tail_.load(std::memory_order_acquire);
   //do while循环先执行do，然后再判断while里面的条件，起码要执行一次
+  CYBER_CONTENTION(uint64_t attempts = 0);
   do {
+    CYBER_CONTENTION(++attempts);
     new_tail = old_tail + 1;
     //如果队列已满，不能进行入队操作，直接返回false
     if (GetIndex(new_tail) == GetIndex(head_.load(std::memory_order_acquire))) {
+      CYBER_CONTENTION(if (attempts > 1) contention_.CasFailure(attempts - 1));
       return false;
     }
   } while (!tail_.compare_exchange_weak(old_tail, new_tail,
                                         std::memory_order_acq_rel,
                                         std::memory_order_relaxed));
+  CYBER_CONTENTION(if (attempts > 1) contention_.CasFailure(attempts - 1));
     //tail_为原子变量，将当前的tail_的值和old_tail进行比较，如果相等，则tail_更新为new_tail
     //返回true,!操作返回fasle，使得跳出循环，开始下面的入队操作
     //否则，如果tail_的值和old_tail不相等（将old_tail更新为当前的tail_值），
@@ -124,11 +136,17 @@ bool BoundedQueue<T>::Enqueue(const T& element) {
   //在old_tail的位置入队，old_tail可能在上面的循环了进行了多次的累加
   //和程序入口的old_tail可能已经不同了
   pool_[GetIndex(old_tail)] = element;
+  CYBER_CONTENTION(uint64_t spins = 0);
   do {
+    CYBER_CONTENTION(++spins);
     old_commit = old_tail;
   } while (cyber_unlikely(!commit_.compare_exchange_weak(
       old_commit, new_tail, std::memory_order_acq_rel,
       std::memory_order_relaxed)));
+  //前面的生产者还没提交时在这里空转
+  CYBER_CONTENTION(if (spins > 1) contention_.Spin(spins - 1));
+  CYBER_TRACE(QUEUE_ENQUEUE, reinterpret_cast<uint64_t>(this),
+              static_cast<uint32_t>(old_tail));
   //commit_为原子变量，将commit_和old_commit进行比较，
   //如果相等，则commit_更新为new_tail，返回true，!操作返回false，跳出循环实现了入队
   //如果不相等，则old_commit更新为当前的commit_值（不过do里边又会覆盖为old_tail的值）
@@ -145,20 +163,30 @@ bool BoundedQueue<T>::Enqueue(T&& element) {
   uint64_t new_tail = 0;
   uint64_t old_commit = 0;
   uint64_t old_tail = tail_.load(std::memory_order_acquire);
+  CYBER_CONTENTION(uint64_t attempts = 0);
   do {
+    CYBER_CONTENTION(++attempts);
     new_tail = old_tail + 1;
     if (GetIndex(new_tail) == GetIndex(head_.load(std::memory_order_acquire))) {
+      CYBER_CONTENTION(if (attempts > 1) contention_.CasFailure(attempts - 1));
       return false;
     }
   } while (!tail_.compare_exchange_weak(old_tail, new_tail,
                                         std::memory_order_acq_rel,
                                         std::memory_order_relaxed));
+  CYBER_CONTENTION(if (attempts > 1) contention_.CasFailure(attempts - 1));
   pool_[GetIndex(old_tail)] = std::move(element);
+  CYBER_CONTENTION(uint64_t spins = 0);
   do {
+    CYBER_CONTENTION(++spins);
     old_commit = old_tail;
   } while (cyber_unlikely(!commit_.compare_exchange_weak(
       old_commit, new_tail, std::memory_order_acq_rel,
       std::memory_order_relaxed)));
+  //前面的生产者还没提交时在这里空转
+  CYBER_CONTENTION(if (spins > 1) contention_.Spin(spins - 1));
+  CYBER_TRACE(QUEUE_ENQUEUE, reinterpret_cast<uint64_t>(this),
+              static_cast<uint32_t>(old_tail));
   wait_strategy_->NotifyOne();
   return true;
 }
@@ -167,20 +195,26 @@ template <typename T>
 bool BoundedQueue<T>::Dequeue(T* element) {
   uint64_t new_head = 0;
   uint64_t old_head = head_.load(std::memory_order_acquire);
+  CYBER_CONTENTION(uint64_t attempts = 0);
   do {
+    CYBER_CONTENTION(++attempts);
     new_head = old_head + 1;
     //队列已经空队列，返回false
     if (new_head == commit_.load(std::memory_order_acquire)) {
+      CYBER_CONTENTION(if (attempts > 1) contention_.CasFailure(attempts - 1));
       return false;
     }
     *element = pool_[GetIndex(new_head)];
   } while (!head_.compare_exchange_weak(old_head, new_head,
                                         std::memory_order_acq_rel,
                                         std::memory_order_relaxed));
+  CYBER_CONTENTION(if (attempts > 1) contention_.CasFailure(attempts - 1));
     //head_原子变量,和old_head比较，
     //如果相等，则更新为new_head并返回true，!操作取反返回false，退出循环
     //如果不等，则说明其他线程已经取走了当前的head元素，将old_head更新为head_值
     //并进入下一次do里面的操作
+  CYBER_TRACE(QUEUE_DEQUEUE, reinterpret_cast<uint64_t>(this),
+              static_cast<uint32_t>(new_head));
   return true;
 }
 
@@ -188,51 +222,73 @@ bool BoundedQueue<T>::Dequeue(T* element) {
 //知道队列不再满后再插入，或者等待超时返回。
 template <typename T>
 bool BoundedQueue<T>::WaitEnqueue(const T& element) {
+  CYBER_CONTENTION(uint64_t wait_begin = 0);
+  bool done = false;
   while (!break_all_wait_) {
     if (Enqueue(element)) {
-      return true;
+      done = true;
+      break;
     }
+    CYBER_CONTENTION(if (wait_begin == 0) wait_begin = TscClock::Now());
+    CYBER_CONTENTION(contention_.Yield());
     if (wait_strategy_->EmptyWait()) {
       continue;
     }
     // wait timeout
     break;
   }
-
-  return false;
+  //从第一次失败到成功（或者超时、被打断）的时间
+  CYBER_CONTENTION(if (wait_begin != 0)
+                       contention_.RecordFullWait(TscClock::Now() - wait_begin));
+  return done;
 }
 
 template <typename T>
 bool BoundedQueue<T>::WaitEnqueue(T&& element) {
+  CYBER_CONTENTION(uint64_t wait_begin = 0);
+  bool done = false;
   while (!break_all_wait_) {
     if (Enqueue(std::move(element))) {
-      return true;
+      done = true;
+      break;
     }
+    CYBER_CONTENTION(if (wait_begin == 0) wait_begin = TscClock::Now());
+    CYBER_CONTENTION(contention_.Yield());
     if (wait_strategy_->EmptyWait()) {
       continue;
     }
     // wait timeout
     break;
   }
-
-  return false;
+  //从第一次失败到成功（或者超时、被打断）的时间
+  CYBER_CONTENTION(if (wait_begin != 0)
+                       contention_.RecordFullWait(TscClock::Now() - wait_begin));
+  return done;
 }
 
 //这里实现了等待机制，如果队列未空，则立马取回队首元素返回，否则进入空等状态
 //知道队列不再空后再取回队首元素，或者等待超时返回。
 template <typename T>
 bool BoundedQueue<T>::WaitDequeue(T* element) {
+  CYBER_CONTENTION(uint64_t wait_begin = 0);
+  bool done = false;
   while (!break_all_wait_) {
     if (Dequeue(element)) {
-      return true;
+      done = true;
+      break;
     }
+    CYBER_CONTENTION(if (wait_begin == 0) wait_begin = TscClock::Now());
+    CYBER_CONTENTION(contention_.Yield());
     if (wait_strategy_->EmptyWait()) {
       continue;
     }
     // wait timeout
     break;
   }
-  return false;
+  //从第一次失败到成功（或者超时、被打断）的时间
+  CYBER_CONTENTION(if (wait_begin != 0)
+                       contention_.RecordEmptyWait(TscClock::Now() - wait_begin));
+  return done;
 }
 
 template <typename T>
@@ -259,4 +315,6 @@ template <typename T>
 inline void BoundedQueue<T>::BreakAllWait() {
   break_all_wait_ = true;
   wait_strategy_->BreakAllWait();
-}
\ No newline at end of file
+}
+
+#endif  // CYBER_BASE_BOUNDED_QUEUE_H_
@@ -0,0 +1,368 @@
+#ifndef CYBER_BASE_BROADCAST_RING_H_
+#define CYBER_BASE_BROADCAST_RING_H_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "common/macros.h"
+#include "common/trace_recorder.h"
+#include "wait_strategy.h"
+
+//单生产者、多消费者的广播环形缓冲区（Disruptor风格）。
+//每条消息只写一次，每个消费者有自己的读游标，都能读到全部消息；
+//生产者被最慢的消费者限速：最慢的消费者还没读的消息不会被覆盖。
+//有损（lossy）消费者不参与限速，落后超过一圈时直接跳到最旧的未覆盖消息，并记下丢了多少条，
+//只有Init时allow_lossy为true的环才能添加有损消费者。
+//消费者应当在生产者开始Publish之前添加，运行中添加的消费者从当前位置开始读。
+//RemoveConsumer之后消费者的槽位可以被之后的AddConsumer复用，同时存在的消费者不超过kMaxConsumers个。
+template <typename T>
+class BroadcastRing {
+ public:
+  using value_type = T;
+  using size_type = uint64_t;
+
+  static constexpr uint32_t kMaxConsumers = 32;
+
+  class Consumer {
+   public:
+    bool lossy() const { return lossy_.load(std::memory_order_relaxed); }
+    //有损消费者因为被覆盖而丢掉的消息数
+    uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+   private:
+    friend class BroadcastRing;
+    //下一条要读的消息序号，只有消费者自己写
+    alignas(CACHELINE_SIZE) std::atomic<uint64_t> cursor_ = {0};
+    std::atomic<uint64_t> dropped_ = {0};
+    //AddConsumer用CAS占用槽位，RemoveConsumer之后释放；占用之后初始化完游标才置active_
+    std::atomic<bool> claimed_ = {false};
+    std::atomic<bool> active_ = {false};
+    //槽位复用时会改写，生产者扫描时可能同时读取
+    std::atomic<bool> lossy_ = {false};
+  };
+
+ public:
+  BroadcastRing() {}
+  BroadcastRing& operator=(const BroadcastRing& other) = delete;
+  BroadcastRing(const BroadcastRing& other) = delete;
+  ~BroadcastRing();
+  //capacity向上取整为2的幂
+  bool Init(uint64_t capacity);
+  bool Init(uint64_t capacity, WaitStrategy* strategy, bool allow_lossy = false);
+  Consumer* AddConsumer(bool lossy = false);
+  void RemoveConsumer(Consumer* consumer);
+
+  //只能有一个生产者线程。最慢的消费者还没空出槽位时返回false
+  bool Publish(const T& element);
+  bool Publish(T&& element);
+  bool WaitPublish(const T& element);
+  bool WaitPublish(T&& element);
+
+  bool Read(Consumer* consumer, T* element);
+  bool WaitRead(Consumer* consumer, T* element);
+  //批量读取：对连续的至多max条消息依次调用f(const T&)，读完后一次性推进游标，返回读了多少条。
+  //非有损消费者的f直接访问环里的消息，不做拷贝；有损消费者的f在槽位锁内执行，应当尽量短
+  template <typename F>
+  uint64_t Consume(Consumer* consumer, F&& f,
+                   uint64_t max = std::numeric_limits<uint64_t>::max());
+  template <typename F>
+  uint64_t WaitConsume(Consumer* consumer, F&& f,
+                       uint64_t max = std::numeric_limits<uint64_t>::max());
+
+  //已经发布的消息总数
+  uint64_t Cursor() const { return cursor_.load(std::memory_order_acquire); }
+  uint64_t Capacity() const { return capacity_; }
+  //消费者还没读的消息数
+  uint64_t Available(const Consumer* consumer) const {
+    return Cursor() - consumer->cursor_.load(std::memory_order_relaxed);
+  }
+  void SetWaitStrategy(WaitStrategy* strategy);
+  void BreakAllWait();
+
+ private:
+  struct Slot {
+    //只在允许有损消费者时使用：生产者写和有损消费者读时互斥
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    //槽位中消息的序号
+    uint64_t seq = 0;
+    T value;
+
+    void Lock() {
+      while (lock.test_and_set(std::memory_order_acquire)) {
+      }
+    }
+    void Unlock() { lock.clear(std::memory_order_release); }
+  };
+
+  template <typename U>
+  bool Push(U&& element);
+  //最慢的非有损消费者的游标
+  uint64_t MinGatingCursor();
+  template <typename F>
+  uint64_t ConsumeLossy(Consumer* consumer, F&& f, uint64_t max);
+
+  alignas(CACHELINE_SIZE) std::atomic<uint64_t> cursor_ = {0};
+  //以下字段只有生产者访问
+  alignas(CACHELINE_SIZE) uint64_t gating_cache_ = 0;
+  alignas(CACHELINE_SIZE) Consumer consumers_[kMaxConsumers];
+  //用过的槽位数（只增不减），生产者只扫描这些槽位
+  std::atomic<uint32_t> consumer_num_ = {0};
+  uint64_t capacity_ = 0;
+  uint64_t mask_ = 0;
+  bool allow_lossy_ = false;
+  std::unique_ptr<Slot[]> slots_;
+  std::unique_ptr<WaitStrategy> wait_strategy_ = nullptr;
+  std::atomic<bool> break_all_wait_ = {false};
+};
+
+template <typename T>
+constexpr uint32_t BroadcastRing<T>::kMaxConsumers;
+
+template <typename T>
+BroadcastRing<T>::~BroadcastRing() {
+  if (wait_strategy_) {
+    BreakAllWait();
+  }
+}
+
+template <typename T>
+inline bool BroadcastRing<T>::Init(uint64_t capacity) {
+  return Init(capacity, new SleepWaitStrategy());
+}
+
+template <typename T>
+bool BroadcastRing<T>::Init(uint64_t capacity, WaitStrategy* strategy,
+                            bool allow_lossy) {
+  wait_strategy_.reset(strategy);
+  if (slots_ != nullptr || capacity == 0) {
+    return false;
+  }
+  capacity_ = 1;
+  while (capacity_ < capacity) {
+    capacity_ <<= 1;
+  }
+  mask_ = capacity_ - 1;
+  allow_lossy_ = allow_lossy;
+  slots_.reset(new Slot[capacity_]);
+  return true;
+}
+
+template <typename T>
+typename BroadcastRing<T>::Consumer* BroadcastRing<T>::AddConsumer(bool lossy) {
+  if (lossy && !allow_lossy_) {
+    return nullptr;
+  }
+  //优先复用已经移除的消费者的槽位，按下标从小到大找，生产者扫描的范围不会无谓地变大
+  for (uint32_t index = 0; index < kMaxConsumers; ++index) {
+    Consumer* consumer = &consumers_[index];
+    bool expected = false;
+    if (consumer->claimed_.load(std::memory_order_relaxed) ||
+        !consumer->claimed_.compare_exchange_strong(
+            expected, true, std::memory_order_acq_rel)) {
+      continue;
+    }
+    consumer->lossy_.store(lossy, std::memory_order_relaxed);
+    consumer->dropped_.store(0, std::memory_order_relaxed);
+    consumer->cursor_.store(cursor_.load(std::memory_order_acquire),
+                            std::memory_order_relaxed);
+    consumer->active_.store(true, std::memory_order_release);
+    uint32_t num = consumer_num_.load(std::memory_order_relaxed);
+    while (num < index + 1 &&
+           !consumer_num_.compare_exchange_weak(num, index + 1,
+                                                std::memory_order_acq_rel)) {
+    }
+    return consumer;
+  }
+  return nullptr;
+}
+
+template <typename T>
+inline void BroadcastRing<T>::RemoveConsumer(Consumer* consumer) {
+  consumer->active_.store(false, std::memory_order_release);
+  consumer->claimed_.store(false, std::memory_order_release);
+  wait_strategy_->NotifyAll();
+}
+
+template <typename T>
+uint64_t BroadcastRing<T>::MinGatingCursor() {
+  uint64_t min = cursor_.load(std::memory_order_relaxed);
+  uint32_t num = consumer_num_.load(std::memory_order_acquire);
+  for (uint32_t i = 0; i < num; ++i) {
+    const Consumer& consumer = consumers_[i];
+    if (!consumer.active_.load(std::memory_order_acquire) ||
+        consumer.lossy_.load(std::memory_order_relaxed)) {
+      continue;
+    }
+    uint64_t cursor = consumer.cursor_.load(std::memory_order_acquire);
+    if (cursor < min) {
+      min = cursor;
+    }
+  }
+  return min;
+}
+
+template <typename T>
+bool BroadcastRing<T>::Publish(const T& element) {
+  return Push(element);
+}
+
+template <typename T>
+bool BroadcastRing<T>::Publish(T&& element) {
+  return Push(std::move(element));
+}
+
+template <typename T>
+template <typename U>
+bool BroadcastRing<T>::Push(U&& element) {
+  uint64_t seq = cursor_.load(std::memory_order_relaxed);
+  //先看缓存的最慢游标，不够时才扫描所有消费者
+  if (seq - gating_cache_ >= capacity_) {
+    gating_cache_ = MinGatingCursor();
+    if (seq - gating_cache_ >= capacity_) {
+      return false;
+    }
+  }
+  Slot& slot = slots_[seq & mask_];
+  if (allow_lossy_) {
+    slot.Lock();
+    slot.value = std::forward<U>(element);
+    slot.seq = seq;
+    slot.Unlock();
+  } else {
+    slot.value = std::forward<U>(element);
+    slot.seq = seq;
+  }
+  cursor_.store(seq + 1, std::memory_order_release);
+  CYBER_TRACE(QUEUE_ENQUEUE, reinterpret_cast<uint64_t>(this),
+              static_cast<uint32_t>(seq));
+  wait_strategy_->NotifyAll();
+  return true;
+}
+
+template <typename T>
+bool BroadcastRing<T>::WaitPublish(const T& element) {
+  while (!break_all_wait_) {
+    if (Publish(element)) {
+      return true;
+    }
+    //等最慢的消费者，消费者推进游标时不通知生产者，这里只让出CPU
+    std::this_thread::yield();
+  }
+  return false;
+}
+
+template <typename T>
+bool BroadcastRing<T>::WaitPublish(T&& element) {
+  while (!break_all_wait_) {
+    if (Publish(std::move(element))) {
+      return true;
+    }
+    std::this_thread::yield();
+  }
+  return false;
+}
+
+template <typename T>
+bool BroadcastRing<T>::Read(Consumer* consumer, T* element) {
+  return Consume(consumer, [element](const T& value) { *element = value; },
+                 1) == 1;
+}
+
+template <typename T>
+bool BroadcastRing<T>::WaitRead(Consumer* consumer, T* element) {
+  return WaitConsume(consumer,
+                     [element](const T& value) { *element = value; }, 1) == 1;
+}
+
+template <typename T>
+template <typename F>
+uint64_t BroadcastRing<T>::Consume(Consumer* consumer, F&& f, uint64_t max) {
+  if (consumer->lossy_.load(std::memory_order_relaxed)) {
+    return ConsumeLossy(consumer, std::forward<F>(f), max);
+  }
+  uint64_t begin = consumer->cursor_.load(std::memory_order_relaxed);
+  uint64_t end = cursor_.load(std::memory_order_acquire);
+  if (end - begin > max) {
+    end = begin + max;
+  }
+  //[begin, end)里的槽位在游标推进之前不会被生产者覆盖
+  for (uint64_t seq = begin; seq != end; ++seq) {
+    f(const_cast<const T&>(slots_[seq & mask_].value));
+  }
+  if (end != begin) {
+    consumer->cursor_.store(end, std::memory_order_release);
+    CYBER_TRACE(QUEUE_DEQUEUE, reinterpret_cast<uint64_t>(this),
+                static_cast<uint32_t>(end - 1));
+  }
+  return end - begin;
+}
+
+template <typename T>
+template <typename F>
+uint64_t BroadcastRing<T>::ConsumeLossy(Consumer* consumer, F&& f,
+                                        uint64_t max) {
+  uint64_t seq = consumer->cursor_.load(std::memory_order_relaxed);
+  uint64_t count = 0;
+  while (count < max) {
+    uint64_t end = cursor_.load(std::memory_order_acquire);
+    if (seq == end) {
+      break;
+    }
+    if (end - seq > capacity_) {
+      //落后超过一圈，跳到还没被覆盖的最旧消息
+      consumer->dropped_.fetch_add(end - capacity_ - seq,
+                                   std::memory_order_relaxed);
+      seq = end - capacity_;
+    }
+    Slot& slot = slots_[seq & mask_];
+    slot.Lock();
+    bool valid = slot.seq == seq;
+    if (valid) {
+      f(const_cast<const T&>(slot.value));
+    }
+    slot.Unlock();
+    if (!valid) {
+      //读之前刚被覆盖，重新计算位置
+      continue;
+    }
+    ++seq;
+    ++count;
+  }
+  consumer->cursor_.store(seq, std::memory_order_release);
+  return count;
+}
+
+template <typename T>
+template <typename F>
+uint64_t BroadcastRing<T>::WaitConsume(Consumer* consumer, F&& f,
+                                       uint64_t max) {
+  while (!break_all_wait_) {
+    uint64_t count = Consume(consumer, f, max);
+    if (count != 0) {
+      return count;
+    }
+    if (wait_strategy_->EmptyWait()) {
+      continue;
+    }
+    // wait timeout
+    break;
+  }
+  return 0;
+}
+
+template <typename T>
+inline void BroadcastRing<T>::SetWaitStrategy(WaitStrategy* strategy) {
+  wait_strategy_.reset(strategy);
+}
+
+template <typename T>
+inline void BroadcastRing<T>::BreakAllWait() {
+  break_all_wait_ = true;
+  wait_strategy_->BreakAllWait();
+}
+
+#endif  // CYBER_BASE_BROADCAST_RING_H_
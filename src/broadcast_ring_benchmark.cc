@@ -0,0 +1,112 @@
+//一个生产者把每条消息扇出给8个消费者：
+//1、BroadcastRing：消息只写一次，消费者各自批量读取
+//2、8个BoundedQueue：生产者把消息拷贝进每个消费者自己的队列
+//两种方式都在失败时让出CPU后重试。
+//用法：broadcast_ring_benchmark [messages]
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "broadcast_ring.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kConsumers = 8;
+constexpr uint64_t kCapacity = 4096;
+
+//一帧传感器数据的头部大小
+struct Message {
+  uint64_t seq;
+  uint64_t payload[7];
+};
+
+double RunRing(uint64_t messages) {
+  BroadcastRing<Message> ring;
+  ring.Init(kCapacity, new YieldWaitStrategy());
+  std::vector<BroadcastRing<Message>::Consumer*> consumers;
+  for (int i = 0; i < kConsumers; ++i) {
+    consumers.push_back(ring.AddConsumer());
+  }
+  std::atomic<uint64_t> checksum = {0};
+  auto begin = Clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kConsumers; ++i) {
+    threads.emplace_back([&, i]() {
+      uint64_t received = 0;
+      uint64_t sum = 0;
+      while (received < messages) {
+        received += ring.WaitConsume(
+            consumers[i], [&sum](const Message& msg) { sum += msg.seq; });
+      }
+      checksum += sum;
+    });
+  }
+  Message msg = {};
+  for (uint64_t i = 0; i < messages; ++i) {
+    msg.seq = i;
+    ring.WaitPublish(msg);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+double RunQueues(uint64_t messages) {
+  BoundedQueue<Message> queues[kConsumers];
+  for (auto& queue : queues) {
+    queue.Init(kCapacity, new YieldWaitStrategy());
+  }
+  std::atomic<uint64_t> checksum = {0};
+  auto begin = Clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kConsumers; ++i) {
+    threads.emplace_back([&, i]() {
+      uint64_t sum = 0;
+      Message msg;
+      for (uint64_t received = 0; received < messages; ++received) {
+        while (!queues[i].Dequeue(&msg)) {
+          std::this_thread::yield();
+        }
+        sum += msg.seq;
+      }
+      checksum += sum;
+    });
+  }
+  Message msg = {};
+  for (uint64_t i = 0; i < messages; ++i) {
+    msg.seq = i;
+    for (auto& queue : queues) {
+      while (!queue.Enqueue(msg)) {
+        std::this_thread::yield();
+      }
+    }
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  uint64_t messages = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+  double ring = RunRing(messages);
+  double queues = RunQueues(messages);
+  printf("fan-out of %llu x %zu-byte messages to %d consumers\n",
+         static_cast<unsigned long long>(messages), sizeof(Message),
+         kConsumers);
+  printf("BroadcastRing:        %8.2f M msgs/s (%.3f s)\n",
+         messages / ring / 1e6, ring);
+  printf("%d x BoundedQueue:     %8.2f M msgs/s (%.3f s)\n", kConsumers,
+         messages / queues / 1e6, queues);
+  return 0;
+}
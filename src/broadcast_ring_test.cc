@@ -0,0 +1,222 @@
+#include "broadcast_ring.h"
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(BroadcastRing, EveryConsumerSeesEveryMessageInOrder) {
+  constexpr int kConsumers = 3;
+  constexpr uint64_t kMessages = 100000;
+  BroadcastRing<uint64_t> ring;
+  ASSERT_TRUE(ring.Init(64, new YieldWaitStrategy()));
+  std::vector<BroadcastRing<uint64_t>::Consumer*> consumers;
+  for (int i = 0; i < kConsumers; ++i) {
+    consumers.push_back(ring.AddConsumer());
+  }
+  std::vector<uint64_t> errors(kConsumers, 0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kConsumers; ++i) {
+    threads.emplace_back([&, i]() {
+      uint64_t expected = 0;
+      while (expected < kMessages) {
+        ring.WaitConsume(consumers[i], [&](const uint64_t& value) {
+          if (value != expected) {
+            errors[i]++;
+          }
+          expected++;
+        });
+      }
+    });
+  }
+  for (uint64_t i = 0; i < kMessages; ++i) {
+    ASSERT_TRUE(ring.WaitPublish(i));
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (int i = 0; i < kConsumers; ++i) {
+    EXPECT_EQ(errors[i], 0u);
+  }
+}
+
+TEST(BroadcastRing, SlowestConsumerGatesProducer) {
+  BroadcastRing<int> ring;
+  ASSERT_TRUE(ring.Init(6, new SleepWaitStrategy()));
+  EXPECT_EQ(ring.Capacity(), 8u);
+  auto fast = ring.AddConsumer();
+  auto slow = ring.AddConsumer();
+  int value = 0;
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_TRUE(ring.Publish(i));
+    EXPECT_TRUE(ring.Read(fast, &value));
+  }
+  EXPECT_FALSE(ring.Publish(8));
+  EXPECT_TRUE(ring.Read(slow, &value));
+  EXPECT_EQ(value, 0);
+  EXPECT_TRUE(ring.Publish(8));
+  EXPECT_FALSE(ring.Publish(9));
+  //移除的消费者不再限速
+  ring.RemoveConsumer(slow);
+  EXPECT_TRUE(ring.Publish(9));
+}
+
+//移除的消费者的槽位被复用，反复添加和移除的次数可以远超kMaxConsumers
+TEST(BroadcastRing, RemovedConsumerSlotsAreReused) {
+  using Ring = BroadcastRing<int>;
+  Ring ring;
+  ASSERT_TRUE(ring.Init(8, new SleepWaitStrategy(), true));
+  int value = 0;
+  for (uint32_t round = 0; round < 10 * Ring::kMaxConsumers; ++round) {
+    //游标落后的旧消费者被移除后，新消费者从当前位置开始读，不受旧游标和旧计数的影响
+    auto consumer = ring.AddConsumer(round % 2 == 0);
+    ASSERT_NE(consumer, nullptr) << "round " << round;
+    EXPECT_EQ(consumer->lossy(), round % 2 == 0);
+    EXPECT_EQ(consumer->Dropped(), 0u);
+    EXPECT_EQ(ring.Available(consumer), 0u);
+    for (int i = 0; i < 12; ++i) {
+      ASSERT_TRUE(ring.Publish(i));
+      if (!consumer->lossy()) {
+        ASSERT_TRUE(ring.Read(consumer, &value));
+        EXPECT_EQ(value, i);
+      }
+    }
+    ring.RemoveConsumer(consumer);
+  }
+
+  std::vector<Ring::Consumer*> consumers;
+  for (uint32_t i = 0; i < Ring::kMaxConsumers; ++i) {
+    consumers.push_back(ring.AddConsumer());
+    ASSERT_NE(consumers.back(), nullptr);
+  }
+  EXPECT_EQ(ring.AddConsumer(), nullptr);
+  ring.RemoveConsumer(consumers[5]);
+  EXPECT_EQ(ring.AddConsumer(), consumers[5]);
+}
+
+//多个线程同时添加和移除，同时存在的消费者不会拿到同一个槽位
+TEST(BroadcastRing, ConcurrentConsumerChurn) {
+  using Ring = BroadcastRing<int>;
+  constexpr int kThreads = 4;
+  Ring ring;
+  ASSERT_TRUE(ring.Init(8, new SleepWaitStrategy()));
+  std::mutex mutex;
+  std::set<Ring::Consumer*> live;
+  std::atomic<int> failures = {0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&]() {
+      for (uint32_t i = 0; i < 50 * Ring::kMaxConsumers; ++i) {
+        auto consumer = ring.AddConsumer();
+        if (consumer == nullptr) {
+          failures++;
+          continue;
+        }
+        {
+          std::lock_guard<std::mutex> lk(mutex);
+          if (!live.insert(consumer).second) {
+            failures++;
+          }
+        }
+        {
+          std::lock_guard<std::mutex> lk(mutex);
+          live.erase(consumer);
+        }
+        ring.RemoveConsumer(consumer);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(failures, 0);
+}
+
+TEST(BroadcastRing, BatchConsumeIsContiguous) {
+  BroadcastRing<int> ring;
+  ASSERT_TRUE(ring.Init(16, new SleepWaitStrategy()));
+  auto consumer = ring.AddConsumer();
+  for (int i = 0; i < 10; ++i) {
+    ring.Publish(i);
+  }
+  std::vector<int> batch;
+  auto collect = [&batch](const int& value) { batch.push_back(value); };
+  EXPECT_EQ(ring.Consume(consumer, collect, 4), 4u);
+  EXPECT_EQ(ring.Available(consumer), 6u);
+  EXPECT_EQ(ring.Consume(consumer, collect), 6u);
+  EXPECT_EQ(ring.Consume(consumer, collect), 0u);
+  ASSERT_EQ(batch.size(), 10u);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(batch[i], i);
+  }
+}
+
+TEST(BroadcastRing, LossyConsumerDropsOldest) {
+  BroadcastRing<int> strict;
+  ASSERT_TRUE(strict.Init(8, new SleepWaitStrategy()));
+  EXPECT_EQ(strict.AddConsumer(true), nullptr);
+
+  BroadcastRing<int> ring;
+  ASSERT_TRUE(ring.Init(8, new SleepWaitStrategy(), true));
+  auto lossy = ring.AddConsumer(true);
+  ASSERT_NE(lossy, nullptr);
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_TRUE(ring.Publish(i));
+  }
+  std::vector<int> seen;
+  ring.Consume(lossy, [&seen](const int& value) { seen.push_back(value); });
+  EXPECT_EQ(lossy->Dropped(), 12u);
+  ASSERT_EQ(seen.size(), 8u);
+  EXPECT_EQ(seen.front(), 12);
+  EXPECT_EQ(seen.back(), 19);
+}
+
+TEST(BroadcastRing, LossyConsumerUnderConcurrentOverwrite) {
+  constexpr int kMessages = 200000;
+  BroadcastRing<std::vector<int>> ring;
+  ASSERT_TRUE(ring.Init(16, new YieldWaitStrategy(), true));
+  auto lossy = ring.AddConsumer(true);
+  std::atomic<bool> done = {false};
+  uint64_t received = 0;
+  int last = -1;
+  bool ordered = true;
+  std::thread consumer([&]() {
+    while (!done.load() || ring.Available(lossy) != 0) {
+      ring.Consume(lossy, [&](const std::vector<int>& value) {
+        //消息内容在读的过程中不能被改写
+        ordered = ordered && value.size() == 4 && value[0] == value[3] &&
+                  value[0] > last;
+        last = value[0];
+        received++;
+      });
+      std::this_thread::yield();
+    }
+  });
+  for (int i = 0; i < kMessages; ++i) {
+    ring.Publish(std::vector<int>(4, i));
+  }
+  done = true;
+  consumer.join();
+  EXPECT_TRUE(ordered);
+  EXPECT_EQ(received + lossy->Dropped(), static_cast<uint64_t>(kMessages));
+}
+
+TEST(BroadcastRing, WaitReadBreaks) {
+  BroadcastRing<int> ring;
+  ASSERT_TRUE(ring.Init(8, new SleepWaitStrategy(1000)));
+  auto consumer = ring.AddConsumer();
+  int value = 0;
+  std::thread reader([&]() {
+    EXPECT_TRUE(ring.WaitRead(consumer, &value));
+    EXPECT_FALSE(ring.WaitRead(consumer, &value));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ring.Publish(7);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ring.BreakAllWait();
+  reader.join();
+  EXPECT_EQ(value, 7);
+}
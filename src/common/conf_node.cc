@@ -0,0 +1,274 @@
+#include "conf_node.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+//递归下降解析：
+//  message := field*
+//  field   := name [':'] ( '{' message '}' | '[' item (',' item)* ']' | scalar ) [',' | ';']
+//  item    := '{' message '}' | scalar
+class ConfParser {
+ public:
+  explicit ConfParser(const std::string& text) : text_(text) {}
+
+  bool ParseMessage(ConfNode* node, bool nested) {
+    for (;;) {
+      SkipSpace();
+      if (pos_ >= text_.size()) {
+        return nested ? Fail("missing '}'") : true;
+      }
+      if (text_[pos_] == '}') {
+        if (!nested) {
+          return Fail("unexpected '}'");
+        }
+        ++pos_;
+        return true;
+      }
+      std::string name;
+      if (!ParseName(&name)) {
+        return Fail("expected field name");
+      }
+      SkipSpace();
+      bool colon = Consume(':');
+      SkipSpace();
+      if (Peek() == '[') {
+        ++pos_;
+        if (!ParseList(name, node)) {
+          return false;
+        }
+      } else {
+        node->children_.emplace_back(name, ConfNode());
+        ConfNode* child = &node->children_.back().second;
+        if (Peek() == '{') {
+          ++pos_;
+          if (!ParseMessage(child, true)) {
+            return false;
+          }
+        } else if (!colon) {
+          return Fail("expected ':' or '{' after " + name);
+        } else if (!ParseScalar(&child->value_)) {
+          return false;
+        }
+      }
+      SkipSpace();
+      if (!Consume(',')) {
+        Consume(';');
+      }
+    }
+  }
+
+  const std::string& error() const { return error_; }
+
+ private:
+  bool ParseList(const std::string& name, ConfNode* node) {
+    for (;;) {
+      SkipSpace();
+      if (Consume(']')) {
+        return true;
+      }
+      node->children_.emplace_back(name, ConfNode());
+      ConfNode* child = &node->children_.back().second;
+      if (Consume('{')) {
+        if (!ParseMessage(child, true)) {
+          return false;
+        }
+      } else if (!ParseScalar(&child->value_)) {
+        return false;
+      }
+      SkipSpace();
+      if (!Consume(',') && Peek() != ']') {
+        return Fail("expected ',' or ']' in " + name);
+      }
+    }
+  }
+
+  bool ParseName(std::string* name) {
+    size_t begin = pos_;
+    while (pos_ < text_.size() &&
+           (isalnum(static_cast<unsigned char>(text_[pos_])) ||
+            text_[pos_] == '_')) {
+      ++pos_;
+    }
+    *name = text_.substr(begin, pos_ - begin);
+    return !name->empty();
+  }
+
+  bool ParseScalar(std::string* value) {
+    if (Consume('"')) {
+      value->clear();
+      while (pos_ < text_.size() && text_[pos_] != '"') {
+        if (text_[pos_] == '\n') {
+          return Fail("unterminated string");
+        }
+        if (text_[pos_] == '\\' && pos_ + 1 < text_.size()) {
+          ++pos_;
+        }
+        value->push_back(text_[pos_++]);
+      }
+      if (!Consume('"')) {
+        return Fail("unterminated string");
+      }
+      return true;
+    }
+    size_t begin = pos_;
+    while (pos_ < text_.size() &&
+           (isalnum(static_cast<unsigned char>(text_[pos_])) ||
+            text_[pos_] == '_' || text_[pos_] == '-' || text_[pos_] == '+' ||
+            text_[pos_] == '.')) {
+      ++pos_;
+    }
+    if (pos_ == begin) {
+      return Fail("expected value");
+    }
+    *value = text_.substr(begin, pos_ - begin);
+    return true;
+  }
+
+  void SkipSpace() {
+    while (pos_ < text_.size()) {
+      char c = text_[pos_];
+      if (c == '#') {
+        while (pos_ < text_.size() && text_[pos_] != '\n') {
+          ++pos_;
+        }
+      } else if (isspace(static_cast<unsigned char>(c))) {
+        ++pos_;
+      } else {
+        break;
+      }
+    }
+  }
+
+  char Peek() const { return pos_ < text_.size() ? text_[pos_] : '\0'; }
+
+  bool Consume(char c) {
+    if (Peek() != c) {
+      return false;
+    }
+    ++pos_;
+    return true;
+  }
+
+  bool Fail(const std::string& reason) {
+    if (error_.empty()) {
+      int line = 1;
+      for (size_t i = 0; i < pos_ && i < text_.size(); ++i) {
+        line += text_[i] == '\n';
+      }
+      error_ = "line " + std::to_string(line) + ": " + reason;
+    }
+    return false;
+  }
+
+  const std::string& text_;
+  size_t pos_ = 0;
+  std::string error_;
+};
+
+bool ConfNode::Parse(const std::string& text, ConfNode* root,
+                     std::string* error) {
+  *root = ConfNode();
+  ConfParser parser(text);
+  if (!parser.ParseMessage(root, false)) {
+    if (error != nullptr) {
+      *error = parser.error();
+    }
+    return false;
+  }
+  return true;
+}
+
+bool ConfNode::Load(const std::string& path, ConfNode* root,
+                    std::string* error) {
+  std::ifstream in(path);
+  if (!in) {
+    if (error != nullptr) {
+      *error = "cannot open " + path;
+    }
+    return false;
+  }
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return Parse(ss.str(), root, error);
+}
+
+const ConfNode* ConfNode::Child(const std::string& key) const {
+  for (auto& child : children_) {
+    if (child.first == key) {
+      return &child.second;
+    }
+  }
+  return nullptr;
+}
+
+std::vector<const ConfNode*> ConfNode::Children(const std::string& key) const {
+  std::vector<const ConfNode*> result;
+  for (auto& child : children_) {
+    if (child.first == key) {
+      result.push_back(&child.second);
+    }
+  }
+  return result;
+}
+
+bool ConfNode::Get(const std::string& key, std::string* value) const {
+  const ConfNode* child = Child(key);
+  if (child == nullptr || !child->children_.empty()) {
+    return false;
+  }
+  *value = child->value_;
+  return true;
+}
+
+bool ConfNode::Get(const std::string& key, int32_t* value) const {
+  std::string str;
+  if (!Get(key, &str) || str.empty()) {
+    return false;
+  }
+  char* end = nullptr;
+  errno = 0;
+  long long number = strtoll(str.c_str(), &end, 0);
+  if (*end != '\0' || errno != 0 ||
+      number < std::numeric_limits<int32_t>::min() ||
+      number > std::numeric_limits<int32_t>::max()) {
+    return false;
+  }
+  *value = static_cast<int32_t>(number);
+  return true;
+}
+
+bool ConfNode::Get(const std::string& key, uint32_t* value) const {
+  std::string str;
+  //负数不能转换成无符号数
+  if (!Get(key, &str) || str.empty() || str[0] == '-') {
+    return false;
+  }
+  char* end = nullptr;
+  errno = 0;
+  unsigned long long unsigned_number = strtoull(str.c_str(), &end, 0);
+  if (*end != '\0' || errno != 0 ||
+      unsigned_number > std::numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+  *value = static_cast<uint32_t>(unsigned_number);
+  return true;
+}
+
+bool ConfNode::Get(const std::string& key, bool* value) const {
+  std::string str;
+  if (!Get(key, &str)) {
+    return false;
+  }
+  if (str == "true" || str == "1") {
+    *value = true;
+  } else if (str == "false" || str == "0") {
+    *value = false;
+  } else {
+    return false;
+  }
+  return true;
+}
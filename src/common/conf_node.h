@@ -0,0 +1,43 @@
+#ifndef CYBER_COMMON_CONF_NODE_H_
+#define CYBER_COMMON_CONF_NODE_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+//读取Apollo风格的配置文件（protobuf文本格式的一个子集）：
+//  key: value            value是数字、标识符（true、SCHED_FIFO等）或者双引号字符串
+//  key { ... }           嵌套的消息，也可以写成key: { ... }
+//  key: [ {...}, {...} ] 列表，每一项都是一个名为key的子节点，和把key重复写多次等价
+//  #到行尾是注释，字段之间的逗号和分号可以省略
+//解析出的树只保存字符串，读取时再按需要的类型转换。
+class ConfNode {
+ public:
+  //解析失败时返回false，error中是带行号的原因
+  static bool Parse(const std::string& text, ConfNode* root, std::string* error);
+  static bool Load(const std::string& path, ConfNode* root, std::string* error);
+
+  //第一个名为key的子节点，不存在时返回nullptr
+  const ConfNode* Child(const std::string& key) const;
+  //所有名为key的子节点，按出现的顺序
+  std::vector<const ConfNode*> Children(const std::string& key) const;
+  bool Has(const std::string& key) const { return Child(key) != nullptr; }
+
+  //key不存在或者不能转换成对应的类型时返回false，value保持不变
+  bool Get(const std::string& key, std::string* value) const;
+  bool Get(const std::string& key, int32_t* value) const;
+  bool Get(const std::string& key, uint32_t* value) const;
+  bool Get(const std::string& key, bool* value) const;
+
+  //标量节点的值，消息节点为空
+  const std::string& value() const { return value_; }
+
+ private:
+  friend class ConfParser;
+
+  std::string value_;
+  std::vector<std::pair<std::string, ConfNode>> children_;
+};
+
+#endif  // CYBER_COMMON_CONF_NODE_H_
@@ -0,0 +1,75 @@
+#include "conf_node.h"
+
+#include "gtest/gtest.h"
+
+TEST(ConfNode, ScalarsAndNestedMessages) {
+  const char* text = R"(
+    # 注释
+    name: "quoted # not a comment"
+    num: 8, neg: -1
+    flag: true
+    policy: SCHED_FIFO
+    inner { value: 3 }
+    other: { value: 4; }
+  )";
+  ConfNode root;
+  std::string error;
+  ASSERT_TRUE(ConfNode::Parse(text, &root, &error)) << error;
+  std::string str;
+  EXPECT_TRUE(root.Get("name", &str));
+  EXPECT_EQ(str, "quoted # not a comment");
+  EXPECT_TRUE(root.Get("policy", &str));
+  EXPECT_EQ(str, "SCHED_FIFO");
+  int32_t num = 0;
+  EXPECT_TRUE(root.Get("num", &num));
+  EXPECT_EQ(num, 8);
+  EXPECT_TRUE(root.Get("neg", &num));
+  EXPECT_EQ(num, -1);
+  uint32_t unsigned_num = 7;
+  EXPECT_FALSE(root.Get("neg", &unsigned_num));
+  EXPECT_EQ(unsigned_num, 7u);
+  bool flag = false;
+  EXPECT_TRUE(root.Get("flag", &flag));
+  EXPECT_TRUE(flag);
+  EXPECT_FALSE(root.Get("name", &num));
+  EXPECT_FALSE(root.Get("missing", &str));
+  ASSERT_NE(root.Child("inner"), nullptr);
+  EXPECT_TRUE(root.Child("inner")->Get("value", &num));
+  EXPECT_EQ(num, 3);
+  ASSERT_NE(root.Child("other"), nullptr);
+  EXPECT_TRUE(root.Child("other")->Get("value", &num));
+  EXPECT_EQ(num, 4);
+}
+
+//列表和重复字段是等价的
+TEST(ConfNode, ListsAndRepeatedFields) {
+  ConfNode root;
+  std::string error;
+  ASSERT_TRUE(ConfNode::Parse(
+      "tasks: [ { name: \"A\" }, { name: \"B\" } ]\n"
+      "tasks { name: \"C\" }\n"
+      "ids: [1, 2, 3]\n"
+      "empty: []\n",
+      &root, &error))
+      << error;
+  auto tasks = root.Children("tasks");
+  ASSERT_EQ(tasks.size(), 3u);
+  std::string name;
+  EXPECT_TRUE(tasks[2]->Get("name", &name));
+  EXPECT_EQ(name, "C");
+  auto ids = root.Children("ids");
+  ASSERT_EQ(ids.size(), 3u);
+  EXPECT_EQ(ids[1]->value(), "2");
+  EXPECT_TRUE(root.Children("empty").empty());
+}
+
+TEST(ConfNode, ReportsErrorLine) {
+  ConfNode root;
+  std::string error;
+  EXPECT_FALSE(ConfNode::Parse("a: 1\nb {\n  c: 2\n", &root, &error));
+  EXPECT_NE(error.find("missing '}'"), std::string::npos) << error;
+  EXPECT_FALSE(ConfNode::Parse("a: 1\nb 2\n", &root, &error));
+  EXPECT_EQ(error.find("line 2"), 0u) << error;
+  EXPECT_FALSE(ConfNode::Parse("s: \"open\n", &root, &error));
+  EXPECT_FALSE(ConfNode::Load("/nonexistent/sched.conf", &root, &error));
+}
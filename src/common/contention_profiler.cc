@@ -0,0 +1,280 @@
+#include "contention_profiler.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <new>
+#include <sstream>
+
+namespace {
+
+//线程编号的分配表，线程退出时归还编号
+class ThreadSlots {
+ public:
+  static ThreadSlots* Instance() {
+    static ThreadSlots* slots = new ThreadSlots();
+    return slots;
+  }
+
+  int Acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_.empty()) {
+      int slot = free_.back();
+      free_.pop_back();
+      return slot;
+    }
+    if (next_ < ContentionSite::kMaxThreads) {
+      return next_++;
+    }
+    return ContentionSite::kMaxThreads;
+  }
+
+  void Release(int slot) {
+    if (slot == ContentionSite::kMaxThreads) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(slot);
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<int> free_;
+  int next_ = 0;
+};
+
+struct ThreadSlotHolder {
+  ~ThreadSlotHolder() {
+    if (slot >= 0) {
+      ThreadSlots::Instance()->Release(slot);
+    }
+  }
+  int slot = -1;
+};
+
+int BucketOf(uint64_t ns) {
+  if (ns == 0) {
+    return 0;
+  }
+  int bucket = 63 - __builtin_clzll(ns);
+  return std::min(bucket, ContentionHistogram::kBucketNum - 1);
+}
+
+void AppendHistogram(std::ostringstream* os, const char* label,
+                     const ContentionHistogram& h) {
+  if (h.count == 0) {
+    return;
+  }
+  char line[256];
+  snprintf(line, sizeof(line),
+           "    %-10s count %-10llu avg %8.0f ns  p50 <%llu ns  p99 <%llu ns  "
+           "max <%llu ns\n",
+           label, static_cast<unsigned long long>(h.count),
+           static_cast<double>(h.total_ns) / h.count,
+           static_cast<unsigned long long>(h.Percentile(0.5)),
+           static_cast<unsigned long long>(h.Percentile(0.99)),
+           static_cast<unsigned long long>(h.Percentile(1.0)));
+  *os << line;
+}
+
+}  // namespace
+
+uint64_t ContentionHistogram::Percentile(double q) const {
+  if (count == 0) {
+    return 0;
+  }
+  uint64_t target = static_cast<uint64_t>(q * count);
+  if (target == 0) {
+    target = 1;
+  }
+  uint64_t seen = 0;
+  for (int i = 0; i < kBucketNum; ++i) {
+    seen += buckets[i];
+    if (seen >= target) {
+      return 2ULL << i;
+    }
+  }
+  return 2ULL << (kBucketNum - 1);
+}
+
+void ContentionHistogram::Merge(const ContentionHistogram& other) {
+  count += other.count;
+  total_ns += other.total_ns;
+  for (int i = 0; i < kBucketNum; ++i) {
+    buckets[i] += other.buckets[i];
+  }
+}
+
+ContentionSite::ContentionSite(const char* type) {
+  char name[64];
+  snprintf(name, sizeof(name), "%s@%p", type, static_cast<void*>(this));
+  name_ = name;
+  ContentionProfiler::Instance()->Register(this);
+}
+
+ContentionSite::~ContentionSite() {
+  ContentionProfiler::Instance()->Unregister(this);
+  for (auto& slot : slots_) {
+    Counters* counters = slot.load(std::memory_order_acquire);
+    if (counters != nullptr) {
+      counters->~Counters();
+      free(counters);
+    }
+  }
+}
+
+void ContentionSite::SetName(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  name_ = name;
+}
+
+std::string ContentionSite::name() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return name_;
+}
+
+int ContentionSite::ThreadSlot() {
+  static thread_local ThreadSlotHolder holder;
+  if (cyber_unlikely(holder.slot < 0)) {
+    holder.slot = ThreadSlots::Instance()->Acquire();
+  }
+  return holder.slot;
+}
+
+ContentionSite::Counters* ContentionSite::CreateCounters(int slot) {
+  void* mem = nullptr;
+  if (posix_memalign(&mem, CACHELINE_SIZE, sizeof(Counters)) != 0) {
+    throw std::bad_alloc();
+  }
+  Counters* counters = new (mem) Counters();
+  counters->shared = slot == kMaxThreads;
+  Counters* expected = nullptr;
+  //只有共用的那组计数器会有多个线程同时创建
+  if (!slots_[slot].compare_exchange_strong(expected, counters,
+                                            std::memory_order_acq_rel)) {
+    counters->~Counters();
+    free(counters);
+    return expected;
+  }
+  return counters;
+}
+
+void ContentionSite::Record(Counters* counters, Histogram* histogram,
+                            uint64_t ticks) {
+  uint64_t ns = static_cast<uint64_t>(ticks * TscClock::NsPerTick());
+  Add(counters, &histogram->count, 1);
+  Add(counters, &histogram->total_ns, ns);
+  Add(counters, &histogram->buckets[BucketOf(ns)], 1);
+}
+
+ContentionStats ContentionSite::Snapshot() const {
+  ContentionStats stats;
+  stats.name = name();
+  auto merge = [](const Histogram& from, ContentionHistogram* to) {
+    to->count += from.count.load(std::memory_order_relaxed);
+    to->total_ns += from.total_ns.load(std::memory_order_relaxed);
+    for (int i = 0; i < ContentionHistogram::kBucketNum; ++i) {
+      to->buckets[i] += from.buckets[i].load(std::memory_order_relaxed);
+    }
+  };
+  for (auto& slot : slots_) {
+    const Counters* counters = slot.load(std::memory_order_acquire);
+    if (counters == nullptr) {
+      continue;
+    }
+    stats.cas_failures += counters->cas_failures.load(std::memory_order_relaxed);
+    stats.spins += counters->spins.load(std::memory_order_relaxed);
+    stats.yields += counters->yields.load(std::memory_order_relaxed);
+    merge(counters->hold, &stats.hold);
+    merge(counters->wait, &stats.wait);
+    merge(counters->full_wait, &stats.full_wait);
+    merge(counters->empty_wait, &stats.empty_wait);
+  }
+  return stats;
+}
+
+//和记录并发时，正在累加的计数可能覆盖掉清零
+void ContentionSite::Reset() {
+  auto reset = [](Histogram* h) {
+    h->count.store(0, std::memory_order_relaxed);
+    h->total_ns.store(0, std::memory_order_relaxed);
+    for (auto& bucket : h->buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  };
+  for (auto& slot : slots_) {
+    Counters* counters = slot.load(std::memory_order_acquire);
+    if (counters == nullptr) {
+      continue;
+    }
+    counters->cas_failures.store(0, std::memory_order_relaxed);
+    counters->spins.store(0, std::memory_order_relaxed);
+    counters->yields.store(0, std::memory_order_relaxed);
+    reset(&counters->hold);
+    reset(&counters->wait);
+    reset(&counters->full_wait);
+    reset(&counters->empty_wait);
+  }
+}
+
+ContentionProfiler* ContentionProfiler::Instance() {
+  static ContentionProfiler* profiler = new ContentionProfiler();
+  return profiler;
+}
+
+void ContentionProfiler::Register(ContentionSite* site) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sites_.push_back(site);
+}
+
+void ContentionProfiler::Unregister(ContentionSite* site) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sites_.erase(std::remove(sites_.begin(), sites_.end(), site), sites_.end());
+}
+
+std::vector<ContentionStats> ContentionProfiler::Snapshot() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<ContentionStats> result;
+  result.reserve(sites_.size());
+  for (auto site : sites_) {
+    result.push_back(site->Snapshot());
+  }
+  return result;
+}
+
+std::vector<ContentionStats> ContentionProfiler::Top(size_t n) {
+  auto stats = Snapshot();
+  std::sort(stats.begin(), stats.end(),
+            [](const ContentionStats& a, const ContentionStats& b) {
+              if (a.WaitNs() != b.WaitNs()) {
+                return a.WaitNs() > b.WaitNs();
+              }
+              return a.cas_failures + a.spins > b.cas_failures + b.spins;
+            });
+  if (stats.size() > n) {
+    stats.resize(n);
+  }
+  return stats;
+}
+
+std::string ContentionProfiler::Dump(size_t n) {
+  std::ostringstream os;
+  for (auto& stats : Top(n)) {
+    os << stats.name << ": wait " << stats.WaitNs() / 1000 << " us, cas_failures "
+       << stats.cas_failures << ", spins " << stats.spins << ", yields "
+       << stats.yields << "\n";
+    AppendHistogram(&os, "hold", stats.hold);
+    AppendHistogram(&os, "wait", stats.wait);
+    AppendHistogram(&os, "full_wait", stats.full_wait);
+    AppendHistogram(&os, "empty_wait", stats.empty_wait);
+  }
+  return os.str();
+}
+
+void ContentionProfiler::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto site : sites_) {
+    site->Reset();
+  }
+}
@@ -0,0 +1,178 @@
+#ifndef CYBER_COMMON_CONTENTION_PROFILER_H_
+#define CYBER_COMMON_CONTENTION_PROFILER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "macros.h"
+#include "tsc_clock.h"
+
+//按2的幂分桶的耗时直方图，第i个桶统计[2^i, 2^(i+1))纳秒，第0个桶还包括0纳秒
+struct ContentionHistogram {
+  static constexpr int kBucketNum = 40;
+
+  uint64_t count = 0;
+  uint64_t total_ns = 0;
+  uint64_t buckets[kBucketNum] = {};
+
+  //按桶估算的分位数（返回所在桶的上界）
+  uint64_t Percentile(double q) const;
+  void Merge(const ContentionHistogram& other);
+};
+
+//一个被观测对象（一个队列、一把锁）的竞争统计快照
+struct ContentionStats {
+  std::string name;
+  //CAS失败后重试的次数
+  uint64_t cas_failures = 0;
+  //等待条件满足时空转的次数
+  uint64_t spins = 0;
+  //让出CPU（yield）或者交给WaitStrategy等待的次数
+  uint64_t yields = 0;
+  //锁的持有时间
+  ContentionHistogram hold;
+  //加锁时从第一次遇到竞争到拿到锁的时间，没有竞争时记为0
+  ContentionHistogram wait;
+  //队列满时入队方的等待时间
+  ContentionHistogram full_wait;
+  //队列空时出队方的等待时间
+  ContentionHistogram empty_wait;
+
+  //排序依据：所有等待时间之和
+  uint64_t WaitNs() const {
+    return wait.total_ns + full_wait.total_ns + empty_wait.total_ns;
+  }
+};
+
+//一个被观测对象的计数器，嵌入在BoundedQueue、AtomicRWLock里。
+//每个线程第一次记录时分到自己的一组计数器，之后只有这个线程写，用relaxed的load+store累加，
+//不需要原子的读改写；Snapshot()时合并所有线程的计数器。线程退出后计数器仍然保留。
+//同时活跃的线程超过kMaxThreads时，多出来的线程共用一组计数器，改用fetch_add。
+class ContentionSite {
+ public:
+  static constexpr int kMaxThreads = 64;
+
+  explicit ContentionSite(const char* type);
+  ~ContentionSite();
+  ContentionSite(const ContentionSite&) = delete;
+  ContentionSite& operator=(const ContentionSite&) = delete;
+
+  void SetName(const std::string& name);
+  std::string name() const;
+
+  void CasFailure(uint64_t n = 1) {
+    Counters* c = Local();
+    Add(c, &c->cas_failures, n);
+  }
+  void Spin(uint64_t n = 1) {
+    Counters* c = Local();
+    Add(c, &c->spins, n);
+  }
+  void Yield(uint64_t n = 1) {
+    Counters* c = Local();
+    Add(c, &c->yields, n);
+  }
+  //参数都是tsc的差值
+  void RecordHold(uint64_t ticks) {
+    Counters* c = Local();
+    Record(c, &c->hold, ticks);
+  }
+  void RecordWait(uint64_t ticks) {
+    Counters* c = Local();
+    Record(c, &c->wait, ticks);
+  }
+  void RecordFullWait(uint64_t ticks) {
+    Counters* c = Local();
+    Record(c, &c->full_wait, ticks);
+  }
+  void RecordEmptyWait(uint64_t ticks) {
+    Counters* c = Local();
+    Record(c, &c->empty_wait, ticks);
+  }
+
+  ContentionStats Snapshot() const;
+  void Reset();
+
+ private:
+  struct Histogram {
+    std::atomic<uint64_t> count = {0};
+    std::atomic<uint64_t> total_ns = {0};
+    std::atomic<uint64_t> buckets[ContentionHistogram::kBucketNum] = {};
+  };
+
+  struct alignas(CACHELINE_SIZE) Counters {
+    bool shared = false;
+    std::atomic<uint64_t> cas_failures = {0};
+    std::atomic<uint64_t> spins = {0};
+    std::atomic<uint64_t> yields = {0};
+    Histogram hold;
+    Histogram wait;
+    Histogram full_wait;
+    Histogram empty_wait;
+  };
+
+  //当前线程的计数器，第一次调用时分配
+  Counters* Local() {
+    int slot = ThreadSlot();
+    Counters* counters = slots_[slot].load(std::memory_order_acquire);
+    if (cyber_unlikely(counters == nullptr)) {
+      counters = CreateCounters(slot);
+    }
+    return counters;
+  }
+  Counters* CreateCounters(int slot);
+  //当前线程的编号，线程退出后编号回收给新线程；超过kMaxThreads的线程都返回kMaxThreads
+  static int ThreadSlot();
+
+  static void Add(Counters* counters, std::atomic<uint64_t>* counter,
+                  uint64_t delta) {
+    if (cyber_unlikely(counters->shared)) {
+      counter->fetch_add(delta, std::memory_order_relaxed);
+    } else {
+      counter->store(counter->load(std::memory_order_relaxed) + delta,
+                     std::memory_order_relaxed);
+    }
+  }
+  static void Record(Counters* counters, Histogram* histogram,
+                     uint64_t ticks);
+
+  mutable std::mutex mutex_;
+  std::string name_;
+  //下标kMaxThreads是多出来的线程共用的计数器
+  std::atomic<Counters*> slots_[kMaxThreads + 1] = {};
+};
+
+//所有ContentionSite的登记表，用来找出竞争最激烈的对象
+class ContentionProfiler {
+ public:
+  static ContentionProfiler* Instance();
+
+  std::vector<ContentionStats> Snapshot();
+  //按等待时间之和从大到小排列，等待时间相同的按CAS失败次数和空转次数
+  std::vector<ContentionStats> Top(size_t n);
+  //前n个对象的文本报告
+  std::string Dump(size_t n = 10);
+  void Reset();
+
+ private:
+  friend class ContentionSite;
+  ContentionProfiler() = default;
+  void Register(ContentionSite* site);
+  void Unregister(ContentionSite* site);
+
+  std::mutex mutex_;
+  std::vector<ContentionSite*> sites_;
+};
+
+//只有定义了CYBER_CONTENTION_PROFILE编译时才统计，否则包在宏里的语句全部编译掉。
+//该宏会改变BoundedQueue、AtomicRWLock的内存布局，所有源文件必须使用相同的定义编译。
+#ifdef CYBER_CONTENTION_PROFILE
+#define CYBER_CONTENTION(...) __VA_ARGS__
+#else
+#define CYBER_CONTENTION(...)
+#endif
+
+#endif  // CYBER_COMMON_CONTENTION_PROFILER_H_
@@ -0,0 +1,142 @@
+//以-DCYBER_CONTENTION_PROFILE编译
+#include "contention_profiler.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "atomic_rw_lock.h"
+#include "bounded_queue.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+const ContentionStats* Find(const std::vector<ContentionStats>& all,
+                            const std::string& name) {
+  for (auto& stats : all) {
+    if (stats.name == name) {
+      return &stats;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST(ContentionProfiler, HistogramBuckets) {
+  ContentionHistogram h;
+  //1ns、3ns各一次，1000ns两次
+  h.count = 4;
+  h.buckets[0] = 1;
+  h.buckets[1] = 1;
+  h.buckets[9] = 2;
+  EXPECT_EQ(h.Percentile(0.25), 2u);
+  EXPECT_EQ(h.Percentile(0.5), 4u);
+  EXPECT_EQ(h.Percentile(0.99), 1024u);
+  ContentionHistogram other;
+  other.count = 1;
+  other.buckets[9] = 1;
+  h.Merge(other);
+  EXPECT_EQ(h.count, 5u);
+  EXPECT_EQ(h.buckets[9], 3u);
+}
+
+//每个线程写自己的计数器，线程退出之后读取时合并
+TEST(ContentionProfiler, MergesPerThreadCounters) {
+  constexpr int kThreads = 4;
+  constexpr int kLoops = 1000;
+  ContentionSite site("Test");
+  site.SetName("merge");
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&site]() {
+      for (int i = 0; i < kLoops; ++i) {
+        site.CasFailure();
+        site.Spin(2);
+        site.RecordWait(100);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  auto stats = site.Snapshot();
+  EXPECT_EQ(stats.name, "merge");
+  EXPECT_EQ(stats.cas_failures, static_cast<uint64_t>(kThreads * kLoops));
+  EXPECT_EQ(stats.spins, static_cast<uint64_t>(2 * kThreads * kLoops));
+  EXPECT_EQ(stats.wait.count, static_cast<uint64_t>(kThreads * kLoops));
+  site.Reset();
+  EXPECT_EQ(site.Snapshot().cas_failures, 0u);
+}
+
+TEST(ContentionProfiler, QueueWaits) {
+  BoundedQueue<int> queue;
+  ASSERT_TRUE(queue.Init(1, new SleepWaitStrategy(1000)));
+  queue.SetName("tiny_queue");
+  ASSERT_TRUE(queue.Enqueue(1));
+  //队列满，生产者等到消费者取走元素
+  std::thread producer([&queue]() { EXPECT_TRUE(queue.WaitEnqueue(2)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  int value = 0;
+  ASSERT_TRUE(queue.Dequeue(&value));
+  producer.join();
+  ASSERT_TRUE(queue.Dequeue(&value));
+  //队列空，消费者等到生产者放入元素
+  std::thread consumer([&queue]() {
+    int v = 0;
+    EXPECT_TRUE(queue.WaitDequeue(&v));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_TRUE(queue.Enqueue(3));
+  consumer.join();
+
+  auto all = ContentionProfiler::Instance()->Snapshot();
+  auto stats = Find(all, "tiny_queue");
+  ASSERT_NE(stats, nullptr);
+  EXPECT_EQ(stats->full_wait.count, 1u);
+  EXPECT_EQ(stats->empty_wait.count, 1u);
+  EXPECT_GT(stats->yields, 0u);
+  EXPECT_GE(stats->full_wait.total_ns, 10000000u);
+  EXPECT_GE(stats->empty_wait.total_ns, 10000000u);
+  //等待时间最长的排在前面
+  auto top = ContentionProfiler::Instance()->Top(1);
+  ASSERT_EQ(top.size(), 1u);
+  EXPECT_EQ(top[0].name, "tiny_queue");
+  EXPECT_NE(ContentionProfiler::Instance()->Dump(1).find("tiny_queue"),
+            std::string::npos);
+}
+
+TEST(ContentionProfiler, RWLockHoldAndWait) {
+  constexpr int kThreads = 2;
+  constexpr int kLoops = 2000;
+  //读优先，嵌套加读锁时不会被等待中的写者卡住
+  AtomicRWLock lock(false);
+  lock.SetName("rw");
+  uint64_t value = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < kLoops; ++i) {
+        if (i % 2 == 0) {
+          WriteLockGuard<AtomicRWLock> guard(lock);
+          value++;
+        } else {
+          ReadLockGuard<AtomicRWLock> outer(lock);
+          ReadLockGuard<AtomicRWLock> inner(lock);
+          volatile uint64_t read = value;
+          (void)read;
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  auto all = ContentionProfiler::Instance()->Snapshot();
+  auto stats = Find(all, "rw");
+  ASSERT_NE(stats, nullptr);
+  //每次写锁一次、每次读锁两层，各自记录一次等待和一次持有
+  uint64_t acquisitions = kThreads * (kLoops / 2 + kLoops);
+  EXPECT_EQ(stats->wait.count, acquisitions);
+  EXPECT_EQ(stats->hold.count, acquisitions);
+}
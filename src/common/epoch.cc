@@ -0,0 +1,262 @@
+#include "epoch.h"
+
+#include <stdlib.h>
+
+#include <cstdlib>
+#include <new>
+
+constexpr size_t RetireBatch::kCapacity;
+constexpr size_t Epoch::kMaxFreeBatches;
+
+//线程退出时把没回收完的批交给pending_，由后台回收线程或者其他线程的Collect继续回收，
+//然后把记录标记为可复用
+struct EpochRecordReleaser {
+  EpochRecord* record = nullptr;
+  ~EpochRecordReleaser() {
+    if (record == nullptr) {
+      return;
+    }
+    Epoch* epoch = Epoch::Instance();
+    if (record->open != nullptr && record->open->count != 0) {
+      epoch->Seal(record);
+    }
+    if (record->open != nullptr) {
+      epoch->FreeBatch(record->open);
+      record->open = nullptr;
+    }
+    if (record->sealed != nullptr) {
+      RetireBatch* last = record->sealed;
+      while (last->next != nullptr) {
+        last = last->next;
+      }
+      epoch->PushPending(record->sealed, last);
+      record->sealed = nullptr;
+    }
+    Epoch::ThreadRecord() = nullptr;
+    record->in_use.store(false, std::memory_order_release);
+  }
+};
+
+namespace {
+
+thread_local EpochRecordReleaser releaser;
+
+}  // namespace
+
+Epoch* Epoch::Instance() {
+  //成员按缓存行对齐，用静态对象而不是new
+  static Epoch instance;
+  return &instance;
+}
+
+Epoch::~Epoch() { StopReclaimer(); }
+
+EpochRecord* Epoch::Register() {
+  EpochRecord* record = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    for (auto r = records_.load(std::memory_order_acquire); r != nullptr;
+         r = r->next) {
+      if (!r->in_use.load(std::memory_order_acquire)) {
+        record = r;
+        break;
+      }
+    }
+    if (record == nullptr) {
+      //C++14的new不保证按缓存行对齐
+      void* memory = nullptr;
+      if (posix_memalign(&memory, CACHELINE_SIZE, sizeof(EpochRecord)) != 0) {
+        std::abort();
+      }
+      record = new (memory) EpochRecord();
+      record->next = records_.load(std::memory_order_relaxed);
+      records_.store(record, std::memory_order_release);
+    }
+    record->in_use.store(true, std::memory_order_relaxed);
+  }
+  ThreadRecord() = record;
+  releaser.record = record;
+  return record;
+}
+
+void Epoch::Retire(void* ptr, void (*deleter)(void*)) {
+  EpochRecord* record = ThreadRecord();
+  if (cyber_unlikely(record == nullptr)) {
+    record = Register();
+  }
+  if (cyber_unlikely(record->open == nullptr)) {
+    record->open = NewBatch();
+  }
+  RetireBatch* batch = record->open;
+  batch->nodes[batch->count++] = {ptr, deleter};
+  if (batch->count == RetireBatch::kCapacity) {
+    Seal(record);
+  }
+}
+
+void Epoch::Seal(EpochRecord* record) {
+  RetireBatch* batch = record->open;
+  record->open = nullptr;
+  //摘下节点的写必须先于读取全局epoch
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  batch->epoch = global_.load(std::memory_order_relaxed);
+  if (reclaimer_running_.load(std::memory_order_acquire)) {
+    PushPending(batch, batch);
+    return;
+  }
+  batch->next = record->sealed;
+  record->sealed = batch;
+  TryAdvance();
+  ReclaimLocal(record);
+}
+
+void Epoch::Collect() {
+  EpochRecord* record = ThreadRecord();
+  if (record != nullptr && record->open != nullptr &&
+      record->open->count != 0) {
+    Seal(record);
+  }
+  TryAdvance();
+  if (record != nullptr) {
+    ReclaimLocal(record);
+  }
+  ReclaimPending();
+}
+
+size_t Epoch::PendingCount() {
+  EpochRecord* record = ThreadRecord();
+  if (record == nullptr) {
+    return 0;
+  }
+  size_t count = record->open == nullptr ? 0 : record->open->count;
+  for (auto batch = record->sealed; batch != nullptr; batch = batch->next) {
+    count += batch->count;
+  }
+  return count;
+}
+
+bool Epoch::TryAdvance() {
+  uint64_t epoch = global_.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  for (auto r = records_.load(std::memory_order_acquire); r != nullptr;
+       r = r->next) {
+    uint64_t state = r->state.load(std::memory_order_acquire);
+    if ((state & 1) != 0 && (state >> 1) != epoch) {
+      return false;
+    }
+  }
+  return global_.compare_exchange_strong(epoch, epoch + 1,
+                                         std::memory_order_acq_rel);
+}
+
+void Epoch::ReclaimLocal(EpochRecord* record) {
+  uint64_t epoch = global_.load(std::memory_order_acquire);
+  //链表从新到旧，找到第一个可以回收的批，它后面的都更旧
+  RetireBatch** link = &record->sealed;
+  while (*link != nullptr && (*link)->epoch + 2 > epoch) {
+    link = &(*link)->next;
+  }
+  RetireBatch* batch = *link;
+  *link = nullptr;
+  while (batch != nullptr) {
+    RetireBatch* next = batch->next;
+    FreeBatch(batch);
+    batch = next;
+  }
+}
+
+void Epoch::ReclaimPending() {
+  if (pending_.load(std::memory_order_relaxed) == nullptr) {
+    return;
+  }
+  RetireBatch* batch = pending_.exchange(nullptr, std::memory_order_acquire);
+  uint64_t epoch = global_.load(std::memory_order_acquire);
+  RetireBatch* keep_first = nullptr;
+  RetireBatch* keep_last = nullptr;
+  while (batch != nullptr) {
+    RetireBatch* next = batch->next;
+    if (batch->epoch + 2 <= epoch) {
+      FreeBatch(batch);
+    } else {
+      batch->next = keep_first;
+      keep_first = batch;
+      if (keep_last == nullptr) {
+        keep_last = batch;
+      }
+    }
+    batch = next;
+  }
+  if (keep_first != nullptr) {
+    PushPending(keep_first, keep_last);
+  }
+}
+
+void Epoch::PushPending(RetireBatch* first, RetireBatch* last) {
+  RetireBatch* head = pending_.load(std::memory_order_relaxed);
+  do {
+    last->next = head;
+  } while (!pending_.compare_exchange_weak(head, first,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+}
+
+void Epoch::FreeBatch(RetireBatch* batch) {
+  for (size_t i = 0; i < batch->count; ++i) {
+    batch->nodes[i].deleter(batch->nodes[i].ptr);
+  }
+  reclaimed_.fetch_add(batch->count, std::memory_order_relaxed);
+  batch->count = 0;
+  while (free_lock_.test_and_set(std::memory_order_acquire)) {
+  }
+  if (free_count_ < kMaxFreeBatches) {
+    batch->next = free_batches_;
+    free_batches_ = batch;
+    ++free_count_;
+    batch = nullptr;
+  }
+  free_lock_.clear(std::memory_order_release);
+  delete batch;
+}
+
+RetireBatch* Epoch::NewBatch() {
+  while (free_lock_.test_and_set(std::memory_order_acquire)) {
+  }
+  RetireBatch* batch = free_batches_;
+  if (batch != nullptr) {
+    free_batches_ = batch->next;
+    --free_count_;
+  }
+  free_lock_.clear(std::memory_order_release);
+  if (batch == nullptr) {
+    batch = new RetireBatch();
+  }
+  batch->next = nullptr;
+  return batch;
+}
+
+void Epoch::StartReclaimer(std::chrono::microseconds interval) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  if (reclaimer_running_.load()) {
+    return;
+  }
+  reclaimer_running_.store(true, std::memory_order_release);
+  reclaimer_ = std::thread([this, interval]() {
+    while (reclaimer_running_.load(std::memory_order_acquire)) {
+      TryAdvance();
+      ReclaimPending();
+      std::this_thread::sleep_for(interval);
+    }
+  });
+}
+
+void Epoch::StopReclaimer() {
+  std::thread reclaimer;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (!reclaimer_running_.exchange(false)) {
+      return;
+    }
+    reclaimer.swap(reclaimer_);
+  }
+  reclaimer.join();
+}
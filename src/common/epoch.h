@@ -0,0 +1,148 @@
+#ifndef CYBER_COMMON_EPOCH_H_
+#define CYBER_COMMON_EPOCH_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "macros.h"
+
+//已经从数据结构中摘下、等待安全释放的节点
+struct RetiredNode {
+  void* ptr;
+  void (*deleter)(void*);
+};
+
+//待释放节点按批处理：攒满一批才读一次全局epoch、尝试一次回收，批本身也循环使用
+struct RetireBatch {
+  static constexpr size_t kCapacity = 64;
+  RetiredNode nodes[kCapacity];
+  size_t count = 0;
+  //封存这一批时看到的全局epoch，批里的节点都在这之前被摘下
+  uint64_t epoch = 0;
+  RetireBatch* next = nullptr;
+};
+
+//每个线程一个的epoch记录，线程退出后可以被新线程复用
+struct alignas(CACHELINE_SIZE) EpochRecord {
+  //最低位为1表示处于临界区，其余位是进入临界区时看到的全局epoch
+  std::atomic<uint64_t> state = {0};
+  std::atomic<bool> in_use = {false};
+  //以下字段只有所属线程访问
+  uint32_t nesting = 0;
+  //正在填充的批
+  RetireBatch* open = nullptr;
+  //已经封存、由本线程回收的批，新封存的在链表头部
+  RetireBatch* sealed = nullptr;
+  EpochRecord* next = nullptr;
+};
+
+//基于epoch的内存回收（Epoch-Based Reclamation）。
+//读者进入临界区时记下当前的全局epoch；所有处于临界区的线程都已经看到全局epoch e之后，
+//全局epoch才能推进到e+1。节点在epoch t被摘下，等全局epoch推进到t+2时，
+//摘下节点之前进入临界区的线程都已经退出，节点可以安全释放或复用。
+//临界区的进入和退出只有线程局部的读写和一次内存屏障，没有共享变量上的读改写。
+//临界区很长（比如会阻塞）时会拖住所有节点的回收，这种场景用HazardPointer。
+class Epoch {
+ public:
+  static Epoch* Instance();
+
+  static void Enter() {
+    EpochRecord* record = ThreadRecord();
+    if (cyber_unlikely(record == nullptr)) {
+      record = Instance()->Register();
+    }
+    if (record->nesting++ != 0) {
+      return;
+    }
+    std::atomic<uint64_t>& global = Instance()->global_;
+    uint64_t epoch = global.load(std::memory_order_relaxed);
+    for (;;) {
+      record->state.store((epoch << 1) | 1, std::memory_order_release);
+      //保证后面对共享指针的读不会重排到state的写之前
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      uint64_t now = global.load(std::memory_order_relaxed);
+      if (cyber_likely(now == epoch)) {
+        break;
+      }
+      //进入的过程中全局epoch推进了，记旧的值虽然安全但会阻止epoch继续推进
+      epoch = now;
+    }
+  }
+
+  static void Exit() {
+    EpochRecord* record = ThreadRecord();
+    if (--record->nesting == 0) {
+      record->state.store(0, std::memory_order_release);
+    }
+  }
+
+  //ptr已经从数据结构中摘下，等没有线程能再访问到它时调用deleter(ptr)。
+  //deleter可能在任意一个调用过Retire的线程或者后台回收线程上执行，deleter里不能再调用Retire。
+  void Retire(void* ptr, void (*deleter)(void*));
+  //封存本线程未满的批，尝试推进全局epoch，并释放已经安全的节点
+  void Collect();
+  uint64_t GlobalEpoch() const {
+    return global_.load(std::memory_order_acquire);
+  }
+  //本线程还没有释放的节点个数
+  size_t PendingCount();
+  //所有处于临界区的线程都已经看到当前的全局epoch时把它加一，否则返回false。
+  //自己管理待回收节点的数据结构用它推进epoch，节点在epoch t摘下，全局epoch到t+2后可以复用
+  bool TryAdvance();
+
+  //启动后台回收线程：封存的批交给它回收，Retire的线程不再自己推进epoch和调用deleter
+  void StartReclaimer(std::chrono::microseconds interval);
+  void StopReclaimer();
+  //后台回收线程和Collect已经释放的节点总数
+  uint64_t ReclaimedCount() const {
+    return reclaimed_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  friend struct EpochRecordReleaser;
+
+  Epoch() = default;
+  ~Epoch();
+  EpochRecord* Register();
+  void Seal(EpochRecord* record);
+  void ReclaimLocal(EpochRecord* record);
+  void ReclaimPending();
+  void PushPending(RetireBatch* first, RetireBatch* last);
+  void FreeBatch(RetireBatch* batch);
+  RetireBatch* NewBatch();
+
+  //空闲批缓存的上限
+  static constexpr size_t kMaxFreeBatches = 256;
+
+  static EpochRecord*& ThreadRecord() {
+    static thread_local EpochRecord* record = nullptr;
+    return record;
+  }
+
+  alignas(CACHELINE_SIZE) std::atomic<uint64_t> global_ = {0};
+  //记录只增不删，遍历时不需要加锁
+  alignas(CACHELINE_SIZE) std::atomic<EpochRecord*> records_ = {nullptr};
+  //交给后台回收线程的批，以及退出线程留下的批
+  alignas(CACHELINE_SIZE) std::atomic<RetireBatch*> pending_ = {nullptr};
+  std::atomic<uint64_t> reclaimed_ = {0};
+  std::atomic<bool> reclaimer_running_ = {false};
+  std::thread reclaimer_;
+  std::mutex mutex_;
+  std::atomic_flag free_lock_ = ATOMIC_FLAG_INIT;
+  RetireBatch* free_batches_ = nullptr;
+  size_t free_count_ = 0;
+};
+
+class EpochGuard {
+ public:
+  EpochGuard() { Epoch::Enter(); }
+  ~EpochGuard() { Epoch::Exit(); }
+  EpochGuard(const EpochGuard&) = delete;
+  EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+#endif  // CYBER_COMMON_EPOCH_H_
@@ -0,0 +1,130 @@
+//Epoch和HazardPointer的开销：
+//1、临界区进入+退出（EpochGuard）和一次保护+清除（HazardPointer::Protect/Reset）的耗时
+//2、多个线程不停Retire时的回收吞吐量：Retire的线程自己回收、后台线程回收、hazard pointer
+//用法：epoch_benchmark [nodes_per_thread]
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "epoch.h"
+#include "hazard_pointer.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Node {
+  uint64_t value = 0;
+};
+
+std::atomic<Node*> shared = {nullptr};
+
+void DeleteNode(void* ptr) { delete static_cast<Node*>(ptr); }
+
+double Seconds(Clock::time_point begin) {
+  return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+void GuardCost() {
+  constexpr int kLoops = 20000000;
+  uint64_t sum = 0;
+  auto begin = Clock::now();
+  for (int i = 0; i < kLoops; ++i) {
+    EpochGuard guard;
+    sum += shared.load(std::memory_order_acquire)->value;
+  }
+  printf("EpochGuard enter+exit:           %6.1f ns\n",
+         Seconds(begin) * 1e9 / kLoops);
+
+  begin = Clock::now();
+  {
+    EpochGuard outer;
+    for (int i = 0; i < kLoops; ++i) {
+      EpochGuard guard;
+      sum += shared.load(std::memory_order_acquire)->value;
+    }
+  }
+  printf("EpochGuard nested enter+exit:    %6.1f ns\n",
+         Seconds(begin) * 1e9 / kLoops);
+
+  HazardPointer hp;
+  begin = Clock::now();
+  for (int i = 0; i < kLoops; ++i) {
+    sum += hp.Protect(shared)->value;
+    hp.Reset();
+  }
+  printf("HazardPointer protect+reset:     %6.1f ns\n",
+         Seconds(begin) * 1e9 / kLoops);
+
+  begin = Clock::now();
+  for (int i = 0; i < kLoops; ++i) {
+    sum += shared.load(std::memory_order_acquire)->value;
+  }
+  printf("unprotected load:                %6.1f ns (%llu)\n",
+         Seconds(begin) * 1e9 / kLoops, static_cast<unsigned long long>(sum));
+}
+
+enum class Mode { kInline, kBackground, kHazard };
+
+//threads个线程各自分配并Retire nodes个节点，直到全部释放为止
+double Reclaim(Mode mode, int threads, int nodes) {
+  uint64_t reclaimed = Epoch::Instance()->ReclaimedCount();
+  if (mode == Mode::kBackground) {
+    Epoch::Instance()->StartReclaimer(std::chrono::microseconds(100));
+  }
+  auto begin = Clock::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([mode, nodes]() {
+      for (int i = 0; i < nodes; ++i) {
+        if (mode == Mode::kHazard) {
+          HazardPointers::Instance()->Retire(new Node(), &DeleteNode);
+        } else {
+          EpochGuard guard;
+          Epoch::Instance()->Retire(new Node(), &DeleteNode);
+        }
+      }
+      if (mode == Mode::kHazard) {
+        HazardPointers::Instance()->Scan();
+      }
+    });
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+  uint64_t total = static_cast<uint64_t>(threads) * nodes;
+  if (mode != Mode::kHazard) {
+    while (Epoch::Instance()->ReclaimedCount() - reclaimed < total) {
+      Epoch::Instance()->Collect();
+      std::this_thread::yield();
+    }
+  }
+  double seconds = Seconds(begin);
+  if (mode == Mode::kBackground) {
+    Epoch::Instance()->StopReclaimer();
+  }
+  return total / seconds / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int nodes = argc > 1 ? atoi(argv[1]) : 1000000;
+  shared.store(new Node());
+  GuardCost();
+  printf("\n%-8s %14s %14s %14s\n", "threads", "epoch Mnode/s",
+         "bg epoch", "hazard");
+  for (int threads : {1, 2, 4, 8}) {
+    double inline_rate = Reclaim(Mode::kInline, threads, nodes / threads);
+    double background_rate =
+        Reclaim(Mode::kBackground, threads, nodes / threads);
+    double hazard_rate = Reclaim(Mode::kHazard, threads, nodes / threads);
+    printf("%-8d %14.2f %14.2f %14.2f\n", threads, inline_rate,
+           background_rate, hazard_rate);
+  }
+  return 0;
+}
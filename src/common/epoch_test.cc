@@ -0,0 +1,132 @@
+#include "epoch.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+constexpr uint64_t kAlive = 0x600dcafe;
+
+struct Node {
+  uint64_t magic = kAlive;
+  uint64_t value = 0;
+};
+
+std::atomic<uint64_t> deleted = {0};
+
+void DeleteNode(void* ptr) {
+  auto node = static_cast<Node*>(ptr);
+  //释放之前先破坏掉，过早释放时读者能直接看到
+  node->magic = 0;
+  delete node;
+  deleted++;
+}
+
+}  // namespace
+
+TEST(Epoch, GuardDefersReclaim) {
+  uint64_t before = deleted.load();
+  std::atomic<int> step = {0};
+  std::thread reader([&]() {
+    EpochGuard guard;
+    step = 1;
+    while (step.load() != 2) {
+      std::this_thread::yield();
+    }
+  });
+  while (step.load() != 1) {
+    std::this_thread::yield();
+  }
+  Epoch::Instance()->Retire(new Node(), &DeleteNode);
+  for (int i = 0; i < 10; ++i) {
+    Epoch::Instance()->Collect();
+  }
+  EXPECT_EQ(deleted.load(), before);
+  EXPECT_EQ(Epoch::Instance()->PendingCount(), 1u);
+  step = 2;
+  reader.join();
+  for (int i = 0; i < 3; ++i) {
+    Epoch::Instance()->Collect();
+  }
+  EXPECT_EQ(deleted.load(), before + 1);
+  EXPECT_EQ(Epoch::Instance()->PendingCount(), 0u);
+}
+
+//读者在临界区内反复读取共享节点，写者不停替换节点并Retire旧节点。
+//过早释放会让读者读到被破坏的magic，ThreadSanitizer下还会报告对已释放内存的访问。
+TEST(Epoch, StressReadersAndWriters) {
+  constexpr int kReaders = 4;
+  constexpr int kWriters = 2;
+  constexpr int kReplacements = 20000;
+  std::atomic<Node*> shared = {new Node()};
+  std::atomic<bool> stop = {false};
+  std::atomic<uint64_t> corrupted = {0};
+  uint64_t before = deleted.load();
+  std::vector<std::thread> threads;
+  for (int r = 0; r < kReaders; ++r) {
+    threads.emplace_back([&]() {
+      while (!stop.load(std::memory_order_relaxed)) {
+        EpochGuard guard;
+        Node* node = shared.load(std::memory_order_acquire);
+        if (node->magic != kAlive) {
+          corrupted++;
+        }
+        volatile uint64_t value = node->value;
+        (void)value;
+      }
+    });
+  }
+  std::vector<std::thread> writers;
+  for (int w = 0; w < kWriters; ++w) {
+    writers.emplace_back([&]() {
+      for (int i = 0; i < kReplacements; ++i) {
+        auto node = new Node();
+        node->value = i;
+        if (i % 64 == 0) {
+          std::this_thread::yield();
+        }
+        Node* old = shared.exchange(node, std::memory_order_acq_rel);
+        Epoch::Instance()->Retire(old, &DeleteNode);
+      }
+    });
+  }
+  for (auto& t : writers) {
+    t.join();
+  }
+  stop = true;
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(corrupted.load(), 0u);
+  //写者退出时没释放完的批留给了Collect
+  for (int i = 0; i < 3; ++i) {
+    Epoch::Instance()->Collect();
+  }
+  EXPECT_EQ(deleted.load() - before,
+            static_cast<uint64_t>(kWriters) * kReplacements);
+  DeleteNode(shared.load());
+}
+
+TEST(Epoch, BackgroundReclaimer) {
+  constexpr int kNodes = 10000;
+  uint64_t before = deleted.load();
+  Epoch::Instance()->StartReclaimer(std::chrono::microseconds(200));
+  std::thread writer([]() {
+    for (int i = 0; i < kNodes; ++i) {
+      Epoch::Instance()->Retire(new Node(), &DeleteNode);
+    }
+  });
+  writer.join();
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (deleted.load() - before < kNodes &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  Epoch::Instance()->StopReclaimer();
+  EXPECT_EQ(deleted.load() - before, static_cast<uint64_t>(kNodes));
+}
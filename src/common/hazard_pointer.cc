@@ -0,0 +1,139 @@
+#include "hazard_pointer.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "log.h"
+
+constexpr int HazardRecord::kSlots;
+constexpr size_t HazardPointers::kScanThreshold;
+
+//线程退出时把没释放的节点交给orphans_，由其他线程的Scan继续回收，然后把记录标记为可复用
+struct HazardRecordReleaser {
+  HazardRecord* record = nullptr;
+  ~HazardRecordReleaser() {
+    if (record == nullptr) {
+      return;
+    }
+    HazardPointers* hp = HazardPointers::Instance();
+    hp->Scan();
+    if (!record->retired.empty()) {
+      std::lock_guard<std::mutex> lk(hp->mutex_);
+      hp->orphans_.insert(hp->orphans_.end(), record->retired.begin(),
+                          record->retired.end());
+      hp->orphan_count_.store(hp->orphans_.size(), std::memory_order_release);
+      record->retired.clear();
+    }
+    HazardPointers::ThreadRecordRef() = nullptr;
+    record->in_use.store(false, std::memory_order_release);
+  }
+};
+
+namespace {
+
+thread_local HazardRecordReleaser releaser;
+
+}  // namespace
+
+HazardPointers* HazardPointers::Instance() {
+  static HazardPointers* instance = new HazardPointers();
+  return instance;
+}
+
+HazardRecord* HazardPointers::Register() {
+  HazardRecord* record = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    for (auto r = records_.load(std::memory_order_acquire); r != nullptr;
+         r = r->next) {
+      if (!r->in_use.load(std::memory_order_acquire)) {
+        record = r;
+        break;
+      }
+    }
+    if (record == nullptr) {
+      //C++14的new不保证按缓存行对齐
+      void* memory = nullptr;
+      if (posix_memalign(&memory, CACHELINE_SIZE, sizeof(HazardRecord)) != 0) {
+        std::abort();
+      }
+      record = new (memory) HazardRecord();
+      record->next = records_.load(std::memory_order_relaxed);
+      records_.store(record, std::memory_order_release);
+    }
+    record->in_use.store(true, std::memory_order_relaxed);
+  }
+  ThreadRecordRef() = record;
+  releaser.record = record;
+  return record;
+}
+
+void HazardPointers::Retire(void* ptr, void (*deleter)(void*)) {
+  HazardRecord* record = ThreadRecord();
+  record->retired.push_back({ptr, deleter});
+  if (record->retired.size() >= kScanThreshold) {
+    Scan();
+  }
+}
+
+void HazardPointers::Scan() {
+  HazardRecord* record = ThreadRecord();
+  if (orphan_count_.load(std::memory_order_acquire) != 0) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    record->retired.insert(record->retired.end(), orphans_.begin(),
+                           orphans_.end());
+    orphans_.clear();
+    orphan_count_.store(0, std::memory_order_relaxed);
+  }
+  //摘下节点的写必须先于读取槽位
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  auto& hazards = record->hazards;
+  hazards.clear();
+  for (auto r = records_.load(std::memory_order_acquire); r != nullptr;
+       r = r->next) {
+    for (auto& slot : r->slots) {
+      void* ptr = slot.load(std::memory_order_acquire);
+      if (ptr != nullptr) {
+        hazards.push_back(ptr);
+      }
+    }
+  }
+  std::sort(hazards.begin(), hazards.end());
+  auto& retired = record->retired;
+  size_t kept = 0;
+  for (size_t i = 0; i < retired.size(); ++i) {
+    if (std::binary_search(hazards.begin(), hazards.end(), retired[i].ptr)) {
+      retired[kept++] = retired[i];
+    } else {
+      retired[i].deleter(retired[i].ptr);
+    }
+  }
+  retired.resize(kept);
+}
+
+size_t HazardPointers::PendingCount() {
+  return ThreadRecord()->retired.size();
+}
+
+HazardPointer::HazardPointer() : record_(HazardPointers::ThreadRecord()) {
+  for (index_ = 0; index_ < HazardRecord::kSlots; ++index_) {
+    if ((record_->used_mask & (1u << index_)) == 0) {
+      break;
+    }
+  }
+  if (index_ == HazardRecord::kSlots) {
+    AERROR << "a thread can hold at most " << HazardRecord::kSlots
+           << " hazard pointers";
+    std::abort();
+  }
+  record_->used_mask |= 1u << index_;
+  slot_ = &record_->slots[index_];
+}
+
+HazardPointer::~HazardPointer() {
+  Reset();
+  record_->used_mask &= ~(1u << index_);
+}
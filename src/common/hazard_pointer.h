@@ -0,0 +1,107 @@
+#ifndef CYBER_COMMON_HAZARD_POINTER_H_
+#define CYBER_COMMON_HAZARD_POINTER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "epoch.h"
+#include "macros.h"
+
+//每个线程一个的hazard pointer记录，线程退出后可以被新线程复用
+struct alignas(CACHELINE_SIZE) HazardRecord {
+  static constexpr int kSlots = 4;
+  std::atomic<void*> slots[kSlots];
+  std::atomic<bool> in_use = {false};
+  //以下字段只有所属线程访问
+  uint32_t used_mask = 0;
+  std::vector<RetiredNode> retired;
+  //Scan时收集到的槽位内容，复用容量避免每次分配
+  std::vector<void*> hazards;
+  HazardRecord* next = nullptr;
+
+  HazardRecord() {
+    for (auto& slot : slots) {
+      slot.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+};
+
+//Hazard pointer内存回收。
+//读者在访问节点之前把节点地址发布到自己的槽位里，回收时跳过所有槽位中出现的节点。
+//和Epoch相比，每次保护都要一次内存屏障，但一个读者只拖住它正在保护的那几个节点，
+//适合临界区很长、或者在临界区里会阻塞的场景。
+class HazardPointers {
+ public:
+  static HazardPointers* Instance();
+
+  //ptr已经从数据结构中摘下，等没有槽位保护它时调用deleter(ptr)，deleter里不能再调用Retire
+  void Retire(void* ptr, void (*deleter)(void*));
+  //释放本线程（以及退出线程留下的）所有没有被保护的节点
+  void Scan();
+  //本线程还没有释放的节点个数
+  size_t PendingCount();
+
+ private:
+  friend class HazardPointer;
+  friend struct HazardRecordReleaser;
+
+  HazardPointers() = default;
+  HazardRecord* Register();
+  static HazardRecord* ThreadRecord() {
+    HazardRecord* record = ThreadRecordRef();
+    if (cyber_unlikely(record == nullptr)) {
+      record = Instance()->Register();
+    }
+    return record;
+  }
+  static HazardRecord*& ThreadRecordRef() {
+    static thread_local HazardRecord* record = nullptr;
+    return record;
+  }
+
+  //本线程积累了这么多待释放节点时扫描一次
+  static constexpr size_t kScanThreshold = 64;
+
+  std::atomic<HazardRecord*> records_ = {nullptr};
+  std::mutex mutex_;
+  //退出线程留下的节点
+  std::vector<RetiredNode> orphans_;
+  std::atomic<size_t> orphan_count_ = {0};
+};
+
+//占用本线程的一个槽位，析构时归还。每个线程最多同时持有HazardRecord::kSlots个。
+class HazardPointer {
+ public:
+  HazardPointer();
+  ~HazardPointer();
+  HazardPointer(const HazardPointer&) = delete;
+  HazardPointer& operator=(const HazardPointer&) = delete;
+
+  //读取src并保护读到的节点，返回之后节点在Reset或析构之前不会被释放
+  template <typename T>
+  T* Protect(const std::atomic<T*>& src) {
+    T* ptr = src.load(std::memory_order_relaxed);
+    for (;;) {
+      slot_->store(ptr, std::memory_order_release);
+      //槽位的写必须先于再次读取src
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      T* now = src.load(std::memory_order_acquire);
+      if (cyber_likely(now == ptr)) {
+        return ptr;
+      }
+      ptr = now;
+    }
+  }
+
+  void Reset() { slot_->store(nullptr, std::memory_order_release); }
+
+ private:
+  HazardRecord* record_;
+  int index_;
+  std::atomic<void*>* slot_;
+};
+
+#endif  // CYBER_COMMON_HAZARD_POINTER_H_
@@ -0,0 +1,101 @@
+#include "hazard_pointer.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+constexpr uint64_t kAlive = 0x600dcafe;
+
+struct Node {
+  uint64_t magic = kAlive;
+  uint64_t value = 0;
+};
+
+std::atomic<uint64_t> deleted = {0};
+
+void DeleteNode(void* ptr) {
+  auto node = static_cast<Node*>(ptr);
+  node->magic = 0;
+  delete node;
+  deleted++;
+}
+
+}  // namespace
+
+TEST(HazardPointer, ProtectedNodeSurvivesScan) {
+  std::atomic<Node*> shared = {new Node()};
+  uint64_t before = deleted.load();
+  HazardPointer hp;
+  Node* node = hp.Protect(shared);
+  shared.store(new Node());
+  HazardPointers::Instance()->Retire(node, &DeleteNode);
+  HazardPointers::Instance()->Scan();
+  EXPECT_EQ(deleted.load(), before);
+  EXPECT_EQ(node->magic, kAlive);
+  hp.Reset();
+  HazardPointers::Instance()->Scan();
+  EXPECT_EQ(deleted.load(), before + 1);
+  DeleteNode(shared.load());
+}
+
+//读者长时间持有保护，中途会阻塞；写者的回收只被当前保护的节点拖住
+TEST(HazardPointer, StressLongReaders) {
+  constexpr int kReaders = 4;
+  constexpr int kWriters = 2;
+  constexpr int kReplacements = 20000;
+  std::atomic<Node*> shared = {new Node()};
+  std::atomic<bool> stop = {false};
+  std::atomic<uint64_t> corrupted = {0};
+  uint64_t before = deleted.load();
+  std::vector<std::thread> readers;
+  for (int r = 0; r < kReaders; ++r) {
+    readers.emplace_back([&]() {
+      HazardPointer hp;
+      while (!stop.load(std::memory_order_relaxed)) {
+        Node* node = hp.Protect(shared);
+        for (int i = 0; i < 8; ++i) {
+          if (node->magic != kAlive) {
+            corrupted++;
+          }
+          std::this_thread::yield();
+        }
+        hp.Reset();
+      }
+    });
+  }
+  std::vector<std::thread> writers;
+  for (int w = 0; w < kWriters; ++w) {
+    writers.emplace_back([&]() {
+      for (int i = 0; i < kReplacements; ++i) {
+        auto node = new Node();
+        node->value = i;
+        if (i % 64 == 0) {
+          std::this_thread::yield();
+        }
+        Node* old = shared.exchange(node, std::memory_order_acq_rel);
+        HazardPointers::Instance()->Retire(old, &DeleteNode);
+      }
+      //扫描之后留下的只有读者正在保护的节点，每个读者最多一个
+      HazardPointers::Instance()->Scan();
+      EXPECT_LE(HazardPointers::Instance()->PendingCount(),
+                static_cast<size_t>(kReaders));
+    });
+  }
+  for (auto& t : writers) {
+    t.join();
+  }
+  stop = true;
+  for (auto& t : readers) {
+    t.join();
+  }
+  EXPECT_EQ(corrupted.load(), 0u);
+  //写者退出时没释放的节点留给了这里的Scan
+  HazardPointers::Instance()->Scan();
+  EXPECT_EQ(deleted.load() - before,
+            static_cast<uint64_t>(kWriters) * kReplacements);
+  DeleteNode(shared.load());
+}
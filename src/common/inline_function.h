@@ -0,0 +1,137 @@
+#ifndef CYBER_COMMON_INLINE_FUNCTION_H_
+#define CYBER_COMMON_INLINE_FUNCTION_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename Signature, size_t Capacity>
+class InlineFunction;
+
+//只能移动的std::function替代品，可调用对象不超过Capacity字节时直接存放在对象内部，不分配堆内存。
+//libstdc++的std::function只能内联16字节（两个指针），捕获了几个引用的lambda就需要一次malloc；
+//超过Capacity或者移动构造可能抛异常的可调用对象退化为放在堆上。
+template <typename R, typename... Args, size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+ public:
+  InlineFunction() = default;
+  InlineFunction(std::nullptr_t) {}  // NOLINT
+
+  template <typename F, typename D = typename std::decay<F>::type,
+            typename = typename std::enable_if<
+                !std::is_same<D, InlineFunction>::value &&
+                std::is_convertible<decltype(std::declval<D&>()(
+                                        std::declval<Args>()...)),
+                                    R>::value>::type>
+  InlineFunction(F&& f) {  // NOLINT
+    Init<D>(std::forward<F>(f), std::integral_constant<bool, FitsInline<D>()>());
+  }
+
+  InlineFunction(InlineFunction&& other) noexcept { MoveFrom(&other); }
+
+  InlineFunction& operator=(InlineFunction&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      MoveFrom(&other);
+    }
+    return *this;
+  }
+
+  ~InlineFunction() { Reset(); }
+
+  R operator()(Args... args) const {
+    return ops_->invoke(const_cast<char*>(storage_),
+                        std::forward<Args>(args)...);
+  }
+
+  explicit operator bool() const { return ops_ != nullptr; }
+
+  //可调用对象是否放在了对象内部
+  bool IsInline() const { return ops_ != nullptr && ops_->is_inline; }
+
+ private:
+  InlineFunction(const InlineFunction&) = delete;
+  InlineFunction& operator=(const InlineFunction&) = delete;
+
+  struct Ops {
+    R (*invoke)(void* storage, Args&&... args);
+    //把src中的可调用对象移动到dst并析构src中的对象
+    void (*relocate)(void* dst, void* src);
+    void (*destroy)(void* storage);
+    bool is_inline;
+  };
+
+  template <typename D>
+  static constexpr bool FitsInline() {
+    return sizeof(D) <= Capacity && alignof(D) <= alignof(std::max_align_t) &&
+           std::is_nothrow_move_constructible<D>::value;
+  }
+
+  template <typename D>
+  struct InlineOps {
+    static R Invoke(void* storage, Args&&... args) {
+      return (*static_cast<D*>(storage))(std::forward<Args>(args)...);
+    }
+    static void Relocate(void* dst, void* src) {
+      new (dst) D(std::move(*static_cast<D*>(src)));
+      static_cast<D*>(src)->~D();
+    }
+    static void Destroy(void* storage) { static_cast<D*>(storage)->~D(); }
+    static const Ops* Get() {
+      static const Ops ops = {&Invoke, &Relocate, &Destroy, true};
+      return &ops;
+    }
+  };
+
+  //堆上的可调用对象，storage_中只保存指针
+  template <typename D>
+  struct HeapOps {
+    static D* Ptr(void* storage) { return *static_cast<D**>(storage); }
+    static R Invoke(void* storage, Args&&... args) {
+      return (*Ptr(storage))(std::forward<Args>(args)...);
+    }
+    static void Relocate(void* dst, void* src) {
+      *static_cast<D**>(dst) = Ptr(src);
+    }
+    static void Destroy(void* storage) { delete Ptr(storage); }
+    static const Ops* Get() {
+      static const Ops ops = {&Invoke, &Relocate, &Destroy, false};
+      return &ops;
+    }
+  };
+
+  template <typename D, typename F>
+  void Init(F&& f, std::true_type) {
+    new (storage_) D(std::forward<F>(f));
+    ops_ = InlineOps<D>::Get();
+  }
+
+  template <typename D, typename F>
+  void Init(F&& f, std::false_type) {
+    *reinterpret_cast<D**>(storage_) = new D(std::forward<F>(f));
+    ops_ = HeapOps<D>::Get();
+  }
+
+  void MoveFrom(InlineFunction* other) {
+    if (other->ops_ != nullptr) {
+      other->ops_->relocate(storage_, other->storage_);
+      ops_ = other->ops_;
+      other->ops_ = nullptr;
+    }
+  }
+
+  void Reset() {
+    if (ops_ != nullptr) {
+      ops_->destroy(storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  static_assert(Capacity >= sizeof(void*), "capacity must hold a pointer");
+
+  alignas(std::max_align_t) char storage_[Capacity];
+  const Ops* ops_ = nullptr;
+};
+
+#endif  // CYBER_COMMON_INLINE_FUNCTION_H_
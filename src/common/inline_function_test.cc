@@ -0,0 +1,102 @@
+#include "inline_function.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "name_table.h"
+
+namespace {
+
+struct Counter {
+  explicit Counter(int* live) : live(live) { ++*live; }
+  Counter(Counter&& other) noexcept : live(other.live) { ++*live; }
+  ~Counter() { --*live; }
+  int operator()(int x) const { return x + 1; }
+  int* live;
+};
+
+}  // namespace
+
+TEST(InlineFunction, SmallCallableStaysInline) {
+  int a = 1;
+  int b = 2;
+  int c = 3;
+  //捕获三个引用的lambda是24字节，std::function放不下
+  InlineFunction<int(), 48> f = [&a, &b, &c]() { return a + b + c; };
+  EXPECT_TRUE(f.IsInline());
+  EXPECT_EQ(f(), 6);
+
+  InlineFunction<int(), 48> moved = std::move(f);
+  EXPECT_FALSE(static_cast<bool>(f));
+  EXPECT_TRUE(moved.IsInline());
+  EXPECT_EQ(moved(), 6);
+}
+
+TEST(InlineFunction, LargeCallableGoesToHeap) {
+  char payload[128] = {7};
+  InlineFunction<int(), 48> f = [payload]() { return payload[0]; };
+  EXPECT_FALSE(f.IsInline());
+  EXPECT_EQ(f(), 7);
+  InlineFunction<int(), 48> moved = std::move(f);
+  EXPECT_EQ(moved(), 7);
+
+  //只能移动的可调用对象也可以保存
+  std::unique_ptr<int> owned(new int(9));
+  InlineFunction<int(), 48> move_only = [p = std::move(owned)]() {
+    return *p;
+  };
+  EXPECT_EQ(move_only(), 9);
+}
+
+TEST(InlineFunction, DestroysCallable) {
+  int live = 0;
+  {
+    InlineFunction<int(int), 48> f = Counter(&live);
+    EXPECT_EQ(live, 1);
+    EXPECT_EQ(f(1), 2);
+    InlineFunction<int(int), 48> g = std::move(f);
+    EXPECT_EQ(live, 1);
+    g = nullptr;
+    EXPECT_EQ(live, 0);
+    g = Counter(&live);
+    EXPECT_EQ(live, 1);
+  }
+  EXPECT_EQ(live, 0);
+
+  std::function<void()> std_func = []() {};
+  InlineFunction<void(), 48> wrapped = std_func;
+  EXPECT_TRUE(wrapped.IsInline());
+  wrapped();
+}
+
+TEST(NameTable, InternReturnsSamePointer) {
+  std::string name = "component";
+  const std::string* first = NameTable::Intern(name);
+  const std::string* second = NameTable::Intern(std::string("compo") + "nent");
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(*first, "component");
+  const std::string* other = NameTable::Intern("other");
+  EXPECT_NE(other, first);
+  EXPECT_TRUE(NameTable::Empty()->empty());
+  NameTable::Release(first);
+  NameTable::Release(second);
+  NameTable::Release(other);
+}
+
+//最后一个引用释放后名字从表中删除
+TEST(NameTable, ReleaseRemovesUnusedNames) {
+  size_t before = NameTable::Size();
+  for (int i = 0; i < 1000; ++i) {
+    const std::string* name = NameTable::Intern("routine_" + std::to_string(i));
+    const std::string* again = NameTable::Intern(*name);
+    EXPECT_EQ(name, again);
+    NameTable::Release(again);
+    EXPECT_EQ(*name, "routine_" + std::to_string(i));
+    NameTable::Release(name);
+  }
+  EXPECT_EQ(NameTable::Size(), before);
+  NameTable::Release(NameTable::Empty());
+  EXPECT_TRUE(NameTable::Empty()->empty());
+}
@@ -0,0 +1,26 @@
+#ifndef CYBER_COMMON_LOG_H_
+#define CYBER_COMMON_LOG_H_
+
+#include <iostream>
+#include <sstream>
+
+//Apollo中的AINFO/AWARN/AERROR基于glog实现，这里简化为输出到标准错误，
+//保持相同的流式用法，每条日志结束时自动换行
+class LogMessage {
+ public:
+  explicit LogMessage(const char* level) { stream_ << level; }
+  ~LogMessage() {
+    stream_ << '\n';
+    std::cerr << stream_.str();
+  }
+  std::ostringstream& stream() { return stream_; }
+
+ private:
+  std::ostringstream stream_;
+};
+
+#define AINFO LogMessage("[INFO] ").stream()
+#define AWARN LogMessage("[WARN] ").stream()
+#define AERROR LogMessage("[ERROR] ").stream()
+
+#endif  // CYBER_COMMON_LOG_H_
@@ -0,0 +1,8 @@
+#ifndef CYBER_COMMON_MACROS_H_
+#define CYBER_COMMON_MACROS_H_
+
+#define CACHELINE_SIZE 64
+#define cyber_likely(x) (__builtin_expect((x), 1))
+#define cyber_unlikely(x) (__builtin_expect((x), 0))
+
+#endif  // CYBER_COMMON_MACROS_H_
@@ -0,0 +1,60 @@
+#ifndef CYBER_COMMON_NAME_TABLE_H_
+#define CYBER_COMMON_NAME_TABLE_H_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+//字符串驻留表：相同的名字只保存一份，创建协程时只做一次查表，不再为每个协程拷贝字符串。
+//每个名字带引用计数，Intern和Release成对调用，最后一次Release时名字从表中删除，
+//所以不断用新名字创建协程也不会让表无限增长。Empty()返回的空串一直有效，不需要Release。
+class NameTable {
+ public:
+  //返回的指针在对应的Release之前一直有效
+  static const std::string* Intern(const std::string& name) {
+    NameTable* table = Instance();
+    std::lock_guard<std::mutex> lk(table->mutex_);
+    auto it = table->names_.emplace(name, 0).first;
+    ++it->second;
+    return &it->first;
+  }
+
+  static void Release(const std::string* name) {
+    if (name == nullptr || name == Empty()) {
+      return;
+    }
+    NameTable* table = Instance();
+    std::lock_guard<std::mutex> lk(table->mutex_);
+    auto it = table->names_.find(*name);
+    if (it != table->names_.end() && --it->second == 0) {
+      table->names_.erase(it);
+    }
+  }
+
+  static const std::string* Empty() {
+    static const std::string* empty = Intern(std::string());
+    return empty;
+  }
+
+  //表中名字的个数
+  static size_t Size() {
+    NameTable* table = Instance();
+    std::lock_guard<std::mutex> lk(table->mutex_);
+    return table->names_.size();
+  }
+
+ private:
+  NameTable() = default;
+
+  static NameTable* Instance() {
+    static NameTable* table = new NameTable();
+    return table;
+  }
+
+  std::mutex mutex_;
+  //unordered_map的节点在rehash时不会移动，键的地址保持不变
+  std::unordered_map<std::string, uint32_t> names_;
+};
+
+#endif  // CYBER_COMMON_NAME_TABLE_H_
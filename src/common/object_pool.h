@@ -0,0 +1,206 @@
+#ifndef CYBER_COMMON_OBJECT_POOL_H_
+#define CYBER_COMMON_OBJECT_POOL_H_
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "macros.h"
+
+//预先分配capacity个对象槽位的无锁对象池，GetObject返回带侵入式引用计数的Handle，
+//最后一个Handle释放时析构对象，槽位回到空闲链表，整个过程不调用malloc/free。
+//空闲链表是Treiber栈：栈顶用一个64位原子变量保存“版本号<<32 | 槽位下标+1”，
+//每次修改都把版本号加一，槽位被取走又放回之后，旧的栈顶值CAS不会成功，避免了ABA。
+//槽位内存不归还给系统，对象池必须比它发出去的所有Handle活得长。
+template <typename T>
+class ObjectPool {
+  struct Node;
+
+ public:
+  //不拥有引用的8字节句柄，平凡可拷贝，用来在BoundedQueue这类按值拷贝元素的队列里传递对象：
+  //Handle::Detach()交出引用，收到的一方用Handle::Adopt()接管
+  class RawHandle {
+   public:
+    RawHandle() = default;
+    explicit operator bool() const { return node_ != nullptr; }
+
+   private:
+    friend class ObjectPool;
+    explicit RawHandle(Node* node) : node_(node) {}
+    Node* node_ = nullptr;
+  };
+
+  class Handle {
+   public:
+    Handle() = default;
+    Handle(const Handle& other) : node_(other.node_) {
+      if (node_ != nullptr) {
+        node_->refs.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    Handle(Handle&& other) noexcept : node_(other.node_) {
+      other.node_ = nullptr;
+    }
+    Handle& operator=(Handle other) noexcept {
+      std::swap(node_, other.node_);
+      return *this;
+    }
+    ~Handle() { reset(); }
+
+    //接管RawHandle代表的引用，每个Detach出来的RawHandle只能Adopt一次
+    static Handle Adopt(RawHandle raw) { return Handle(raw.node_); }
+    //交出引用，调用之后本Handle为空
+    RawHandle Detach() {
+      Node* node = node_;
+      node_ = nullptr;
+      return RawHandle(node);
+    }
+
+    void reset() {
+      if (node_ != nullptr) {
+        node_->pool->Release(node_);
+        node_ = nullptr;
+      }
+    }
+    T* get() const { return node_ == nullptr ? nullptr : node_->object(); }
+    T* operator->() const { return node_->object(); }
+    T& operator*() const { return *node_->object(); }
+    explicit operator bool() const { return node_ != nullptr; }
+    uint32_t use_count() const {
+      return node_ == nullptr ? 0 : node_->refs.load(std::memory_order_relaxed);
+    }
+
+   private:
+    friend class ObjectPool;
+    explicit Handle(Node* node) : node_(node) {}
+    Node* node_ = nullptr;
+  };
+
+ public:
+  explicit ObjectPool(uint32_t capacity);
+  ~ObjectPool();
+  ObjectPool(const ObjectPool&) = delete;
+  ObjectPool& operator=(const ObjectPool&) = delete;
+
+  //用args在空闲槽位上构造对象，池已经用完时返回空Handle
+  template <typename... Args>
+  Handle GetObject(Args&&... args);
+  uint32_t Capacity() const { return capacity_; }
+
+ private:
+  //每个槽位单独占缓存行，不同线程持有的对象的引用计数不会互相干扰
+  struct alignas(CACHELINE_SIZE) Node {
+    std::atomic<uint32_t> refs = {0};
+    //空闲时空闲链表中下一个槽位的下标+1，0表示链表结尾
+    std::atomic<uint32_t> next = {0};
+    ObjectPool* pool = nullptr;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+    T* object() { return reinterpret_cast<T*>(&storage); }
+  };
+
+  static uint64_t Pack(uint64_t tag, uint32_t index) {
+    return tag << 32 | index;
+  }
+  Node* Pop();
+  void Push(Node* node);
+  void Release(Node* node);
+
+  const uint32_t capacity_;
+  Node* nodes_ = nullptr;
+  alignas(CACHELINE_SIZE) std::atomic<uint64_t> free_head_ = {0};
+};
+
+template <typename T>
+ObjectPool<T>::ObjectPool(uint32_t capacity) : capacity_(capacity) {
+  void* mem = nullptr;
+  if (posix_memalign(&mem, CACHELINE_SIZE, sizeof(Node) * capacity_) != 0) {
+    throw std::bad_alloc();
+  }
+  nodes_ = static_cast<Node*>(mem);
+  for (uint32_t i = 0; i < capacity_; ++i) {
+    new (&nodes_[i]) Node();
+    nodes_[i].pool = this;
+    nodes_[i].next.store(i + 1 < capacity_ ? i + 2 : 0,
+                         std::memory_order_relaxed);
+  }
+  free_head_.store(capacity_ > 0 ? Pack(0, 1) : 0, std::memory_order_release);
+}
+
+template <typename T>
+ObjectPool<T>::~ObjectPool() {
+  //还没释放的对象在这里析构，之后再使用它们的Handle是未定义行为
+  for (uint32_t i = 0; i < capacity_; ++i) {
+    if (nodes_[i].refs.load(std::memory_order_acquire) != 0) {
+      nodes_[i].object()->~T();
+    }
+    nodes_[i].~Node();
+  }
+  free(nodes_);
+}
+
+template <typename T>
+typename ObjectPool<T>::Node* ObjectPool<T>::Pop() {
+  uint64_t head = free_head_.load(std::memory_order_acquire);
+  for (;;) {
+    uint32_t index = static_cast<uint32_t>(head);
+    if (index == 0) {
+      return nullptr;
+    }
+    Node* node = &nodes_[index - 1];
+    //node可能刚被别的线程取走，这时读到的next是旧值，但版本号变了，下面的CAS一定失败
+    uint32_t next = node->next.load(std::memory_order_relaxed);
+    if (free_head_.compare_exchange_weak(head, Pack((head >> 32) + 1, next),
+                                         std::memory_order_acquire,
+                                         std::memory_order_acquire)) {
+      return node;
+    }
+  }
+}
+
+template <typename T>
+void ObjectPool<T>::Push(Node* node) {
+  uint32_t index = static_cast<uint32_t>(node - nodes_) + 1;
+  uint64_t head = free_head_.load(std::memory_order_relaxed);
+  do {
+    node->next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+  } while (!free_head_.compare_exchange_weak(
+      head, Pack((head >> 32) + 1, index), std::memory_order_release,
+      std::memory_order_relaxed));
+}
+
+template <typename T>
+template <typename... Args>
+typename ObjectPool<T>::Handle ObjectPool<T>::GetObject(Args&&... args) {
+  Node* node = Pop();
+  if (cyber_unlikely(node == nullptr)) {
+    return Handle();
+  }
+  try {
+    new (&node->storage) T(std::forward<Args>(args)...);
+  } catch (...) {
+    Push(node);
+    throw;
+  }
+  node->refs.store(1, std::memory_order_relaxed);
+  return Handle(node);
+}
+
+template <typename T>
+void ObjectPool<T>::Release(Node* node) {
+  //只剩自己这一个引用时不会有别人再增加引用，省掉一次原子的读改写；
+  //refs必须清零，池析构时靠它判断槽位上还有没有活着的对象
+  if (node->refs.load(std::memory_order_acquire) == 1) {
+    node->refs.store(0, std::memory_order_relaxed);
+  } else if (node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+    return;
+  }
+  node->object()->~T();
+  Push(node);
+}
+
+#endif  // CYBER_COMMON_OBJECT_POOL_H_
@@ -0,0 +1,174 @@
+//ObjectPool和std::make_shared的对比：
+//1、多个线程各自不停地创建、共享、释放64字节的消息，每个线程同时持有16个
+//2、每对生产者/消费者线程通过一个BoundedQueue传递消息，消费者释放；
+//   make_shared的队列元素是shared_ptr，对象池的队列元素是8字节的RawHandle
+//用法：object_pool_benchmark [messages_per_thread]
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "object_pool.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kLive = 16;
+constexpr uint64_t kQueueSize = 1024;
+constexpr int kMaxPairs = 4;
+
+struct Message {
+  explicit Message(uint64_t s) : seq(s) {}
+  uint64_t seq;
+  uint64_t payload[7] = {};
+};
+
+using Pool = ObjectPool<Message>;
+
+double Seconds(Clock::time_point begin) {
+  return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+template <typename F>
+double RunThreads(int threads, F&& f) {
+  auto begin = Clock::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back(f);
+  }
+  for (auto& w : workers) {
+    w.join();
+  }
+  return Seconds(begin);
+}
+
+double ChurnShared(int threads, uint64_t loops) {
+  return RunThreads(threads, [loops]() {
+    std::shared_ptr<Message> live[kLive];
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < loops; ++i) {
+      auto& slot = live[i % kLive];
+      slot.reset();
+      slot = std::make_shared<Message>(i);
+      auto copy = slot;
+      sum += copy->seq;
+    }
+    volatile uint64_t result = sum;
+    (void)result;
+  }) * 1e9 / loops;
+}
+
+double ChurnPool(int threads, uint64_t loops) {
+  Pool pool(threads * kLive);
+  return RunThreads(threads, [&pool, loops]() {
+    Pool::Handle live[kLive];
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < loops; ++i) {
+      auto& slot = live[i % kLive];
+      slot.reset();
+      slot = pool.GetObject(i);
+      auto copy = slot;
+      sum += copy->seq;
+    }
+    volatile uint64_t result = sum;
+    (void)result;
+  }) * 1e9 / loops;
+}
+
+double HandoffShared(int pairs, uint64_t messages) {
+  BoundedQueue<std::shared_ptr<Message>> queues[kMaxPairs];
+  for (int i = 0; i < pairs; ++i) {
+    queues[i].Init(kQueueSize);
+  }
+  auto begin = Clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < pairs; ++i) {
+    auto queue = &queues[i];
+    threads.emplace_back([queue, messages]() {
+      for (uint64_t n = 0; n < messages; ++n) {
+        auto msg = std::make_shared<Message>(n);
+        while (!queue->Enqueue(std::move(msg))) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([queue, messages]() {
+      std::shared_ptr<Message> msg;
+      for (uint64_t n = 0; n < messages; ++n) {
+        while (!queue->Dequeue(&msg)) {
+          std::this_thread::yield();
+        }
+        msg.reset();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  return pairs * messages / Seconds(begin) / 1e6;
+}
+
+double HandoffPool(int pairs, uint64_t messages) {
+  //对象池要装得下所有队列里的消息，再加上生产者和消费者手上的
+  Pool pool(static_cast<uint32_t>(pairs * (kQueueSize + 2)));
+  BoundedQueue<Pool::RawHandle> queues[kMaxPairs];
+  for (int i = 0; i < pairs; ++i) {
+    queues[i].Init(kQueueSize);
+  }
+  auto begin = Clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < pairs; ++i) {
+    auto queue = &queues[i];
+    threads.emplace_back([&pool, queue, messages]() {
+      for (uint64_t n = 0; n < messages; ++n) {
+        auto msg = pool.GetObject(n);
+        while (!msg) {
+          std::this_thread::yield();
+          msg = pool.GetObject(n);
+        }
+        auto raw = msg.Detach();
+        while (!queue->Enqueue(raw)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([queue, messages]() {
+      Pool::RawHandle raw;
+      for (uint64_t n = 0; n < messages; ++n) {
+        while (!queue->Dequeue(&raw)) {
+          std::this_thread::yield();
+        }
+        Pool::Handle::Adopt(raw).reset();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  return pairs * messages / Seconds(begin) / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  uint64_t messages = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+  printf("churn, ns per create+copy+release (%d live per thread)\n", kLive);
+  printf("%-8s %14s %14s\n", "threads", "make_shared", "ObjectPool");
+  for (int threads : {1, 2, 4, 8}) {
+    printf("%-8d %14.1f %14.1f\n", threads, ChurnShared(threads, messages),
+           ChurnPool(threads, messages));
+  }
+  printf("\nhandoff through BoundedQueue, M msgs/s\n");
+  printf("%-8s %14s %14s\n", "pairs", "make_shared", "ObjectPool");
+  for (int pairs : {1, 2, 4}) {
+    printf("%-8d %14.2f %14.2f\n", pairs, HandoffShared(pairs, messages),
+           HandoffPool(pairs, messages));
+  }
+  return 0;
+}
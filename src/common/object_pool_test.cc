@@ -0,0 +1,145 @@
+#include "object_pool.h"
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+std::atomic<int> alive = {0};
+
+struct Message {
+  explicit Message(uint64_t v) : value(v) { alive++; }
+  ~Message() { alive--; }
+  uint64_t value;
+};
+
+}  // namespace
+
+TEST(ObjectPool, HandlesReturnObjectsOnLastRelease) {
+  ObjectPool<Message> pool(2);
+  auto a = pool.GetObject(1);
+  auto b = pool.GetObject(2);
+  ASSERT_TRUE(a);
+  ASSERT_TRUE(b);
+  EXPECT_EQ(a->value, 1u);
+  EXPECT_EQ((*b).value, 2u);
+  EXPECT_EQ(alive.load(), 2);
+  //池已经用完
+  EXPECT_FALSE(pool.GetObject(3));
+
+  auto copy = a;
+  EXPECT_EQ(a.use_count(), 2u);
+  a.reset();
+  EXPECT_EQ(alive.load(), 2);
+  EXPECT_FALSE(pool.GetObject(3));
+  Message* reused = copy.get();
+  copy = ObjectPool<Message>::Handle();
+  EXPECT_EQ(alive.load(), 1);
+  //最后一个引用释放后槽位回到池中
+  auto c = pool.GetObject(4);
+  ASSERT_TRUE(c);
+  EXPECT_EQ(c.get(), reused);
+  EXPECT_EQ(c->value, 4u);
+}
+
+TEST(ObjectPool, DetachAndAdoptThroughBoundedQueue) {
+  ObjectPool<Message> pool(8);
+  BoundedQueue<ObjectPool<Message>::RawHandle> queue;
+  ASSERT_TRUE(queue.Init(4));
+  for (uint64_t i = 0; i < 4; ++i) {
+    auto handle = pool.GetObject(i);
+    EXPECT_TRUE(queue.Enqueue(handle.Detach()));
+    EXPECT_FALSE(handle);
+  }
+  EXPECT_EQ(alive.load(), 4);
+  ObjectPool<Message>::RawHandle raw;
+  for (uint64_t i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.Dequeue(&raw));
+    auto handle = ObjectPool<Message>::Handle::Adopt(raw);
+    EXPECT_EQ(handle->value, i);
+    EXPECT_EQ(handle.use_count(), 1u);
+  }
+  EXPECT_EQ(alive.load(), 0);
+}
+
+//多个线程同时取用、共享和释放对象，同一时刻不会有两个活着的对象占用同一个槽位
+TEST(ObjectPool, ConcurrentChurn) {
+  constexpr int kThreads = 4;
+  constexpr int kLoops = 50000;
+  constexpr int kLive = 8;
+  ObjectPool<Message> pool(kThreads * kLive);
+  std::atomic<uint64_t> corrupted = {0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      ObjectPool<Message>::Handle live[kLive];
+      for (int i = 0; i < kLoops; ++i) {
+        uint64_t value = static_cast<uint64_t>(t) << 32 | i;
+        auto& slot = live[i % kLive];
+        //先释放旧对象，每个线程最多同时持有kLive个
+        slot.reset();
+        slot = pool.GetObject(value);
+        if (!slot) {
+          corrupted++;
+          continue;
+        }
+        auto shared = slot;
+        if (i % 64 == 0) {
+          std::this_thread::yield();
+        }
+        if (shared->value != value) {
+          corrupted++;
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(corrupted.load(), 0u);
+  EXPECT_EQ(alive.load(), 0);
+  //所有槽位都回到了池中
+  std::vector<ObjectPool<Message>::Handle> all;
+  std::set<Message*> distinct;
+  for (uint32_t i = 0; i < pool.Capacity(); ++i) {
+    all.push_back(pool.GetObject(i));
+    ASSERT_TRUE(all.back());
+    distinct.insert(all.back().get());
+  }
+  EXPECT_EQ(distinct.size(), pool.Capacity());
+  EXPECT_FALSE(pool.GetObject(0));
+}
+
+namespace {
+
+std::atomic<int> destroyed = {0};
+
+struct Counted {
+  ~Counted() { destroyed++; }
+};
+
+}  // namespace
+
+//所有Handle都释放后再析构池，每个对象只析构一次；
+//Detach之后一直没有Adopt的对象由池析构
+TEST(ObjectPool, DestroyPoolAfterRelease) {
+  destroyed = 0;
+  {
+    ObjectPool<Counted> pool(4);
+    {
+      auto a = pool.GetObject();
+      auto b = pool.GetObject();
+      auto shared = b;
+      auto c = pool.GetObject();
+    }
+    EXPECT_EQ(destroyed.load(), 3);
+    auto leaked = pool.GetObject();
+    leaked.Detach();
+  }
+  EXPECT_EQ(destroyed.load(), 4);
+}
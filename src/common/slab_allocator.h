@@ -0,0 +1,151 @@
+#ifndef CYBER_COMMON_SLAB_ALLOCATOR_H_
+#define CYBER_COMMON_SLAB_ALLOCATOR_H_
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+
+#include "macros.h"
+
+//固定大小对象的slab：每次向系统申请kBlocksPerSlab个块，空闲块通过侵入式链表串起来。
+//块按缓存行对齐，申请到的内存不归还给系统，释放的块只回到空闲链表。
+//分配和释放可以在不同线程，空闲链表由一个自旋锁保护，临界区只有几条指令，
+//申请新slab在锁外进行。
+template <size_t Size, size_t Align>
+class SlabPool {
+ public:
+  static SlabPool* Instance() {
+    static SlabPool* pool = new SlabPool();
+    return pool;
+  }
+
+  void* Allocate() {
+    Lock();
+    FreeBlock* block = free_;
+    if (cyber_likely(block != nullptr)) {
+      free_ = block->next;
+      Unlock();
+      return block;
+    }
+    Unlock();
+    //新的slab在锁外申请：posix_memalign可能很慢，失败时抛出的异常也不会带着自旋锁离开。
+    //几个线程同时发现链表为空时会各自申请一个slab，多出来的块留在空闲链表里
+    FreeBlock* last = nullptr;
+    block = NewSlab(&last);
+    Lock();
+    last->next = free_;
+    free_ = block->next;
+    Unlock();
+    return block;
+  }
+
+  void Deallocate(void* ptr) {
+    auto block = static_cast<FreeBlock*>(ptr);
+    Lock();
+    block->next = free_;
+    free_ = block;
+    Unlock();
+  }
+
+  static constexpr size_t kAlign = Align > CACHELINE_SIZE ? Align : CACHELINE_SIZE;
+  static constexpr size_t kBlockSize = (Size + kAlign - 1) / kAlign * kAlign;
+  static constexpr size_t kBlocksPerSlab = 64;
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  SlabPool() = default;
+
+  //不持锁调用，把新申请的slab切成块串成链表，返回第一个块，last是最后一个块
+  static FreeBlock* NewSlab(FreeBlock** last) {
+    void* slab = nullptr;
+    if (posix_memalign(&slab, kAlign, kBlockSize * kBlocksPerSlab) != 0) {
+      throw std::bad_alloc();
+    }
+    char* base = static_cast<char*>(slab);
+    FreeBlock* first = nullptr;
+    for (size_t i = kBlocksPerSlab; i > 0; --i) {
+      auto block = reinterpret_cast<FreeBlock*>(base + (i - 1) * kBlockSize);
+      block->next = first;
+      first = block;
+    }
+    *last = reinterpret_cast<FreeBlock*>(base +
+                                         (kBlocksPerSlab - 1) * kBlockSize);
+    return first;
+  }
+
+  //临界区很短，持锁的线程被抢占时让出CPU，不要空转整个时间片
+  void Lock() {
+    for (uint32_t spins = 0; lock_.test_and_set(std::memory_order_acquire);
+         ++spins) {
+      if (spins >= kSpinLimit) {
+        std::this_thread::yield();
+      }
+    }
+  }
+  void Unlock() { lock_.clear(std::memory_order_release); }
+
+  static constexpr uint32_t kSpinLimit = 64;
+
+  std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+  FreeBlock* free_ = nullptr;
+};
+
+template <size_t Size, size_t Align>
+constexpr size_t SlabPool<Size, Align>::kAlign;
+template <size_t Size, size_t Align>
+constexpr size_t SlabPool<Size, Align>::kBlockSize;
+template <size_t Size, size_t Align>
+constexpr size_t SlabPool<Size, Align>::kBlocksPerSlab;
+template <size_t Size, size_t Align>
+constexpr uint32_t SlabPool<Size, Align>::kSpinLimit;
+
+//从SlabPool分配单个对象的标准分配器，配合std::allocate_shared使用时对象和引用计数在同一块内存里；
+//一次分配多个对象时退化为按缓存行对齐的posix_memalign
+template <typename T>
+class SlabAllocator {
+ public:
+  using value_type = T;
+
+  SlabAllocator() = default;
+  template <typename U>
+  SlabAllocator(const SlabAllocator<U>&) {}  // NOLINT
+
+  T* allocate(size_t n) {
+    using Pool = SlabPool<sizeof(T), alignof(T)>;
+    if (cyber_likely(n == 1)) {
+      return static_cast<T*>(Pool::Instance()->Allocate());
+    }
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, Pool::kAlign, sizeof(T) * n) != 0) {
+      throw std::bad_alloc();
+    }
+    return static_cast<T*>(ptr);
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    if (cyber_likely(n == 1)) {
+      SlabPool<sizeof(T), alignof(T)>::Instance()->Deallocate(ptr);
+    } else {
+      free(ptr);
+    }
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const SlabAllocator<T>&, const SlabAllocator<U>&) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const SlabAllocator<T>&, const SlabAllocator<U>&) {
+  return false;
+}
+
+#endif  // CYBER_COMMON_SLAB_ALLOCATOR_H_
@@ -0,0 +1,48 @@
+#include "slab_allocator.h"
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+struct Payload {
+  uint64_t values[5];
+};
+
+}  // namespace
+
+TEST(SlabAllocator, BlocksAreCachelineAlignedAndReused) {
+  using Pool = SlabPool<sizeof(Payload), alignof(Payload)>;
+  EXPECT_EQ(Pool::kBlockSize, 64u);
+  std::vector<void*> blocks;
+  for (size_t i = 0; i < Pool::kBlocksPerSlab * 2; ++i) {
+    void* block = Pool::Instance()->Allocate();
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % CACHELINE_SIZE, 0u);
+    blocks.push_back(block);
+  }
+  EXPECT_EQ(std::set<void*>(blocks.begin(), blocks.end()).size(),
+            blocks.size());
+  void* last = blocks.back();
+  Pool::Instance()->Deallocate(last);
+  EXPECT_EQ(Pool::Instance()->Allocate(), last);
+  for (auto block : blocks) {
+    Pool::Instance()->Deallocate(block);
+  }
+}
+
+TEST(SlabAllocator, AllocateSharedAcrossThreads) {
+  std::vector<std::shared_ptr<Payload>> objects;
+  for (int i = 0; i < 1000; ++i) {
+    objects.push_back(
+        std::allocate_shared<Payload>(SlabAllocator<Payload>(), Payload{{1}}));
+  }
+  //在其他线程释放，块回到同一个空闲链表
+  std::thread([&objects]() { objects.clear(); }).join();
+  auto again = std::allocate_shared<Payload>(SlabAllocator<Payload>());
+  EXPECT_NE(again, nullptr);
+}
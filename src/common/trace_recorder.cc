@@ -0,0 +1,275 @@
+#include "trace_recorder.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+constexpr size_t TraceRecorder::kMaxBuffers;
+constexpr size_t TraceRecorder::kMaxRetiredNames;
+
+void TraceRecorder::SetBufferCapacity(uint64_t capacity) {
+  uint64_t size = 1;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  std::lock_guard<std::mutex> lk(mutex_);
+  capacity_ = size;
+}
+
+void TraceRecorder::RegisterName(uint64_t id, const std::string& name) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto& entry = names_[id];
+  entry.name = name;
+  entry.live = true;
+}
+
+void TraceRecorder::UnregisterName(uint64_t id) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = names_.find(id);
+  if (it == names_.end() || !it->second.live) {
+    return;
+  }
+  it->second.live = false;
+  retired_names_.push_back(id);
+  while (retired_names_.size() > kMaxRetiredNames) {
+    //同名的协程可能已经重新创建，这时名字要保留
+    auto oldest = names_.find(retired_names_.front());
+    if (oldest != names_.end() && !oldest->second.live) {
+      names_.erase(oldest);
+    }
+    retired_names_.pop_front();
+  }
+}
+
+namespace {
+
+template <typename T>
+void WritePod(std::ofstream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool ReadPod(std::ifstream& in, T* value) {
+  in.read(reinterpret_cast<char*>(value), sizeof(*value));
+  return static_cast<bool>(in);
+}
+
+}  // namespace
+
+bool TraceRecorder::Dump(const std::string& path) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    return false;
+  }
+  out.write(kTraceMagic, sizeof(kTraceMagic));
+  WritePod(out, TscClock::NsPerTick());
+
+  std::lock_guard<std::mutex> lk(mutex_);
+  WritePod(out, static_cast<uint32_t>(buffers_.size()));
+  std::vector<TraceEvent> events;
+  for (auto& buffer : buffers_) {
+    uint64_t capacity = buffer->mask + 1;
+    uint64_t end = buffer->head.load(std::memory_order_acquire);
+    //所属线程可能正在写事件end，它占用的是事件end - capacity的位置
+    uint64_t begin = std::max(buffer->base.load(std::memory_order_acquire),
+                              end + 1 > capacity ? end + 1 - capacity : 0);
+    events.clear();
+    for (uint64_t i = begin; i < end; ++i) {
+      events.push_back(buffer->events[i & buffer->mask]);
+    }
+    //拷贝期间所属线程可能继续写入并覆盖最旧的事件，丢弃可能被覆盖的部分
+    uint64_t now = buffer->head.load(std::memory_order_acquire);
+    uint64_t valid = now + 1 > capacity ? now + 1 - capacity : 0;
+    size_t skip = valid > begin ? std::min<uint64_t>(valid - begin, events.size())
+                                : 0;
+    WritePod(out, buffer->tid);
+    WritePod(out, static_cast<uint64_t>(events.size() - skip));
+    out.write(reinterpret_cast<const char*>(events.data() + skip),
+              (events.size() - skip) * sizeof(TraceEvent));
+  }
+
+  WritePod(out, static_cast<uint32_t>(names_.size()));
+  for (auto& it : names_) {
+    WritePod(out, it.first);
+    WritePod(out, static_cast<uint32_t>(it.second.name.size()));
+    out.write(it.second.name.data(), it.second.name.size());
+  }
+  return static_cast<bool>(out);
+}
+
+void TraceRecorder::Clear() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  for (auto& buffer : buffers_) {
+    buffer->base.store(buffer->head.load(std::memory_order_acquire),
+                       std::memory_order_release);
+  }
+}
+
+uint64_t TraceRecorder::EventCount() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  uint64_t count = 0;
+  for (auto& buffer : buffers_) {
+    count += buffer->head.load(std::memory_order_acquire) -
+             buffer->base.load(std::memory_order_acquire);
+  }
+  return count;
+}
+
+bool ReadTraceFile(const std::string& path, TraceFile* trace) {
+  std::ifstream in(path, std::ios::binary);
+  char magic[sizeof(kTraceMagic)];
+  in.read(magic, sizeof(magic));
+  if (!in || memcmp(magic, kTraceMagic, sizeof(magic)) != 0) {
+    return false;
+  }
+  uint32_t buffer_num = 0;
+  if (!ReadPod(in, &trace->ns_per_tick) || !ReadPod(in, &buffer_num)) {
+    return false;
+  }
+  trace->threads.resize(buffer_num);
+  for (auto& thread : trace->threads) {
+    uint64_t event_num = 0;
+    if (!ReadPod(in, &thread.tid) || !ReadPod(in, &event_num)) {
+      return false;
+    }
+    thread.events.resize(event_num);
+    in.read(reinterpret_cast<char*>(thread.events.data()),
+            event_num * sizeof(TraceEvent));
+  }
+  uint32_t name_num = 0;
+  if (!ReadPod(in, &name_num)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < name_num; ++i) {
+    uint64_t id = 0;
+    uint32_t len = 0;
+    if (!ReadPod(in, &id) || !ReadPod(in, &len)) {
+      return false;
+    }
+    std::string name(len, '\0');
+    in.read(&name[0], len);
+    trace->names[id] = name;
+  }
+  return static_cast<bool>(in);
+}
+
+namespace {
+
+const char* StateName(uint32_t state) {
+  static const char* names[] = {"READY", "FINISHED", "SLEEP", "IO_WAIT",
+                                "DATA_WAIT"};
+  return state < sizeof(names) / sizeof(names[0]) ? names[state] : "UNKNOWN";
+}
+
+std::string EscapeJson(const std::string& str) {
+  std::string out;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+      out.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out += buf;
+    } else {
+      out.push_back(c);
+    }
+  }
+  return out;
+}
+
+}  // namespace
+
+bool WriteChromeTrace(const TraceFile& trace, const std::string& path) {
+  FILE* out = fopen(path.c_str(), "w");
+  if (out == nullptr) {
+    return false;
+  }
+  uint64_t base = UINT64_MAX;
+  for (auto& thread : trace.threads) {
+    if (!thread.events.empty()) {
+      base = std::min(base, thread.events.front().tsc);
+    }
+  }
+
+  auto routine_name = [&trace](uint64_t id) {
+    auto it = trace.names.find(id);
+    if (it != trace.names.end()) {
+      return EscapeJson(it->second);
+    }
+    return "routine " + std::to_string(id);
+  };
+
+  fprintf(out, "{\"traceEvents\":[\n");
+  bool first = true;
+  for (auto& thread : trace.threads) {
+    //环形缓冲区开头的事件可能缺少与之配对的开始事件，跳过多余的结束事件
+    int depth = 0;
+    for (auto& event : thread.events) {
+      double ts = (event.tsc - base) * trace.ns_per_tick / 1000.0;
+      const char* phase = nullptr;
+      std::string name;
+      std::string args;
+      switch (event.type) {
+        case TraceEventType::ROUTINE_RESUME:
+          phase = "B";
+          name = routine_name(event.id);
+          break;
+        case TraceEventType::ROUTINE_YIELD:
+          phase = "E";
+          args = std::string("{\"state\":\"") + StateName(event.arg) + "\"}";
+          break;
+        case TraceEventType::TASK_START:
+          phase = "B";
+          name = "task";
+          break;
+        case TraceEventType::WAIT_PARK:
+          phase = "B";
+          name = "park";
+          break;
+        case TraceEventType::TASK_END:
+        case TraceEventType::WAIT_UNPARK:
+          phase = "E";
+          break;
+        case TraceEventType::QUEUE_ENQUEUE:
+        case TraceEventType::QUEUE_DEQUEUE: {
+          phase = "i";
+          name = event.type == TraceEventType::QUEUE_ENQUEUE ? "enqueue"
+                                                             : "dequeue";
+          char buf[64];
+          snprintf(buf, sizeof(buf), "{\"queue\":\"0x%" PRIx64 "\",\"pos\":%u}",
+                   event.id, event.arg);
+          args = buf;
+          break;
+        }
+        default:
+          continue;
+      }
+      if (phase[0] == 'B') {
+        ++depth;
+      } else if (phase[0] == 'E') {
+        if (depth == 0) {
+          continue;
+        }
+        --depth;
+      }
+      fprintf(out, "%s{\"ph\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f",
+              first ? "" : ",\n", phase, thread.tid, ts);
+      if (!name.empty()) {
+        fprintf(out, ",\"name\":\"%s\"", name.c_str());
+      }
+      if (phase[0] == 'i') {
+        fprintf(out, ",\"s\":\"t\"");
+      }
+      if (!args.empty()) {
+        fprintf(out, ",\"args\":%s", args.c_str());
+      }
+      fprintf(out, "}");
+      first = false;
+    }
+  }
+  fprintf(out, "\n]}\n");
+  return fclose(out) == 0;
+}
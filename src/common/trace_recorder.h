@@ -0,0 +1,214 @@
+#ifndef CYBER_COMMON_TRACE_RECORDER_H_
+#define CYBER_COMMON_TRACE_RECORDER_H_
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "macros.h"
+#include "tsc_clock.h"
+
+//调度相关的事件类型，id/arg的含义见各个事件的注释
+enum class TraceEventType : uint32_t {
+  ROUTINE_RESUME = 0,  // id: 协程id
+  ROUTINE_YIELD,       // id: 协程id，arg: 让出后的RoutineState
+  QUEUE_ENQUEUE,       // id: 队列地址，arg: 入队位置
+  QUEUE_DEQUEUE,       // id: 队列地址，arg: 出队位置
+  WAIT_PARK,           // id: WaitStrategy地址
+  WAIT_UNPARK,         // id: WaitStrategy地址，arg: 1表示被唤醒，0表示超时
+  TASK_START,          // id: 线程池地址
+  TASK_END,            // id: 线程池地址
+  TYPE_NUM,
+};
+
+struct TraceEvent {
+  uint64_t tsc;
+  uint64_t id;
+  TraceEventType type;
+  uint32_t arg;
+};
+
+//每个线程一个的环形缓冲区，只有所属线程写入，满了之后覆盖最旧的事件，写入永远不会阻塞。
+//线程退出后缓冲区仍由TraceRecorder持有，可以在之后导出。
+struct TraceBuffer {
+  TraceBuffer(uint32_t tid, uint64_t capacity)
+      : tid(tid), mask(capacity - 1), events(new TraceEvent[capacity]) {}
+
+  uint32_t tid;
+  const uint64_t mask;
+  std::unique_ptr<TraceEvent[]> events;
+  //已经写入的事件总数，事件i位于events[i & mask]；只有所属线程写入，不需要单独占一个缓存行
+  std::atomic<uint64_t> head = {0};
+  //Clear()时的head，导出和计数只看这之后的事件。
+  //Clear()由其他线程调用，不能直接把head改为0：所属线程对head是普通的读和写，会把重置覆盖掉
+  std::atomic<uint64_t> base = {0};
+  //所属线程已经退出，缓冲区个数超过上限时可以被新线程复用
+  std::atomic<bool> retired = {false};
+};
+
+//常开的二进制事件记录器。
+//记录一个事件只有一次线程局部变量访问、一次rdtsc和几次普通的写，没有锁和原子的读改写；
+//导出（Dump）时把各线程的缓冲区拷贝出来写成二进制文件，再由trace_dump离线转换为Chrome trace JSON，
+//Chrome的chrome://tracing和Perfetto UI（ui.perfetto.dev）都可以直接打开。
+//记录事件用到的状态都是头文件中内联函数的局部静态变量，队列、线程池等只依赖头文件的原语
+//不链接库也可以埋点；导出相关的函数在trace_recorder.cc中。
+class TraceRecorder {
+ public:
+  static TraceRecorder* Instance() {
+    static TraceRecorder* instance = new TraceRecorder();
+    return instance;
+  }
+
+  static void Record(TraceEventType type, uint64_t id, uint32_t arg = 0) {
+    if (cyber_unlikely(!EnabledFlag().load(std::memory_order_relaxed))) {
+      return;
+    }
+    RecordAt(type, TscClock::Now(), id, arg);
+  }
+
+  //调用者已经读取过tsc时直接使用，省去一次rdtsc
+  static void RecordAt(TraceEventType type, uint64_t tsc, uint64_t id,
+                       uint32_t arg = 0) {
+    if (cyber_unlikely(!EnabledFlag().load(std::memory_order_relaxed))) {
+      return;
+    }
+    TraceBuffer* buffer = ThreadBuffer();
+    if (cyber_unlikely(buffer == nullptr)) {
+      buffer = Instance()->CreateBuffer();
+    }
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer->events[head & buffer->mask];
+    event.tsc = tsc;
+    event.id = id;
+    event.type = type;
+    event.arg = arg;
+    buffer->head.store(head + 1, std::memory_order_release);
+  }
+
+  static void SetEnabled(bool enabled) { EnabledFlag().store(enabled); }
+  static bool Enabled() {
+    return EnabledFlag().load(std::memory_order_relaxed);
+  }
+
+  //每个线程缓冲区的事件个数（向上取整为2的幂），只影响之后新建的缓冲区
+  void SetBufferCapacity(uint64_t capacity);
+  //导出时用来显示协程名字
+  void RegisterName(uint64_t id, const std::string& name);
+  //协程结束后调用。它的事件可能还留在缓冲区中，所以名字不立即删除，
+  //只保留最近结束的kMaxRetiredNames个协程的名字
+  void UnregisterName(uint64_t id);
+
+  static constexpr size_t kMaxRetiredNames = 1024;
+
+  //把当前所有缓冲区中的事件写入二进制文件，可以在记录的同时调用
+  bool Dump(const std::string& path);
+  //清空所有缓冲区，可以在记录的同时调用，正在写入的事件可能保留下来
+  void Clear();
+  //上次Clear()之后记录的事件总数，包括已经被覆盖的
+  uint64_t EventCount();
+
+ private:
+  TraceRecorder() = default;
+  inline TraceBuffer* CreateBuffer();
+
+  //退出线程的缓冲区默认保留下来用于导出，超过这个个数之后新线程复用已退出线程的缓冲区
+  static constexpr size_t kMaxBuffers = 256;
+
+  //常量初始化的局部静态变量没有初始化保护，访问它和访问普通的全局变量一样
+  static std::atomic<bool>& EnabledFlag() {
+    static std::atomic<bool> enabled = {true};
+    return enabled;
+  }
+
+  //函数内的常量初始化的thread_local，跨编译单元访问时不需要经过TLS的初始化包装函数
+  static TraceBuffer*& ThreadBuffer() {
+    static thread_local TraceBuffer* buffer = nullptr;
+    return buffer;
+  }
+
+  std::mutex mutex_;
+  uint64_t capacity_ = 1 << 16;
+  std::vector<std::unique_ptr<TraceBuffer>> buffers_;
+  struct RoutineName {
+    std::string name;
+    bool live = true;
+  };
+  std::unordered_map<uint64_t, RoutineName> names_;
+  //已经结束的协程id，按结束的先后顺序
+  std::deque<uint64_t> retired_names_;
+};
+
+//每个线程第一次记录事件时调用
+TraceBuffer* TraceRecorder::CreateBuffer() {
+  //线程退出时把缓冲区标记为可复用
+  struct BufferRetirer {
+    TraceBuffer* buffer = nullptr;
+    ~BufferRetirer() {
+      if (buffer != nullptr) {
+        buffer->retired.store(true, std::memory_order_release);
+      }
+    }
+  };
+  static thread_local BufferRetirer retirer;
+
+  auto tid = static_cast<uint32_t>(syscall(SYS_gettid));
+  TraceBuffer* buffer = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (buffers_.size() >= kMaxBuffers) {
+      for (auto& candidate : buffers_) {
+        if (candidate->retired.load(std::memory_order_acquire)) {
+          buffer = candidate.get();
+          buffer->tid = tid;
+          buffer->head.store(0, std::memory_order_relaxed);
+          buffer->base.store(0, std::memory_order_relaxed);
+          buffer->retired.store(false, std::memory_order_relaxed);
+          break;
+        }
+      }
+    }
+    if (buffer == nullptr) {
+      buffers_.emplace_back(new TraceBuffer(tid, capacity_));
+      buffer = buffers_.back().get();
+    }
+  }
+  ThreadBuffer() = buffer;
+  retirer.buffer = buffer;
+  return buffer;
+}
+
+#define CYBER_TRACE(type, ...) \
+  TraceRecorder::Record(TraceEventType::type, __VA_ARGS__)
+#define CYBER_TRACE_AT(type, tsc, ...) \
+  TraceRecorder::RecordAt(TraceEventType::type, tsc, __VA_ARGS__)
+
+//二进制文件格式（小端）：
+//  char magic[8] = "CYTRACE1"; double ns_per_tick; uint32_t buffer_num;
+//  每个缓冲区：uint32_t tid; uint64_t event_num; TraceEvent events[event_num];
+//  uint32_t name_num; 每个名字：uint64_t id; uint32_t len; char name[len];
+constexpr char kTraceMagic[8] = {'C', 'Y', 'T', 'R', 'A', 'C', 'E', '1'};
+
+struct TraceThread {
+  uint32_t tid = 0;
+  std::vector<TraceEvent> events;
+};
+
+struct TraceFile {
+  double ns_per_tick = 1.0;
+  std::vector<TraceThread> threads;
+  std::unordered_map<uint64_t, std::string> names;
+};
+
+bool ReadTraceFile(const std::string& path, TraceFile* trace);
+//转换为Chrome trace event格式的JSON
+bool WriteChromeTrace(const TraceFile& trace, const std::string& path);
+
+#endif  // CYBER_COMMON_TRACE_RECORDER_H_
@@ -0,0 +1,230 @@
+#include "trace_recorder.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "../scheduler/policy/scheduler_classic.h"
+#include "../test_util.h"
+#include "../thread_pool.h"
+
+namespace {
+
+std::string TempPath(const std::string& name) {
+  return "/tmp/trace_recorder_test_" + name;
+}
+
+//线程池跑num个空任务所用的时间（纳秒）
+double ThreadPoolRun(int num) {
+  ThreadPool pool(1, num);
+  std::vector<std::future<void>> futures;
+  futures.reserve(num);
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < num; ++i) {
+    futures.push_back(pool.Enqueue([]() {}));
+  }
+  for (auto& f : futures) {
+    f.wait();
+  }
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - begin)
+      .count();
+}
+
+}  // namespace
+
+TEST(TraceRecorder, RingOverwritesOldest) {
+  TraceRecorder::Instance()->SetBufferCapacity(16);
+  uint32_t tid = 0;
+  std::thread t([&tid]() {
+    tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    for (uint32_t i = 0; i < 100; ++i) {
+      CYBER_TRACE(QUEUE_ENQUEUE, 1, i);
+    }
+  });
+  t.join();
+  TraceRecorder::Instance()->SetBufferCapacity(1 << 16);
+
+  std::string path = TempPath("ring.bin");
+  ASSERT_TRUE(TraceRecorder::Instance()->Dump(path));
+  TraceFile trace;
+  ASSERT_TRUE(ReadTraceFile(path, &trace));
+  auto it = std::find_if(trace.threads.begin(), trace.threads.end(),
+                         [tid](const TraceThread& t) { return t.tid == tid; });
+  ASSERT_NE(it, trace.threads.end());
+  //最旧的一个位置可能正在被所属线程覆盖，导出时不包含在内
+  ASSERT_EQ(it->events.size(), 15);
+  for (uint32_t i = 0; i < 15; ++i) {
+    EXPECT_EQ(it->events[i].arg, 85 + i);
+    EXPECT_EQ(it->events[i].type, TraceEventType::QUEUE_ENQUEUE);
+  }
+  EXPECT_LE(it->events.front().tsc, it->events.back().tsc);
+}
+
+TEST(TraceRecorder, ClearFromOtherThread) {
+  std::promise<void> recorded;
+  std::promise<void> cleared;
+  uint32_t tid = 0;
+  std::thread t([&]() {
+    tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    for (uint32_t i = 0; i < 10; ++i) {
+      CYBER_TRACE(QUEUE_ENQUEUE, 2, i);
+    }
+    recorded.set_value();
+    cleared.get_future().wait();
+    for (uint32_t i = 10; i < 15; ++i) {
+      CYBER_TRACE(QUEUE_ENQUEUE, 2, i);
+    }
+  });
+  recorded.get_future().wait();
+  TraceRecorder::Instance()->Clear();
+  cleared.set_value();
+  t.join();
+
+  std::string path = TempPath("clear.bin");
+  ASSERT_TRUE(TraceRecorder::Instance()->Dump(path));
+  TraceFile trace;
+  ASSERT_TRUE(ReadTraceFile(path, &trace));
+  auto it = std::find_if(trace.threads.begin(), trace.threads.end(),
+                         [tid](const TraceThread& t) { return t.tid == tid; });
+  ASSERT_NE(it, trace.threads.end());
+  ASSERT_EQ(it->events.size(), 5);
+  for (uint32_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(it->events[i].arg, 10 + i);
+  }
+}
+
+TEST(TraceRecorder, ChromeTraceExport) {
+  TraceRecorder::Instance()->Clear();
+  {
+    ClassicGroupConf group;
+    group.name = "trace";
+    group.processor_num = 1;
+    ClassicConf conf;
+    conf.groups.push_back(group);
+    SchedulerClassic sched(conf);
+    std::promise<void> done;
+    sched.CreateTask(
+        [&done]() {
+          for (int i = 0; i < 3; ++i) {
+            CRoutine::Yield(RoutineState::READY);
+          }
+          done.set_value();
+        },
+        "traced_routine");
+    done.get_future().wait();
+  }
+  {
+    ThreadPool pool(1);
+    pool.Enqueue([]() {}).wait();
+  }
+
+  std::string bin = TempPath("export.bin");
+  std::string json = TempPath("export.json");
+  ASSERT_TRUE(TraceRecorder::Instance()->Dump(bin));
+  TraceFile trace;
+  ASSERT_TRUE(ReadTraceFile(bin, &trace));
+  ASSERT_TRUE(WriteChromeTrace(trace, json));
+
+  std::ifstream in(json);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  std::string content = ss.str();
+  EXPECT_EQ(content.find("{\"traceEvents\":["), 0);
+  EXPECT_NE(content.find("\"name\":\"traced_routine\""), std::string::npos);
+  EXPECT_NE(content.find("\"state\":\"READY\""), std::string::npos);
+  EXPECT_NE(content.find("\"name\":\"task\""), std::string::npos);
+  EXPECT_NE(content.find("\"name\":\"enqueue\""), std::string::npos);
+}
+
+//结束的协程由调度器注销名字，只保留最近结束的kMaxRetiredNames个
+TEST(TraceRecorder, FinishedRoutineNamesAreBounded) {
+  const int kRoutines = static_cast<int>(TraceRecorder::kMaxRetiredNames) + 500;
+  {
+    SchedulerClassic sched(SingleProcessorConf());
+    std::atomic<int> done = {0};
+    for (int i = 0; i < kRoutines; ++i) {
+      ASSERT_TRUE(sched.CreateTask([&done]() { done++; },
+                                   "short_lived_" + std::to_string(i)));
+    }
+    ASSERT_TRUE(WaitFor([&]() { return done == kRoutines; },
+                        std::chrono::seconds(10)));
+    ASSERT_TRUE(WaitFor([&]() { return sched.TaskNum() == 0; }));
+  }
+
+  std::string path = TempPath("names.bin");
+  ASSERT_TRUE(TraceRecorder::Instance()->Dump(path));
+  TraceFile trace;
+  ASSERT_TRUE(ReadTraceFile(path, &trace));
+  size_t short_lived = 0;
+  for (auto& it : trace.names) {
+    if (it.second.compare(0, 12, "short_lived_") == 0) {
+      ++short_lived;
+    }
+  }
+  EXPECT_EQ(short_lived, TraceRecorder::kMaxRetiredNames);
+  EXPECT_LE(trace.names.size(), TraceRecorder::kMaxRetiredNames);
+}
+
+//记录一个事件的开销除去读取时间戳本身不超过约10ns。
+//线程池中事件分散在多个线程之间，缓冲区的缓存行是冷的，并且线程切换带来的噪声较大，额外放宽kNoiseNs
+TEST(TraceRecorder, OverheadOnThreadPool) {
+  const double kNoiseNs = 30.0;
+  const int kLoops = 10000000;
+  auto measure = [](int loops, bool record) {
+    auto begin = std::chrono::steady_clock::now();
+    uint64_t sink = 0;
+    for (int i = 0; i < loops; ++i) {
+      if (record) {
+        CYBER_TRACE(QUEUE_DEQUEUE, i, i);
+      } else {
+        sink += TscClock::Now();
+      }
+    }
+    volatile uint64_t keep = sink;
+    (void)keep;
+    return std::chrono::duration<double, std::nano>(
+               std::chrono::steady_clock::now() - begin)
+               .count() /
+           loops;
+  };
+  measure(kLoops / 10, true);
+  double clock_ns = measure(kLoops, false);
+  double record_ns = measure(kLoops, true);
+  std::cout << "timestamp " << clock_ns << " ns, record " << record_ns
+            << " ns/event" << std::endl;
+  EXPECT_LE(record_ns - clock_ns, 10.0);
+
+  //开关交替运行多轮，各取最小值以减少调度带来的噪声
+  const int kTasks = 100000;
+  const int kRounds = 10;
+  double off_ns = 1e30;
+  double on_ns = 1e30;
+  uint64_t events = 0;
+  for (int round = 0; round < kRounds; ++round) {
+    TraceRecorder::SetEnabled(false);
+    off_ns = std::min(off_ns, ThreadPoolRun(kTasks));
+    TraceRecorder::SetEnabled(true);
+    uint64_t before = TraceRecorder::Instance()->EventCount();
+    on_ns = std::min(on_ns, ThreadPoolRun(kTasks));
+    events = TraceRecorder::Instance()->EventCount() - before;
+  }
+  double per_event = std::max(on_ns - off_ns, 0.0) / std::max<uint64_t>(events, 1);
+  std::cout << "thread pool: off " << off_ns / kTasks << " ns/task, on "
+            << on_ns / kTasks << " ns/task, "
+            << static_cast<double>(events) / kTasks << " events/task, "
+            << per_event << " ns/event" << std::endl;
+  EXPECT_LE(per_event, clock_ns + 10.0 + kNoiseNs);
+}
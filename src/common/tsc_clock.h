@@ -0,0 +1,49 @@
+#ifndef CYBER_COMMON_TSC_CLOCK_H_
+#define CYBER_COMMON_TSC_CLOCK_H_
+
+#include <time.h>
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+//低开销的时间戳：x86_64上使用rdtsc，其他平台使用clock_gettime(CLOCK_MONOTONIC)（单位即纳秒）。
+//记录时只保存原始计数，需要换算成纳秒时再乘以NsPerTick()。
+class TscClock {
+ public:
+  static uint64_t Now() {
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+#endif
+  }
+
+  //第一次调用时用steady_clock校准一次tsc的频率，大约耗时10ms
+  static double NsPerTick() {
+#if defined(__x86_64__)
+    static const double ns_per_tick = []() {
+      auto begin = std::chrono::steady_clock::now();
+      uint64_t begin_tick = Now();
+      while (std::chrono::steady_clock::now() - begin <
+             std::chrono::milliseconds(10)) {
+      }
+      auto end = std::chrono::steady_clock::now();
+      uint64_t end_tick = Now();
+      double ns =
+          std::chrono::duration<double, std::nano>(end - begin).count();
+      return ns / static_cast<double>(end_tick - begin_tick);
+    }();
+    return ns_per_tick;
+#else
+    return 1.0;
+#endif
+  }
+};
+
+#endif  // CYBER_COMMON_TSC_CLOCK_H_
@@ -0,0 +1,525 @@
+#ifndef CYBER_BASE_CONCURRENT_HASH_MAP_H_
+#define CYBER_BASE_CONCURRENT_HASH_MAP_H_
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "common/epoch.h"
+#include "common/macros.h"
+
+//以uint64_t为键的并发哈希表，用于协程id、任务id这类注册表。
+//- 开放寻址、线性探测，每个槽位是一个指向Entry{key, value}的原子指针。Entry发布之后不再修改，
+//  更新一个键就是换一个新的Entry，旧的Entry交给Epoch，等没有读者能访问时再析构。
+//- 读（Get/Has）不加锁：在EpochGuard里沿着探测序列比较键，读到的Entry在临界区内不会被释放。
+//- 写（Insert/Set/Erase）按键的哈希持有64把分段锁中的一把，同一个键的写操作串行，
+//  不同的键之间只在抢同一个空槽位时用CAS竞争。
+//- 扩容不停顿：已用槽位超过3/4时挂上一张新表，之后的每次写操作先帮忙迁移旧表的64个槽位，
+//  迁移一个Entry时持有它的分段锁，先放进新表，再把旧槽位标记为已迁移。
+//  迁移期间读者依次查找旧表和新表，写者把要操作的键先搬到新表再操作。
+//  所有槽位迁移完后新表成为当前表，旧表交给Epoch回收。
+//Epoch攒满一批才回收，删除的值会晚一些析构；需要立即析构时调用Epoch::Instance()->Collect()。
+//Retire可能当场析构之前摘下的值，所以总是在放开分段锁之后调用，值的析构函数里可以再访问这张表。
+template <typename T>
+class ConcurrentHashMap {
+ public:
+  explicit ConcurrentHashMap(uint64_t capacity = kMinCapacity);
+  ~ConcurrentHashMap();
+  ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+  ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+  bool Has(uint64_t key) const;
+  //找到时把值复制到value（可以为nullptr），返回true
+  bool Get(uint64_t key, T* value) const;
+  //键不存在时插入，已经存在时不修改并返回false
+  bool Insert(uint64_t key, const T& value);
+  bool Insert(uint64_t key, T&& value);
+  //插入或者覆盖
+  void Set(uint64_t key, const T& value);
+  void Set(uint64_t key, T&& value);
+  //删除成功时把原来的值复制到value（可以为nullptr）
+  bool Erase(uint64_t key, T* value = nullptr);
+  //并发修改时是近似值
+  size_t Size() const;
+  //对每个键值对调用f(key, const T&)。遍历期间持有所有分段锁，写操作会等待，
+  //只适合统计这类低频操作，f里不能再修改这个表
+  template <typename F>
+  void ForEach(F f);
+  //删除所有键值对，同样持有所有分段锁
+  void Clear();
+  //当前表的槽位数
+  uint64_t Capacity() const;
+
+ private:
+  static constexpr uint64_t kMinCapacity = 64;
+  static constexpr uint64_t kStripeBits = 6;
+  static constexpr uint64_t kStripeNum = 1 << kStripeBits;
+  static constexpr uint64_t kMigrateChunk = 64;
+
+  struct Entry {
+    template <typename V>
+    Entry(uint64_t k, V&& v) : key(k), value(std::forward<V>(v)) {}
+    const uint64_t key;
+    T value;
+  };
+
+  using Slot = std::atomic<Entry*>;
+
+  struct Table {
+    explicit Table(uint64_t cap)
+        : capacity(cap), mask(cap - 1), slots(new Slot[cap]) {
+      for (uint64_t i = 0; i < cap; ++i) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+    const uint64_t capacity;
+    const uint64_t mask;
+    std::unique_ptr<Slot[]> slots;
+    //迁移的目标表，为nullptr表示没有在迁移
+    std::atomic<Table*> next = {nullptr};
+    //非空（包括删除标记）的槽位数
+    std::atomic<uint64_t> used = {0};
+    //下一个待迁移的槽位和已经迁移完的槽位数
+    std::atomic<uint64_t> migrate_next = {0};
+    std::atomic<uint64_t> migrate_done = {0};
+  };
+
+  struct alignas(CACHELINE_SIZE) Stripe {
+    std::mutex mutex;
+    //这个分段的键数，持有锁时修改
+    std::atomic<int64_t> count = {0};
+  };
+
+  enum class PlaceResult { kPlaced, kMoved, kFull };
+
+  //删除标记和已迁移标记，不是合法的Entry地址
+  static Entry* Tombstone() { return reinterpret_cast<Entry*>(uintptr_t(1)); }
+  static Entry* Moved() { return reinterpret_cast<Entry*>(uintptr_t(2)); }
+  static bool IsLive(const Entry* entry) {
+    return reinterpret_cast<uintptr_t>(entry) > 2;
+  }
+
+  //MurmurHash3的fmix64，顺序分配的id也能打散
+  static uint64_t Hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+  }
+  static uint64_t RoundUp(uint64_t n) {
+    uint64_t cap = kMinCapacity;
+    while (cap < n) {
+      cap <<= 1;
+    }
+    return cap;
+  }
+  Stripe& StripeOf(uint64_t hash) const {
+    return stripes_[hash >> (64 - kStripeBits)];
+  }
+
+  static void DeleteEntry(void* ptr) { delete static_cast<Entry*>(ptr); }
+  static void DeleteTable(void* ptr) { delete static_cast<Table*>(ptr); }
+
+  //以下函数需要在EpochGuard内调用
+  //在一张表里查找键所在的槽位，不存在时返回nullptr
+  static Slot* FindSlot(Table* table, uint64_t key, uint64_t hash);
+  PlaceResult Place(Table* table, uint64_t hash, Entry* entry);
+  //放进table或者它之后的表，返回放入的表
+  Table* PlaceInChain(Table* table, uint64_t hash, Entry* entry);
+  //持有键的分段锁时调用：把键从正在迁移的表搬到最后一张表，
+  //返回最后一张表，键存在时slot是它所在的槽位
+  Table* Locate(uint64_t key, uint64_t hash, Slot** slot);
+  void StartMigration(Table* table);
+  //不持有任何分段锁时调用：迁移当前表的一段槽位
+  void HelpMigrate();
+  void MigrateSlot(Table* table, Table* next, uint64_t index);
+
+  template <typename V>
+  bool Put(uint64_t key, V&& value, bool overwrite);
+  void LockAll();
+  void UnlockAll();
+
+  std::atomic<Table*> current_ = {nullptr};
+  Stripe* stripes_ = nullptr;
+};
+
+template <typename T>
+ConcurrentHashMap<T>::ConcurrentHashMap(uint64_t capacity) {
+  //C++14的new不保证按缓存行对齐
+  void* memory = nullptr;
+  if (posix_memalign(&memory, CACHELINE_SIZE, sizeof(Stripe) * kStripeNum) !=
+      0) {
+    throw std::bad_alloc();
+  }
+  stripes_ = static_cast<Stripe*>(memory);
+  for (uint64_t i = 0; i < kStripeNum; ++i) {
+    new (&stripes_[i]) Stripe();
+  }
+  current_.store(new Table(RoundUp(capacity)), std::memory_order_release);
+}
+
+template <typename T>
+ConcurrentHashMap<T>::~ConcurrentHashMap() {
+  //析构时没有并发访问，每个存活的Entry只在一张表里
+  Table* table = current_.load(std::memory_order_acquire);
+  while (table != nullptr) {
+    for (uint64_t i = 0; i < table->capacity; ++i) {
+      Entry* entry = table->slots[i].load(std::memory_order_relaxed);
+      if (IsLive(entry)) {
+        delete entry;
+      }
+    }
+    Table* next = table->next.load(std::memory_order_relaxed);
+    delete table;
+    table = next;
+  }
+  for (uint64_t i = 0; i < kStripeNum; ++i) {
+    stripes_[i].~Stripe();
+  }
+  free(stripes_);
+}
+
+template <typename T>
+typename ConcurrentHashMap<T>::Slot* ConcurrentHashMap<T>::FindSlot(
+    Table* table, uint64_t key, uint64_t hash) {
+  for (uint64_t i = 0; i < table->capacity; ++i) {
+    Slot* slot = &table->slots[(hash + i) & table->mask];
+    Entry* entry = slot->load(std::memory_order_acquire);
+    if (entry == nullptr) {
+      return nullptr;
+    }
+    //删除标记和已迁移标记都要跳过继续探测
+    if (IsLive(entry) && entry->key == key) {
+      return slot;
+    }
+  }
+  return nullptr;
+}
+
+template <typename T>
+bool ConcurrentHashMap<T>::Has(uint64_t key) const {
+  return Get(key, nullptr);
+}
+
+template <typename T>
+bool ConcurrentHashMap<T>::Get(uint64_t key, T* value) const {
+  uint64_t hash = Hash(key);
+  EpochGuard guard;
+  //迁移中的键先放进新表再标记旧槽位，所以沿着表链找下去不会漏掉存活的键
+  for (Table* table = current_.load(std::memory_order_acquire);
+       table != nullptr; table = table->next.load(std::memory_order_acquire)) {
+    Slot* slot = FindSlot(table, key, hash);
+    if (slot != nullptr) {
+      Entry* entry = slot->load(std::memory_order_acquire);
+      if (IsLive(entry)) {
+        if (value != nullptr) {
+          *value = entry->value;
+        }
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+template <typename T>
+typename ConcurrentHashMap<T>::PlaceResult ConcurrentHashMap<T>::Place(
+    Table* table, uint64_t hash, Entry* entry) {
+  for (uint64_t i = 0; i < table->capacity;) {
+    Slot* slot = &table->slots[(hash + i) & table->mask];
+    Entry* old = slot->load(std::memory_order_acquire);
+    if (old == Moved()) {
+      return PlaceResult::kMoved;
+    }
+    if (IsLive(old)) {
+      ++i;
+      continue;
+    }
+    //空槽位或者删除标记，和其他键的插入或迁移竞争，失败后重新看这个槽位
+    if (slot->compare_exchange_strong(old, entry, std::memory_order_acq_rel,
+                                      std::memory_order_acquire)) {
+      if (old == nullptr) {
+        uint64_t used = table->used.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (used > table->capacity / 4 * 3) {
+          StartMigration(table);
+        }
+      }
+      return PlaceResult::kPlaced;
+    }
+  }
+  return PlaceResult::kFull;
+}
+
+template <typename T>
+typename ConcurrentHashMap<T>::Table* ConcurrentHashMap<T>::PlaceInChain(
+    Table* table, uint64_t hash, Entry* entry) {
+  for (;;) {
+    PlaceResult result = Place(table, hash, entry);
+    if (result == PlaceResult::kPlaced) {
+      return table;
+    }
+    //表已经在迁移或者已经满了，放进下一张表
+    if (result == PlaceResult::kFull) {
+      StartMigration(table);
+    }
+    table = table->next.load(std::memory_order_acquire);
+  }
+}
+
+template <typename T>
+void ConcurrentHashMap<T>::StartMigration(Table* table) {
+  if (table->next.load(std::memory_order_acquire) != nullptr) {
+    return;
+  }
+  //新表至少是存活键数的2倍，删除标记多时新表可以比旧表小
+  uint64_t live = Size();
+  uint64_t cap = RoundUp(std::max(live * 2, table->capacity / 4));
+  Table* next = new Table(cap);
+  Table* expected = nullptr;
+  if (!table->next.compare_exchange_strong(expected, next,
+                                           std::memory_order_acq_rel)) {
+    delete next;
+  }
+}
+
+template <typename T>
+typename ConcurrentHashMap<T>::Table* ConcurrentHashMap<T>::Locate(
+    uint64_t key, uint64_t hash, Slot** slot) {
+  Table* table = current_.load(std::memory_order_acquire);
+  for (;;) {
+    Slot* found = FindSlot(table, key, hash);
+    Table* next = table->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      //之后才开始的迁移要搬这个键，也要先拿到同一把分段锁
+      *slot = found;
+      return table;
+    }
+    if (found != nullptr) {
+      Entry* entry = found->load(std::memory_order_relaxed);
+      PlaceInChain(next, hash, entry);
+      found->store(Moved(), std::memory_order_release);
+    }
+    table = next;
+  }
+}
+
+template <typename T>
+void ConcurrentHashMap<T>::MigrateSlot(Table* table, Table* next,
+                                       uint64_t index) {
+  Slot* slot = &table->slots[index];
+  for (;;) {
+    Entry* entry = slot->load(std::memory_order_acquire);
+    if (entry == Moved()) {
+      return;
+    }
+    if (!IsLive(entry)) {
+      if (slot->compare_exchange_strong(entry, Moved(),
+                                        std::memory_order_acq_rel)) {
+        return;
+      }
+      continue;
+    }
+    uint64_t hash = Hash(entry->key);
+    std::lock_guard<std::mutex> lk(StripeOf(hash).mutex);
+    //等锁期间这个键可能已经被删除、覆盖或者搬走
+    if (slot->load(std::memory_order_acquire) != entry) {
+      continue;
+    }
+    PlaceInChain(next, hash, entry);
+    slot->store(Moved(), std::memory_order_release);
+    return;
+  }
+}
+
+template <typename T>
+void ConcurrentHashMap<T>::HelpMigrate() {
+  Table* table = current_.load(std::memory_order_acquire);
+  Table* next = table->next.load(std::memory_order_acquire);
+  if (cyber_likely(next == nullptr)) {
+    return;
+  }
+  uint64_t begin =
+      table->migrate_next.fetch_add(kMigrateChunk, std::memory_order_relaxed);
+  if (begin >= table->capacity) {
+    return;
+  }
+  uint64_t end = std::min(begin + kMigrateChunk, table->capacity);
+  for (uint64_t i = begin; i < end; ++i) {
+    MigrateSlot(table, next, i);
+  }
+  uint64_t done =
+      table->migrate_done.fetch_add(end - begin, std::memory_order_acq_rel) +
+      (end - begin);
+  if (done == table->capacity) {
+    //Clear()可能已经换掉了当前表，那时旧表由Clear()回收
+    Table* expected = table;
+    if (current_.compare_exchange_strong(expected, next,
+                                         std::memory_order_acq_rel)) {
+      Epoch::Instance()->Retire(table, &DeleteTable);
+    }
+  }
+}
+
+template <typename T>
+template <typename V>
+bool ConcurrentHashMap<T>::Put(uint64_t key, V&& value, bool overwrite) {
+  uint64_t hash = Hash(key);
+  Stripe& stripe = StripeOf(hash);
+  EpochGuard guard;
+  HelpMigrate();
+  Entry* old = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(stripe.mutex);
+    Slot* slot = nullptr;
+    Table* table = Locate(key, hash, &slot);
+    if (slot == nullptr) {
+      PlaceInChain(table, hash, new Entry(key, std::forward<V>(value)));
+      stripe.count.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    if (!overwrite) {
+      return false;
+    }
+    old = slot->load(std::memory_order_relaxed);
+    slot->store(new Entry(key, std::forward<V>(value)),
+                std::memory_order_release);
+  }
+  Epoch::Instance()->Retire(old, &DeleteEntry);
+  return true;
+}
+
+template <typename T>
+bool ConcurrentHashMap<T>::Insert(uint64_t key, const T& value) {
+  return Put(key, value, false);
+}
+
+template <typename T>
+bool ConcurrentHashMap<T>::Insert(uint64_t key, T&& value) {
+  return Put(key, std::move(value), false);
+}
+
+template <typename T>
+void ConcurrentHashMap<T>::Set(uint64_t key, const T& value) {
+  Put(key, value, true);
+}
+
+template <typename T>
+void ConcurrentHashMap<T>::Set(uint64_t key, T&& value) {
+  Put(key, std::move(value), true);
+}
+
+template <typename T>
+bool ConcurrentHashMap<T>::Erase(uint64_t key, T* value) {
+  uint64_t hash = Hash(key);
+  Stripe& stripe = StripeOf(hash);
+  EpochGuard guard;
+  HelpMigrate();
+  Entry* old = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(stripe.mutex);
+    Slot* slot = nullptr;
+    Locate(key, hash, &slot);
+    if (slot == nullptr) {
+      return false;
+    }
+    old = slot->load(std::memory_order_relaxed);
+    if (value != nullptr) {
+      *value = old->value;
+    }
+    slot->store(Tombstone(), std::memory_order_release);
+    stripe.count.fetch_sub(1, std::memory_order_relaxed);
+  }
+  Epoch::Instance()->Retire(old, &DeleteEntry);
+  return true;
+}
+
+template <typename T>
+size_t ConcurrentHashMap<T>::Size() const {
+  int64_t size = 0;
+  for (uint64_t i = 0; i < kStripeNum; ++i) {
+    size += stripes_[i].count.load(std::memory_order_relaxed);
+  }
+  return size < 0 ? 0 : static_cast<size_t>(size);
+}
+
+template <typename T>
+uint64_t ConcurrentHashMap<T>::Capacity() const {
+  EpochGuard guard;
+  return current_.load(std::memory_order_acquire)->capacity;
+}
+
+template <typename T>
+void ConcurrentHashMap<T>::LockAll() {
+  for (uint64_t i = 0; i < kStripeNum; ++i) {
+    stripes_[i].mutex.lock();
+  }
+}
+
+template <typename T>
+void ConcurrentHashMap<T>::UnlockAll() {
+  for (uint64_t i = kStripeNum; i > 0; --i) {
+    stripes_[i - 1].mutex.unlock();
+  }
+}
+
+template <typename T>
+template <typename F>
+void ConcurrentHashMap<T>::ForEach(F f) {
+  EpochGuard guard;
+  LockAll();
+  //持有所有分段锁时没有正在搬动的Entry，每个存活的键只在一张表里
+  for (Table* table = current_.load(std::memory_order_acquire);
+       table != nullptr; table = table->next.load(std::memory_order_acquire)) {
+    for (uint64_t i = 0; i < table->capacity; ++i) {
+      Entry* entry = table->slots[i].load(std::memory_order_acquire);
+      if (IsLive(entry)) {
+        f(entry->key, static_cast<const T&>(entry->value));
+      }
+    }
+  }
+  UnlockAll();
+}
+
+template <typename T>
+void ConcurrentHashMap<T>::Clear() {
+  EpochGuard guard;
+  std::vector<Entry*> entries;
+  std::vector<Table*> tables;
+  LockAll();
+  Table* table = current_.exchange(new Table(kMinCapacity),
+                                   std::memory_order_acq_rel);
+  //旧表上可能还有没拿锁的迁移在把空槽位标记为已迁移，表和Entry都交给Epoch
+  while (table != nullptr) {
+    for (uint64_t i = 0; i < table->capacity; ++i) {
+      Entry* entry = table->slots[i].load(std::memory_order_acquire);
+      if (IsLive(entry)) {
+        entries.push_back(entry);
+      }
+    }
+    tables.push_back(table);
+    table = table->next.load(std::memory_order_acquire);
+  }
+  for (uint64_t i = 0; i < kStripeNum; ++i) {
+    stripes_[i].count.store(0, std::memory_order_relaxed);
+  }
+  UnlockAll();
+  //摘下的Entry已经不在任何表里，放锁之后再交给Epoch，析构值时不持有分段锁
+  for (Entry* entry : entries) {
+    Epoch::Instance()->Retire(entry, &DeleteEntry);
+  }
+  for (Table* old : tables) {
+    Epoch::Instance()->Retire(old, &DeleteTable);
+  }
+}
+
+#endif  // CYBER_BASE_CONCURRENT_HASH_MAP_H_
@@ -0,0 +1,186 @@
+//id注册表的三种实现在查找/更新混合负载下的吞吐量：
+//- concurrent：ConcurrentHashMap，读不加锁，写按分段加锁；
+//- mutex：一把std::mutex保护的std::unordered_map；
+//- rw_sharded：按键分成16段，每段一个AtomicRWLock和一个std::unordered_map。
+//值是std::shared_ptr，查找时复制一份，和调度器按id取协程一样。
+//键空间有kKeys个键，开始时插入一半；更新一半是插入或覆盖，一半是删除，存活的键数大致不变。
+//用法：concurrent_hash_map_benchmark [duration_ms] [max_threads]
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "atomic_rw_lock.h"
+#include "concurrent_hash_map.h"
+
+namespace {
+
+using Value = std::shared_ptr<uint64_t>;
+
+constexpr uint64_t kKeys = 1 << 14;
+
+class MutexMap {
+ public:
+  bool Get(uint64_t key, Value* value) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+      return false;
+    }
+    *value = it->second;
+    return true;
+  }
+  void Set(uint64_t key, const Value& value) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    map_[key] = value;
+  }
+  void Erase(uint64_t key) {
+    Value value;
+    {
+      std::lock_guard<std::mutex> lk(mutex_);
+      auto it = map_.find(key);
+      if (it == map_.end()) {
+        return;
+      }
+      value = std::move(it->second);
+      map_.erase(it);
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<uint64_t, Value> map_;
+};
+
+class RWShardedMap {
+ public:
+  bool Get(uint64_t key, Value* value) {
+    Shard& shard = shards_[key % kShards];
+    ReadLockGuard<AtomicRWLock> guard(shard.lock);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end()) {
+      return false;
+    }
+    *value = it->second;
+    return true;
+  }
+  void Set(uint64_t key, const Value& value) {
+    Shard& shard = shards_[key % kShards];
+    WriteLockGuard<AtomicRWLock> guard(shard.lock);
+    shard.map[key] = value;
+  }
+  void Erase(uint64_t key) {
+    Shard& shard = shards_[key % kShards];
+    Value value;
+    {
+      WriteLockGuard<AtomicRWLock> guard(shard.lock);
+      auto it = shard.map.find(key);
+      if (it == shard.map.end()) {
+        return;
+      }
+      value = std::move(it->second);
+      shard.map.erase(it);
+    }
+  }
+
+ private:
+  static constexpr uint64_t kShards = 16;
+  struct Shard {
+    AtomicRWLock lock;
+    std::unordered_map<uint64_t, Value> map;
+    char padding[CACHELINE_SIZE];
+  };
+  Shard shards_[kShards];
+};
+
+class ConcurrentMap {
+ public:
+  bool Get(uint64_t key, Value* value) { return map_.Get(key, value); }
+  void Set(uint64_t key, const Value& value) { map_.Set(key, value); }
+  void Erase(uint64_t key) { map_.Erase(key); }
+
+ private:
+  ConcurrentHashMap<Value> map_;
+};
+
+template <typename Map>
+double Run(int threads_num, int update_percent, int duration_ms) {
+  Map map;
+  for (uint64_t key = 0; key < kKeys; key += 2) {
+    map.Set(key, std::make_shared<uint64_t>(key));
+  }
+  std::atomic<bool> stop = {false};
+  std::vector<uint64_t> ops(threads_num, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threads_num; ++t) {
+    threads.emplace_back([&, t]() {
+      uint64_t seed = t + 1;
+      uint64_t count = 0;
+      uint64_t sink = 0;
+      Value value;
+      Value fresh = std::make_shared<uint64_t>(t);
+      while (!stop.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < 64; ++i) {
+          seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+          uint64_t key = (seed >> 24) % kKeys;
+          int dice = (seed >> 50) % 100;
+          if (dice >= update_percent) {
+            if (map.Get(key, &value)) {
+              sink += *value;
+            }
+          } else if (dice % 2 == 0) {
+            map.Set(key, fresh);
+          } else {
+            map.Erase(key);
+          }
+        }
+        count += 64;
+      }
+      ops[t] = count;
+      volatile uint64_t keep = sink;
+      (void)keep;
+    });
+  }
+  auto begin = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+  stop = true;
+  for (auto& t : threads) {
+    t.join();
+  }
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - begin)
+          .count();
+  uint64_t total = 0;
+  for (uint64_t n : ops) {
+    total += n;
+  }
+  return total / seconds / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int duration_ms = argc > 1 ? std::atoi(argv[1]) : 1000;
+  int max_threads = argc > 2 ? std::atoi(argv[2]) : 8;
+  printf("%-8s %-8s %12s %12s %12s  (M ops/s)\n", "mix", "threads",
+         "concurrent", "mutex", "rw_sharded");
+  const int kUpdatePercents[] = {5, 50};
+  for (int update_percent : kUpdatePercents) {
+    for (int threads_num = 1; threads_num <= max_threads; threads_num *= 2) {
+      double concurrent =
+          Run<ConcurrentMap>(threads_num, update_percent, duration_ms);
+      double mutex = Run<MutexMap>(threads_num, update_percent, duration_ms);
+      double rw_sharded =
+          Run<RWShardedMap>(threads_num, update_percent, duration_ms);
+      printf("%2d/%-5d %-8d %12.2f %12.2f %12.2f\n", 100 - update_percent,
+             update_percent, threads_num, concurrent, mutex, rw_sharded);
+    }
+  }
+  return 0;
+}
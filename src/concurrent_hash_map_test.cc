@@ -0,0 +1,236 @@
+#include "concurrent_hash_map.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "common/epoch.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+//析构时计数，用来检查值的回收
+struct Counted {
+  explicit Counted(std::atomic<int>* counter) : destroyed(counter) {}
+  ~Counted() { (*destroyed)++; }
+  std::atomic<int>* destroyed;
+};
+
+//析构时遍历所在的表，Retire在持有分段锁时析构它就会死锁
+struct Probe;
+using ProbeMap = ConcurrentHashMap<std::shared_ptr<Probe>>;
+struct Probe {
+  Probe(ProbeMap* map, std::atomic<int>* counter)
+      : map(map), destroyed(counter) {}
+  ~Probe();
+  ProbeMap* map;
+  std::atomic<int>* destroyed;
+};
+
+Probe::~Probe() {
+  map->ForEach([](uint64_t, const std::shared_ptr<Probe>&) {});
+  (*destroyed)++;
+}
+
+//Epoch要推进两次才能回收一批
+void CollectAll() {
+  for (int i = 0; i < 3; ++i) {
+    Epoch::Instance()->Collect();
+  }
+}
+
+}  // namespace
+
+TEST(ConcurrentHashMap, Basic) {
+  ConcurrentHashMap<int> map;
+  int value = 0;
+  EXPECT_FALSE(map.Get(1, &value));
+  EXPECT_TRUE(map.Insert(1, 10));
+  EXPECT_FALSE(map.Insert(1, 11));
+  EXPECT_TRUE(map.Get(1, &value));
+  EXPECT_EQ(value, 10);
+  map.Set(1, 12);
+  map.Set(2, 20);
+  EXPECT_TRUE(map.Get(1, &value));
+  EXPECT_EQ(value, 12);
+  EXPECT_EQ(map.Size(), 2u);
+  EXPECT_TRUE(map.Erase(1, &value));
+  EXPECT_EQ(value, 12);
+  EXPECT_FALSE(map.Erase(1));
+  EXPECT_FALSE(map.Has(1));
+  EXPECT_TRUE(map.Has(2));
+  EXPECT_EQ(map.Size(), 1u);
+  map.Clear();
+  EXPECT_FALSE(map.Has(2));
+  EXPECT_EQ(map.Size(), 0u);
+}
+
+//单线程插入、删除交替，扩容和清理删除标记后内容和std::map一致
+TEST(ConcurrentHashMap, GrowAndShrink) {
+  ConcurrentHashMap<uint64_t> map;
+  std::map<uint64_t, uint64_t> expected;
+  for (uint64_t i = 0; i < 20000; ++i) {
+    map.Set(i, i * 3);
+    expected[i] = i * 3;
+    if (i % 3 == 0) {
+      EXPECT_TRUE(map.Erase(i / 2) == (expected.erase(i / 2) == 1));
+    }
+  }
+  EXPECT_GT(map.Capacity(), 64u);
+  EXPECT_EQ(map.Size(), expected.size());
+  std::map<uint64_t, uint64_t> visited;
+  map.ForEach([&](uint64_t key, const uint64_t& value) {
+    EXPECT_TRUE(visited.emplace(key, value).second);
+  });
+  EXPECT_EQ(visited, expected);
+  for (uint64_t i = 0; i < 20000; ++i) {
+    map.Erase(i);
+  }
+  EXPECT_EQ(map.Size(), 0u);
+  //只插入又删除新键时，删除标记占满的表按存活的键数迁移，不会继续变大
+  uint64_t capacity = map.Capacity();
+  for (uint64_t i = 0; i < 200000; ++i) {
+    map.Set(100000 + i, i);
+    EXPECT_TRUE(map.Erase(100000 + i));
+  }
+  EXPECT_LE(map.Capacity(), capacity);
+  EXPECT_EQ(map.Size(), 0u);
+}
+
+//写者不停地插入和删除，迫使表反复迁移；读者检查读到的值总是和键匹配，
+//并且始终存在的键一定能读到
+TEST(ConcurrentHashMap, ConcurrentReadersDuringMigration) {
+  ConcurrentHashMap<uint64_t> map;
+  constexpr uint64_t kStable = 256;
+  for (uint64_t i = 0; i < kStable; ++i) {
+    map.Set(i, i * 7);
+  }
+  std::atomic<bool> stop = {false};
+  std::atomic<int> errors = {0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 2; ++t) {
+    threads.emplace_back([&, t]() {
+      uint64_t base = 1000000 * (t + 1);
+      for (int round = 0; round < 20; ++round) {
+        for (uint64_t i = 0; i < 2000; ++i) {
+          map.Insert(base + i, (base + i) * 7);
+        }
+        for (uint64_t i = 0; i < 2000; ++i) {
+          if (!map.Erase(base + i)) {
+            errors++;
+          }
+        }
+      }
+    });
+  }
+  for (int t = 0; t < 2; ++t) {
+    threads.emplace_back([&]() {
+      uint64_t value = 0;
+      while (!stop) {
+        for (uint64_t i = 0; i < kStable; ++i) {
+          if (!map.Get(i, &value) || value != i * 7) {
+            errors++;
+          }
+        }
+        for (uint64_t key = 1000000; key < 1002000; key += 97) {
+          if (map.Get(key, &value) && value != key * 7) {
+            errors++;
+          }
+        }
+      }
+    });
+  }
+  threads[0].join();
+  threads[1].join();
+  stop = true;
+  threads[2].join();
+  threads[3].join();
+  EXPECT_EQ(errors, 0);
+  EXPECT_EQ(map.Size(), kStable);
+}
+
+//多个线程对同一组键做Insert/Erase，每个键最终的状态和成功操作的次数一致
+TEST(ConcurrentHashMap, ConcurrentInsertErase) {
+  ConcurrentHashMap<int> map;
+  constexpr int kKeys = 512;
+  std::atomic<int64_t> balance[kKeys];
+  for (auto& b : balance) {
+    b = 0;
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t]() {
+      uint64_t seed = t + 1;
+      for (int i = 0; i < 50000; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        int key = (seed >> 33) % kKeys;
+        if ((seed >> 20) & 1) {
+          if (map.Insert(key, key)) {
+            balance[key]++;
+          }
+        } else if (map.Erase(key)) {
+          balance[key]--;
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  size_t live = 0;
+  for (int key = 0; key < kKeys; ++key) {
+    ASSERT_TRUE(balance[key] == 0 || balance[key] == 1);
+    EXPECT_EQ(map.Has(key), balance[key] == 1);
+    live += balance[key];
+  }
+  EXPECT_EQ(map.Size(), live);
+}
+
+//被覆盖、删除、清空的值在Epoch回收后析构，析构表时剩下的值也会析构
+TEST(ConcurrentHashMap, ValuesReclaimed) {
+  std::atomic<int> destroyed = {0};
+  {
+    ConcurrentHashMap<std::shared_ptr<Counted>> map;
+    for (uint64_t i = 0; i < 1000; ++i) {
+      map.Set(i, std::make_shared<Counted>(&destroyed));
+    }
+    for (uint64_t i = 0; i < 100; ++i) {
+      map.Set(i, std::make_shared<Counted>(&destroyed));
+    }
+    for (uint64_t i = 100; i < 200; ++i) {
+      std::shared_ptr<Counted> value;
+      EXPECT_TRUE(map.Erase(i, &value));
+    }
+    CollectAll();
+    EXPECT_EQ(destroyed, 200);
+    map.Clear();
+    CollectAll();
+    EXPECT_EQ(destroyed, 1100);
+    for (uint64_t i = 0; i < 10; ++i) {
+      map.Set(i, std::make_shared<Counted>(&destroyed));
+    }
+  }
+  EXPECT_EQ(destroyed, 1110);
+}
+
+//Epoch::Retire可能当场析构之前删除的值（比如协程），析构函数里再访问这张表不能死锁
+TEST(ConcurrentHashMap, ValueDestructorMayUseMap) {
+  std::atomic<int> destroyed = {0};
+  const int kKeys = 1000;
+  ProbeMap map;
+  for (int i = 0; i < kKeys; ++i) {
+    map.Set(i, std::make_shared<Probe>(&map, &destroyed));
+  }
+  for (int i = 0; i < kKeys / 2; ++i) {
+    map.Set(i, std::make_shared<Probe>(&map, &destroyed));
+  }
+  for (int i = kKeys / 2; i < kKeys; ++i) {
+    EXPECT_TRUE(map.Erase(i));
+  }
+  map.Clear();
+  CollectAll();
+  EXPECT_EQ(destroyed, kKeys + kKeys / 2);
+}
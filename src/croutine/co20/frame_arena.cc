@@ -0,0 +1,74 @@
+#include "frame_arena.h"
+
+#include <new>
+
+constexpr size_t FrameArena::kClassSize;
+constexpr size_t FrameArena::kMaxSize;
+constexpr size_t FrameArena::kChunkSize;
+
+FrameArena* FrameArena::ForThread() {
+  static thread_local FrameArena* arena = new FrameArena();
+  return arena;
+}
+
+void* FrameArena::Allocate(size_t size) {
+  size_t total = size + sizeof(Header);
+  Header* header = nullptr;
+  if (total > kMaxSize) {
+    //过大的帧直接从堆上分配，arena为空
+    header = static_cast<Header*>(::operator new(total));
+    header->arena = nullptr;
+    header->size_class = 0;
+  } else {
+    auto size_class = static_cast<uint32_t>((total - 1) / kClassSize);
+    FrameArena* arena = ForThread();
+    header = static_cast<Header*>(arena->AllocateBlock(size_class));
+    header->arena = arena;
+    header->size_class = size_class;
+  }
+  return header + 1;
+}
+
+void FrameArena::Deallocate(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  Header* header = static_cast<Header*>(ptr) - 1;
+  if (header->arena == nullptr) {
+    ::operator delete(header);
+    return;
+  }
+  header->arena->FreeBlockTo(header, header->size_class);
+}
+
+void* FrameArena::AllocateBlock(uint32_t size_class) {
+  size_t block_size = (size_class + 1) * kClassSize;
+  Lock();
+  void* block = free_lists_[size_class];
+  if (block != nullptr) {
+    free_lists_[size_class] = free_lists_[size_class]->next;
+  } else {
+    if (chunk_left_ < block_size) {
+      //上一个大块剩下的部分直接丢弃，最多浪费一个kMaxSize
+      chunk_ = static_cast<char*>(::operator new(kChunkSize));
+      chunks_.push_back(chunk_);
+      chunk_left_ = kChunkSize;
+    }
+    block = chunk_;
+    chunk_ += block_size;
+    chunk_left_ -= block_size;
+  }
+  Unlock();
+  bytes_in_use_.fetch_add(block_size, std::memory_order_relaxed);
+  return block;
+}
+
+void FrameArena::FreeBlockTo(void* block, uint32_t size_class) {
+  auto free_block = static_cast<FreeBlock*>(block);
+  Lock();
+  free_block->next = free_lists_[size_class];
+  free_lists_[size_class] = free_block;
+  Unlock();
+  bytes_in_use_.fetch_sub((size_class + 1) * kClassSize,
+                          std::memory_order_relaxed);
+}
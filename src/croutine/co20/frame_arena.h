@@ -0,0 +1,59 @@
+#ifndef CYBER_CROUTINE_CO20_FRAME_ARENA_H_
+#define CYBER_CROUTINE_CO20_FRAME_ARENA_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//无栈协程帧的分配器。
+//每个线程（处理器）一个arena，按64字节分级的空闲链表，块从64KB的大块中切出，不归还给系统；
+//释放时根据块头记录的arena放回分配它的那个arena，因此可以在其他线程释放，空闲链表由自旋锁保护，
+//正常情况下只有所属线程访问，锁不会有竞争。
+//协程帧在调用协程函数时分配，所以在处理器线程中创建的协程使用该处理器的arena。
+//arena在线程退出后不会释放（协程帧可能比线程活得久），处理器线程是常驻的，数量有限。
+class FrameArena {
+ public:
+  static void* Allocate(size_t size);
+  static void Deallocate(void* ptr);
+
+  //当前线程的arena
+  static FrameArena* ForThread();
+
+  //从arena中分配出去、尚未释放的字节数（按分级后的大小）
+  size_t BytesInUse() const { return bytes_in_use_.load(std::memory_order_relaxed); }
+
+  static constexpr size_t kClassSize = 64;
+  static constexpr size_t kMaxSize = 4096;
+  static constexpr size_t kChunkSize = 64 * 1024;
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  //块头，保持16字节以满足协程帧的对齐
+  struct alignas(16) Header {
+    FrameArena* arena;
+    uint32_t size_class;
+  };
+
+  FrameArena() = default;
+  void* AllocateBlock(uint32_t size_class);
+  void FreeBlockTo(void* block, uint32_t size_class);
+
+  void Lock() {
+    while (lock_.test_and_set(std::memory_order_acquire)) {
+    }
+  }
+  void Unlock() { lock_.clear(std::memory_order_release); }
+
+  std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+  FreeBlock* free_lists_[kMaxSize / kClassSize] = {};
+  char* chunk_ = nullptr;
+  size_t chunk_left_ = 0;
+  std::vector<char*> chunks_;
+  std::atomic<size_t> bytes_in_use_ = {0};
+};
+
+#endif  // CYBER_CROUTINE_CO20_FRAME_ARENA_H_
@@ -0,0 +1,30 @@
+#include "stackless_routine.h"
+
+std::coroutine_handle<> CoTask::FinalAwaiter::await_suspend(
+    Handle handle) noexcept {
+  auto continuation = handle.promise().continuation;
+  auto routine = StacklessRoutine::Current();
+  if (continuation) {
+    routine->set_leaf(continuation);
+    return continuation;
+  }
+  //根协程结束，帧保持在最终挂起点，由StacklessRoutine析构时销毁
+  routine->set_state(RoutineState::FINISHED);
+  return std::noop_coroutine();
+}
+
+std::coroutine_handle<> CoTask::Awaiter::await_suspend(
+    std::coroutine_handle<> parent) {
+  handle.promise().continuation = parent;
+  StacklessRoutine::Current()->set_leaf(handle);
+  return handle;
+}
+
+StacklessRoutine::StacklessRoutine(CoTask task)
+    : CRoutine(&StacklessRoutine::ResumeLeaf),
+      task_(std::move(task)),
+      leaf_(task_.handle()) {}
+
+void StacklessRoutine::ResumeLeaf(CRoutine* cr) {
+  static_cast<StacklessRoutine*>(cr)->leaf_.resume();
+}
@@ -0,0 +1,162 @@
+#ifndef CYBER_CROUTINE_CO20_STACKLESS_ROUTINE_H_
+#define CYBER_CROUTINE_CO20_STACKLESS_ROUTINE_H_
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "../../common/slab_allocator.h"
+#include "../../scheduler/scheduler.h"
+#include "../croutine.h"
+#include "frame_arena.h"
+
+//基于C++20无栈协程的CRoutine，需要以-std=c++20编译。
+//StacklessRoutine继承CRoutine，处理器像对待有栈协程一样调度它：优先级、processor_id、
+//RoutineState的转换、Wake/Notify/Park都是同一套；区别只在Resume()里不切换栈，
+//而是在处理器线程自己的栈上恢复协程帧，协程帧co_await挂起时Resume()返回。
+//协程体不能调用CRoutine::Yield()/Sleep()/HangUp()以及基于它们的CoMutex、CoCondVar、DataNotifier、
+//Reactor::WaitFd（它们要切换栈，调用时打印错误并终止进程；CRoutine::MaybeYield()总是返回false），
+//改为co_await下面的awaitable：
+//  co_await YieldNow();          //READY，让出一次
+//  co_await SleepFor(duration);  //SLEEP
+//  co_await HangUp();            //DATA_WAIT，等待Scheduler::NotifyTask()/Wakeup()
+//  co_await MaybeYield();        //用完时间片时让出
+//CoTask可以嵌套co_await，子协程结束后通过对称转移直接回到父协程。
+
+class CoTask {
+ public:
+  struct promise_type;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  //子协程结束后回到父协程，根协程结束后把协程标记为FINISHED并返回处理器
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(Handle handle) noexcept;
+    void await_resume() const noexcept {}
+  };
+
+  struct promise_type {
+    CoTask get_return_object() { return CoTask(Handle::from_promise(*this)); }
+    //协程创建后先挂起，等处理器第一次Resume()时再开始执行
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void return_void() const {}
+    void unhandled_exception() const { std::terminate(); }
+
+    //协程帧从当前线程的FrameArena分配
+    static void* operator new(size_t size) { return FrameArena::Allocate(size); }
+    static void operator delete(void* ptr) { FrameArena::Deallocate(ptr); }
+
+    std::coroutine_handle<> continuation;
+  };
+
+  //co_await一个CoTask：记录父协程，直接转移到子协程执行
+  struct Awaiter {
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> parent);
+    void await_resume() const noexcept {}
+    Handle handle;
+  };
+
+  CoTask() = default;
+  CoTask(CoTask&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+  CoTask& operator=(CoTask&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+  ~CoTask() { Reset(); }
+
+  Awaiter operator co_await() && { return Awaiter{handle_}; }
+  Handle handle() const { return handle_; }
+
+ private:
+  explicit CoTask(Handle handle) : handle_(handle) {}
+  CoTask(const CoTask&) = delete;
+  CoTask& operator=(const CoTask&) = delete;
+
+  void Reset() {
+    if (handle_) {
+      handle_.destroy();
+      handle_ = {};
+    }
+  }
+
+  Handle handle_;
+};
+
+class StacklessRoutine : public CRoutine {
+ public:
+  explicit StacklessRoutine(CoTask task);
+
+  //当前线程正在运行的无栈协程，只能在无栈协程体内调用
+  static StacklessRoutine* Current() {
+    return static_cast<StacklessRoutine*>(CRoutine::GetCurrentRoutine());
+  }
+
+  //下一次Resume()时要恢复的协程帧：嵌套时是最内层的子协程
+  void set_leaf(std::coroutine_handle<> leaf) { leaf_ = leaf; }
+
+ private:
+  static void ResumeLeaf(CRoutine* cr);
+
+  //根协程帧由task_持有，随StacklessRoutine析构；子协程帧由父协程帧中的CoTask持有
+  CoTask task_;
+  std::coroutine_handle<> leaf_;
+};
+
+//以给定的状态让出，处理器根据状态把协程放回就绪队列、时间轮或挂起
+class YieldAs {
+ public:
+  explicit YieldAs(RoutineState state) : state_(state) {}
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> handle) const {
+    auto routine = StacklessRoutine::Current();
+    routine->set_leaf(handle);
+    routine->set_state(state_);
+  }
+  void await_resume() const noexcept {}
+
+ private:
+  RoutineState state_;
+};
+
+inline YieldAs YieldNow() { return YieldAs(RoutineState::READY); }
+
+inline YieldAs HangUp() { return YieldAs(RoutineState::DATA_WAIT); }
+
+inline YieldAs SleepFor(const Duration& duration) {
+  StacklessRoutine::Current()->set_wake_time(std::chrono::steady_clock::now() +
+                                             duration);
+  return YieldAs(RoutineState::SLEEP);
+}
+
+//时间片没有用完时不挂起，只有一次rdtsc
+class MaybeYield {
+ public:
+  bool await_ready() const noexcept {
+    return !StacklessRoutine::Current()->ShouldYield();
+  }
+  void await_suspend(std::coroutine_handle<> handle) const {
+    auto routine = StacklessRoutine::Current();
+    routine->RequestPreempt();
+    routine->set_leaf(handle);
+    routine->set_state(RoutineState::READY);
+  }
+  void await_resume() const noexcept {}
+};
+
+//创建无栈协程并交给调度器分发，协程id同样由名字哈希得到
+inline bool CreateStacklessTask(Scheduler* scheduler, CoTask task,
+                                const std::string& name) {
+  return scheduler->CreateTask(
+      std::allocate_shared<StacklessRoutine>(SlabAllocator<StacklessRoutine>(),
+                                             std::move(task)),
+      name);
+}
+
+#endif  // CYBER_CROUTINE_CO20_STACKLESS_ROUTINE_H_
@@ -0,0 +1,135 @@
+#include "stackless_routine.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "../../scheduler/policy/scheduler_classic.h"
+#include "../../test_util.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+CoTask AddTwice(std::atomic<int>* count) {
+  (*count)++;
+  co_await YieldNow();
+  (*count)++;
+}
+
+CoTask Parent(std::atomic<int>* count) {
+  co_await AddTwice(count);
+  co_await SleepFor(std::chrono::milliseconds(2));
+  co_await AddTwice(count);
+}
+
+CoTask WaitTwice(std::atomic<int>* wakeups) {
+  for (int i = 0; i < 2; ++i) {
+    co_await HangUp();
+    (*wakeups)++;
+  }
+}
+
+CoTask Record(std::atomic<int>* order, std::atomic<int>* slot) {
+  *slot = (*order)++;
+  co_return;
+}
+
+CoTask CheckMaybeYield(std::atomic<int>* result) {
+  StacklessRoutine::Current()->RequestPreempt();
+  *result = CRoutine::MaybeYield() ? 1 : 0;
+  co_return;
+}
+
+CoTask StackfulHangUp() {
+  CRoutine::GetCurrentRoutine()->HangUp();
+  co_return;
+}
+
+}  // namespace
+
+TEST(StacklessRoutine, NestedTaskAndSleep) {
+  SchedulerClassic sched(SingleProcessorConf());
+  std::atomic<int> count = {0};
+  ASSERT_TRUE(CreateStacklessTask(&sched, Parent(&count), "parent"));
+  EXPECT_TRUE(WaitFor([&]() { return count == 4; }));
+  EXPECT_TRUE(WaitFor([&]() { return sched.TaskNum() == 0; }));
+}
+
+TEST(StacklessRoutine, HangUpAndNotify) {
+  SchedulerClassic sched(SingleProcessorConf());
+  std::atomic<int> wakeups = {0};
+  ASSERT_TRUE(CreateStacklessTask(&sched, WaitTwice(&wakeups), "waiter"));
+  uint64_t crid = std::hash<std::string>()("waiter");
+  for (int i = 1; i <= 2; ++i) {
+    //通知可能在协程挂起之前到达，Park()/Notify()保证不会丢失
+    sched.NotifyTask(crid);
+    EXPECT_TRUE(WaitFor([&]() { return wakeups == i; }));
+  }
+  EXPECT_TRUE(WaitFor([&]() { return sched.TaskNum() == 0; }));
+}
+
+TEST(StacklessRoutine, MixedWithStackfulByPriority) {
+  SchedulerClassic sched(SingleProcessorConf());
+  std::atomic<bool> started = {false};
+  std::atomic<bool> release = {false};
+  sched.CreateTask(
+      [&]() {
+        started = true;
+        while (!release) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      },
+      "blocker");
+  ASSERT_TRUE(WaitFor([&]() { return started.load(); }));
+  std::atomic<int> order = {0};
+  std::atomic<int> low_order = {-1};
+  std::atomic<int> high_order = {-1};
+  sched.CreateTask([&]() { low_order = order++; }, "low");
+  CreateStacklessTask(&sched, Record(&order, &high_order), "high");
+  release = true;
+  EXPECT_TRUE(WaitFor([&]() { return low_order >= 0 && high_order >= 0; }));
+  EXPECT_EQ(high_order, 0);
+  EXPECT_EQ(low_order, 1);
+}
+
+//无栈协程中CRoutine::MaybeYield()不切换栈，直接返回false
+TEST(StacklessRoutine, StackfulMaybeYieldIsNoOp) {
+  SchedulerClassic sched(SingleProcessorConf());
+  std::atomic<int> result = {-1};
+  ASSERT_TRUE(CreateStacklessTask(&sched, CheckMaybeYield(&result), "check"));
+  EXPECT_TRUE(WaitFor([&]() { return result >= 0; }));
+  EXPECT_EQ(result, 0);
+}
+
+//要切换栈的挂起（HangUp以及CoMutex等基于它的等待）在无栈协程中打印错误并终止进程，
+//而不是访问空的context_
+TEST(StacklessRoutineDeathTest, StackfulHangUpAborts) {
+  testing::GTEST_FLAG(death_test_style) = "threadsafe";
+  EXPECT_DEATH(
+      {
+        SchedulerClassic sched(SingleProcessorConf());
+        CreateStacklessTask(&sched, StackfulHangUp(), "hangup");
+        std::this_thread::sleep_for(std::chrono::seconds(5));
+      },
+      "stackless routine hangup .*co_await");
+}
+
+TEST(FrameArena, ReuseFreedBlock) {
+  void* first = FrameArena::Allocate(100);
+  size_t in_use = FrameArena::ForThread()->BytesInUse();
+  FrameArena::Deallocate(first);
+  void* second = FrameArena::Allocate(90);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(FrameArena::ForThread()->BytesInUse(), in_use);
+  FrameArena::Deallocate(second);
+
+  //在其他线程释放时放回分配它的arena
+  void* block = FrameArena::Allocate(200);
+  std::thread([block]() { FrameArena::Deallocate(block); }).join();
+  EXPECT_EQ(FrameArena::Allocate(200), block);
+  FrameArena::Deallocate(block);
+
+  void* large = FrameArena::Allocate(FrameArena::kMaxSize * 2);
+  FrameArena::Deallocate(large);
+}
@@ -1,18 +1,24 @@
 
 #include "./croutine.h"
-#include <algorithm>
+#include <cstdlib>
 #include <utility>
 #include "./detail/routine_context.h"
+#include "../common/log.h"
+#include "../common/macros.h"
+#include "../common/slab_allocator.h"
+#include "../common/trace_recorder.h"
 
 
 thread_local CRoutine *CRoutine::current_routine_ = nullptr;
 thread_local char *CRoutine::main_stack_ = nullptr;
+constexpr Duration CRoutine::kDefaultTimeSlice;
 
 namespace {
-//维护一个协程上下文的对象池
-//cyber\base\object_pool.h
-//该对象池基于链表实现，通过GetObject获取当前的池子中申请但尚未初始化的context空间
-std::shared_ptr<base::CCObjectPool<RoutineContext>> context_pool = nullptr;
+//维护一个协程上下文（栈）的对象池，协程结束后栈放回池中复用。
+//Apollo按组件数和配置文件中的routine_num确定容量，这里没有全局配置，用一个固定的容量，
+//超过时协程仍然可以创建，只是结束后多出来的栈直接释放
+constexpr uint32_t kRoutineContextNum = 256;
+std::unique_ptr<RoutineContextPool> context_pool = nullptr;
 std::once_flag pool_init_flag;
 
 void CRoutineEntry(void *arg) {
@@ -22,31 +28,37 @@ void CRoutineEntry(void *arg) {
 }
 }  // namespace
 
-CRoutine::CRoutine(const std::function<void()> &func) : func_(func) {
-  std::call_once(pool_init_flag, [&]() {
-    uint32_t routine_num = common::GlobalData::Instance()->ComponentNums();
-    auto &global_conf = common::GlobalData::Instance()->Config();
-    if (global_conf.has_scheduler_conf() &&
-        global_conf.scheduler_conf().has_routine_num()) {
-      routine_num =
-          std::max(routine_num, global_conf.scheduler_conf().routine_num());
-    }
-    context_pool.reset(new base::CCObjectPool<RoutineContext>(routine_num));
+CRoutine::CRoutine(RoutineFunc func) : func_(std::move(func)) {
+  std::call_once(pool_init_flag, []() {
+    context_pool.reset(new RoutineContextPool(kRoutineContextNum));
   });
 
-  context_ = context_pool->GetObject();
-  if (context_ == nullptr) {
-    AWARN << "Maximum routine context number exceeded! Please check "
-             "[routine_num] in config file.";
-    context_.reset(new RoutineContext());
-  }
+  context_ = context_pool->Get();
+  slice_ticks_ = DefaultSliceTicks();
+  MakeContext(CRoutineEntry, this, context_);
+  state_ = RoutineState::READY;
+  updated_.test_and_set(std::memory_order_release);
+}
 
-  MakeContext(CRoutineEntry, this, context_.get());
+CRoutine::CRoutine(ResumeHook resume_hook) : resume_hook_(resume_hook) {
+  slice_ticks_ = DefaultSliceTicks();
   state_ = RoutineState::READY;
   updated_.test_and_set(std::memory_order_release);
 }
 
-CRoutine::~CRoutine() { context_ = nullptr; }
+CRoutine::~CRoutine() {
+  NameTable::Release(name_);
+  NameTable::Release(group_name_);
+  if (context_ != nullptr) {
+    context_pool->Put(context_);
+    context_ = nullptr;
+  }
+}
+
+std::shared_ptr<CRoutine> CRoutine::Create(RoutineFunc func) {
+  return std::allocate_shared<CRoutine>(SlabAllocator<CRoutine>(),
+                                        std::move(func));
+}
 
 RoutineState CRoutine::Resume() {
   if (cyber_unlikely(force_stop_)) {
@@ -60,10 +72,59 @@ RoutineState CRoutine::Resume() {
   }
 
   current_routine_ = this;
-  //切换协程上下文实现当前协程的resume功能
-  SwapContext(GetMainStack(), GetStack());
+  preempt_.store(false, std::memory_order_relaxed);
+  slice_start_ = TscClock::Now();
+#ifdef CYBER_ROUTINE_STATISTICS
+  profiler_.OnResume();
+#endif
+  CYBER_TRACE_AT(ROUTINE_RESUME, slice_start_, id_);
+  if (resume_hook_ != nullptr) {
+    //无栈协程直接在处理器的栈上恢复协程帧
+    resume_hook_(this);
+  } else {
+    //切换协程上下文实现当前协程的resume功能
+    SwapContext(GetMainStack(), GetStack());
+  }
+  CYBER_TRACE(ROUTINE_YIELD, id_, static_cast<uint32_t>(state_));
+#ifdef CYBER_ROUTINE_STATISTICS
+  profiler_.OnYield(static_cast<int>(state_));
+#endif
   current_routine_ = nullptr;
   return state_;
 }
 
-void CRoutine::Stop() { force_stop_ = true; }
\ No newline at end of file
+RoutineStatistics CRoutine::GetStatistics() const {
+  RoutineStatistics stats;
+  stats.id = id_;
+  stats.name = *name_;
+#ifdef CYBER_ROUTINE_STATISTICS
+  profiler_.Snapshot(&stats);
+#endif
+  return stats;
+}
+
+void CRoutine::set_time_slice(const Duration &time_slice) {
+  time_slice_ = time_slice;
+  //tsc的频率在第一次调用时校准，之后只是一次除法
+  slice_ticks_ = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(time_slice).count() /
+      TscClock::NsPerTick());
+}
+
+uint64_t CRoutine::DefaultSliceTicks() {
+  static const uint64_t ticks = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(kDefaultTimeSlice)
+          .count() /
+      TscClock::NsPerTick());
+  return ticks;
+}
+
+void CRoutine::Stop() { force_stop_ = true; }
+
+void CRoutine::AbortStacklessYield(CRoutine *routine) {
+  AERROR << "stackless routine " << routine->name() << " (id " << routine->id()
+         << ") called a stackful suspend (CRoutine::Yield/HangUp/Sleep, "
+            "CoMutex, CoCondVar, DataNotifier or Reactor::WaitFd); use "
+            "co_await YieldNow()/HangUp()/SleepFor() instead";
+  std::abort();
+}
\ No newline at end of file
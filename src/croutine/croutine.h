@@ -1,3 +1,6 @@
+#ifndef CYBER_CROUTINE_CROUTINE_H_
+#define CYBER_CROUTINE_CROUTINE_H_
+
 #include <atomic>
 #include <chrono>
 #include <functional>
@@ -6,30 +9,47 @@
 #include <set>
 #include <string>
 
+#include "../common/inline_function.h"
+#include "../common/macros.h"
+#include "../common/name_table.h"
+#include "../common/tsc_clock.h"
 #include "./detail/routine_context.h"
+#include "./routine_statistics.h"
 
-using RoutineFunc = std::function<void()>;
+//协程函数体，不超过48字节的可调用对象（例如捕获了几个引用的lambda）直接存放在CRoutine内部
+using RoutineFunc = InlineFunction<void(), 48>;
 using Duration = std::chrono::microseconds;
 
 enum class RoutineState { READY, FINISHED, SLEEP, IO_WAIT, DATA_WAIT };
 
+class RoutineList;
+
 
 //协程（非对称）中最核心需要实现resume和yield两个操作。
 //前者让该协程继续执行，后者让协程交出控制权。
 //这里分别是Resume()和Yield()函数。
 //前者最核心做的事就是将上下文从当前切换到目标协程；
 //后者反之。它们都是通过SwapContext()函数实现的上下文切换。
-class CRoutine {
+//对象按缓存行对齐，热点字段集中在第一个缓存行里，见成员变量的注释。
+class alignas(CACHELINE_SIZE) CRoutine {
  public:
-  explicit CRoutine(const RoutineFunc &func);
+  explicit CRoutine(RoutineFunc func);
   virtual ~CRoutine();
 
+  //从slab分配协程，对象和shared_ptr的引用计数在同一块按缓存行对齐的内存中，
+  //调度器创建协程都通过这里
+  static std::shared_ptr<CRoutine> Create(RoutineFunc func);
+
   // static interfaces
   static void Yield();
   static void Yield(const RoutineState &state);
   static void SetMainContext(const std::shared_ptr<RoutineContext> &context);
   static CRoutine *GetCurrentRoutine();
   static char **GetMainStack();
+  //协作式抢占的检查点：当前协程这次运行超过了时间片，或者看门狗请求了抢占时以READY让出，
+  //返回true表示让出过。只有一次rdtsc和比较，长时间运行的计算循环里可以每隔几微秒调用一次。
+  //在无栈协程中总是返回false
+  static bool MaybeYield();
 
   // public interfaces
   bool Acquire();
@@ -39,6 +59,13 @@ class CRoutine {
   // SetUpdateFlag().
   void SetUpdateFlag();
 
+  //事件驱动的唤醒，替代SetUpdateFlag()+UpdateState()的轮询方式：
+  //Park()在协程以DATA_WAIT/IO_WAIT让出之后由处理器调用，返回false表示运行期间已经收到了通知，
+  //应当直接重新调度；Notify()可以在任意线程调用，返回true表示协程已经挂起，由调用者负责把它放回就绪队列。
+  //两者配合保证通知和让出并发时协程恰好被重新调度一次，多次通知会被合并。
+  bool Park();
+  bool Notify();
+
   // acquire && release should be called before Resume
   // when work-steal like mechanism used
   RoutineState Resume();
@@ -69,42 +96,114 @@ class CRoutine {
   void set_priority(uint32_t priority);
 
   std::chrono::steady_clock::time_point wake_time() const;
+  void set_wake_time(const std::chrono::steady_clock::time_point &wake_time) {
+    wake_time_ = wake_time;
+  }
+
+  //每次Resume可以连续运行的时间，只对调用MaybeYield()的协程生效，默认kDefaultTimeSlice
+  Duration time_slice() const { return time_slice_; }
+  void set_time_slice(const Duration &time_slice);
+  //这次运行已经用完时间片或者被请求抢占，MaybeYield()据此决定是否让出
+  bool ShouldYield() const {
+    return preempt_.load(std::memory_order_relaxed) ||
+           TscClock::Now() - slice_start_ >= slice_ticks_;
+  }
+  //请求当前这次运行在下一个检查点让出。只写一个原子变量，可以在信号处理函数中调用
+  void RequestPreempt() { preempt_.store(true, std::memory_order_relaxed); }
+  //上一次运行是因为用完时间片（或被看门狗标记）而结束的，Resume返回后由处理器读取
+  bool SliceExpired() const { return preempt_.load(std::memory_order_relaxed); }
+  //降级只改变当前的优先级，配置的优先级保存在base_priority_中，RestorePriority()恢复
+  void Demote();
+  void RestorePriority() { priority_ = base_priority_; }
 
   void set_group_name(const std::string &group_name) {
-    group_name_ = group_name;
+    const std::string *old = group_name_;
+    group_name_ = NameTable::Intern(group_name);
+    NameTable::Release(old);
   }
 
-  const std::string &group_name() { return group_name_; }
+  const std::string &group_name() { return *group_name_; }
+
+  //运行统计的快照，可以在任意线程调用；未定义CYBER_ROUTINE_STATISTICS时计数全为0
+  RoutineStatistics GetStatistics() const;
+
+  static constexpr Duration kDefaultTimeSlice{5000};
+
+ protected:
+  //无栈协程（见co20/stackless_routine.h）使用：不分配栈，Resume()时调用resume_hook，
+  //由它恢复协程帧，协程帧挂起（co_await）时返回
+  using ResumeHook = void (*)(CRoutine *);
+  explicit CRoutine(ResumeHook resume_hook);
 
  private:
+  //侵入式链表（RoutineList）直接访问next_，避免为调度队列额外分配节点
+  friend class RoutineList;
+  //处理器的收件队列（RoutineInbox）使用inbox_next_，可以在其他线程入队
+  friend class RoutineInbox;
+
   CRoutine(CRoutine &) = delete;
   CRoutine &operator=(CRoutine &) = delete;
 
-  std::string name_;
-  std::chrono::steady_clock::time_point wake_time_ =
-      std::chrono::steady_clock::now();
-
-  //协程要执行的函数体
-  RoutineFunc func_;
-  RoutineState state_;
+  //协程进入READY状态时记录时间点，用于统计从就绪到运行的延迟
+  void MarkReady();
+  static uint64_t DefaultSliceTicks();
+  //无栈协程调用了要切换栈的Yield()（包括HangUp/Sleep和基于它们的CoMutex、CoCondVar、
+  //DataNotifier、Reactor::WaitFd）：没有栈可以切换，打印协程名后终止进程
+  [[noreturn]] static void AbortStacklessYield(CRoutine *routine);
 
+  //调度器选取/切换协程时访问的字段集中在对象的第一个缓存行（对象按缓存行对齐，前8字节是虚表指针），
+  //这里的顺序和大小正好填满64字节，增删字段时需要注意
   //context_指向相应的RoutineContext对象。该对象存放的就是对应协程的上下文。
   //对于一个执行体来说，最主要的上下文就是栈和寄存器了，因此RoutineContext中也非常简单，
-  //就是一块空间作为栈（大小为8M），加一个栈指针。进程中所有的RoutineContext对象会有一个全局的对象池来管理，
-  //其指针保存在context_pool变量中。这个对象池CCObjectPool的实现位于concurrent_object_pool.h。
-  //它会在初始化时将指定个数的对象全分配好。
-  std::shared_ptr<RoutineContext> context_;
+  //就是一块空间作为栈（大小为2M），加一个栈指针。RoutineContext由RoutineContextPool管理，
+  //协程独占自己的RoutineContext，析构时放回池中。
+  RoutineContext *context_ = nullptr;
+
+  //侵入式链表指针，协程在同一时刻只会处于一个就绪队列或等待队列中，
+  //因此一个指针即可，由调度器所在的线程维护
+  CRoutine *next_ = nullptr;
+
+  //只在Sleep()时设置，创建时不读时钟
+  std::chrono::steady_clock::time_point wake_time_;
+
+  //本次Resume开始时的tsc，只在协程所在的处理器线程读写
+  uint64_t slice_start_ = 0;
+  uint64_t id_ = 0;
+
+  RoutineState state_;
+  uint32_t priority_ = 0;
+
+  //Park()/Notify()使用的状态位：kParked表示协程已挂起且不在任何队列中，kNotified表示有未处理的通知
+  static constexpr uint32_t kParked = 1;
+  static constexpr uint32_t kNotified = 2;
+  std::atomic<uint32_t> wait_flags_ = {0};
 
   std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
   std::atomic_flag updated_ = ATOMIC_FLAG_INIT;
+  std::atomic<bool> force_stop_ = {false};
+  std::atomic<bool> preempt_ = {false};
 
-  bool force_stop_ = false;
-
+  //以下是创建时设置、很少访问的字段
+  //时间片对应的tsc计数
+  uint64_t slice_ticks_ = 0;
+  ResumeHook resume_hook_ = nullptr;
   int processor_id_ = -1;
-  uint32_t priority_ = 0;
-  uint64_t id_ = 0;
+  uint32_t base_priority_ = 0;
+  Duration time_slice_ = kDefaultTimeSlice;
+
+  //名字和分组名都是驻留在NameTable中的字符串，析构时释放引用
+  const std::string *name_ = NameTable::Empty();
+  const std::string *group_name_ = NameTable::Empty();
 
-  std::string group_name_;
+  //收件队列的侵入式链表指针，其他线程唤醒协程时写入
+  std::atomic<CRoutine *> inbox_next_ = {nullptr};
+
+  //协程要执行的函数体
+  RoutineFunc func_;
+
+#ifdef CYBER_ROUTINE_STATISTICS
+  RoutineProfiler profiler_;
+#endif
 
   //指向当前线程正在执行的协程对应的CRoutine对象
   //thread_local对象
@@ -119,19 +218,40 @@ class CRoutine {
 
 inline void CRoutine::Yield(const RoutineState &state) {
   auto routine = GetCurrentRoutine();
+  if (cyber_unlikely(routine->resume_hook_ != nullptr)) {
+    AbortStacklessYield(routine);
+  }
   routine->set_state(state);
-  SwapContext(GetCurrentRoutine()->GetStack(), GetMainStack());
+  SwapContext(routine->GetStack(), GetMainStack());
 }
 
 inline void CRoutine::Yield() {
-  SwapContext(GetCurrentRoutine()->GetStack(), GetMainStack());
+  auto routine = GetCurrentRoutine();
+  if (cyber_unlikely(routine->resume_hook_ != nullptr)) {
+    AbortStacklessYield(routine);
+  }
+  SwapContext(routine->GetStack(), GetMainStack());
 }
 
 inline CRoutine *CRoutine::GetCurrentRoutine() { return current_routine_; }
 
+inline bool CRoutine::MaybeYield() {
+  auto routine = GetCurrentRoutine();
+  //无栈协程没有自己的栈，不能在这里让出，要用co_await MaybeYield()
+  if (cyber_unlikely(routine == nullptr || routine->resume_hook_ != nullptr)) {
+    return false;
+  }
+  if (cyber_likely(!routine->ShouldYield())) {
+    return false;
+  }
+  routine->preempt_.store(true, std::memory_order_relaxed);
+  Yield(RoutineState::READY);
+  return true;
+}
+
 inline char **CRoutine::GetMainStack() { return &main_stack_; }
 
-inline RoutineContext *CRoutine::GetContext() { return context_.get(); }
+inline RoutineContext *CRoutine::GetContext() { return context_; }
 
 inline char **CRoutine::GetStack() { return &(context_->sp); }
 
@@ -145,7 +265,16 @@ inline std::chrono::steady_clock::time_point CRoutine::wake_time() const {
   return wake_time_;
 }
 
-inline void CRoutine::Wake() { state_ = RoutineState::READY; }
+inline void CRoutine::Wake() {
+  state_ = RoutineState::READY;
+  MarkReady();
+}
+
+inline void CRoutine::MarkReady() {
+#ifdef CYBER_ROUTINE_STATISTICS
+  profiler_.OnReady();
+#endif
+}
 
 //当前携程挂起，将当前状态设置为RoutineState::DATA_WAIT，并切换上下文继续新的携程执行
 inline void CRoutine::HangUp() { CRoutine::Yield(RoutineState::DATA_WAIT); }
@@ -159,9 +288,13 @@ inline uint64_t CRoutine::id() const { return id_; }
 
 inline void CRoutine::set_id(uint64_t id) { id_ = id; }
 
-inline const std::string &CRoutine::name() const { return name_; }
+inline const std::string &CRoutine::name() const { return *name_; }
 
-inline void CRoutine::set_name(const std::string &name) { name_ = name; }
+inline void CRoutine::set_name(const std::string &name) {
+  const std::string *old = name_;
+  name_ = NameTable::Intern(name);
+  NameTable::Release(old);
+}
 
 inline int CRoutine::processor_id() const { return processor_id_; }
 
@@ -172,6 +305,11 @@ inline void CRoutine::set_processor_id(int processor_id) {
 //检测并更新携程状态
 //该函数在协程的调度环境回继续介绍
 inline RoutineState CRoutine::UpdateState() {
+  //被Stop()的协程视为可运行，交给Resume()返回FINISHED，调度器据此回收
+  if (force_stop_) {
+    return RoutineState::READY;
+  }
+
   // Synchronous Event Mechanism
   if (state_ == RoutineState::SLEEP &&
       std::chrono::steady_clock::now() > wake_time_) {
@@ -190,7 +328,16 @@ inline RoutineState CRoutine::UpdateState() {
 
 inline uint32_t CRoutine::priority() const { return priority_; }
 
-inline void CRoutine::set_priority(uint32_t priority) { priority_ = priority; }
+inline void CRoutine::set_priority(uint32_t priority) {
+  priority_ = priority;
+  base_priority_ = priority;
+}
+
+inline void CRoutine::Demote() {
+  if (priority_ > 0) {
+    --priority_;
+  }
+}
 
 inline bool CRoutine::Acquire() {
   return !lock_.test_and_set(std::memory_order_acquire);
@@ -204,3 +351,28 @@ inline void CRoutine::SetUpdateFlag() {
   updated_.clear(std::memory_order_release);
 }
 
+inline bool CRoutine::Park() {
+  uint32_t flags = 0;
+  if (wait_flags_.compare_exchange_strong(flags, kParked,
+                                          std::memory_order_acq_rel,
+                                          std::memory_order_acquire)) {
+    return true;
+  }
+  //运行期间已经收到通知，消费掉这次通知
+  wait_flags_.store(0, std::memory_order_release);
+  return false;
+}
+
+inline bool CRoutine::Notify() {
+  //只有看到恰好是kParked的那一次通知负责重新调度，其余的通知都被合并
+  if (wait_flags_.fetch_or(kNotified, std::memory_order_acq_rel) != kParked) {
+    return false;
+  }
+  //在放回就绪队列之前清除状态位，之后到达的通知会留给下一次Park()
+  wait_flags_.store(0, std::memory_order_release);
+  state_ = RoutineState::READY;
+  MarkReady();
+  return true;
+}
+
+#endif  // CYBER_CROUTINE_CROUTINE_H_
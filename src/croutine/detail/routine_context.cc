@@ -1,5 +1,7 @@
 #include "routine_context.h"
 
+#include "../../common/log.h"
+
 //  The stack layout looks as follows:
 //
 //              +------------------+
@@ -29,3 +31,51 @@ void MakeContext(const func &f1, const void *arg, RoutineContext *ctx) {
   sp -= sizeof(void *);
   *reinterpret_cast<void **>(sp) = const_cast<void *>(arg);
 }
+
+RoutineContextPool::~RoutineContextPool() {
+  while (free_ != nullptr) {
+    RoutineContext* ctx = free_;
+    free_ = ctx->next;
+    delete ctx;
+  }
+}
+
+RoutineContext* RoutineContextPool::Get() {
+  RoutineContext* ctx = nullptr;
+  bool exceeded = false;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (free_ != nullptr) {
+      ctx = free_;
+      free_ = ctx->next;
+      --free_num_;
+    }
+    //超过容量时只在第一次告警，之后的协程仍然可以创建，只是结束后栈不再缓存
+    exceeded = ++in_use_ > capacity_ && !warned_;
+    warned_ = warned_ || exceeded;
+  }
+  if (exceeded) {
+    AWARN << "Maximum routine context number " << capacity_
+          << " exceeded! Extra stacks will not be cached.";
+  }
+  if (ctx == nullptr) {
+    //不能写成new RoutineContext()：值初始化会把2MB的栈全部清零，每个协程都占满物理内存
+    ctx = new RoutineContext;
+  }
+  ctx->next = nullptr;
+  return ctx;
+}
+
+void RoutineContextPool::Put(RoutineContext* ctx) {
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    --in_use_;
+    if (free_num_ < capacity_) {
+      ctx->next = free_;
+      free_ = ctx;
+      ++free_num_;
+      return;
+    }
+  }
+  delete ctx;
+}
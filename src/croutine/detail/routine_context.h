@@ -1,6 +1,11 @@
+#ifndef CYBER_CROUTINE_DETAIL_ROUTINE_CONTEXT_H_
+#define CYBER_CROUTINE_DETAIL_ROUTINE_CONTEXT_H_
+
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <mutex>
 
 extern "C" {
 extern void ctx_swap(void**, void**) asm("ctx_swap");
@@ -27,6 +32,8 @@ typedef void (*func)(void*);
 struct RoutineContext {
   char stack[STACK_SIZE];
   char* sp = nullptr;
+  //空闲时在RoutineContextPool的链表中的下一个，侵入式链表不需要额外的节点
+  RoutineContext* next = nullptr;
 #if defined __aarch64__
 } __attribute__((aligned(16)));
 #else
@@ -35,6 +42,32 @@ struct RoutineContext {
 
 void MakeContext(const func& f1, const void* arg, RoutineContext* ctx);
 
+//协程栈的对象池。栈有2MB，每次new/delete都是一次mmap/munmap，
+//协程结束后把栈放回池中给下一个协程复用，最多缓存capacity个，超过时直接释放。
+//CRoutine独占自己的RoutineContext，不需要shared_ptr的引用计数。
+class RoutineContextPool {
+ public:
+  explicit RoutineContextPool(uint32_t capacity) : capacity_(capacity) {}
+  ~RoutineContextPool();
+
+  //返回的RoutineContext可能是之前用过的，调用者需要重新MakeContext
+  RoutineContext* Get();
+  void Put(RoutineContext* ctx);
+
+ private:
+  RoutineContextPool(const RoutineContextPool&) = delete;
+  RoutineContextPool& operator=(const RoutineContextPool&) = delete;
+
+  const uint32_t capacity_;
+  std::mutex mutex_;
+  RoutineContext* free_ = nullptr;
+  uint32_t free_num_ = 0;
+  uint32_t in_use_ = 0;
+  bool warned_ = false;
+};
+
 inline void SwapContext(char** src_sp, char** dest_sp) {
   ctx_swap(reinterpret_cast<void**>(src_sp), reinterpret_cast<void**>(dest_sp));
 }
+
+#endif  // CYBER_CROUTINE_DETAIL_ROUTINE_CONTEXT_H_
@@ -17,18 +17,12 @@
 #ifndef CYBER_CROUTINE_ROUTINE_FACTORY_H_
 #define CYBER_CROUTINE_ROUTINE_FACTORY_H_
 
+#include <functional>
 #include <memory>
 #include <utility>
 
-#include "cyber/common/global_data.h"
-#include "cyber/common/log.h"
-#include "cyber/croutine/croutine.h"
-#include "cyber/data/data_visitor.h"
-#include "cyber/event/perf_event_cache.h"
-
-namespace apollo {
-namespace cyber {
-namespace croutine {
+#include "../data/data_visitor.h"
+#include "./croutine.h"
 
 class RoutineFactory {
  public:
@@ -36,37 +30,34 @@ class RoutineFactory {
   using CreateRoutineFunc = std::function<VoidFunc()>;
   // We can use routine_func directly.
   CreateRoutineFunc create_routine;
-  inline std::shared_ptr<data::DataVisitorBase> GetDataVisitor() const {
+  inline std::shared_ptr<DataVisitorBase> GetDataVisitor() const {
     return data_visitor_;
   }
-  inline void SetDataVisitor(const std::shared_ptr<data::DataVisitorBase>& dv) {
+  inline void SetDataVisitor(const std::shared_ptr<DataVisitorBase>& dv) {
     data_visitor_ = dv;
   }
 
  private:
-  std::shared_ptr<data::DataVisitorBase> data_visitor_ = nullptr;
+  std::shared_ptr<DataVisitorBase> data_visitor_ = nullptr;
 };
 
 template <typename M0, typename F>
 RoutineFactory CreateRoutineFactory(
-    F&& f, const std::shared_ptr<data::DataVisitor<M0>>& dv) {
+    F&& f, const std::shared_ptr<DataVisitor<M0>>& dv) {
   RoutineFactory factory;
   factory.SetDataVisitor(dv);
   //创建协程，该协程的函数体为如下的lambda表达式
-  //默认将该协程执行时当前协程状态设为等数据状态
-  //然后通过data_visitor去获取数据，再调用函数，执行完后将协程状态设为RoutineState::READY并切换出去
-  //如果获取不到数据则直接让出cpu给其他协程
-  //DataVisitor和协程的调度专门作为主题文章后面继续介绍
+  //通过data_visitor去获取数据，再调用函数，执行完后将协程状态设为RoutineState::READY并切换出去
+  //如果获取不到数据则挂起协程（DATA_WAIT），直到主通道写入新的数据时被唤醒，不会空转
   factory.create_routine = [=]() {
     return [=]() {
       std::shared_ptr<M0> msg;
       for (;;) {
-        CRoutine::GetCurrentRoutine()->set_state(RoutineState::DATA_WAIT);
         if (dv->TryFetch(msg)) {
           f(msg);
           CRoutine::Yield(RoutineState::READY);
         } else {
-          CRoutine::Yield();
+          dv->WaitData();
         }
       }
     };
@@ -76,7 +67,7 @@ RoutineFactory CreateRoutineFactory(
 
 template <typename M0, typename M1, typename F>
 RoutineFactory CreateRoutineFactory(
-    F&& f, const std::shared_ptr<data::DataVisitor<M0, M1>>& dv) {
+    F&& f, const std::shared_ptr<DataVisitor<M0, M1>>& dv) {
   RoutineFactory factory;
   factory.SetDataVisitor(dv);
   factory.create_routine = [=]() {
@@ -84,12 +75,11 @@ RoutineFactory CreateRoutineFactory(
       std::shared_ptr<M0> msg0;
       std::shared_ptr<M1> msg1;
       for (;;) {
-        CRoutine::GetCurrentRoutine()->set_state(RoutineState::DATA_WAIT);
         if (dv->TryFetch(msg0, msg1)) {
           f(msg0, msg1);
           CRoutine::Yield(RoutineState::READY);
         } else {
-          CRoutine::Yield();
+          dv->WaitData();
         }
       }
     };
@@ -99,7 +89,7 @@ RoutineFactory CreateRoutineFactory(
 
 template <typename M0, typename M1, typename M2, typename F>
 RoutineFactory CreateRoutineFactory(
-    F&& f, const std::shared_ptr<data::DataVisitor<M0, M1, M2>>& dv) {
+    F&& f, const std::shared_ptr<DataVisitor<M0, M1, M2>>& dv) {
   RoutineFactory factory;
   factory.SetDataVisitor(dv);
   factory.create_routine = [=]() {
@@ -108,12 +98,11 @@ RoutineFactory CreateRoutineFactory(
       std::shared_ptr<M1> msg1;
       std::shared_ptr<M2> msg2;
       for (;;) {
-        CRoutine::GetCurrentRoutine()->set_state(RoutineState::DATA_WAIT);
         if (dv->TryFetch(msg0, msg1, msg2)) {
           f(msg0, msg1, msg2);
           CRoutine::Yield(RoutineState::READY);
         } else {
-          CRoutine::Yield();
+          dv->WaitData();
         }
       }
     };
@@ -123,7 +112,7 @@ RoutineFactory CreateRoutineFactory(
 
 template <typename M0, typename M1, typename M2, typename M3, typename F>
 RoutineFactory CreateRoutineFactory(
-    F&& f, const std::shared_ptr<data::DataVisitor<M0, M1, M2, M3>>& dv) {
+    F&& f, const std::shared_ptr<DataVisitor<M0, M1, M2, M3>>& dv) {
   RoutineFactory factory;
   factory.SetDataVisitor(dv);
   factory.create_routine = [=]() {
@@ -133,12 +122,11 @@ RoutineFactory CreateRoutineFactory(
       std::shared_ptr<M2> msg2;
       std::shared_ptr<M3> msg3;
       for (;;) {
-        CRoutine::GetCurrentRoutine()->set_state(RoutineState::DATA_WAIT);
         if (dv->TryFetch(msg0, msg1, msg2, msg3)) {
           f(msg0, msg1, msg2, msg3);
           CRoutine::Yield(RoutineState::READY);
         } else {
-          CRoutine::Yield();
+          dv->WaitData();
         }
       }
     };
@@ -153,8 +141,4 @@ RoutineFactory CreateRoutineFactory(Function&& f) {
   return factory;
 }
 
-}  // namespace croutine
-}  // namespace cyber
-}  // namespace apollo
-
 #endif  // CYBER_CROUTINE_ROUTINE_FACTORY_H_
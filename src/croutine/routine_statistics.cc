@@ -0,0 +1,19 @@
+#include "./routine_statistics.h"
+
+#ifdef CYBER_ROUTINE_STATISTICS
+
+void RoutineProfiler::Snapshot(RoutineStatistics* stats) const {
+  double ns_per_tick = TscClock::NsPerTick();
+  auto to_ns = [ns_per_tick](const std::atomic<uint64_t>& ticks) {
+    return static_cast<uint64_t>(ticks.load(std::memory_order_relaxed) *
+                                 ns_per_tick);
+  };
+  stats->resume_count = resume_count_.load(std::memory_order_relaxed);
+  stats->run_time_ns = to_ns(run_ticks_);
+  for (int i = 0; i < RoutineStatistics::kStateNum; ++i) {
+    stats->state_time_ns[i] = to_ns(state_ticks_[i]);
+  }
+  stats->max_ready_delay_ns = to_ns(max_ready_delay_);
+}
+
+#endif  // CYBER_ROUTINE_STATISTICS
@@ -0,0 +1,99 @@
+#ifndef CYBER_CROUTINE_ROUTINE_STATISTICS_H_
+#define CYBER_CROUTINE_ROUTINE_STATISTICS_H_
+
+#include <cstdint>
+#include <string>
+
+//协程运行统计的快照。
+//只有定义了CYBER_ROUTINE_STATISTICS编译时才会采集，否则相关代码全部编译掉，快照中全为0。
+//该宏会改变CRoutine的内存布局，所有源文件必须使用相同的定义编译。
+struct RoutineStatistics {
+  //与RoutineState的取值一一对应
+  static constexpr int kStateNum = 5;
+
+  uint64_t id = 0;
+  std::string name;
+
+  //被Resume的次数，也就是上下文切换的次数
+  uint64_t resume_count = 0;
+  //累计在处理器上运行的时间
+  uint64_t run_time_ns = 0;
+  //不在运行时处于各个状态的累计时间；READY的时间即从就绪到真正被调度运行的等待时间
+  uint64_t state_time_ns[kStateNum] = {};
+  //单次从就绪到运行的最大延迟
+  uint64_t max_ready_delay_ns = 0;
+
+  uint64_t total_ready_delay_ns() const { return state_time_ns[0]; }
+};
+
+#ifdef CYBER_ROUTINE_STATISTICS
+
+#include <atomic>
+
+#include "../common/tsc_clock.h"
+
+//嵌入在每个CRoutine中的计数器。
+//OnResume()/OnYield()只在运行该协程的处理器线程中调用，OnReady()可能在唤醒它的任意线程中调用，
+//每个字段只有一个写者，所以都用relaxed的load/store，不需要原子的读改写。
+class RoutineProfiler {
+ public:
+  RoutineProfiler() { OnReady(); }
+
+  //协程进入READY状态（创建、唤醒、到期）
+  void OnReady() { Store(&ready_tick_, TscClock::Now()); }
+
+  void OnResume() {
+    uint64_t now = TscClock::Now();
+    uint64_t ready = ready_tick_.load(std::memory_order_relaxed);
+    uint64_t exit = exit_tick_.load(std::memory_order_relaxed);
+    if (ready < exit) {
+      ready = exit;
+    }
+    if (resume_count_.load(std::memory_order_relaxed) > 0) {
+      Add(&state_ticks_[last_state_], ready - exit);
+    }
+    uint64_t delay = now > ready ? now - ready : 0;
+    Add(&state_ticks_[0], delay);
+    if (delay > max_ready_delay_.load(std::memory_order_relaxed)) {
+      Store(&max_ready_delay_, delay);
+    }
+    Add(&resume_count_, 1);
+    enter_tick_ = now;
+  }
+
+  //state为协程让出后的状态，让出时已经是READY的直接记录就绪时间，不再读取一次时钟
+  void OnYield(int state) {
+    uint64_t now = TscClock::Now();
+    Add(&run_ticks_, now - enter_tick_);
+    Store(&exit_tick_, now);
+    last_state_ = state;
+    if (state == 0) {
+      Store(&ready_tick_, now);
+    }
+  }
+
+  void Snapshot(RoutineStatistics* stats) const;
+
+ private:
+  static void Add(std::atomic<uint64_t>* counter, uint64_t delta) {
+    counter->store(counter->load(std::memory_order_relaxed) + delta,
+                   std::memory_order_relaxed);
+  }
+  static void Store(std::atomic<uint64_t>* counter, uint64_t value) {
+    counter->store(value, std::memory_order_relaxed);
+  }
+
+  std::atomic<uint64_t> ready_tick_ = {0};
+  std::atomic<uint64_t> exit_tick_ = {0};
+  uint64_t enter_tick_ = 0;
+  int last_state_ = 0;
+
+  std::atomic<uint64_t> resume_count_ = {0};
+  std::atomic<uint64_t> run_ticks_ = {0};
+  std::atomic<uint64_t> state_ticks_[RoutineStatistics::kStateNum] = {};
+  std::atomic<uint64_t> max_ready_delay_ = {0};
+};
+
+#endif  // CYBER_ROUTINE_STATISTICS
+
+#endif  // CYBER_CROUTINE_ROUTINE_STATISTICS_H_
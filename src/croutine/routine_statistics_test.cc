@@ -0,0 +1,66 @@
+#include "./routine_statistics.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "../scheduler/policy/scheduler_classic.h"
+#include "./croutine.h"
+
+TEST(RoutineStatistics, Snapshot) {
+  ClassicGroupConf group;
+  group.name = "stats";
+  group.processor_num = 1;
+  ClassicConf conf;
+  conf.groups.push_back(group);
+  SchedulerClassic sched(conf);
+
+  std::atomic<int> step = {0};
+  ASSERT_TRUE(sched.CreateTask(
+      [&]() {
+        for (int i = 0; i < 10; ++i) {
+          CRoutine::Yield(RoutineState::READY);
+        }
+        CRoutine::GetCurrentRoutine()->Sleep(std::chrono::milliseconds(5));
+        step = 1;
+        CRoutine::Yield(RoutineState::DATA_WAIT);
+        step = 2;
+        //运行一段时间，保证累计运行时间可以观察到
+        auto end = std::chrono::steady_clock::now() +
+                   std::chrono::milliseconds(2);
+        while (std::chrono::steady_clock::now() < end) {
+        }
+        CRoutine::Yield(RoutineState::DATA_WAIT);
+      },
+      "stats"));
+
+  while (step < 1) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  sched.NotifyTask(std::hash<std::string>()("stats"));
+  while (step < 2) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  auto all = sched.GetRoutineStatistics();
+  ASSERT_EQ(all.size(), 1);
+  const auto& stats = all[0];
+  EXPECT_EQ(stats.name, "stats");
+#ifdef CYBER_ROUTINE_STATISTICS
+  const int kSleep = static_cast<int>(RoutineState::SLEEP);
+  const int kDataWait = static_cast<int>(RoutineState::DATA_WAIT);
+  EXPECT_EQ(stats.resume_count, 13);
+  EXPECT_GE(stats.run_time_ns, 2000000);
+  EXPECT_GE(stats.state_time_ns[kSleep], 5000000);
+  EXPECT_GE(stats.state_time_ns[kDataWait], 10000000);
+  EXPECT_GT(stats.total_ready_delay_ns(), 0);
+  EXPECT_GE(stats.total_ready_delay_ns(), stats.max_ready_delay_ns);
+#else
+  EXPECT_EQ(stats.resume_count, 0);
+  EXPECT_EQ(stats.run_time_ns, 0);
+#endif
+}
@@ -0,0 +1,37 @@
+#include "co_cond_var.h"
+
+void CoCondVar::wait(std::unique_lock<CoMutex>& lock) {
+  CoWaiter waiter;
+  {
+    std::lock_guard<CoSpinLock> lg(spin_);
+    waiters_.PushBack(&waiter);
+  }
+  //先入队再释放锁，持锁修改条件后的notify一定能看到这个等待者
+  lock.unlock();
+  waiter.Wait();
+  lock.lock();
+}
+
+void CoCondVar::notify_one() {
+  CoWaiter* waiter = nullptr;
+  {
+    std::lock_guard<CoSpinLock> lg(spin_);
+    waiter = waiters_.PopFront();
+  }
+  if (waiter != nullptr) {
+    waiter->Wake();
+  }
+}
+
+void CoCondVar::notify_all() {
+  CoWaitQueue waiters;
+  {
+    std::lock_guard<CoSpinLock> lg(spin_);
+    while (!waiters_.Empty()) {
+      waiters.PushBack(waiters_.PopFront());
+    }
+  }
+  while (!waiters.Empty()) {
+    waiters.PopFront()->Wake();
+  }
+}
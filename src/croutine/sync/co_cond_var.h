@@ -0,0 +1,35 @@
+#ifndef CYBER_CROUTINE_SYNC_CO_COND_VAR_H_
+#define CYBER_CROUTINE_SYNC_CO_COND_VAR_H_
+
+#include <mutex>
+
+#include "co_mutex.h"
+#include "co_wait_queue.h"
+
+//协程条件变量，接口与std::condition_variable一致，配合CoMutex使用。
+//wait()把当前协程挂起在条件变量上并释放锁，被唤醒后重新加锁；notify_one()只唤醒一个等待者。
+class CoCondVar {
+ public:
+  CoCondVar() = default;
+
+  void wait(std::unique_lock<CoMutex>& lock);
+
+  template <typename Predicate>
+  void wait(std::unique_lock<CoMutex>& lock, Predicate pred) {
+    while (!pred()) {
+      wait(lock);
+    }
+  }
+
+  void notify_one();
+  void notify_all();
+
+ private:
+  CoCondVar(const CoCondVar&) = delete;
+  CoCondVar& operator=(const CoCondVar&) = delete;
+
+  CoSpinLock spin_;
+  CoWaitQueue waiters_;
+};
+
+#endif  // CYBER_CROUTINE_SYNC_CO_COND_VAR_H_
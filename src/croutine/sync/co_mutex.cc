@@ -0,0 +1,76 @@
+#include "co_mutex.h"
+
+#include <mutex>
+
+constexpr uint32_t CoMutex::kUnlocked;
+constexpr uint32_t CoMutex::kLocked;
+constexpr uint32_t CoMutex::kContended;
+
+bool CoMutex::try_lock() {
+  uint32_t expected = kUnlocked;
+  return state_.compare_exchange_strong(expected, kLocked,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed);
+}
+
+void CoMutex::lock() {
+  if (try_lock()) {
+    return;
+  }
+
+  bool woken = false;
+  for (;;) {
+    CoWaiter waiter;
+    {
+      std::lock_guard<CoSpinLock> lg(spin_);
+      //持有spin_时标记kContended再入队；unlock()的快速路径CAS kLocked->kUnlocked会失败，
+      //从而进入慢路径在spin_下看到这个等待者
+      uint32_t state = state_.load(std::memory_order_relaxed);
+      for (;;) {
+        if (state == kUnlocked) {
+          uint32_t locked = waiters_.Empty() ? kLocked : kContended;
+          if (state_.compare_exchange_weak(state, locked,
+                                           std::memory_order_acquire,
+                                           std::memory_order_relaxed)) {
+            return;
+          }
+        } else if (state == kContended ||
+                   state_.compare_exchange_weak(state, kContended,
+                                                std::memory_order_relaxed,
+                                                std::memory_order_relaxed)) {
+          break;
+        }
+      }
+      //被唤醒后又被其他协程抢先拿到锁的等待者回到队首，避免饿死
+      if (woken) {
+        waiters_.PushFront(&waiter);
+      } else {
+        waiters_.PushBack(&waiter);
+      }
+    }
+    waiter.Wait();
+    woken = true;
+  }
+}
+
+//不直接把锁移交给等待者：被唤醒的协程要等处理器调度到才能运行，移交会让锁在这段时间内空闲，
+//所有协程排成一列（lock convoy）。这里释放锁并唤醒一个等待者，由它重新竞争，
+//期间正在运行的协程可以直接拿到锁
+void CoMutex::unlock() {
+  uint32_t expected = kLocked;
+  if (state_.compare_exchange_strong(expected, kUnlocked,
+                                     std::memory_order_release,
+                                     std::memory_order_relaxed)) {
+    return;
+  }
+
+  CoWaiter* next = nullptr;
+  {
+    std::lock_guard<CoSpinLock> lg(spin_);
+    next = waiters_.PopFront();
+    state_.store(kUnlocked, std::memory_order_release);
+  }
+  if (next != nullptr) {
+    next->Wake();
+  }
+}
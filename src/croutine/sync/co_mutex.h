@@ -0,0 +1,35 @@
+#ifndef CYBER_CROUTINE_SYNC_CO_MUTEX_H_
+#define CYBER_CROUTINE_SYNC_CO_MUTEX_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "co_wait_queue.h"
+
+//协程互斥锁，接口与std::mutex一致，可以配合std::lock_guard/std::unique_lock使用。
+//拿不到锁时挂起当前协程而不是阻塞处理器线程，同一处理器上的其他协程可以继续运行；
+//持有锁期间也可以让出（Yield/Sleep/IO等待）。
+//unlock()时如果有等待者，只唤醒队首的一个，由它重新竞争锁。
+class CoMutex {
+ public:
+  CoMutex() = default;
+
+  void lock();
+  bool try_lock();
+  void unlock();
+
+ private:
+  CoMutex(const CoMutex&) = delete;
+  CoMutex& operator=(const CoMutex&) = delete;
+
+  static constexpr uint32_t kUnlocked = 0;
+  static constexpr uint32_t kLocked = 1;
+  //已加锁并且可能有等待者，unlock()需要进入慢路径
+  static constexpr uint32_t kContended = 2;
+
+  std::atomic<uint32_t> state_ = {kUnlocked};
+  CoSpinLock spin_;
+  CoWaitQueue waiters_;
+};
+
+#endif  // CYBER_CROUTINE_SYNC_CO_MUTEX_H_
@@ -0,0 +1,90 @@
+//10k个协程在4个处理器上争用同一把锁，对比std::mutex和CoMutex：
+//每个协程循环加锁、在临界区内做一小段计算、解锁、让出。
+//std::mutex拿不到锁时阻塞整个处理器线程，CoMutex只挂起当前协程。
+//用法：co_mutex_benchmark [routines=10000] [loops=100] [processors=4]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../scheduler/policy/scheduler_classic.h"
+#include "co_mutex.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+//临界区内的计算，大约几百纳秒
+uint64_t Work(uint64_t seed) {
+  for (int i = 0; i < 100; ++i) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  }
+  return seed;
+}
+
+template <typename Mutex>
+void Run(const std::string& name, int routines, int loops, int processors) {
+  ClassicGroupConf group;
+  group.name = "contention";
+  group.processor_num = processors;
+  ClassicConf conf;
+  conf.groups.push_back(group);
+  SchedulerClassic sched(conf);
+
+  Mutex mutex;
+  uint64_t shared = 0;
+  std::atomic<int> done = {0};
+  std::vector<std::vector<double>> waits(routines);
+  auto begin = Clock::now();
+  for (int i = 0; i < routines; ++i) {
+    waits[i].reserve(loops);
+    sched.CreateTask(
+        [&, i]() {
+          for (int j = 0; j < loops; ++j) {
+            auto start = Clock::now();
+            {
+              std::lock_guard<Mutex> lg(mutex);
+              waits[i].push_back(
+                  std::chrono::duration<double, std::micro>(Clock::now() -
+                                                            start)
+                      .count());
+              shared = Work(shared);
+            }
+            CRoutine::Yield(RoutineState::READY);
+          }
+          done++;
+        },
+        name + std::to_string(i));
+  }
+  while (done < routines) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+  sched.Shutdown();
+
+  std::vector<double> all;
+  all.reserve(static_cast<size_t>(routines) * loops);
+  for (auto& w : waits) {
+    all.insert(all.end(), w.begin(), w.end());
+  }
+  std::sort(all.begin(), all.end());
+  std::cout << name << ": " << all.size() / seconds / 1e6
+            << " M locks/s, wait p50 " << all[all.size() / 2] << " us, p99 "
+            << all[all.size() * 99 / 100] << " us" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int routines = argc > 1 ? std::atoi(argv[1]) : 10000;
+  int loops = argc > 2 ? std::atoi(argv[2]) : 100;
+  int processors = argc > 3 ? std::atoi(argv[3]) : 4;
+  Run<std::mutex>("std_mutex_", routines, loops, processors);
+  Run<CoMutex>("co_mutex_", routines, loops, processors);
+  return 0;
+}
@@ -0,0 +1,74 @@
+#include "co_rw_lock.h"
+
+#include <mutex>
+
+namespace {
+
+void WakeAll(CoWaitQueue* ready) {
+  while (!ready->Empty()) {
+    ready->PopFront()->Wake();
+  }
+}
+
+}  // namespace
+
+void CoRWLock::ReadLock() {
+  CoWaiter waiter;
+  {
+    std::lock_guard<CoSpinLock> lg(spin_);
+    bool writer_waiting = write_first_ && !writers_.Empty();
+    if (lock_num_ >= RW_LOCK_FREE && !writer_waiting) {
+      ++lock_num_;
+      return;
+    }
+    readers_.PushBack(&waiter);
+  }
+  waiter.Wait();
+}
+
+void CoRWLock::WriteLock() {
+  CoWaiter waiter;
+  {
+    std::lock_guard<CoSpinLock> lg(spin_);
+    if (lock_num_ == RW_LOCK_FREE) {
+      lock_num_ = WRITE_EXCLUSIVE;
+      return;
+    }
+    writers_.PushBack(&waiter);
+  }
+  waiter.Wait();
+}
+
+void CoRWLock::ReadUnlock() {
+  CoWaitQueue ready;
+  {
+    std::lock_guard<CoSpinLock> lg(spin_);
+    if (--lock_num_ == RW_LOCK_FREE) {
+      HandOff(&ready);
+    }
+  }
+  WakeAll(&ready);
+}
+
+void CoRWLock::WriteUnlock() {
+  CoWaitQueue ready;
+  {
+    std::lock_guard<CoSpinLock> lg(spin_);
+    lock_num_ = RW_LOCK_FREE;
+    HandOff(&ready);
+  }
+  WakeAll(&ready);
+}
+
+void CoRWLock::HandOff(CoWaitQueue* ready) {
+  bool prefer_writer = write_first_ || readers_.Empty();
+  if (prefer_writer && !writers_.Empty()) {
+    lock_num_ = WRITE_EXCLUSIVE;
+    ready->PushBack(writers_.PopFront());
+    return;
+  }
+  while (!readers_.Empty()) {
+    ++lock_num_;
+    ready->PushBack(readers_.PopFront());
+  }
+}
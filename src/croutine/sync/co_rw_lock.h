@@ -0,0 +1,40 @@
+#ifndef CYBER_CROUTINE_SYNC_CO_RW_LOCK_H_
+#define CYBER_CROUTINE_SYNC_CO_RW_LOCK_H_
+
+#include <cstdint>
+
+#include "co_wait_queue.h"
+
+//协程读写锁，读写语义与AtomicRWLock一致：
+//多个读者可以同时持有，写者独占；write_first为true（默认）时有写者在等待，新的读者也要排队。
+//拿不到锁时挂起协程而不是自旋，解锁时把锁直接移交给下一个写者或者全部等待的读者。
+class CoRWLock {
+ public:
+  CoRWLock() {}
+  explicit CoRWLock(bool write_first) : write_first_(write_first) {}
+
+  void ReadLock();
+  void WriteLock();
+
+  void ReadUnlock();
+  void WriteUnlock();
+
+ private:
+  CoRWLock(const CoRWLock&) = delete;
+  CoRWLock& operator=(const CoRWLock&) = delete;
+
+  //把锁移交给等待者，调用时持有spin_，被移交的等待者放入ready中由调用者在释放spin_后唤醒
+  void HandOff(CoWaitQueue* ready);
+
+  static const int32_t RW_LOCK_FREE = 0;
+  static const int32_t WRITE_EXCLUSIVE = -1;
+
+  CoSpinLock spin_;
+  //大于0为持有锁的读者个数，WRITE_EXCLUSIVE表示写者持有
+  int32_t lock_num_ = RW_LOCK_FREE;
+  CoWaitQueue readers_;
+  CoWaitQueue writers_;
+  bool write_first_ = true;
+};
+
+#endif  // CYBER_CROUTINE_SYNC_CO_RW_LOCK_H_
@@ -0,0 +1,45 @@
+#include "co_semaphore.h"
+
+#include <mutex>
+
+void CoSemaphore::acquire() {
+  CoWaiter waiter;
+  {
+    std::lock_guard<CoSpinLock> lg(spin_);
+    if (count_ > 0) {
+      --count_;
+      return;
+    }
+    waiters_.PushBack(&waiter);
+  }
+  waiter.Wait();
+}
+
+bool CoSemaphore::try_acquire() {
+  std::lock_guard<CoSpinLock> lg(spin_);
+  if (count_ > 0) {
+    --count_;
+    return true;
+  }
+  return false;
+}
+
+void CoSemaphore::release(int64_t update) {
+  CoWaitQueue ready;
+  {
+    std::lock_guard<CoSpinLock> lg(spin_);
+    while (update > 0 && !waiters_.Empty()) {
+      ready.PushBack(waiters_.PopFront());
+      --update;
+    }
+    count_ += update;
+  }
+  while (!ready.Empty()) {
+    ready.PopFront()->Wake();
+  }
+}
+
+int64_t CoSemaphore::count() {
+  std::lock_guard<CoSpinLock> lg(spin_);
+  return count_;
+}
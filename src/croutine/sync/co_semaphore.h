@@ -0,0 +1,29 @@
+#ifndef CYBER_CROUTINE_SYNC_CO_SEMAPHORE_H_
+#define CYBER_CROUTINE_SYNC_CO_SEMAPHORE_H_
+
+#include <cstdint>
+
+#include "co_wait_queue.h"
+
+//协程计数信号量，接口与C++20的std::counting_semaphore类似。
+//计数为0时acquire()挂起当前协程；release()有等待者时把计数直接移交给队首的等待者。
+class CoSemaphore {
+ public:
+  explicit CoSemaphore(int64_t count = 0) : count_(count) {}
+
+  void acquire();
+  bool try_acquire();
+  void release(int64_t update = 1);
+
+  int64_t count();
+
+ private:
+  CoSemaphore(const CoSemaphore&) = delete;
+  CoSemaphore& operator=(const CoSemaphore&) = delete;
+
+  CoSpinLock spin_;
+  int64_t count_ = 0;
+  CoWaitQueue waiters_;
+};
+
+#endif  // CYBER_CROUTINE_SYNC_CO_SEMAPHORE_H_
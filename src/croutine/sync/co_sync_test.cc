@@ -0,0 +1,222 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "../../scheduler/policy/scheduler_classic.h"
+#include "../../test_util.h"
+#include "co_cond_var.h"
+#include "co_mutex.h"
+#include "co_rw_lock.h"
+#include "co_semaphore.h"
+
+namespace {
+
+ClassicConf Conf(int processor_num) {
+  ClassicGroupConf group;
+  group.name = "sync";
+  group.processor_num = processor_num;
+  ClassicConf conf;
+  conf.groups.push_back(group);
+  return conf;
+}
+
+void YieldReady() { CRoutine::Yield(RoutineState::READY); }
+
+}  // namespace
+
+//持有锁期间让出，同一处理器上的其他协程不会被阻塞，也不会进入临界区
+TEST(CoSync, MutexYieldInsideCriticalSection) {
+  SchedulerClassic sched(Conf(2));
+  CoMutex mutex;
+  int counter = 0;
+  std::atomic<int> inside = {0};
+  std::atomic<int> overlap = {0};
+  std::atomic<int> done = {0};
+  const int kRoutines = 100;
+  const int kLoops = 20;
+  for (int i = 0; i < kRoutines; ++i) {
+    sched.CreateTask(
+        [&]() {
+          for (int j = 0; j < kLoops; ++j) {
+            std::lock_guard<CoMutex> lg(mutex);
+            if (inside++ != 0) {
+              overlap++;
+            }
+            int value = counter;
+            YieldReady();
+            counter = value + 1;
+            inside--;
+          }
+          done++;
+        },
+        "mutex_" + std::to_string(i));
+  }
+  WaitFor([&]() { return done >= kRoutines; }, std::chrono::seconds(10));
+  EXPECT_EQ(done, kRoutines);
+  EXPECT_EQ(overlap, 0);
+  std::lock_guard<CoMutex> lg(mutex);
+  EXPECT_EQ(counter, kRoutines * kLoops);
+}
+
+//等待者刚入队时由普通线程unlock，被唤醒的协程拿到锁后立即结束并被删除，
+//与unlock中仍在进行的Wakeup()竞争
+TEST(CoSync, MutexUnlockRacesFinishingWaiter) {
+  SchedulerClassic sched(Conf(2));
+  CoMutex mutex;
+  std::atomic<int> started = {0};
+  std::atomic<int> done = {0};
+  const int kRounds = 2000;
+  for (int i = 0; i < kRounds; ++i) {
+    mutex.lock();
+    sched.CreateTask(
+        [&]() {
+          started++;
+          mutex.lock();
+          mutex.unlock();
+          done++;
+        },
+        "waiter_" + std::to_string(i));
+    while (started <= i) {
+      std::this_thread::yield();
+    }
+    mutex.unlock();
+  }
+  WaitFor([&]() { return done >= kRounds; }, std::chrono::seconds(10));
+  EXPECT_EQ(done, kRounds);
+}
+
+TEST(CoSync, CondVarProducerConsumer) {
+  SchedulerClassic sched(Conf(1));
+  CoMutex mutex;
+  CoCondVar cv;
+  int items = 0;
+  std::atomic<int> consumed = {0};
+  const int kConsumers = 10;
+  const int kItems = 1000;
+  for (int i = 0; i < kConsumers; ++i) {
+    sched.CreateTask(
+        [&]() {
+          for (;;) {
+            std::unique_lock<CoMutex> lk(mutex);
+            cv.wait(lk, [&]() { return items > 0; });
+            --items;
+            if (++consumed == kItems) {
+              return;
+            }
+          }
+        },
+        "consumer_" + std::to_string(i));
+  }
+  //生产者是普通线程
+  for (int i = 0; i < kItems; ++i) {
+    {
+      std::lock_guard<CoMutex> lg(mutex);
+      ++items;
+    }
+    cv.notify_one();
+  }
+  WaitFor([&]() { return consumed >= kItems; }, std::chrono::seconds(10));
+  EXPECT_EQ(consumed, kItems);
+}
+
+TEST(CoSync, SemaphoreLimitsConcurrency) {
+  SchedulerClassic sched(Conf(2));
+  CoSemaphore sem(3);
+  std::atomic<int> active = {0};
+  std::atomic<int> max_active = {0};
+  std::atomic<int> done = {0};
+  const int kRoutines = 50;
+  for (int i = 0; i < kRoutines; ++i) {
+    sched.CreateTask(
+        [&]() {
+          sem.acquire();
+          int now = ++active;
+          int prev = max_active.load();
+          while (now > prev && !max_active.compare_exchange_weak(prev, now)) {
+          }
+          CRoutine::GetCurrentRoutine()->Sleep(std::chrono::milliseconds(1));
+          active--;
+          sem.release();
+          done++;
+        },
+        "sem_" + std::to_string(i));
+  }
+  WaitFor([&]() { return done >= kRoutines; }, std::chrono::seconds(10));
+  EXPECT_EQ(done, kRoutines);
+  EXPECT_EQ(max_active, 3);
+  EXPECT_EQ(sem.count(), 3);
+  EXPECT_FALSE(sem.try_acquire() && sem.try_acquire() && sem.try_acquire() &&
+               sem.try_acquire());
+}
+
+TEST(CoSync, RWLockReadersShareWritersExclusive) {
+  SchedulerClassic sched(Conf(2));
+  CoRWLock lock;
+  std::atomic<int> readers = {0};
+  std::atomic<int> writers = {0};
+  std::atomic<int> violations = {0};
+  std::atomic<int> done = {0};
+  const int kRoutines = 40;
+  for (int i = 0; i < kRoutines; ++i) {
+    bool writer = i % 4 == 0;
+    sched.CreateTask(
+        [&, writer]() {
+          for (int j = 0; j < 10; ++j) {
+            if (writer) {
+              lock.WriteLock();
+              if (writers++ != 0 || readers != 0) {
+                violations++;
+              }
+              YieldReady();
+              writers--;
+              lock.WriteUnlock();
+            } else {
+              lock.ReadLock();
+              readers++;
+              if (writers != 0) {
+                violations++;
+              }
+              YieldReady();
+              readers--;
+              lock.ReadUnlock();
+            }
+          }
+          done++;
+        },
+        "rw_" + std::to_string(i));
+  }
+  WaitFor([&]() { return done >= kRoutines; }, std::chrono::seconds(10));
+  EXPECT_EQ(done, kRoutines);
+  EXPECT_EQ(violations, 0);
+
+  //主线程持有读锁时协程可以拿到读锁，拿不到写锁。
+  //write_first下有写者排队时新的读者也要等待，所以先验证读者
+  std::atomic<int> read_locked = {0};
+  std::atomic<int> write_locked = {0};
+  lock.ReadLock();
+  sched.CreateTask(
+      [&]() {
+        lock.ReadLock();
+        read_locked++;
+        lock.ReadUnlock();
+      },
+      "shared_reader");
+  WaitFor([&]() { return read_locked >= 1; }, std::chrono::seconds(10));
+  EXPECT_EQ(read_locked, 1);
+  sched.CreateTask(
+      [&]() {
+        lock.WriteLock();
+        write_locked++;
+        lock.WriteUnlock();
+      },
+      "blocked_writer");
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(write_locked, 0);
+  lock.ReadUnlock();
+  WaitFor([&]() { return write_locked >= 1; }, std::chrono::seconds(10));
+  EXPECT_EQ(write_locked, 1);
+}
@@ -0,0 +1,126 @@
+#ifndef CYBER_CROUTINE_SYNC_CO_WAIT_QUEUE_H_
+#define CYBER_CROUTINE_SYNC_CO_WAIT_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "../../scheduler/processor_context.h"
+#include "../croutine.h"
+
+//同步原语内部使用的自旋锁，只保护等待队列的几次指针操作，持有期间不会切换协程
+class CoSpinLock {
+ public:
+  void lock() {
+    uint32_t retry_times = 0;
+    while (flag_.test_and_set(std::memory_order_acquire)) {
+      if (++retry_times == kMaxRetryTimes) {
+        // saving cpu
+        std::this_thread::yield();
+        retry_times = 0;
+      }
+    }
+  }
+  void unlock() { flag_.clear(std::memory_order_release); }
+
+ private:
+  static constexpr uint32_t kMaxRetryTimes = 5;
+  std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+//挂起在同步原语上的等待者，节点分配在等待者自己的栈上，入队不需要分配内存。
+//在协程中等待时以DATA_WAIT挂起（CRoutine::HangUp），由Wake()通过所在处理器的Wakeup()恢复；
+//不在协程中（普通线程）时退化为让出时间片的自旋等待。
+class CoWaiter {
+ public:
+  CoWaiter()
+      : cr_(CRoutine::GetCurrentRoutine()), ctx_(ProcessorContext::Current()) {
+    if (cr_ == nullptr || ctx_ == nullptr) {
+      cr_ = nullptr;
+      ctx_ = nullptr;
+    }
+  }
+
+  //阻塞直到Wake()，多余的唤醒（例如其他地方的Notify）会重新挂起
+  void Wait() {
+    while (!woken_.load(std::memory_order_acquire)) {
+      if (ctx_ != nullptr) {
+        cr_->HangUp();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  //woken_置位之后等待者随时可能返回并销毁节点，等待的协程也可能立即运行结束并被调度器释放，
+  //所以置位之前先取出需要的字段，并取得协程的强引用，保证Wakeup()期间协程不会被析构
+  void Wake() {
+    ProcessorContext* ctx = ctx_;
+    std::shared_ptr<CRoutine> cr;
+    if (ctx != nullptr) {
+      cr = ctx->GetRoutine(cr_->id());
+    }
+    woken_.store(true, std::memory_order_release);
+    if (cr != nullptr) {
+      ctx->Wakeup(cr.get());
+    }
+  }
+
+ private:
+  friend class CoWaitQueue;
+
+  CRoutine* cr_ = nullptr;
+  ProcessorContext* ctx_ = nullptr;
+  std::atomic<bool> woken_ = {false};
+  CoWaiter* next_ = nullptr;
+};
+
+//CoWaiter的侵入式FIFO队列，由使用者持有CoSpinLock访问
+class CoWaitQueue {
+ public:
+  bool Empty() const { return head_ == nullptr; }
+  size_t Size() const { return size_; }
+  CoWaiter* Front() const { return head_; }
+
+  void PushBack(CoWaiter* waiter) {
+    waiter->next_ = nullptr;
+    if (tail_ == nullptr) {
+      head_ = waiter;
+    } else {
+      tail_->next_ = waiter;
+    }
+    tail_ = waiter;
+    ++size_;
+  }
+
+  void PushFront(CoWaiter* waiter) {
+    waiter->next_ = head_;
+    head_ = waiter;
+    if (tail_ == nullptr) {
+      tail_ = waiter;
+    }
+    ++size_;
+  }
+
+  CoWaiter* PopFront() {
+    CoWaiter* waiter = head_;
+    if (waiter == nullptr) {
+      return nullptr;
+    }
+    head_ = waiter->next_;
+    if (head_ == nullptr) {
+      tail_ = nullptr;
+    }
+    --size_;
+    return waiter;
+  }
+
+ private:
+  CoWaiter* head_ = nullptr;
+  CoWaiter* tail_ = nullptr;
+  size_t size_ = 0;
+};
+
+#endif  // CYBER_CROUTINE_SYNC_CO_WAIT_QUEUE_H_
@@ -0,0 +1,68 @@
+#ifndef CYBER_DATA_CHANNEL_H_
+#define CYBER_DATA_CHANNEL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "../bounded_queue.h"
+#include "data_notifier.h"
+
+//QUEUED：按写入顺序缓存最多capacity条消息，满了之后丢弃最旧的消息
+//LATEST：只保留最新的一条消息
+enum class ChannelPolicy { QUEUED, LATEST };
+
+//类型化的消息通道，基于无锁的BoundedQueue<std::shared_ptr<M>>实现，
+//可以有多个写者，只有一个读者（DataVisitor）。读者注册的DataNotifier在每次写入后被通知，
+//挂起等待数据的协程会被直接唤醒，不需要轮询。
+template <typename M>
+class Channel {
+ public:
+  explicit Channel(uint64_t capacity = 16,
+                   ChannelPolicy policy = ChannelPolicy::QUEUED)
+      : policy_(policy) {
+    queue_.Init(policy == ChannelPolicy::LATEST ? 1 : capacity,
+                new BusySpinWaitStrategy());
+  }
+
+  //写入消息，通道满时丢弃最旧的消息，返回false表示有消息被丢弃
+  bool Write(const std::shared_ptr<M>& msg) {
+    bool dropped = false;
+    while (!queue_.Enqueue(msg)) {
+      std::shared_ptr<M> oldest;
+      if (queue_.Dequeue(&oldest)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        dropped = true;
+      }
+    }
+    auto notifier = notifier_.load(std::memory_order_acquire);
+    if (notifier != nullptr) {
+      notifier->Notify();
+    }
+    return !dropped;
+  }
+
+  //非阻塞读取，通道为空时返回false
+  bool Read(std::shared_ptr<M>* msg) { return queue_.Dequeue(msg); }
+
+  bool Empty() { return queue_.Empty(); }
+  uint64_t Size() { return queue_.Size(); }
+  ChannelPolicy policy() const { return policy_; }
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  //由读者注册，读者析构之前需要注销，注销之后不能再并发写入
+  void SetNotifier(DataNotifier* notifier) {
+    notifier_.store(notifier, std::memory_order_release);
+  }
+
+ private:
+  Channel(const Channel&) = delete;
+  Channel& operator=(const Channel&) = delete;
+
+  BoundedQueue<std::shared_ptr<M>> queue_;
+  ChannelPolicy policy_;
+  std::atomic<DataNotifier*> notifier_ = {nullptr};
+  std::atomic<uint64_t> dropped_ = {0};
+};
+
+#endif  // CYBER_DATA_CHANNEL_H_
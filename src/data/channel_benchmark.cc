@@ -0,0 +1,91 @@
+//通道的消息吞吐量以及空闲时的CPU占用，对比两种消费方式：
+//1、park：TryFetch失败时挂起协程，写入时唤醒（CreateRoutineFactory的方式）
+//2、poll：TryFetch失败时直接Yield，协程一直处于就绪状态轮询
+//用法：channel_benchmark [messages]
+#include <time.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "../croutine/routine_factory.h"
+#include "../scheduler/policy/scheduler_classic.h"
+#include "data_visitor.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ProcessCpuSeconds() {
+  timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void Run(bool park, int messages) {
+  ClassicGroupConf group;
+  group.name = "channel";
+  group.processor_num = 1;
+  ClassicConf conf;
+  conf.groups.push_back(group);
+  SchedulerClassic sched(conf);
+
+  auto channel = std::make_shared<Channel<int>>(4096);
+  auto dv = std::make_shared<DataVisitor<int>>(channel);
+  std::atomic<int> received = {0};
+  auto callback = [&received](const std::shared_ptr<int>&) { received++; };
+  if (park) {
+    sched.CreateTask(CreateRoutineFactory<int>(callback, dv).create_routine(),
+                     "consumer");
+  } else {
+    sched.CreateTask(
+        [&]() {
+          std::shared_ptr<int> msg;
+          for (;;) {
+            if (dv->TryFetch(msg)) {
+              callback(msg);
+            }
+            CRoutine::Yield(RoutineState::READY);
+          }
+        },
+        "consumer");
+  }
+
+  //空闲阶段：没有任何消息
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  double cpu_begin = ProcessCpuSeconds();
+  auto wall_begin = Clock::now();
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  double idle_cpu = (ProcessCpuSeconds() - cpu_begin) /
+                    std::chrono::duration<double>(Clock::now() - wall_begin).count();
+
+  //吞吐阶段：写满时让出cpu给消费者
+  auto msg = std::make_shared<int>(0);
+  auto begin = Clock::now();
+  for (int i = 0; i < messages; ++i) {
+    while (channel->Size() >= 4000) {
+      std::this_thread::yield();
+    }
+    channel->Write(msg);
+  }
+  while (received + static_cast<int>(channel->dropped()) < messages) {
+    std::this_thread::yield();
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+  std::cout << (park ? "park" : "poll") << ": " << messages / seconds / 1e6
+            << " M msgs/s, idle cpu " << idle_cpu * 100 << "%" << std::endl;
+  sched.Shutdown();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int messages = argc > 1 ? std::atoi(argv[1]) : 2000000;
+  Run(true, messages);
+  Run(false, messages);
+  return 0;
+}
@@ -0,0 +1,54 @@
+#ifndef CYBER_DATA_DATA_NOTIFIER_H_
+#define CYBER_DATA_DATA_NOTIFIER_H_
+
+#include <atomic>
+#include <thread>
+
+#include "../croutine/croutine.h"
+#include "../scheduler/processor_context.h"
+
+//记录一个等待数据的协程，数据写入时通过所在处理器的Wakeup()唤醒它。
+//没有协程在等待时Notify()只有一次原子读，写数据的一方几乎没有额外开销。
+class DataNotifier {
+ public:
+  //在协程中调用：has_data()返回false时挂起当前协程，直到Notify()
+  template <typename HasData>
+  void Wait(HasData has_data) {
+    auto cr = CRoutine::GetCurrentRoutine();
+    auto ctx = ProcessorContext::Current();
+    if (cr == nullptr || ctx == nullptr) {
+      //不在调度器的处理器线程中运行时没有办法挂起，只能让出cpu后由调用者重试
+      if (cr == nullptr) {
+        std::this_thread::yield();
+      } else {
+        CRoutine::Yield(RoutineState::READY);
+      }
+      return;
+    }
+
+    cr_ = cr;
+    ctx_ = ctx;
+    //先声明等待再检查数据；与Notify()中先写数据再检查waiting_配合，不会丢失唤醒
+    waiting_.store(true, std::memory_order_seq_cst);
+    if (has_data()) {
+      waiting_.store(false, std::memory_order_relaxed);
+      return;
+    }
+    CRoutine::Yield(RoutineState::DATA_WAIT);
+  }
+
+  //可以在任意线程调用
+  void Notify() {
+    if (waiting_.load(std::memory_order_seq_cst) &&
+        waiting_.exchange(false, std::memory_order_acq_rel)) {
+      ctx_->Wakeup(cr_);
+    }
+  }
+
+ private:
+  std::atomic<bool> waiting_ = {false};
+  CRoutine* cr_ = nullptr;
+  ProcessorContext* ctx_ = nullptr;
+};
+
+#endif  // CYBER_DATA_DATA_NOTIFIER_H_
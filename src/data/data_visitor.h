@@ -0,0 +1,79 @@
+#ifndef CYBER_DATA_DATA_VISITOR_H_
+#define CYBER_DATA_DATA_VISITOR_H_
+
+#include <memory>
+#include <tuple>
+#include <utility>
+
+#include "channel.h"
+#include "data_notifier.h"
+
+class DataVisitorBase {
+ public:
+  virtual ~DataVisitorBase() {}
+
+  //在协程中调用：主通道没有数据时挂起当前协程，直到主通道写入新的数据
+  void WaitData() {
+    notifier_.Wait([this]() { return HasData(); });
+  }
+
+ protected:
+  virtual bool HasData() = 0;
+
+  DataNotifier notifier_;
+};
+
+//从1~4个通道读取并融合数据。第一个通道是主通道，只有它的写入会唤醒协程；
+//每次TryFetch从主通道取一条消息，其余通道有新消息时取一条（QUEUED按顺序，LATEST为最新），
+//没有新消息时沿用上一次取到的消息。某个辅助通道还从来没有过消息时，
+//这次取到的主通道消息被丢弃并返回false。
+template <typename M0, typename... Ms>
+class DataVisitor : public DataVisitorBase {
+  static_assert(sizeof...(Ms) <= 3, "DataVisitor supports up to 4 channels");
+
+ public:
+  explicit DataVisitor(const std::shared_ptr<Channel<M0>>& channel0,
+                       const std::shared_ptr<Channel<Ms>>&... channels)
+      : channel0_(channel0), channels_(channels...) {
+    channel0_->SetNotifier(&notifier_);
+  }
+
+  ~DataVisitor() override { channel0_->SetNotifier(nullptr); }
+
+  bool TryFetch(std::shared_ptr<M0>& m0, std::shared_ptr<Ms>&... ms) {
+    if (!channel0_->Read(&m0)) {
+      return false;
+    }
+    return FetchAll(std::index_sequence_for<Ms...>(), ms...);
+  }
+
+ protected:
+  bool HasData() override { return !channel0_->Empty(); }
+
+ private:
+  template <size_t... I>
+  bool FetchAll(std::index_sequence<I...>, std::shared_ptr<Ms>&... ms) {
+    bool ready = true;
+    //每个辅助通道都要读取一次，保证其缓存的消息被及时更新
+    int unused[] = {0, (ready = Fetch<I>(ms) && ready, 0)...};
+    (void)unused;
+    return ready;
+  }
+
+  template <size_t I, typename T>
+  bool Fetch(std::shared_ptr<T>& msg) {
+    auto& latest = std::get<I>(latest_);
+    std::shared_ptr<T> fresh;
+    if (std::get<I>(channels_)->Read(&fresh)) {
+      latest = std::move(fresh);
+    }
+    msg = latest;
+    return msg != nullptr;
+  }
+
+  std::shared_ptr<Channel<M0>> channel0_;
+  std::tuple<std::shared_ptr<Channel<Ms>>...> channels_;
+  std::tuple<std::shared_ptr<Ms>...> latest_;
+};
+
+#endif  // CYBER_DATA_DATA_VISITOR_H_
@@ -0,0 +1,109 @@
+#include "data_visitor.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "../croutine/routine_factory.h"
+#include "../scheduler/policy/scheduler_classic.h"
+
+TEST(DataVisitor, QueuedAndLatest) {
+  auto queued = std::make_shared<Channel<int>>(2, ChannelPolicy::QUEUED);
+  auto latest = std::make_shared<Channel<int>>(8, ChannelPolicy::LATEST);
+  for (int i = 1; i <= 3; ++i) {
+    queued->Write(std::make_shared<int>(i));
+    latest->Write(std::make_shared<int>(i));
+  }
+  EXPECT_EQ(queued->dropped(), 1);
+  EXPECT_EQ(latest->dropped(), 2);
+
+  DataVisitor<int> queued_dv(queued);
+  std::shared_ptr<int> msg;
+  ASSERT_TRUE(queued_dv.TryFetch(msg));
+  EXPECT_EQ(*msg, 2);
+  ASSERT_TRUE(queued_dv.TryFetch(msg));
+  EXPECT_EQ(*msg, 3);
+  EXPECT_FALSE(queued_dv.TryFetch(msg));
+
+  DataVisitor<int> latest_dv(latest);
+  ASSERT_TRUE(latest_dv.TryFetch(msg));
+  EXPECT_EQ(*msg, 3);
+  EXPECT_FALSE(latest_dv.TryFetch(msg));
+}
+
+TEST(DataVisitor, Fusion) {
+  auto c0 = std::make_shared<Channel<int>>();
+  auto c1 = std::make_shared<Channel<std::string>>(4, ChannelPolicy::LATEST);
+  auto c2 = std::make_shared<Channel<double>>();
+  DataVisitor<int, std::string, double> dv(c0, c1, c2);
+  std::shared_ptr<int> m0;
+  std::shared_ptr<std::string> m1;
+  std::shared_ptr<double> m2;
+
+  //辅助通道还没有消息，主通道的消息被丢弃
+  c0->Write(std::make_shared<int>(0));
+  c1->Write(std::make_shared<std::string>("a"));
+  EXPECT_FALSE(dv.TryFetch(m0, m1, m2));
+  EXPECT_FALSE(dv.TryFetch(m0, m1, m2));
+
+  c2->Write(std::make_shared<double>(1.0));
+  c2->Write(std::make_shared<double>(2.0));
+  c0->Write(std::make_shared<int>(1));
+  ASSERT_TRUE(dv.TryFetch(m0, m1, m2));
+  EXPECT_EQ(*m0, 1);
+  EXPECT_EQ(*m1, "a");
+  EXPECT_EQ(*m2, 1.0);
+
+  //辅助通道没有新消息时沿用上一次的消息，QUEUED的辅助通道按顺序取
+  c0->Write(std::make_shared<int>(2));
+  c0->Write(std::make_shared<int>(3));
+  ASSERT_TRUE(dv.TryFetch(m0, m1, m2));
+  EXPECT_EQ(*m0, 2);
+  EXPECT_EQ(*m2, 2.0);
+  ASSERT_TRUE(dv.TryFetch(m0, m1, m2));
+  EXPECT_EQ(*m0, 3);
+  EXPECT_EQ(*m1, "a");
+  EXPECT_EQ(*m2, 2.0);
+}
+
+TEST(DataVisitor, RoutineParksUntilWrite) {
+  ClassicGroupConf group;
+  group.name = "data";
+  group.processor_num = 1;
+  ClassicConf conf;
+  conf.groups.push_back(group);
+  SchedulerClassic sched(conf);
+
+  auto channel = std::make_shared<Channel<int>>(1024);
+  auto dv = std::make_shared<DataVisitor<int>>(channel);
+  std::atomic<int> received = {0};
+  std::atomic<int> sum = {0};
+  auto factory = CreateRoutineFactory<int>(
+      [&](const std::shared_ptr<int>& msg) {
+        sum += *msg;
+        received++;
+      },
+      dv);
+  ASSERT_TRUE(sched.CreateTask(factory.create_routine(), "consumer"));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  std::thread producer([&]() {
+    for (int i = 1; i <= 1000; ++i) {
+      while (!channel->Write(std::make_shared<int>(i))) {
+      }
+      if (i % 100 == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+  });
+  producer.join();
+  for (int i = 0; i < 1000 && received < 1000; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(received, 1000 - static_cast<int>(channel->dropped()));
+  EXPECT_EQ(channel->dropped(), 0);
+  EXPECT_EQ(sum, 500500);
+}
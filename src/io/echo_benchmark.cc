@@ -0,0 +1,206 @@
+//本地回环上的echo服务，对比两种服务端实现的吞吐量和延迟：
+//1、routine：SchedulerClassic上每个连接一个协程，通过Session以IO_WAIT等待fd就绪
+//2、thread：每个连接一个线程，阻塞读写
+//客户端是同一个独立的epoll线程，每个连接发送64字节，收到回复后再发送下一条。
+//用法：echo_benchmark [connections=1000] [seconds=5] [processors=2]
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../scheduler/policy/scheduler_classic.h"
+#include "session.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kMessageSize = 64;
+
+int ListenLoopback(bool nonblock, sockaddr_in* addr) {
+  int fd = socket(AF_INET, SOCK_STREAM | (nonblock ? SOCK_NONBLOCK : 0), 0);
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  *addr = {};
+  addr->sin_family = AF_INET;
+  addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bind(fd, reinterpret_cast<sockaddr*>(addr), sizeof(*addr));
+  listen(fd, 4096);
+  socklen_t len = sizeof(*addr);
+  getsockname(fd, reinterpret_cast<sockaddr*>(addr), &len);
+  return fd;
+}
+
+struct Conn {
+  int fd = -1;
+  size_t received = 0;
+  Clock::time_point sent;
+};
+
+//所有连接都在一个epoll线程里驱动，返回每个请求的往返延迟（微秒）
+std::vector<double> RunClients(const sockaddr_in& addr, int connections,
+                               int seconds, uint64_t* requests) {
+  std::vector<Conn> conns(connections);
+  int epfd = epoll_create1(0);
+  char buf[kMessageSize] = {0};
+  for (auto& conn : conns) {
+    conn.fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(conn.fd, reinterpret_cast<const sockaddr*>(&addr),
+                sizeof(addr)) != 0) {
+      std::cerr << "connect failed" << std::endl;
+      std::exit(1);
+    }
+    int one = 1;
+    setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = &conn;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, conn.fd, &ev);
+  }
+
+  std::vector<double> latencies;
+  latencies.reserve(1 << 22);
+  for (auto& conn : conns) {
+    conn.sent = Clock::now();
+    write(conn.fd, buf, kMessageSize);
+  }
+  auto end = Clock::now() + std::chrono::seconds(seconds);
+  std::vector<epoll_event> events(1024);
+  *requests = 0;
+  while (Clock::now() < end) {
+    int n = epoll_wait(epfd, events.data(), events.size(), 100);
+    auto now = Clock::now();
+    for (int i = 0; i < n; ++i) {
+      auto conn = static_cast<Conn*>(events[i].data.ptr);
+      ssize_t r = read(conn->fd, buf, kMessageSize - conn->received);
+      if (r <= 0) {
+        continue;
+      }
+      conn->received += r;
+      if (conn->received < kMessageSize) {
+        continue;
+      }
+      conn->received = 0;
+      latencies.push_back(
+          std::chrono::duration<double, std::micro>(now - conn->sent).count());
+      ++*requests;
+      conn->sent = now;
+      write(conn->fd, buf, kMessageSize);
+    }
+  }
+  for (auto& conn : conns) {
+    close(conn.fd);
+  }
+  close(epfd);
+  return latencies;
+}
+
+void Report(const std::string& name, std::vector<double> latencies,
+            uint64_t requests, int seconds) {
+  std::sort(latencies.begin(), latencies.end());
+  auto pct = [&latencies](double p) {
+    return latencies.empty() ? 0.0
+                             : latencies[static_cast<size_t>(
+                                   p * (latencies.size() - 1))];
+  };
+  std::cout << name << ": " << requests / seconds << " req/s, p50 " << pct(0.5)
+            << " us, p99 " << pct(0.99) << " us" << std::endl;
+}
+
+void RunRoutineServer(int connections, int seconds, int processors) {
+  ClassicGroupConf group;
+  group.name = "echo";
+  group.processor_num = processors;
+  ClassicConf conf;
+  conf.groups.push_back(group);
+  SchedulerClassic sched(conf);
+
+  sockaddr_in addr;
+  auto server = std::make_shared<Session>(ListenLoopback(true, &addr));
+  sched.CreateTask(
+      [&sched, server]() {
+        for (int id = 0;; ++id) {
+          auto conn = server->Accept(nullptr, nullptr);
+          if (conn == nullptr) {
+            return;
+          }
+          int one = 1;
+          setsockopt(conn->fd(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+          sched.CreateTask(
+              [conn]() {
+                char buf[kMessageSize];
+                ssize_t n = 0;
+                while ((n = conn->Read(buf, sizeof(buf))) > 0) {
+                  conn->Write(buf, n);
+                }
+                conn->Close();
+              },
+              "echo_" + std::to_string(id));
+        }
+      },
+      "acceptor");
+
+  uint64_t requests = 0;
+  auto latencies = RunClients(addr, connections, seconds, &requests);
+  Report("routine(" + std::to_string(processors) + " processors)",
+         std::move(latencies), requests, seconds);
+  sched.Shutdown();
+}
+
+void RunThreadServer(int connections, int seconds) {
+  sockaddr_in addr;
+  int listen_fd = ListenLoopback(false, &addr);
+  std::vector<std::thread> workers;
+  std::thread acceptor([&]() {
+    for (int i = 0; i < connections; ++i) {
+      int fd = accept(listen_fd, nullptr, nullptr);
+      if (fd < 0) {
+        return;
+      }
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      workers.emplace_back([fd]() {
+        char buf[kMessageSize];
+        ssize_t n = 0;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) {
+          write(fd, buf, n);
+        }
+        close(fd);
+      });
+    }
+  });
+
+  uint64_t requests = 0;
+  auto latencies = RunClients(addr, connections, seconds, &requests);
+  acceptor.join();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  close(listen_fd);
+  Report("thread-per-connection", std::move(latencies), requests, seconds);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int connections = argc > 1 ? std::atoi(argv[1]) : 1000;
+  int seconds = argc > 2 ? std::atoi(argv[2]) : 5;
+  int processors = argc > 3 ? std::atoi(argv[3]) : 2;
+  std::cout << connections << " connections, " << kMessageSize
+            << " bytes per request" << std::endl;
+  RunRoutineServer(connections, seconds, processors);
+  RunThreadServer(connections, seconds);
+  return 0;
+}
@@ -0,0 +1,126 @@
+#include "reactor.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "../common/log.h"
+
+constexpr int Reactor::kMaxEvents;
+
+Reactor::Reactor(ProcessorContext* ctx) : ctx_(ctx), events_(kMaxEvents) {
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0) {
+    AERROR << "epoll_create1 failed: " << strerror(errno);
+    return;
+  }
+  event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (event_fd_ < 0) {
+    AERROR << "eventfd failed: " << strerror(errno);
+    return;
+  }
+  epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.ptr = nullptr;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &ev) != 0) {
+    AERROR << "register eventfd failed: " << strerror(errno);
+  }
+}
+
+Reactor::~Reactor() {
+  if (event_fd_ >= 0) {
+    close(event_fd_);
+  }
+  if (epoll_fd_ >= 0) {
+    close(epoll_fd_);
+  }
+}
+
+int Reactor::WaitFd(int fd, uint32_t events, int timeout_ms) {
+  Waiter waiter;
+  waiter.cr = CRoutine::GetCurrentRoutine();
+  waiter.fd = fd;
+
+  //fd上一次就绪后EPOLLONESHOT已经将其禁用，通常只需要MOD重新启用；
+  //第一次等待或者fd被关闭重用过时再ADD
+  epoll_event ev;
+  ev.events = events | EPOLLONESHOT;
+  ev.data.ptr = &waiter;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) != 0) {
+    if (errno != ENOENT || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+      AERROR << "register fd " << fd << " failed: " << strerror(errno);
+      return -1;
+    }
+  }
+
+  if (timeout_ms >= 0) {
+    waiter.has_deadline = true;
+    waiter.deadline = deadlines_.emplace(
+        Clock::now() + std::chrono::milliseconds(timeout_ms), &waiter);
+  }
+  ++waiting_;
+  CRoutine::Yield(RoutineState::IO_WAIT);
+  return static_cast<int>(waiter.revents);
+}
+
+int Reactor::Poll(int timeout_ms) {
+  int woken = 0;
+  int n = epoll_wait(epoll_fd_, events_.data(), kMaxEvents, timeout_ms);
+  if (n < 0 && errno != EINTR) {
+    AERROR << "epoll_wait failed: " << strerror(errno);
+  }
+  for (int i = 0; i < n; ++i) {
+    auto waiter = static_cast<Waiter*>(events_[i].data.ptr);
+    if (waiter == nullptr) {
+      uint64_t value = 0;
+      while (read(event_fd_, &value, sizeof(value)) > 0) {
+      }
+      continue;
+    }
+    waiter->revents = events_[i].events;
+    Wake(waiter);
+    ++woken;
+  }
+
+  if (!deadlines_.empty()) {
+    auto now = Clock::now();
+    while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+      ExpireFront();
+      ++woken;
+    }
+  }
+  return woken;
+}
+
+void Reactor::Interrupt() {
+  uint64_t value = 1;
+  if (write(event_fd_, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+    AWARN << "interrupt reactor failed: " << strerror(errno);
+  }
+}
+
+Reactor::Clock::time_point Reactor::NextDeadline() const {
+  if (deadlines_.empty()) {
+    return Clock::time_point::max();
+  }
+  return deadlines_.begin()->first;
+}
+
+//Wakeup()之后协程可能马上在其他处理器上恢复运行，waiter随之失效，之后不能再访问
+void Reactor::Wake(Waiter* waiter) {
+  if (waiter->has_deadline) {
+    deadlines_.erase(waiter->deadline);
+    waiter->has_deadline = false;
+  }
+  --waiting_;
+  ctx_->Wakeup(waiter->cr);
+}
+
+//超时的等待先从epoll中删除fd，保证之后不会再收到指向已失效waiter的事件
+void Reactor::ExpireFront() {
+  auto waiter = deadlines_.begin()->second;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, waiter->fd, nullptr);
+  waiter->revents = 0;
+  Wake(waiter);
+}
@@ -0,0 +1,69 @@
+#ifndef CYBER_IO_REACTOR_H_
+#define CYBER_IO_REACTOR_H_
+
+#include <sys/epoll.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "../croutine/croutine.h"
+#include "../scheduler/processor_context.h"
+
+//每个处理器一个的epoll反应器。
+//协程通过WaitFd()把fd注册到当前处理器的epoll上（EPOLLONESHOT），以IO_WAIT状态挂起；
+//处理器线程空闲时阻塞在Poll()中，fd就绪后通过ProcessorContext::Wakeup()把协程放回就绪队列。
+//除Interrupt()以外的接口都只在所属处理器的线程中调用，内部不需要加锁。
+class Reactor {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit Reactor(ProcessorContext* ctx);
+  ~Reactor();
+
+  //在协程中调用：挂起当前协程直到fd上有events中的事件或超时（timeout_ms<0表示不超时），
+  //返回就绪的事件，超时返回0，注册失败返回-1
+  int WaitFd(int fd, uint32_t events, int timeout_ms);
+
+  //处理器线程调用：等待最多timeout_ms毫秒（<0一直等待），唤醒fd就绪以及等待超时的协程，
+  //返回唤醒的协程个数
+  int Poll(int timeout_ms);
+
+  //可以在任意线程调用：打断阻塞在Poll()中的处理器线程
+  void Interrupt();
+
+  //正在等待IO的协程个数
+  size_t Waiting() const { return waiting_; }
+
+  //最早的IO等待超时时间，没有设置超时时返回Clock::time_point::max()
+  Clock::time_point NextDeadline() const;
+
+ private:
+  //挂起期间保存在协程栈上，地址作为epoll_event的data.ptr
+  struct Waiter {
+    CRoutine* cr = nullptr;
+    int fd = -1;
+    uint32_t revents = 0;
+    bool has_deadline = false;
+    std::multimap<Clock::time_point, Waiter*>::iterator deadline;
+  };
+
+  void Wake(Waiter* waiter);
+  void ExpireFront();
+
+  Reactor(const Reactor&) = delete;
+  Reactor& operator=(const Reactor&) = delete;
+
+  static constexpr int kMaxEvents = 256;
+
+  ProcessorContext* ctx_ = nullptr;
+  int epoll_fd_ = -1;
+  //用于Interrupt()的eventfd，注册时data.ptr为nullptr
+  int event_fd_ = -1;
+  size_t waiting_ = 0;
+  std::multimap<Clock::time_point, Waiter*> deadlines_;
+  std::vector<epoll_event> events_;
+};
+
+#endif  // CYBER_IO_REACTOR_H_
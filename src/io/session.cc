@@ -0,0 +1,184 @@
+#include "session.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "../common/log.h"
+#include "../croutine/croutine.h"
+#include "../scheduler/processor_context.h"
+#include "reactor.h"
+
+namespace {
+
+inline bool WouldBlock(int err) { return err == EAGAIN || err == EWOULDBLOCK; }
+
+}  // namespace
+
+Session::Session() : Session(-1) {}
+
+Session::Session(int fd) { set_fd(fd); }
+
+int Session::Socket(int domain, int type, int protocol) {
+  if (fd_ != -1) {
+    AINFO << "session has hold a valid fd: " << fd_;
+    return -1;
+  }
+  int fd = socket(domain, type | SOCK_NONBLOCK | SOCK_CLOEXEC, protocol);
+  if (fd != -1) {
+    set_fd(fd);
+  }
+  return fd;
+}
+
+int Session::Listen(int backlog) { return listen(fd_, backlog); }
+
+int Session::Bind(const struct sockaddr* addr, socklen_t addrlen) {
+  return bind(fd_, addr, addrlen);
+}
+
+Session::SessionPtr Session::Accept(struct sockaddr* addr, socklen_t* addrlen,
+                                    int timeout_ms) {
+  for (;;) {
+    int fd = accept4(fd_, addr, addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd >= 0) {
+      return std::make_shared<Session>(fd);
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (!WouldBlock(errno) || WaitFd(EPOLLIN, timeout_ms) <= 0) {
+      return nullptr;
+    }
+  }
+}
+
+int Session::Connect(const struct sockaddr* addr, socklen_t addrlen,
+                     int timeout_ms) {
+  if (connect(fd_, addr, addrlen) == 0) {
+    return 0;
+  }
+  if (errno != EINPROGRESS) {
+    return -1;
+  }
+  if (WaitFd(EPOLLOUT, timeout_ms) <= 0) {
+    return -1;
+  }
+  int err = 0;
+  socklen_t len = sizeof(err);
+  if (getsockopt(fd_, SOL_SOCKET, SO_ERROR, &err, &len) != 0) {
+    return -1;
+  }
+  if (err != 0) {
+    errno = err;
+    return -1;
+  }
+  return 0;
+}
+
+int Session::Close() {
+  int ret = close(fd_);
+  fd_ = -1;
+  return ret;
+}
+
+ssize_t Session::Recv(void* buf, size_t len, int flags, int timeout_ms) {
+  for (;;) {
+    ssize_t n = recv(fd_, buf, len, flags);
+    if (n >= 0) {
+      return n;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (!WouldBlock(errno) || WaitFd(EPOLLIN, timeout_ms) <= 0) {
+      return -1;
+    }
+  }
+}
+
+ssize_t Session::Read(void* buf, size_t count, int timeout_ms) {
+  for (;;) {
+    ssize_t n = read(fd_, buf, count);
+    if (n >= 0) {
+      return n;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (!WouldBlock(errno) || WaitFd(EPOLLIN, timeout_ms) <= 0) {
+      return -1;
+    }
+  }
+}
+
+ssize_t Session::Send(const void* buf, size_t len, int flags, int timeout_ms) {
+  for (;;) {
+    ssize_t n = send(fd_, buf, len, flags | MSG_NOSIGNAL);
+    if (n >= 0) {
+      return n;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (!WouldBlock(errno) || WaitFd(EPOLLOUT, timeout_ms) <= 0) {
+      return -1;
+    }
+  }
+}
+
+ssize_t Session::Write(const void* buf, size_t count, int timeout_ms) {
+  for (;;) {
+    ssize_t n = write(fd_, buf, count);
+    if (n >= 0) {
+      return n;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (!WouldBlock(errno) || WaitFd(EPOLLOUT, timeout_ms) <= 0) {
+      return -1;
+    }
+  }
+}
+
+void Session::set_fd(int fd) {
+  fd_ = fd;
+  if (fd_ < 0) {
+    return;
+  }
+  int flags = fcntl(fd_, F_GETFL, 0);
+  if (flags != -1 && !(flags & O_NONBLOCK)) {
+    fcntl(fd_, F_SETFL, flags | O_NONBLOCK);
+  }
+}
+
+int Session::WaitFd(uint32_t events, int timeout_ms) {
+  int ready = 0;
+  auto ctx = ProcessorContext::Current();
+  Reactor* reactor = nullptr;
+  if (CRoutine::GetCurrentRoutine() != nullptr && ctx != nullptr) {
+    reactor = ctx->GetReactor();
+  }
+  if (reactor != nullptr) {
+    ready = reactor->WaitFd(fd_, events, timeout_ms);
+  } else {
+    //EPOLLIN/EPOLLOUT与POLLIN/POLLOUT的取值相同
+    struct pollfd pfd;
+    pfd.fd = fd_;
+    pfd.events = static_cast<short>(events);
+    pfd.revents = 0;
+    do {
+      ready = poll(&pfd, 1, timeout_ms);
+    } while (ready < 0 && errno == EINTR);
+    if (ready > 0) {
+      ready = pfd.revents;
+    }
+  }
+  if (ready == 0) {
+    errno = ETIMEDOUT;
+  }
+  return ready;
+}
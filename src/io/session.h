@@ -0,0 +1,46 @@
+#ifndef CYBER_IO_SESSION_H_
+#define CYBER_IO_SESSION_H_
+
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <cstdint>
+#include <memory>
+
+//非阻塞socket的协程封装，接口和对应的系统调用一致。
+//在调度器的协程中调用时，fd暂时不可读写会以IO_WAIT挂起当前协程，等待所在处理器的反应器唤醒，
+//代码写起来和阻塞IO一样，但不占用处理器线程；不在协程中调用时退化为poll(2)阻塞等待。
+//timeout_ms<0表示不超时，超时返回-1并设置errno为ETIMEDOUT。
+class Session {
+ public:
+  using SessionPtr = std::shared_ptr<Session>;
+
+  Session();
+  explicit Session(int fd);
+  virtual ~Session() = default;
+
+  int Socket(int domain, int type, int protocol);
+  int Listen(int backlog);
+  int Bind(const struct sockaddr* addr, socklen_t addrlen);
+  SessionPtr Accept(struct sockaddr* addr, socklen_t* addrlen,
+                    int timeout_ms = -1);
+  int Connect(const struct sockaddr* addr, socklen_t addrlen,
+              int timeout_ms = -1);
+  int Close();
+
+  ssize_t Recv(void* buf, size_t len, int flags, int timeout_ms = -1);
+  ssize_t Read(void* buf, size_t count, int timeout_ms = -1);
+  ssize_t Send(const void* buf, size_t len, int flags, int timeout_ms = -1);
+  ssize_t Write(const void* buf, size_t count, int timeout_ms = -1);
+
+  int fd() const { return fd_; }
+
+ private:
+  void set_fd(int fd);
+  //等待fd上的事件，返回就绪的事件，超时返回0，出错返回-1
+  int WaitFd(uint32_t events, int timeout_ms);
+
+  int fd_ = -1;
+};
+
+#endif  // CYBER_IO_SESSION_H_
@@ -0,0 +1,158 @@
+#include "session.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "../scheduler/policy/scheduler_classic.h"
+#include "../test_util.h"
+
+namespace {
+
+ClassicConf OneProcessorConf() {
+  ClassicGroupConf group;
+  group.name = "io";
+  group.processor_num = 1;
+  ClassicConf conf;
+  conf.groups.push_back(group);
+  return conf;
+}
+
+}  // namespace
+
+TEST(Session, EchoOverLoopback) {
+  SchedulerClassic sched(OneProcessorConf());
+
+  auto server = std::make_shared<Session>();
+  ASSERT_GE(server->Socket(AF_INET, SOCK_STREAM, 0), 0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  ASSERT_EQ(server->Bind(reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+  ASSERT_EQ(server->Listen(128), 0);
+  socklen_t len = sizeof(addr);
+  getsockname(server->fd(), reinterpret_cast<sockaddr*>(&addr), &len);
+
+  const int kClients = 50;
+  const int kRounds = 20;
+  std::atomic<int> accepted = {0};
+  sched.CreateTask(
+      [&]() {
+        for (;;) {
+          auto conn = server->Accept(nullptr, nullptr);
+          if (conn == nullptr) {
+            return;
+          }
+          int id = accepted++;
+          sched.CreateTask(
+              [conn]() {
+                char buf[64];
+                ssize_t n = 0;
+                while ((n = conn->Read(buf, sizeof(buf))) > 0) {
+                  conn->Write(buf, n);
+                }
+                conn->Close();
+              },
+              "echo_" + std::to_string(id));
+        }
+      },
+      "acceptor");
+
+  std::atomic<int> done = {0};
+  std::atomic<int> errors = {0};
+  for (int i = 0; i < kClients; ++i) {
+    sched.CreateTask(
+        [&, i]() {
+          Session client;
+          client.Socket(AF_INET, SOCK_STREAM, 0);
+          if (client.Connect(reinterpret_cast<sockaddr*>(&addr),
+                             sizeof(addr)) != 0) {
+            errors++;
+            done++;
+            return;
+          }
+          for (int r = 0; r < kRounds; ++r) {
+            std::string msg = std::to_string(i * 1000 + r);
+            char buf[64];
+            client.Write(msg.data(), msg.size());
+            ssize_t n = client.Read(buf, sizeof(buf));
+            if (n != static_cast<ssize_t>(msg.size()) ||
+                std::string(buf, n) != msg) {
+              errors++;
+            }
+          }
+          client.Close();
+          done++;
+        },
+        "client_" + std::to_string(i));
+  }
+
+  WaitFor([&]() { return done >= kClients; }, std::chrono::seconds(5));
+  EXPECT_EQ(done, kClients);
+  EXPECT_EQ(errors, 0);
+  EXPECT_EQ(accepted, kClients);
+}
+
+//等待IO的协程不占用处理器，超时后返回ETIMEDOUT
+TEST(Session, ReadTimeoutDoesNotBlockProcessor) {
+  SchedulerClassic sched(OneProcessorConf());
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  auto reader = std::make_shared<Session>(fds[0]);
+
+  std::atomic<int> ticks = {0};
+  std::atomic<int> done = {0};
+  std::atomic<int> read_errno = {0};
+  std::atomic<int> ticks_at_timeout = {0};
+  sched.CreateTask(
+      [&]() {
+        char buf[8];
+        if (reader->Read(buf, sizeof(buf), 50) < 0) {
+          read_errno = errno;
+        }
+        ticks_at_timeout = ticks.load();
+        done++;
+      },
+      "reader");
+  sched.CreateTask(
+      [&]() {
+        while (done == 0) {
+          ticks++;
+          CRoutine::GetCurrentRoutine()->Sleep(std::chrono::milliseconds(1));
+        }
+      },
+      "ticker");
+
+  WaitFor([&]() { return done >= 1; }, std::chrono::seconds(5));
+  EXPECT_EQ(read_errno, ETIMEDOUT);
+  EXPECT_GT(ticks_at_timeout, 10);
+  close(fds[1]);
+  reader->Close();
+}
+
+TEST(Session, BlockingFallbackOutsideRoutine) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  Session reader(fds[0]);
+  Session writer(fds[1]);
+  char buf[8];
+  EXPECT_EQ(reader.Read(buf, sizeof(buf), 10), -1);
+  EXPECT_EQ(errno, ETIMEDOUT);
+
+  std::thread t([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    writer.Write("ping", 4);
+  });
+  EXPECT_EQ(reader.Read(buf, sizeof(buf)), 4);
+  t.join();
+  reader.Close();
+  writer.Close();
+}
@@ -0,0 +1,240 @@
+#ifndef CYBER_BASE_MULTI_QUEUE_H_
+#define CYBER_BASE_MULTI_QUEUE_H_
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+
+//默认把元素本身当作键
+template <typename T>
+struct IdentityKey {
+  const T& operator()(const T& value) const { return value; }
+};
+
+//松弛的并发优先队列（MultiQueue）：内部有queue_num个各自加锁的二叉堆，通常取线程数的2～4倍。
+//- Push随机选一个堆，抢不到锁就换一个，所以插入几乎不会互相等待。
+//- TryPop随机选两个堆，比较缓存的堆顶键，从较小的那个取（two-choice）。
+//  出队的不一定是全局最小的元素：期望的rank误差（比它小、还在队列里的元素个数）是O(queue_num)，
+//  见docs/multi_queue.md。两次都选到空堆或者抢不到锁时重新选，多次失败后按顺序扫描所有堆，
+//  只有所有堆都空时才返回false。
+//- KeyOf从元素取出键，Compare(a, b)为true表示a比b先出队。键在入队时取出并和元素一起保存，
+//  元素在队列中时键不能变。键要能放进std::atomic，用于无锁地读堆顶。
+template <typename T, typename KeyOf = IdentityKey<T>,
+          typename Compare = std::less<typename std::decay<
+              typename std::result_of<KeyOf(const T&)>::type>::type>>
+class MultiQueue {
+ public:
+  using Key = typename std::decay<
+      typename std::result_of<KeyOf(const T&)>::type>::type;
+  static_assert(std::is_trivially_copyable<Key>::value,
+                "MultiQueue key must be trivially copyable");
+
+  explicit MultiQueue(uint32_t queue_num, KeyOf key_of = KeyOf(),
+                      Compare compare = Compare());
+  ~MultiQueue();
+  MultiQueue(const MultiQueue&) = delete;
+  MultiQueue& operator=(const MultiQueue&) = delete;
+
+  void Push(T value);
+  //取出一个键较小的元素，所有堆都空时返回false
+  bool TryPop(T* value);
+  //并发修改时只是近似值
+  bool Empty() const;
+  uint64_t Size() const;
+  uint32_t QueueNum() const { return queue_num_; }
+
+ private:
+  struct Entry {
+    Key key;
+    T value;
+  };
+
+  struct alignas(CACHELINE_SIZE) Heap {
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    //堆顶的键和元素个数，加锁修改，不加锁读
+    std::atomic<Key> top;
+    std::atomic<uint64_t> size = {0};
+    std::vector<Entry> entries;
+  };
+
+  static constexpr int kTwoChoiceAttempts = 8;
+  static constexpr uint32_t kMaxRetryTimes = 5;
+
+  static uint64_t Random();
+  uint32_t RandomHeap() { return static_cast<uint32_t>(Random() % queue_num_); }
+  bool Before(const Key& a, const Key& b) const { return compare_(a, b); }
+  //std::push_heap建的是大顶堆，比较时反过来
+  bool HeapLess(const Entry& a, const Entry& b) const {
+    return compare_(b.key, a.key);
+  }
+  static bool TryLock(Heap* heap) {
+    return !heap->lock.test_and_set(std::memory_order_acquire);
+  }
+  static void Lock(Heap* heap);
+  static void Unlock(Heap* heap) { heap->lock.clear(std::memory_order_release); }
+  //持有锁时调用，堆非空
+  void PopLocked(Heap* heap, T* value);
+
+  const uint32_t queue_num_;
+  Heap* heaps_ = nullptr;
+  KeyOf key_of_;
+  Compare compare_;
+};
+
+template <typename T, typename KeyOf, typename Compare>
+MultiQueue<T, KeyOf, Compare>::MultiQueue(uint32_t queue_num, KeyOf key_of,
+                                          Compare compare)
+    : queue_num_(queue_num > 0 ? queue_num : 1),
+      key_of_(std::move(key_of)),
+      compare_(std::move(compare)) {
+  void* mem = nullptr;
+  if (posix_memalign(&mem, CACHELINE_SIZE, sizeof(Heap) * queue_num_) != 0) {
+    throw std::bad_alloc();
+  }
+  heaps_ = static_cast<Heap*>(mem);
+  for (uint32_t i = 0; i < queue_num_; ++i) {
+    new (&heaps_[i]) Heap();
+  }
+}
+
+template <typename T, typename KeyOf, typename Compare>
+MultiQueue<T, KeyOf, Compare>::~MultiQueue() {
+  for (uint32_t i = 0; i < queue_num_; ++i) {
+    heaps_[i].~Heap();
+  }
+  free(heaps_);
+}
+
+template <typename T, typename KeyOf, typename Compare>
+uint64_t MultiQueue<T, KeyOf, Compare>::Random() {
+  //xorshift64，每个线程一个状态，种子取自线程id
+  static thread_local uint64_t state =
+      std::hash<std::thread::id>()(std::this_thread::get_id()) |
+      0x9e3779b97f4a7c15ULL;
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+template <typename T, typename KeyOf, typename Compare>
+void MultiQueue<T, KeyOf, Compare>::Lock(Heap* heap) {
+  uint32_t retry_times = 0;
+  while (!TryLock(heap)) {
+    if (++retry_times == kMaxRetryTimes) {
+      // saving cpu
+      std::this_thread::yield();
+      retry_times = 0;
+    }
+  }
+}
+
+template <typename T, typename KeyOf, typename Compare>
+void MultiQueue<T, KeyOf, Compare>::Push(T value) {
+  Key key = key_of_(value);
+  Heap* heap = &heaps_[RandomHeap()];
+  uint32_t retry_times = 0;
+  while (!TryLock(heap)) {
+    //被占用就换一个堆，所有线程都抢不到时才让出CPU
+    if (++retry_times == kMaxRetryTimes) {
+      std::this_thread::yield();
+      retry_times = 0;
+    }
+    heap = &heaps_[RandomHeap()];
+  }
+  heap->entries.push_back(Entry{key, std::move(value)});
+  std::push_heap(heap->entries.begin(), heap->entries.end(),
+                 [this](const Entry& a, const Entry& b) { return HeapLess(a, b); });
+  heap->top.store(heap->entries.front().key, std::memory_order_relaxed);
+  //size最后写，TryPop看到size非0时top已经有效
+  heap->size.store(heap->entries.size(), std::memory_order_release);
+  Unlock(heap);
+}
+
+template <typename T, typename KeyOf, typename Compare>
+void MultiQueue<T, KeyOf, Compare>::PopLocked(Heap* heap, T* value) {
+  std::pop_heap(heap->entries.begin(), heap->entries.end(),
+                [this](const Entry& a, const Entry& b) { return HeapLess(a, b); });
+  *value = std::move(heap->entries.back().value);
+  heap->entries.pop_back();
+  if (!heap->entries.empty()) {
+    heap->top.store(heap->entries.front().key, std::memory_order_relaxed);
+  }
+  heap->size.store(heap->entries.size(), std::memory_order_release);
+}
+
+template <typename T, typename KeyOf, typename Compare>
+bool MultiQueue<T, KeyOf, Compare>::TryPop(T* value) {
+  for (int attempt = 0; attempt < kTwoChoiceAttempts; ++attempt) {
+    Heap* a = &heaps_[RandomHeap()];
+    Heap* b = &heaps_[RandomHeap()];
+    bool a_empty = a->size.load(std::memory_order_acquire) == 0;
+    bool b_empty = b->size.load(std::memory_order_acquire) == 0;
+    if (a_empty && b_empty) {
+      continue;
+    }
+    //不加锁读到的堆顶可能已经过时，只用来挑堆，加锁后以堆里的实际内容为准
+    Heap* heap = a;
+    if (a_empty || (!b_empty && Before(b->top.load(std::memory_order_relaxed),
+                                       a->top.load(std::memory_order_relaxed)))) {
+      heap = b;
+    }
+    if (!TryLock(heap)) {
+      continue;
+    }
+    if (heap->entries.empty()) {
+      Unlock(heap);
+      continue;
+    }
+    PopLocked(heap, value);
+    Unlock(heap);
+    return true;
+  }
+  //元素很少时随机选很容易落空，从随机位置开始扫一遍所有的堆
+  uint32_t start = RandomHeap();
+  for (uint32_t i = 0; i < queue_num_; ++i) {
+    Heap* heap = &heaps_[(start + i) % queue_num_];
+    if (heap->size.load(std::memory_order_acquire) == 0) {
+      continue;
+    }
+    Lock(heap);
+    if (!heap->entries.empty()) {
+      PopLocked(heap, value);
+      Unlock(heap);
+      return true;
+    }
+    Unlock(heap);
+  }
+  return false;
+}
+
+template <typename T, typename KeyOf, typename Compare>
+bool MultiQueue<T, KeyOf, Compare>::Empty() const {
+  for (uint32_t i = 0; i < queue_num_; ++i) {
+    if (heaps_[i].size.load() != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T, typename KeyOf, typename Compare>
+uint64_t MultiQueue<T, KeyOf, Compare>::Size() const {
+  uint64_t size = 0;
+  for (uint32_t i = 0; i < queue_num_; ++i) {
+    size += heaps_[i].size.load(std::memory_order_relaxed);
+  }
+  return size;
+}
+
+#endif  // CYBER_BASE_MULTI_QUEUE_H_
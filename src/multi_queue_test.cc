@@ -0,0 +1,172 @@
+#include "multi_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "priority_thread_pool.h"
+
+namespace {
+
+struct Job {
+  uint64_t deadline;
+  int id;
+};
+
+struct DeadlineKey {
+  uint64_t operator()(const Job& job) const { return job.deadline; }
+};
+
+}  // namespace
+
+//只有一个堆时就是普通的优先队列
+TEST(MultiQueue, SingleHeapIsExact) {
+  MultiQueue<Job, DeadlineKey> queue(1);
+  std::vector<uint64_t> deadlines = {50, 10, 40, 30, 20};
+  for (size_t i = 0; i < deadlines.size(); ++i) {
+    queue.Push(Job{deadlines[i], static_cast<int>(i)});
+  }
+  EXPECT_EQ(queue.Size(), deadlines.size());
+  std::sort(deadlines.begin(), deadlines.end());
+  Job job;
+  for (uint64_t want : deadlines) {
+    ASSERT_TRUE(queue.TryPop(&job));
+    EXPECT_EQ(job.deadline, want);
+  }
+  EXPECT_FALSE(queue.TryPop(&job));
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(MultiQueue, CustomCompare) {
+  MultiQueue<int, IdentityKey<int>, std::greater<int>> queue(1);
+  for (int i = 0; i < 10; ++i) {
+    queue.Push(i);
+  }
+  int value = 0;
+  ASSERT_TRUE(queue.TryPop(&value));
+  EXPECT_EQ(value, 9);
+}
+
+//元素很少时也能取到，不会因为随机选到空堆而返回false
+TEST(MultiQueue, FindsLastElement) {
+  MultiQueue<int> queue(64);
+  for (int round = 0; round < 100; ++round) {
+    queue.Push(round);
+    int value = -1;
+    ASSERT_TRUE(queue.TryPop(&value));
+    EXPECT_EQ(value, round);
+  }
+}
+
+//rank误差：取出的元素之前还有多少个更小的元素留在队列里
+TEST(MultiQueue, RankErrorIsBoundedByQueueNum) {
+  constexpr uint32_t kQueueNum = 16;
+  constexpr int kElements = 20000;
+  MultiQueue<uint64_t> queue(kQueueNum);
+  std::multiset<uint64_t> remaining;
+  std::mt19937_64 rng(42);
+  for (int i = 0; i < kElements; ++i) {
+    uint64_t key = rng() % 1000000;
+    queue.Push(key);
+    remaining.insert(key);
+  }
+  uint64_t total_rank = 0;
+  uint64_t max_rank = 0;
+  uint64_t value = 0;
+  while (queue.TryPop(&value)) {
+    auto it = remaining.find(value);
+    ASSERT_NE(it, remaining.end());
+    uint64_t rank = std::distance(remaining.begin(), remaining.lower_bound(value));
+    total_rank += rank;
+    max_rank = std::max(max_rank, rank);
+    remaining.erase(it);
+  }
+  EXPECT_TRUE(remaining.empty());
+  double mean_rank = static_cast<double>(total_rank) / kElements;
+  EXPECT_LT(mean_rank, 2.0 * kQueueNum);
+  EXPECT_LT(max_rank, 20u * kQueueNum);
+}
+
+TEST(MultiQueue, ConcurrentPushPop) {
+  constexpr int kThreads = 4;
+  constexpr int kPerThread = 20000;
+  MultiQueue<uint64_t> queue(kThreads * 2);
+  std::atomic<int> popped = {0};
+  std::vector<std::vector<uint64_t>> got(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < kPerThread; ++i) {
+        queue.Push(static_cast<uint64_t>(t) * kPerThread + i);
+      }
+    });
+    threads.emplace_back([&, t]() {
+      uint64_t value = 0;
+      while (popped.load() < kThreads * kPerThread) {
+        if (queue.TryPop(&value)) {
+          got[t].push_back(value);
+          popped++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  std::vector<uint64_t> all;
+  for (auto& values : got) {
+    all.insert(all.end(), values.begin(), values.end());
+  }
+  std::sort(all.begin(), all.end());
+  ASSERT_EQ(all.size(), static_cast<size_t>(kThreads * kPerThread));
+  for (size_t i = 0; i < all.size(); ++i) {
+    ASSERT_EQ(all[i], i);
+  }
+}
+
+TEST(PriorityThreadPool, RunsSmallerKeysFirst) {
+  //一个工作线程、一个堆，顺序是严格的
+  PriorityThreadPool pool(1, 1);
+  std::promise<void> gate;
+  std::shared_future<void> opened = gate.get_future().share();
+  auto blocker = pool.Enqueue(0, [opened]() { opened.wait(); });
+  //等工作线程拿走blocker，后面的任务都留在队列里
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  std::vector<int> order;
+  std::vector<std::future<int>> results;
+  for (int key = 5; key >= 1; --key) {
+    results.push_back(pool.Enqueue(key, [&order, key]() {
+      order.push_back(key);
+      return key * 10;
+    }));
+  }
+  gate.set_value();
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(results[i].get(), static_cast<int>(5 - i) * 10);
+  }
+  EXPECT_EQ(order, std::vector<int>({1, 2, 3, 4, 5}));
+}
+
+TEST(PriorityThreadPool, ManyWorkers) {
+  constexpr int kTasks = 10000;
+  std::atomic<int> done = {0};
+  {
+    PriorityThreadPool pool(4);
+    std::vector<std::future<void>> results;
+    for (int i = 0; i < kTasks; ++i) {
+      results.push_back(pool.Enqueue(i % 100, [&done]() { done++; }));
+    }
+    for (auto& r : results) {
+      r.get();
+    }
+  }
+  EXPECT_EQ(done.load(), kTasks);
+}
@@ -0,0 +1,96 @@
+#ifndef CYBER_BASE_PRIORITY_THREAD_POOL_H_
+#define CYBER_BASE_PRIORITY_THREAD_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "multi_queue.h"
+#include "queue_selector.h"
+
+//按键排序执行任务的线程池，任务放在MultiQueue里，键小的先执行（例如截止时间）。
+//和ThreadPool的区别：
+//- 没有容量上限，任务不会因为队列满被丢弃；
+//- 顺序是松弛的，同时在队列里的任务不保证严格按键执行，误差见docs/multi_queue.md；
+//- 空闲的工作线程在SelectorEvent上睡眠，没有线程睡眠时提交任务不加锁。
+class PriorityThreadPool {
+ public:
+  //queues_per_thread是MultiQueue里每个工作线程对应的堆的个数
+  explicit PriorityThreadPool(std::size_t thread_num,
+                              uint32_t queues_per_thread = 2);
+  ~PriorityThreadPool();
+
+  template <typename F, typename... Args>
+  auto Enqueue(uint64_t key, F&& f, Args&&... args)
+      -> std::future<typename std::result_of<F(Args...)>::type>;
+
+ private:
+  struct Task {
+    uint64_t key;
+    std::function<void()> func;
+  };
+  struct TaskKey {
+    uint64_t operator()(const Task& task) const { return task.key; }
+  };
+
+  std::vector<std::thread> workers_;
+  MultiQueue<Task, TaskKey> task_queue_;
+  SelectorEvent event_;
+  std::atomic_bool stop_;
+};
+
+inline PriorityThreadPool::PriorityThreadPool(std::size_t thread_num,
+                                              uint32_t queues_per_thread)
+    : task_queue_(static_cast<uint32_t>(thread_num) * queues_per_thread),
+      stop_(false) {
+  workers_.reserve(thread_num);
+  for (size_t i = 0; i < thread_num; ++i) {
+    workers_.emplace_back([this] {
+      Task task;
+      while (!stop_) {
+        if (task_queue_.TryPop(&task)) {
+          CYBER_TRACE(TASK_START, reinterpret_cast<uint64_t>(this));
+          task.func();
+          CYBER_TRACE(TASK_END, reinterpret_cast<uint64_t>(this));
+          continue;
+        }
+        event_.Wait([this]() { return stop_ || !task_queue_.Empty(); }, 0);
+      }
+    });
+  }
+}
+
+// before using the return value, you should check value.valid()
+template <typename F, typename... Args>
+auto PriorityThreadPool::Enqueue(uint64_t key, F&& f, Args&&... args)
+    -> std::future<typename std::result_of<F(Args...)>::type> {
+  using return_type = typename std::result_of<F(Args...)>::type;
+  auto task = std::make_shared<std::packaged_task<return_type()>>(
+      std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+  std::future<return_type> res = task->get_future();
+  // don't allow enqueueing after stopping the pool
+  if (stop_) {
+    return std::future<return_type>();
+  }
+  task_queue_.Push(Task{key, [task]() { (*task)(); }});
+  event_.Notify();
+  return res;
+}
+
+// the destructor joins all threads, tasks still in the queue are dropped
+inline PriorityThreadPool::~PriorityThreadPool() {
+  if (stop_.exchange(true)) {
+    return;
+  }
+  event_.NotifyAll();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+#endif  // CYBER_BASE_PRIORITY_THREAD_POOL_H_
@@ -0,0 +1,215 @@
+#ifndef CYBER_BASE_QUEUE_SELECTOR_H_
+#define CYBER_BASE_QUEUE_SELECTOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "common/macros.h"
+#include "wait_strategy.h"
+
+//多个队列共用的唤醒事件。
+//等待者先登记（waiters_加一），再检查一遍所有队列，仍然都是空的才睡眠；
+//生产者入队后先看有没有登记的等待者，没有就直接返回，不碰锁也不写任何共享变量。
+//两边都用seq_cst，保证“等待者没看到新元素”和“生产者没看到等待者”不会同时发生。
+class SelectorEvent {
+ public:
+  void Notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (cyber_likely(waiters_.load(std::memory_order_relaxed) == 0)) {
+      return;
+    }
+    //加锁保证等待者要么还没检查队列，要么已经在wait里，不会错过这次唤醒。
+    //同一个事件上可能既有Select的线程，也有直接对某个队列WaitDequeue的线程，
+    //notify_one可能唤醒一个不关心这个队列的等待者，而真正能取走元素的线程继续睡，所以全部唤醒
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    cv_.notify_all();
+  }
+
+  void NotifyAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    cv_.notify_all();
+  }
+
+  //ready()返回true或者被唤醒时返回true，超时返回false；timeout_us为0表示一直等
+  template <typename Ready>
+  bool Wait(Ready ready, uint64_t timeout_us) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    uint64_t generation = generation_;
+    bool woken = true;
+    if (!ready()) {
+      auto notified = [this, generation]() { return generation_ != generation; };
+      if (timeout_us == 0) {
+        cv_.wait(lock, notified);
+      } else {
+        woken = cv_.wait_for(lock, std::chrono::microseconds(timeout_us),
+                             notified);
+      }
+    }
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+    return woken;
+  }
+
+ private:
+  std::atomic<uint32_t> waiters_ = {0};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  //只在mutex_保护下读写
+  uint64_t generation_ = 0;
+};
+
+//加入QueueSelector的队列使用的等待策略，入队时唤醒在选择器上等待的线程。
+//直接对这个队列调用WaitDequeue也可以，任何一个队列入队都会唤醒它，醒来后再检查自己的队列。
+class SelectorWaitStrategy : public WaitStrategy {
+ public:
+  explicit SelectorWaitStrategy(std::shared_ptr<SelectorEvent> event)
+      : event_(std::move(event)) {}
+
+  void NotifyOne() override { event_->Notify(); }
+  void NotifyAll() override { event_->NotifyAll(); }
+  void BreakAllWait() override { event_->NotifyAll(); }
+
+  //调用者在EmptyWait之前检查过队列，中间入队的元素可能没唤醒这里，所以最多睡kMaxWaitUs
+  bool EmptyWait() override {
+    event_->Wait([]() { return false; }, kMaxWaitUs);
+    return true;
+  }
+
+ private:
+  static constexpr uint64_t kMaxWaitUs = 10000;
+  std::shared_ptr<SelectorEvent> event_;
+};
+
+//一个线程同时等待多个BoundedQueue，任一队列非空时取出一个元素并返回它来自哪个队列。
+//- Add时替换队列的WaitStrategy，之后该队列的入队会唤醒在选择器上等待的线程。
+//  没有线程在等时，入队只多了一次内存屏障和一次读，不加锁。
+//- priority大的队列优先；同一优先级的多个队列轮流服务，每次从上次取到元素的队列的下一个开始找。
+//  高优先级的队列一直有数据时，低优先级的队列会被饿死。
+//- Add必须在开始Select之前完成，之后可以有多个线程同时Select。
+template <typename T>
+class QueueSelector {
+ public:
+  QueueSelector() : event_(std::make_shared<SelectorEvent>()) {}
+  QueueSelector(const QueueSelector&) = delete;
+  QueueSelector& operator=(const QueueSelector&) = delete;
+
+  //返回队列的编号，即第几个加入的队列，从0开始
+  int Add(BoundedQueue<T>* queue, int priority = 0);
+
+  //取出一个元素，返回它所在队列的编号；所有队列都空时返回-1
+  int TrySelect(T* element);
+  //所有队列都空时一直等到有元素，BreakAllWait之后返回-1
+  int Select(T* element) { return SelectFor(element, 0); }
+  //最多等timeout_us微秒，超时或者BreakAllWait之后返回-1；timeout_us为0表示一直等
+  int SelectFor(T* element, uint64_t timeout_us);
+
+  void BreakAllWait();
+  size_t Size() const { return queues_.size(); }
+
+ private:
+  //同一优先级的队列
+  struct Tier {
+    int priority;
+    std::vector<int> members;
+    //下一次从members的哪个位置开始找
+    std::atomic<uint32_t> cursor = {0};
+    explicit Tier(int p) : priority(p) {}
+  };
+
+  bool AnyReady();
+
+  std::vector<BoundedQueue<T>*> queues_;
+  //按priority从大到小排列
+  std::vector<std::unique_ptr<Tier>> tiers_;
+  std::shared_ptr<SelectorEvent> event_;
+  std::atomic<bool> break_all_wait_ = {false};
+};
+
+template <typename T>
+int QueueSelector<T>::Add(BoundedQueue<T>* queue, int priority) {
+  int index = static_cast<int>(queues_.size());
+  queues_.push_back(queue);
+  queue->SetWaitStrategy(new SelectorWaitStrategy(event_));
+  auto it = std::find_if(tiers_.begin(), tiers_.end(),
+                         [priority](const std::unique_ptr<Tier>& tier) {
+                           return tier->priority <= priority;
+                         });
+  if (it == tiers_.end() || (*it)->priority != priority) {
+    it = tiers_.emplace(it, new Tier(priority));
+  }
+  (*it)->members.push_back(index);
+  return index;
+}
+
+template <typename T>
+int QueueSelector<T>::TrySelect(T* element) {
+  for (auto& tier : tiers_) {
+    uint32_t size = static_cast<uint32_t>(tier->members.size());
+    uint32_t start = tier->cursor.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < size; ++i) {
+      uint32_t pos = (start + i) % size;
+      int index = tier->members[pos];
+      if (queues_[index]->Dequeue(element)) {
+        //多个线程同时Select时游标只是提示，互相覆盖不影响正确性
+        tier->cursor.store((pos + 1) % size, std::memory_order_relaxed);
+        return index;
+      }
+    }
+  }
+  return -1;
+}
+
+template <typename T>
+int QueueSelector<T>::SelectFor(T* element, uint64_t timeout_us) {
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::microseconds(timeout_us);
+  while (!break_all_wait_.load(std::memory_order_acquire)) {
+    int index = TrySelect(element);
+    if (index >= 0) {
+      return index;
+    }
+    uint64_t wait_us = 0;
+    if (timeout_us != 0) {
+      auto now = std::chrono::steady_clock::now();
+      if (now >= deadline) {
+        return -1;
+      }
+      wait_us = std::max<uint64_t>(
+          1, std::chrono::duration_cast<std::chrono::microseconds>(deadline - now)
+                 .count());
+    }
+    event_->Wait([this]() { return AnyReady(); }, wait_us);
+  }
+  return -1;
+}
+
+template <typename T>
+bool QueueSelector<T>::AnyReady() {
+  if (break_all_wait_.load(std::memory_order_acquire)) {
+    return true;
+  }
+  //Size()包括已经占了位置但还没提交的元素，这里只看已经提交、能出队的
+  for (auto queue : queues_) {
+    if (queue->Head() + 1 != queue->Commit()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename T>
+void QueueSelector<T>::BreakAllWait() {
+  break_all_wait_.store(true, std::memory_order_release);
+  event_->NotifyAll();
+}
+
+#endif  // CYBER_BASE_QUEUE_SELECTOR_H_
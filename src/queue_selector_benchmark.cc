@@ -0,0 +1,133 @@
+//一个消费者服务4个队列，生产者每隔interval_us往其中一个队列放一条消息，比较三种消费方式：
+//1、QueueSelector：所有队列都空时在选择器上睡眠
+//2、poll+sleep：轮流Dequeue每个队列，都空时睡眠poll_sleep_us
+//3、poll+yield：轮流Dequeue每个队列，都空时让出CPU
+//输出入队到出队的延迟，以及消费者线程占用的CPU时间相对墙上时间的比例。
+//最后比较没有线程等待时，入队通知的开销（SelectorWaitStrategy对比不做通知的SleepWaitStrategy）。
+//用法：queue_selector_benchmark [messages] [interval_us] [poll_sleep_us]
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/tsc_clock.h"
+#include "queue_selector.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kQueues = 4;
+constexpr uint64_t kCapacity = 1024;
+
+enum class Mode { kSelector, kPollSleep, kPollYield };
+
+double ThreadCpuSeconds() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void Run(const char* name, Mode mode, uint64_t messages, uint64_t interval_us,
+         uint64_t poll_sleep_us) {
+  std::vector<BoundedQueue<uint64_t>> queues(kQueues);
+  QueueSelector<uint64_t> selector;
+  for (auto& queue : queues) {
+    queue.Init(kCapacity);
+    if (mode == Mode::kSelector) {
+      selector.Add(&queue);
+    }
+  }
+  std::vector<uint64_t> latencies;
+  latencies.reserve(messages);
+  double cpu = 0;
+  auto begin = Clock::now();
+  std::thread consumer([&]() {
+    double cpu_begin = ThreadCpuSeconds();
+    uint64_t ts = 0;
+    size_t next = 0;
+    while (latencies.size() < messages) {
+      bool got = false;
+      if (mode == Mode::kSelector) {
+        got = selector.Select(&ts) >= 0;
+      } else {
+        for (int i = 0; i < kQueues && !got; ++i) {
+          got = queues[next].Dequeue(&ts);
+          next = (next + 1) % kQueues;
+        }
+      }
+      if (got) {
+        latencies.push_back(TscClock::Now() - ts);
+      } else if (mode == Mode::kPollSleep) {
+        std::this_thread::sleep_for(std::chrono::microseconds(poll_sleep_us));
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    cpu = ThreadCpuSeconds() - cpu_begin;
+  });
+  for (uint64_t i = 0; i < messages; ++i) {
+    std::this_thread::sleep_for(std::chrono::microseconds(interval_us));
+    queues[i % kQueues].Enqueue(TscClock::Now());
+  }
+  consumer.join();
+  double wall = std::chrono::duration<double>(Clock::now() - begin).count();
+
+  std::sort(latencies.begin(), latencies.end());
+  double ns_per_tick = TscClock::NsPerTick();
+  auto at = [&](double q) {
+    return latencies[static_cast<size_t>(q * (latencies.size() - 1))] *
+           ns_per_tick / 1000;
+  };
+  printf("%-14s p50 %8.1f us  p99 %8.1f us  max %8.1f us  consumer cpu %5.1f%%\n",
+         name, at(0.5), at(0.99), at(1.0), 100 * cpu / wall);
+}
+
+//单线程入队再出队，没有等待者，只比较入队时NotifyOne的开销
+double NotifyCost(WaitStrategy* strategy, QueueSelector<uint64_t>* selector,
+                  uint64_t loops) {
+  BoundedQueue<uint64_t> queue;
+  queue.Init(kCapacity, strategy);
+  if (selector != nullptr) {
+    selector->Add(&queue);
+  }
+  uint64_t value = 0;
+  auto begin = Clock::now();
+  for (uint64_t i = 0; i < loops; ++i) {
+    queue.Enqueue(i);
+    queue.Dequeue(&value);
+  }
+  return std::chrono::duration<double, std::nano>(Clock::now() - begin).count() /
+         loops;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  uint64_t messages = argc > 1 ? strtoull(argv[1], nullptr, 10) : 5000;
+  uint64_t interval_us = argc > 2 ? strtoull(argv[2], nullptr, 10) : 200;
+  uint64_t poll_sleep_us = argc > 3 ? strtoull(argv[3], nullptr, 10) : 100;
+  printf("%d queues, %llu messages, one every %llu us\n", kQueues,
+         static_cast<unsigned long long>(messages),
+         static_cast<unsigned long long>(interval_us));
+  Run("selector", Mode::kSelector, messages, interval_us, poll_sleep_us);
+  std::string poll_sleep = "poll+sleep" + std::to_string(poll_sleep_us);
+  Run(poll_sleep.c_str(), Mode::kPollSleep, messages, interval_us,
+      poll_sleep_us);
+  Run("poll+yield", Mode::kPollYield, messages, interval_us, poll_sleep_us);
+
+  constexpr uint64_t kLoops = 10000000;
+  QueueSelector<uint64_t> selector;
+  double plain = NotifyCost(new SleepWaitStrategy(), nullptr, kLoops);
+  double selected = NotifyCost(new SleepWaitStrategy(), &selector, kLoops);
+  printf("enqueue+dequeue without waiters: no notify %.1f ns, selector %.1f ns\n",
+         plain, selected);
+  return 0;
+}
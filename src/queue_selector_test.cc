@@ -0,0 +1,155 @@
+#include "queue_selector.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(QueueSelector, PriorityThenRoundRobin) {
+  BoundedQueue<int> low;
+  BoundedQueue<int> high_a;
+  BoundedQueue<int> high_b;
+  ASSERT_TRUE(low.Init(8));
+  ASSERT_TRUE(high_a.Init(8));
+  ASSERT_TRUE(high_b.Init(8));
+  QueueSelector<int> selector;
+  EXPECT_EQ(selector.Add(&low), 0);
+  EXPECT_EQ(selector.Add(&high_a, 1), 1);
+  EXPECT_EQ(selector.Add(&high_b, 1), 2);
+
+  int value = 0;
+  EXPECT_EQ(selector.TrySelect(&value), -1);
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(low.Enqueue(100 + i));
+    ASSERT_TRUE(high_a.Enqueue(200 + i));
+    ASSERT_TRUE(high_b.Enqueue(300 + i));
+  }
+  //高优先级的两个队列交替取，取空之后才轮到低优先级
+  std::vector<int> expected = {200, 300, 201, 301, 100, 101};
+  for (int want : expected) {
+    EXPECT_GE(selector.TrySelect(&value), 0);
+    EXPECT_EQ(value, want);
+  }
+  EXPECT_EQ(selector.TrySelect(&value), -1);
+}
+
+TEST(QueueSelector, WakesOnAnyQueue) {
+  constexpr int kQueues = 4;
+  constexpr int kPerQueue = 20000;
+  std::vector<BoundedQueue<int>> queues(kQueues);
+  QueueSelector<int> selector;
+  for (auto& queue : queues) {
+    ASSERT_TRUE(queue.Init(16));
+    selector.Add(&queue);
+  }
+  std::vector<int> received(kQueues, 0);
+  std::vector<int> out_of_order(kQueues, 0);
+  std::thread consumer([&]() {
+    std::vector<int> next(kQueues, 0);
+    int value = 0;
+    for (int n = 0; n < kQueues * kPerQueue; ++n) {
+      int index = selector.Select(&value);
+      ASSERT_GE(index, 0);
+      if (value != next[index]++) {
+        out_of_order[index]++;
+      }
+      received[index]++;
+    }
+  });
+  //每个生产者只往自己的队列里放，偶尔停一下让消费者睡着
+  std::vector<std::thread> producers;
+  for (int q = 0; q < kQueues; ++q) {
+    producers.emplace_back([&, q]() {
+      for (int i = 0; i < kPerQueue; ++i) {
+        while (!queues[q].Enqueue(i)) {
+          std::this_thread::yield();
+        }
+        if (i % 1000 == 0) {
+          std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+      }
+    });
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  consumer.join();
+  for (int q = 0; q < kQueues; ++q) {
+    EXPECT_EQ(received[q], kPerQueue);
+    EXPECT_EQ(out_of_order[q], 0);
+  }
+}
+
+TEST(QueueSelector, TimeoutAndBreak) {
+  BoundedQueue<int> queue;
+  ASSERT_TRUE(queue.Init(8));
+  QueueSelector<int> selector;
+  selector.Add(&queue);
+  int value = 0;
+  auto begin = std::chrono::steady_clock::now();
+  EXPECT_EQ(selector.SelectFor(&value, 20000), -1);
+  EXPECT_GE(std::chrono::steady_clock::now() - begin,
+            std::chrono::milliseconds(20));
+
+  std::thread waiter([&]() { EXPECT_EQ(selector.Select(&value), -1); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  selector.BreakAllWait();
+  waiter.join();
+}
+
+//加入选择器的队列仍然可以单独WaitDequeue
+TEST(QueueSelector, QueueWaitDequeueStillWorks) {
+  BoundedQueue<int> queue;
+  ASSERT_TRUE(queue.Init(8));
+  QueueSelector<int> selector;
+  selector.Add(&queue);
+  std::thread consumer([&]() {
+    int value = 0;
+    EXPECT_TRUE(queue.WaitDequeue(&value));
+    EXPECT_EQ(value, 7);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_TRUE(queue.Enqueue(7));
+  consumer.join();
+}
+
+//两个线程分别对不同的队列WaitDequeue，入队必须唤醒真正在等这个队列的线程，
+//不能只叫醒另一个、让它要等到EmptyWait的超时（10ms）才检查一次
+TEST(QueueSelector, WakesDirectWaiterOfTheRightQueue) {
+  BoundedQueue<int> idle;
+  BoundedQueue<int> busy;
+  ASSERT_TRUE(idle.Init(8));
+  ASSERT_TRUE(busy.Init(8));
+  QueueSelector<int> selector;
+  selector.Add(&idle);
+  selector.Add(&busy);
+  std::thread idle_waiter([&]() {
+    int value = 0;
+    EXPECT_FALSE(idle.WaitDequeue(&value));
+  });
+  constexpr int kRounds = 100;
+  std::atomic<int> received = {0};
+  std::thread busy_waiter([&]() {
+    int value = 0;
+    for (int i = 0; i < kRounds; ++i) {
+      EXPECT_TRUE(busy.WaitDequeue(&value));
+      received++;
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRounds; ++i) {
+    ASSERT_TRUE(busy.Enqueue(i));
+    while (received <= i) {
+      std::this_thread::yield();
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+  busy_waiter.join();
+  idle.BreakAllWait();
+  idle_waiter.join();
+  //只唤醒一个等待者时大约一半的轮次要等10ms的超时
+  EXPECT_LT(elapsed, std::chrono::milliseconds(kRounds * 3));
+}
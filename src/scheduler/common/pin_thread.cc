@@ -0,0 +1,92 @@
+#include "pin_thread.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <sstream>
+
+#include "../../common/log.h"
+
+void ParseCpuset(const std::string& str, std::vector<int>* cpuset) {
+  std::stringstream ss(str);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty()) {
+      continue;
+    }
+    auto pos = range.find('-');
+    int start = std::stoi(range.substr(0, pos));
+    int end = pos == std::string::npos ? start : std::stoi(range.substr(pos + 1));
+    for (int cpu = start; cpu <= end; ++cpu) {
+      cpuset->emplace_back(cpu);
+    }
+  }
+}
+
+void SetSchedAffinity(std::thread* thread, const std::vector<int>& cpus,
+                      const std::string& affinity, int cpu_id) {
+  if (cpus.empty()) {
+    return;
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (affinity == "range") {
+    for (const auto cpu : cpus) {
+      CPU_SET(cpu, &set);
+    }
+  } else if (affinity == "1to1") {
+    if (cpu_id < 0 || static_cast<size_t>(cpu_id) >= cpus.size()) {
+      AWARN << "cpu_id " << cpu_id << " out of cpuset, skip affinity.";
+      return;
+    }
+    CPU_SET(cpus[cpu_id], &set);
+  } else {
+    AWARN << "Unknown affinity: " << affinity;
+    return;
+  }
+
+  int ret = pthread_setaffinity_np(thread->native_handle(), sizeof(set), &set);
+  if (ret != 0) {
+    AWARN << "pthread_setaffinity_np failed, ret: " << ret;
+  }
+}
+
+bool SetSchedPolicy(std::thread* thread, const std::string& policy,
+                    int priority) {
+  int sched_policy = SCHED_OTHER;
+  if (policy == "SCHED_FIFO") {
+    sched_policy = SCHED_FIFO;
+  } else if (policy == "SCHED_RR") {
+    sched_policy = SCHED_RR;
+  } else if (policy.empty() || policy == "SCHED_OTHER") {
+    //普通策略下不需要修改，也就不需要任何权限
+    return true;
+  } else {
+    AWARN << "Unknown sched policy: " << policy;
+    return false;
+  }
+
+  struct sched_param param;
+  param.sched_priority =
+      std::min(std::max(priority, sched_get_priority_min(sched_policy)),
+               sched_get_priority_max(sched_policy));
+  int ret = pthread_setschedparam(thread->native_handle(), sched_policy, &param);
+  if (ret == 0) {
+    return true;
+  }
+  if (ret == EPERM) {
+    //每个处理器线程都会调用，只提示一次
+    static std::atomic<bool> warned = {false};
+    if (!warned.exchange(true)) {
+      AWARN << "no permission to set " << policy
+            << ", processors keep running with SCHED_OTHER.";
+    }
+  } else {
+    AWARN << "pthread_setschedparam failed, ret: " << ret;
+  }
+  return false;
+}
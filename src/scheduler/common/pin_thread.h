@@ -0,0 +1,23 @@
+#ifndef CYBER_SCHEDULER_COMMON_PIN_THREAD_H_
+#define CYBER_SCHEDULER_COMMON_PIN_THREAD_H_
+
+#include <string>
+#include <thread>
+#include <vector>
+
+//解析形如"0-7,16-23"的cpuset配置
+void ParseCpuset(const std::string& str, std::vector<int>* cpuset);
+
+//affinity取值为"range"时线程可以在cpuset中的任意核上运行，
+//取值为"1to1"时第cpu_id个线程绑定到cpuset中的第cpu_id个核上
+void SetSchedAffinity(std::thread* thread, const std::vector<int>& cpus,
+                      const std::string& affinity, int cpu_id);
+
+//policy取值为"SCHED_FIFO"、"SCHED_RR"或"SCHED_OTHER"，priority只对实时策略有效，
+//超出系统允许的范围时取最近的合法值。
+//没有权限设置实时策略（EPERM，既没有CAP_SYS_NICE，RLIMIT_RTPRIO也不够）时只打印一次警告，
+//线程保持原来的SCHED_OTHER继续运行；成功时返回true
+bool SetSchedPolicy(std::thread* thread, const std::string& policy,
+                    int priority);
+
+#endif  // CYBER_SCHEDULER_COMMON_PIN_THREAD_H_
@@ -0,0 +1,64 @@
+#ifndef CYBER_SCHEDULER_COMMON_ROUTINE_INBOX_H_
+#define CYBER_SCHEDULER_COMMON_ROUTINE_INBOX_H_
+
+#include <atomic>
+
+#include "../../croutine/croutine.h"
+
+//处理器的收件队列：基于CRoutine::inbox_next_的侵入式多生产者单消费者队列。
+//Push()可以在任意线程调用，只有一次XCHG和一次store，是wait-free的，不分配内存也没有容量上限；
+//Pop()只能由所属的处理器线程调用。
+//生产者先交换tail_再链接前驱，两步之间消费者看到的链表是断开的：
+//此时Pop()返回nullptr（稍后重试即可），只有取走最后一个协程时和生产者竞争，才需要等待生产者完成链接。
+//协程通过CRoutine::Notify()保证同一时刻最多在一个收件队列中出现一次。
+class RoutineInbox {
+ public:
+  void Push(CRoutine* cr) {
+    cr->inbox_next_.store(nullptr, std::memory_order_relaxed);
+    //seq_cst：和处理器Wait()中先声明parked_再检查Empty()配合，不会丢失唤醒
+    CRoutine* prev = tail_.exchange(cr, std::memory_order_seq_cst);
+    if (prev == nullptr) {
+      head_.store(cr, std::memory_order_release);
+    } else {
+      prev->inbox_next_.store(cr, std::memory_order_release);
+    }
+  }
+
+  CRoutine* Pop() {
+    CRoutine* head = head_.load(std::memory_order_acquire);
+    if (head == nullptr) {
+      return nullptr;
+    }
+    CRoutine* next = head->inbox_next_.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      head_.store(next, std::memory_order_relaxed);
+      return head;
+    }
+    //head可能是最后一个，也可能有生产者已经交换了tail_但还没有链接到head后面
+    CRoutine* tail = tail_.load(std::memory_order_acquire);
+    if (tail != head) {
+      return nullptr;
+    }
+    head_.store(nullptr, std::memory_order_relaxed);
+    if (tail_.compare_exchange_strong(tail, nullptr, std::memory_order_acq_rel,
+                                      std::memory_order_acquire)) {
+      return head;
+    }
+    //有生产者在head之后入队，它拿到的前驱就是head，等它完成链接
+    while ((next = head->inbox_next_.load(std::memory_order_acquire)) ==
+           nullptr) {
+    }
+    head_.store(next, std::memory_order_relaxed);
+    return head;
+  }
+
+  bool Empty() const {
+    return tail_.load(std::memory_order_seq_cst) == nullptr;
+  }
+
+ private:
+  alignas(CACHELINE_SIZE) std::atomic<CRoutine*> tail_ = {nullptr};
+  alignas(CACHELINE_SIZE) std::atomic<CRoutine*> head_ = {nullptr};
+};
+
+#endif  // CYBER_SCHEDULER_COMMON_ROUTINE_INBOX_H_
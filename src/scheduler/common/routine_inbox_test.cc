@@ -0,0 +1,83 @@
+#include "routine_inbox.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(RoutineInbox, FifoSingleThread) {
+  RoutineInbox inbox;
+  EXPECT_TRUE(inbox.Empty());
+  EXPECT_EQ(inbox.Pop(), nullptr);
+  std::vector<std::shared_ptr<CRoutine>> routines;
+  for (int i = 0; i < 3; ++i) {
+    routines.push_back(CRoutine::Create([]() {}));
+    inbox.Push(routines.back().get());
+  }
+  EXPECT_FALSE(inbox.Empty());
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(inbox.Pop(), routines[i].get());
+  }
+  EXPECT_EQ(inbox.Pop(), nullptr);
+  EXPECT_TRUE(inbox.Empty());
+  //取空之后可以继续使用
+  inbox.Push(routines[1].get());
+  EXPECT_EQ(inbox.Pop(), routines[1].get());
+}
+
+TEST(RoutineInbox, ManyProducers) {
+  constexpr int kProducers = 4;
+  constexpr int kRoutinesPerProducer = 16;
+  constexpr int kRounds = 2000;
+  RoutineInbox inbox;
+  std::vector<std::shared_ptr<CRoutine>> routines;
+  std::unordered_map<CRoutine*, int> index;
+  for (int i = 0; i < kProducers * kRoutinesPerProducer; ++i) {
+    routines.push_back(CRoutine::Create([]() {}));
+    index[routines.back().get()] = i;
+  }
+  //协程被取出之后生产者才能再次放入，和Notify()保证的唤醒语义一致
+  std::unique_ptr<std::atomic<bool>[]> queued(
+      new std::atomic<bool>[routines.size()]);
+  for (size_t i = 0; i < routines.size(); ++i) {
+    queued[i] = false;
+  }
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&, p]() {
+      for (int round = 0; round < kRounds; ++round) {
+        for (int j = 0; j < kRoutinesPerProducer; ++j) {
+          int i = p * kRoutinesPerProducer + j;
+          while (queued[i].load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+          }
+          queued[i].store(true, std::memory_order_relaxed);
+          inbox.Push(routines[i].get());
+        }
+      }
+    });
+  }
+
+  const int total = kProducers * kRoutinesPerProducer * kRounds;
+  int popped = 0;
+  while (popped < total) {
+    CRoutine* cr = inbox.Pop();
+    if (cr == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    int i = index[cr];
+    ASSERT_TRUE(queued[i].load());
+    queued[i].store(false, std::memory_order_release);
+    ++popped;
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  EXPECT_EQ(inbox.Pop(), nullptr);
+  EXPECT_TRUE(inbox.Empty());
+}
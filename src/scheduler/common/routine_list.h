@@ -0,0 +1,73 @@
+#ifndef CYBER_SCHEDULER_COMMON_ROUTINE_LIST_H_
+#define CYBER_SCHEDULER_COMMON_ROUTINE_LIST_H_
+
+#include <cstddef>
+
+#include "../../croutine/croutine.h"
+
+//基于CRoutine::next_的侵入式单向FIFO链表，入队出队都是O(1)且不需要分配内存。
+//链表本身不是线程安全的，由使用者加锁或者只在所属线程中访问。
+class RoutineList {
+ public:
+  bool Empty() const { return head_ == nullptr; }
+  size_t Size() const { return size_; }
+  CRoutine* Front() const { return head_; }
+
+  void PushBack(CRoutine* cr) {
+    cr->next_ = nullptr;
+    if (tail_ == nullptr) {
+      head_ = cr;
+    } else {
+      tail_->next_ = cr;
+    }
+    tail_ = cr;
+    ++size_;
+  }
+
+  CRoutine* PopFront() {
+    CRoutine* cr = head_;
+    if (cr == nullptr) {
+      return nullptr;
+    }
+    head_ = cr->next_;
+    if (head_ == nullptr) {
+      tail_ = nullptr;
+    }
+    cr->next_ = nullptr;
+    --size_;
+    return cr;
+  }
+
+  //遍历链表，把pred返回true的协程摘下来交给sink，其余协程保持原有顺序
+  template <typename Pred, typename Sink>
+  void Extract(Pred pred, Sink sink) {
+    CRoutine* prev = nullptr;
+    CRoutine* cr = head_;
+    while (cr != nullptr) {
+      CRoutine* next = cr->next_;
+      if (pred(cr)) {
+        if (prev == nullptr) {
+          head_ = next;
+        } else {
+          prev->next_ = next;
+        }
+        if (tail_ == cr) {
+          tail_ = prev;
+        }
+        cr->next_ = nullptr;
+        --size_;
+        sink(cr);
+      } else {
+        prev = cr;
+      }
+      cr = next;
+    }
+  }
+
+ private:
+  CRoutine* head_ = nullptr;
+  CRoutine* tail_ = nullptr;
+  size_t size_ = 0;
+};
+
+#endif  // CYBER_SCHEDULER_COMMON_ROUTINE_LIST_H_
@@ -0,0 +1,164 @@
+#ifndef CYBER_SCHEDULER_COMMON_ROUTINE_TIMING_WHEEL_H_
+#define CYBER_SCHEDULER_COMMON_ROUTINE_TIMING_WHEEL_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "routine_list.h"
+
+//处理器私有的分层时间轮，存放处于SLEEP状态的协程。
+//第0层每个槽对应一个tick，第l层每个槽对应64^l个tick，共6层；协程按唤醒时间的绝对tick
+//放入对应层的槽中，时间推进到高层槽的起点时再把其中的协程重新放入低层（cascade），
+//到达第0层槽对应的tick时协程到期。每层用一个64位的位图记录非空的槽，
+//推进时可以跳过空的区间，计算下一次到期时间也只需要几次位运算。
+//时间轮只在所属的处理器线程中访问，不需要加锁。
+class RoutineTimingWheel {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit RoutineTimingWheel(Duration tick = std::chrono::microseconds(100))
+      : tick_(tick), now_tick_(FloorTick(Clock::now())) {}
+
+  bool Empty() const { return size_ == 0; }
+  size_t Size() const { return size_; }
+
+  //按cr->wake_time()放入时间轮；已经到期时返回false，由调用者直接放入就绪队列
+  bool Add(CRoutine* cr) {
+    if (CeilTick(cr->wake_time()) <= now_tick_) {
+      return false;
+    }
+    Insert(cr);
+    return true;
+  }
+
+  //推进到now，期间到期的协程按到期顺序交给sink。
+  //调用者每次推进只需要读一次时钟，多个tick的处理都基于这一次的时间
+  template <typename Sink>
+  void Advance(Clock::time_point now, Sink sink) {
+    uint64_t target = FloorTick(now);
+    while (now_tick_ < target) {
+      if (size_ == 0) {
+        now_tick_ = target;
+        return;
+      }
+      //低于level的各层都为空时，直接跳到level层的下一个槽的起点
+      uint64_t tick = now_tick_ + 1;
+      int level = 0;
+      while (level < kLevels - 1 && levels_[level].bitmap == 0) {
+        ++level;
+      }
+      if (level > 0) {
+        uint64_t step = uint64_t{1} << (kLevelBits * level);
+        tick = (now_tick_ / step + 1) * step;
+        if (tick > target) {
+          now_tick_ = target;
+          return;
+        }
+      }
+      now_tick_ = tick;
+
+      for (int l = kLevels - 1; l >= 1; --l) {
+        if ((tick & ((uint64_t{1} << (kLevelBits * l)) - 1)) == 0) {
+          Cascade(l, SlotIndex(tick, l));
+        }
+      }
+
+      auto& slot = levels_[0].slots[tick & kSlotMask];
+      while (!slot.Empty()) {
+        --size_;
+        sink(slot.PopFront());
+      }
+      levels_[0].bitmap &= ~(uint64_t{1} << (tick & kSlotMask));
+    }
+  }
+
+  //下一次需要推进时间轮的时间点，只会提前不会推迟；时间轮为空时返回time_point::max()
+  Clock::time_point NextExpiry() const {
+    if (size_ == 0) {
+      return Clock::time_point::max();
+    }
+    uint64_t best = UINT64_MAX;
+    for (int l = 0; l < kLevels; ++l) {
+      uint64_t bitmap = levels_[l].bitmap;
+      if (bitmap == 0) {
+        continue;
+      }
+      uint64_t block = now_tick_ >> (kLevelBits * l);
+      uint32_t shift = (block + 1) & kSlotMask;
+      uint64_t rotated = shift == 0 ? bitmap
+                                    : (bitmap >> shift) | (bitmap << (kSlots - shift));
+      uint64_t next = (block + 1 + __builtin_ctzll(rotated)) << (kLevelBits * l);
+      if (next < best) {
+        best = next;
+      }
+    }
+    return Clock::time_point(
+        std::chrono::duration_cast<Clock::duration>(tick_ * best));
+  }
+
+ private:
+  static constexpr int kLevelBits = 6;
+  static constexpr int kLevels = 6;
+  static constexpr uint64_t kSlots = uint64_t{1} << kLevelBits;
+  static constexpr uint64_t kSlotMask = kSlots - 1;
+
+  struct Level {
+    std::array<RoutineList, kSlots> slots;
+    uint64_t bitmap = 0;
+  };
+
+  static uint64_t SlotIndex(uint64_t tick, int level) {
+    return (tick >> (kLevelBits * level)) & kSlotMask;
+  }
+
+  uint64_t FloorTick(Clock::time_point tp) const {
+    return static_cast<uint64_t>(tp.time_since_epoch() / tick_);
+  }
+
+  //向上取整，保证协程不会早于wake_time被唤醒
+  uint64_t CeilTick(Clock::time_point tp) const {
+    auto since_epoch = tp.time_since_epoch();
+    uint64_t tick = static_cast<uint64_t>(since_epoch / tick_);
+    return since_epoch % tick_ == Clock::duration::zero() ? tick : tick + 1;
+  }
+
+  void Insert(CRoutine* cr) {
+    uint64_t expire = CeilTick(cr->wake_time());
+    if (expire < now_tick_) {
+      expire = now_tick_;
+    }
+    uint64_t delta = expire - now_tick_;
+    int level = 0;
+    while (level < kLevels - 1 &&
+           delta >= (uint64_t{1} << (kLevelBits * (level + 1)))) {
+      ++level;
+    }
+    //超出最高层范围的协程先放在最高层较远的槽里（不能是当前槽），到时再重新计算位置
+    if (delta >= (uint64_t{1} << (kLevelBits * kLevels))) {
+      expire = now_tick_ + (uint64_t{1} << (kLevelBits * kLevels)) -
+               (uint64_t{1} << (kLevelBits * (kLevels - 1)));
+    }
+    uint64_t index = SlotIndex(expire, level);
+    levels_[level].slots[index].PushBack(cr);
+    levels_[level].bitmap |= (uint64_t{1} << index);
+    ++size_;
+  }
+
+  void Cascade(int level, uint64_t index) {
+    RoutineList list = levels_[level].slots[index];
+    levels_[level].slots[index] = RoutineList();
+    levels_[level].bitmap &= ~(uint64_t{1} << index);
+    while (!list.Empty()) {
+      --size_;
+      Insert(list.PopFront());
+    }
+  }
+
+  std::array<Level, kLevels> levels_;
+  Duration tick_;
+  uint64_t now_tick_ = 0;
+  size_t size_ = 0;
+};
+
+#endif  // CYBER_SCHEDULER_COMMON_ROUTINE_TIMING_WHEEL_H_
@@ -0,0 +1,69 @@
+#include "routine_watchdog.h"
+
+#include <algorithm>
+
+RoutineWatchdog::RoutineWatchdog(std::chrono::microseconds threshold,
+                                 bool preempt)
+    : threshold_(threshold), preempt_(preempt) {}
+
+RoutineWatchdog::~RoutineWatchdog() { Stop(); }
+
+void RoutineWatchdog::Watch(const std::shared_ptr<Processor>& processor) {
+  Slot slot;
+  slot.processor = processor;
+  slots_.emplace_back(slot);
+}
+
+void RoutineWatchdog::Start() {
+  if (thread_.joinable()) {
+    return;
+  }
+  if (preempt_) {
+    Processor::InstallPreemptHandler();
+  }
+  thread_ = std::thread(&RoutineWatchdog::Loop, this);
+}
+
+void RoutineWatchdog::Stop() {
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void RoutineWatchdog::Loop() {
+  //采样间隔为阈值的一半，超时被发现时实际已经运行了threshold到1.5*threshold
+  auto period = std::max(threshold_ / 2, std::chrono::microseconds(100));
+  std::unique_lock<std::mutex> lk(mutex_);
+  while (!stop_) {
+    cv_.wait_for(lk, period, [this]() { return stop_; });
+    auto now = std::chrono::steady_clock::now();
+    for (auto& slot : slots_) {
+      Check(&slot, now);
+    }
+  }
+}
+
+void RoutineWatchdog::Check(Slot* slot,
+                            std::chrono::steady_clock::time_point now) {
+  uint64_t seq = slot->processor->ResumeSeq();
+  if (seq != slot->last_seq || (seq & 1) == 0) {
+    //处理器空闲或者已经换了一次Resume，重新计时
+    slot->last_seq = seq;
+    slot->since = now;
+    slot->flagged = false;
+    return;
+  }
+  if (slot->flagged || now - slot->since < threshold_) {
+    return;
+  }
+  slot->flagged = true;
+  overrun_count_.fetch_add(1, std::memory_order_relaxed);
+  if (preempt_) {
+    slot->processor->Preempt(seq);
+  }
+}
@@ -0,0 +1,59 @@
+#ifndef CYBER_SCHEDULER_COMMON_ROUTINE_WATCHDOG_H_
+#define CYBER_SCHEDULER_COMMON_ROUTINE_WATCHDOG_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../processor.h"
+
+//协程运行超时的看门狗。
+//后台线程每隔threshold/2采样一次各处理器的Resume序号，同一次Resume持续超过threshold时记一次超时；
+//preempt为true时还向该处理器线程发送Processor::kPreemptSignal，信号处理函数把当前协程标记为需要抢占：
+//协程在下一个MaybeYield()处让出，处理器据此对它降级。
+//协程切换路径上只多了两次relaxed的写，不需要读时钟。
+//完全不调用MaybeYield()的协程无法被打断，看门狗只能记录它超时。
+//注意：被标记时阻塞在系统调用中的协程可能收到一次EINTR。
+class RoutineWatchdog {
+ public:
+  RoutineWatchdog(std::chrono::microseconds threshold, bool preempt);
+  ~RoutineWatchdog();
+
+  //Start()之前调用
+  void Watch(const std::shared_ptr<Processor>& processor);
+  void Start();
+  void Stop();
+
+  //发现的超时次数，每次超时的Resume只记一次
+  uint64_t OverrunCount() const {
+    return overrun_count_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Slot {
+    std::shared_ptr<Processor> processor;
+    uint64_t last_seq = 0;
+    std::chrono::steady_clock::time_point since;
+    bool flagged = false;
+  };
+
+  void Loop();
+  void Check(Slot* slot, std::chrono::steady_clock::time_point now);
+
+  std::chrono::microseconds threshold_;
+  bool preempt_;
+  std::vector<Slot> slots_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+  std::thread thread_;
+  std::atomic<uint64_t> overrun_count_ = {0};
+};
+
+#endif  // CYBER_SCHEDULER_COMMON_ROUTINE_WATCHDOG_H_
@@ -0,0 +1,56 @@
+#ifndef CYBER_SCHEDULER_COMMON_RUN_QUEUE_H_
+#define CYBER_SCHEDULER_COMMON_RUN_QUEUE_H_
+
+#include <array>
+#include <cstdint>
+
+#include "routine_list.h"
+
+//优先级个数，数值越大优先级越高，和Apollo的配置保持一致
+constexpr uint32_t MAX_PRIO = 20;
+static_assert(MAX_PRIO <= 64, "priority bitmap is a uint64_t");
+
+//多优先级就绪队列：每个优先级一个侵入式FIFO，再用一个位图记录哪些优先级非空。
+//选取下一个协程时不再按优先级逐个遍历数组，而是通过clz指令直接找到最高的非空优先级，
+//整个过程是O(1)的，与协程总数以及未就绪协程的个数都无关。
+class RunQueue {
+ public:
+  bool Empty() const { return bitmap_ == 0; }
+  size_t Size() const { return size_; }
+
+  void Push(CRoutine* cr) {
+    uint32_t prio = cr->priority();
+    if (prio >= MAX_PRIO) {
+      prio = MAX_PRIO - 1;
+    }
+    queues_[prio].PushBack(cr);
+    bitmap_ |= (uint64_t{1} << prio);
+    ++size_;
+  }
+
+  CRoutine* Pop() {
+    if (bitmap_ == 0) {
+      return nullptr;
+    }
+    //find-last-set：最高位的1即为最高的非空优先级
+    uint32_t prio = 63 - __builtin_clzll(bitmap_);
+    CRoutine* cr = queues_[prio].PopFront();
+    if (queues_[prio].Empty()) {
+      bitmap_ &= ~(uint64_t{1} << prio);
+    }
+    --size_;
+    return cr;
+  }
+
+  //当前最高的非空优先级，队列为空时返回-1
+  int TopPriority() const {
+    return bitmap_ == 0 ? -1 : 63 - __builtin_clzll(bitmap_);
+  }
+
+ private:
+  std::array<RoutineList, MAX_PRIO> queues_;
+  uint64_t bitmap_ = 0;
+  size_t size_ = 0;
+};
+
+#endif  // CYBER_SCHEDULER_COMMON_RUN_QUEUE_H_
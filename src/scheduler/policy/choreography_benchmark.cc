@@ -0,0 +1,159 @@
+//5级流水线的端到端延迟：编排模式 vs 经典模式的自由线程池。
+//外部线程每period_us产生一条消息，5个阶段协程依次处理（每级忙等stage_us），
+//每级处理完放入下一级的队列并通知下一级，最后一级记录从产生到处理完的时间。
+//同时有noise_num个计算型协程，每次连续计算1ms（中间没有让出点）后再让出。
+//- choreography：5个阶段按配置绑定到0号编排处理器，优先级逐级升高；噪声协程进入线程池。
+//- classic：所有协程放在同一个分组中，由分组内的处理器自由地执行和窃取。
+//两种模式的处理器总数相同。
+//用法：choreography_benchmark [messages] [noise_num] [policy(SCHED_FIFO/SCHED_OTHER)]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../bounded_queue.h"
+#include "scheduler_choreography.h"
+#include "scheduler_classic.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kStageNum = 5;
+constexpr int kStageWorkUs = 20;
+constexpr int kPeriodUs = 1000;
+constexpr int kNoiseBurstUs = 1000;
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Clock::now().time_since_epoch())
+      .count();
+}
+
+void BusyWait(int64_t us) {
+  int64_t end = NowNs() + us * 1000;
+  while (NowNs() < end) {
+  }
+}
+
+std::string StageName(int stage) { return "stage" + std::to_string(stage); }
+
+uint64_t StageId(int stage) { return std::hash<std::string>()(StageName(stage)); }
+
+struct Pipeline {
+  //queues[i]是第i级的输入
+  BoundedQueue<int64_t> queues[kStageNum];
+  std::vector<int64_t> latencies;
+  std::atomic<int> done = {0};
+  std::atomic<bool> quit = {false};
+};
+
+void RunStage(Scheduler* sched, Pipeline* pipeline, int stage) {
+  while (!pipeline->quit) {
+    CRoutine::Yield(RoutineState::DATA_WAIT);
+    int64_t produce_ns = 0;
+    while (pipeline->queues[stage].Dequeue(&produce_ns)) {
+      BusyWait(kStageWorkUs);
+      if (stage + 1 < kStageNum) {
+        pipeline->queues[stage + 1].Enqueue(produce_ns);
+        sched->NotifyTask(StageId(stage + 1));
+      } else {
+        pipeline->latencies.push_back(NowNs() - produce_ns);
+        pipeline->done++;
+      }
+    }
+  }
+}
+
+void RunNoise(Pipeline* pipeline) {
+  while (!pipeline->quit) {
+    BusyWait(kNoiseBurstUs);
+    CRoutine::Yield();
+  }
+}
+
+void Run(const std::string& mode, Scheduler* sched, int messages,
+         int noise_num) {
+  Pipeline pipeline;
+  for (auto& queue : pipeline.queues) {
+    queue.Init(1024);
+  }
+  pipeline.latencies.reserve(messages);
+  for (int i = 0; i < kStageNum; ++i) {
+    sched->CreateTask([sched, &pipeline, i]() { RunStage(sched, &pipeline, i); },
+                      StageName(i));
+  }
+  for (int i = 0; i < noise_num; ++i) {
+    sched->CreateTask([&pipeline]() { RunNoise(&pipeline); },
+                      "noise" + std::to_string(i));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  auto next = Clock::now();
+  for (int i = 0; i < messages; ++i) {
+    next += std::chrono::microseconds(kPeriodUs);
+    std::this_thread::sleep_until(next);
+    pipeline.queues[0].Enqueue(NowNs());
+    sched->NotifyTask(StageId(0));
+  }
+  while (pipeline.done < messages) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  pipeline.quit = true;
+  for (int i = 0; i < kStageNum; ++i) {
+    sched->NotifyTask(StageId(i));
+  }
+  sched->Shutdown();
+
+  auto& samples = pipeline.latencies;
+  std::sort(samples.begin(), samples.end());
+  auto percentile = [&samples](double p) {
+    return samples[static_cast<size_t>(p * (samples.size() - 1))] / 1000.0;
+  };
+  std::cout << mode << " end-to-end us p50: " << percentile(0.5)
+            << " p99: " << percentile(0.99) << " max: " << percentile(1.0)
+            << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int messages = argc > 1 ? std::atoi(argv[1]) : 2000;
+  int noise_num = argc > 2 ? std::atoi(argv[2]) : 4;
+  std::string policy = argc > 3 ? argv[3] : "SCHED_FIFO";
+  std::cout << "messages: " << messages << " noise routines: " << noise_num
+            << " stages: " << kStageNum << " x " << kStageWorkUs << "us"
+            << std::endl;
+
+  {
+    ChoreographyConf conf;
+    conf.choreography_processor_num = 1;
+    conf.choreography_processor_policy = policy;
+    conf.choreography_processor_prio = 10;
+    conf.pool_processor_num = 1;
+    for (int i = 0; i < kStageNum; ++i) {
+      //同一条链路上越靠后的阶段优先级越高，已经进入流水线的消息先处理完
+      conf.tasks.push_back({StageName(i), 0, static_cast<uint32_t>(i + 1)});
+    }
+    SchedulerChoreography sched(conf);
+    std::cout << "policy " << policy << " applied: " << sched.RealtimeApplied()
+              << std::endl;
+    Run("choreography", &sched, messages, noise_num);
+  }
+
+  {
+    ClassicGroupConf group;
+    group.name = "free";
+    group.processor_num = 2;
+    ClassicConf conf;
+    conf.groups.push_back(group);
+    SchedulerClassic sched(conf);
+    Run("classic", &sched, messages, noise_num);
+  }
+  return 0;
+}
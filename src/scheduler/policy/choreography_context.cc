@@ -0,0 +1,117 @@
+#include "choreography_context.h"
+
+#include "../scheduler.h"
+
+constexpr std::chrono::milliseconds ChoreographyContext::kMaxWaitTime;
+
+ChoreographyContext::ChoreographyContext(Scheduler* scheduler, int processor_id)
+    : scheduler_(scheduler), processor_id_(processor_id) {}
+
+CRoutine* ChoreographyContext::NextRoutine() {
+  if (cyber_unlikely(stop_.load())) {
+    return nullptr;
+  }
+
+  if (!inbox_.Empty()) {
+    DrainInbox();
+  }
+  if (!timer_wheel_.Empty()) {
+    AdvanceTimer();
+  }
+
+  CRoutine* cr = run_queue_.Pop();
+  if (cr == nullptr) {
+    return nullptr;
+  }
+  //没有窃取，协程只会出现在本处理器上，Acquire一定成功
+  if (cyber_unlikely(!cr->Acquire())) {
+    run_queue_.Push(cr);
+    return nullptr;
+  }
+  return cr;
+}
+
+void ChoreographyContext::OnRoutineYield(CRoutine* cr) {
+  switch (cr->state()) {
+    case RoutineState::READY:
+      run_queue_.Push(cr);
+      break;
+    case RoutineState::FINISHED:
+      scheduler_->ReleaseRoutine(cr->id());
+      break;
+    case RoutineState::SLEEP:
+      if (!timer_wheel_.Add(cr)) {
+        cr->Wake();
+        run_queue_.Push(cr);
+      }
+      break;
+    default:
+      //运行期间已经收到通知时直接重新调度，否则挂起等待Wakeup()
+      if (!cr->Park()) {
+        cr->Wake();
+        run_queue_.Push(cr);
+      }
+      break;
+  }
+}
+
+void ChoreographyContext::Enqueue(CRoutine* cr) { PushInbox(cr); }
+
+void ChoreographyContext::Wakeup(CRoutine* cr) {
+  if (!cr->Notify()) {
+    return;
+  }
+  PushInbox(cr);
+}
+
+std::shared_ptr<CRoutine> ChoreographyContext::GetRoutine(uint64_t crid) {
+  return scheduler_ == nullptr ? nullptr : scheduler_->GetRoutine(crid);
+}
+
+void ChoreographyContext::PushInbox(CRoutine* cr) {
+  inbox_.Push(cr);
+  //只有处理器已经在等待时才需要加锁唤醒它
+  if (parked_.load(std::memory_order_seq_cst)) {
+    Notify();
+  }
+}
+
+void ChoreographyContext::Wait() {
+  std::unique_lock<std::mutex> lk(mtx_wq_);
+  auto deadline = std::chrono::steady_clock::now() + kMaxWaitTime;
+  auto next_expiry = timer_wheel_.NextExpiry();
+  if (next_expiry < deadline) {
+    deadline = next_expiry;
+  }
+  //先声明自己将要等待，再检查inbox；与PushInbox()中先入队再检查parked_配合，不会丢失唤醒
+  parked_.store(true, std::memory_order_seq_cst);
+  if (!inbox_.Empty() || HasPendingWork()) {
+    parked_.store(false, std::memory_order_relaxed);
+    return;
+  }
+  cv_wq_.wait_until(lk, deadline, [this]() { return notified_ || stop_; });
+  notified_ = false;
+  parked_.store(false, std::memory_order_relaxed);
+}
+
+void ChoreographyContext::Notify() {
+  {
+    std::lock_guard<std::mutex> lk(mtx_wq_);
+    notified_ = true;
+  }
+  cv_wq_.notify_one();
+}
+
+void ChoreographyContext::DrainInbox() {
+  CRoutine* cr = nullptr;
+  while ((cr = inbox_.Pop()) != nullptr) {
+    run_queue_.Push(cr);
+  }
+}
+
+void ChoreographyContext::AdvanceTimer() {
+  timer_wheel_.Advance(std::chrono::steady_clock::now(), [this](CRoutine* cr) {
+    cr->Wake();
+    run_queue_.Push(cr);
+  });
+}
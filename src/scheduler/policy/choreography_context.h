@@ -0,0 +1,72 @@
+#ifndef CYBER_SCHEDULER_POLICY_CHOREOGRAPHY_CONTEXT_H_
+#define CYBER_SCHEDULER_POLICY_CHOREOGRAPHY_CONTEXT_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "../../common/macros.h"
+#include "../common/routine_inbox.h"
+#include "../common/routine_timing_wheel.h"
+#include "../common/run_queue.h"
+#include "../processor_context.h"
+
+class Scheduler;
+
+//编排模式下的处理器上下文。
+//协程通过配置静态地绑定到某个处理器上，不会被其他处理器窃取，所以就绪队列只由本处理器线程访问：
+//- 就绪队列（优先级位图+侵入式FIFO）和时间轮都是处理器私有的，不加锁；
+//- 其他线程分发（Enqueue）或唤醒（Wakeup）的协程都先放入wait-free的收件队列(inbox)，
+//  处理器选取协程前把它们批量移入就绪队列，跨线程的路径上没有锁；
+//- 只有处理器已经在Wait()中睡眠时，唤醒方才加锁通知它。
+//与ClassicContext相比没有窃取、时间片降级和IO反应器，协程之间的先后完全由配置的优先级决定。
+class ChoreographyContext : public ProcessorContext {
+ public:
+  ChoreographyContext(Scheduler* scheduler, int processor_id);
+
+  CRoutine* NextRoutine() override;
+  void OnRoutineYield(CRoutine* cr) override;
+  void Wait() override;
+  void Notify() override;
+  void Wakeup(CRoutine* cr) override;
+  std::shared_ptr<CRoutine> GetRoutine(uint64_t crid) override;
+
+  //可以在任意线程调用，把新分发的协程交给本处理器
+  void Enqueue(CRoutine* cr);
+
+  int processor_id() const { return processor_id_; }
+  bool Parked() const { return parked_.load(std::memory_order_relaxed); }
+
+ protected:
+  //子类自己的待处理事件（例如ShardContext的邮箱），Wait()在声明等待之后检查，返回true时不睡眠。
+  //事件的发送方先发布事件，再检查Parked()决定是否调用Notify()
+  virtual bool HasPendingWork() { return false; }
+
+ private:
+  void DrainInbox();
+  void AdvanceTimer();
+  //放入inbox，处理器在等待时唤醒它
+  void PushInbox(CRoutine* cr);
+
+  //没有任何事件时最长的等待时间
+  static constexpr std::chrono::milliseconds kMaxWaitTime{1000};
+
+  Scheduler* scheduler_ = nullptr;
+  int processor_id_ = -1;
+
+  //只在本处理器线程中访问
+  RunQueue run_queue_;
+  RoutineTimingWheel timer_wheel_;
+
+  RoutineInbox inbox_;
+
+  alignas(CACHELINE_SIZE) std::mutex mtx_wq_;
+  std::condition_variable cv_wq_;
+  bool notified_ = false;
+  std::atomic<bool> parked_ = {false};
+};
+
+#endif  // CYBER_SCHEDULER_POLICY_CHOREOGRAPHY_CONTEXT_H_
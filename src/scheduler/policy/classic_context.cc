@@ -0,0 +1,253 @@
+#include "classic_context.h"
+
+#include "../../common/macros.h"
+#include "../scheduler.h"
+
+constexpr std::chrono::milliseconds ClassicContext::kMaxWaitTime;
+constexpr uint32_t ClassicContext::kIoPollInterval;
+
+ClassicContext::ClassicContext(Scheduler* scheduler,
+                               const std::string& group_name, int processor_id)
+    : scheduler_(scheduler),
+      group_name_(group_name),
+      processor_id_(processor_id),
+      reactor_(this) {}
+
+CRoutine* ClassicContext::NextRoutine() {
+  if (cyber_unlikely(stop_.load())) {
+    return nullptr;
+  }
+
+  if (reactor_.Waiting() > 0 && ++io_poll_count_ >= kIoPollInterval) {
+    io_poll_count_ = 0;
+    reactor_.Poll(0);
+  }
+  if (!inbox_.Empty()) {
+    DrainInbox();
+  }
+  if (!timer_wheel_.Empty()) {
+    AdvanceTimer();
+  }
+
+  CRoutine* cr = PopReady();
+  if (cr == nullptr) {
+    cr = StealFromGroup();
+    if (cr == nullptr) {
+      return nullptr;
+    }
+    cr->set_processor_id(processor_id_);
+  }
+
+  //协程同一时刻只在一个队列里，正常情况下Acquire一定成功
+  if (cyber_unlikely(!cr->Acquire())) {
+    Enqueue(cr);
+    return nullptr;
+  }
+  return cr;
+}
+
+void ClassicContext::OnRoutineYield(CRoutine* cr) {
+  if (demote_on_overrun_) {
+    if (cr->SliceExpired()) {
+      cr->Demote();
+    } else {
+      cr->RestorePriority();
+    }
+  }
+
+  switch (cr->state()) {
+    case RoutineState::READY: {
+      std::lock_guard<std::mutex> lk(rq_mtx_);
+      run_queue_.Push(cr);
+      break;
+    }
+    case RoutineState::FINISHED:
+      scheduler_->ReleaseRoutine(cr->id());
+      break;
+    case RoutineState::SLEEP:
+      if (!timer_wheel_.Add(cr)) {
+        cr->Wake();
+        std::lock_guard<std::mutex> lk(rq_mtx_);
+        run_queue_.Push(cr);
+      }
+      break;
+    default:
+      //运行期间已经收到通知时直接重新调度，否则挂起等待Wakeup()
+      if (!cr->Park()) {
+        cr->Wake();
+        std::lock_guard<std::mutex> lk(rq_mtx_);
+        run_queue_.Push(cr);
+      }
+      break;
+  }
+}
+
+void ClassicContext::Enqueue(CRoutine* cr) {
+  {
+    std::lock_guard<std::mutex> lk(rq_mtx_);
+    run_queue_.Push(cr);
+  }
+  Notify();
+
+  //本处理器正在运行其他协程时，唤醒同组内一个空闲的处理器来窃取
+  if (group_ != nullptr && !Parked()) {
+    for (auto ctx : *group_) {
+      if (ctx != this && ctx->Parked()) {
+        ctx->Notify();
+        break;
+      }
+    }
+  }
+}
+
+void ClassicContext::Wait() {
+  std::unique_lock<std::mutex> lk(mtx_wq_);
+  auto deadline = std::chrono::steady_clock::now() + kMaxWaitTime;
+  auto next_expiry = timer_wheel_.NextExpiry();
+  if (next_expiry < deadline) {
+    deadline = next_expiry;
+  }
+  auto io_deadline = reactor_.NextDeadline();
+  if (io_deadline < deadline) {
+    deadline = io_deadline;
+  }
+  //先声明自己将要等待，再检查inbox；与Wakeup()中先入队再检查parked_配合，不会丢失唤醒
+  parked_.store(true, std::memory_order_seq_cst);
+  if (!inbox_.Empty()) {
+    parked_.store(false, std::memory_order_relaxed);
+    return;
+  }
+  if (reactor_.Waiting() > 0) {
+    WaitIo(&lk, deadline);
+  } else {
+    cv_wq_.wait_until(lk, deadline, [this]() { return notified_ || stop_; });
+  }
+  notified_ = false;
+  parked_.store(false, std::memory_order_relaxed);
+}
+
+void ClassicContext::Notify() {
+  bool polling = false;
+  {
+    std::lock_guard<std::mutex> lk(mtx_wq_);
+    notified_ = true;
+    polling = polling_;
+  }
+  //反应器在Poll()中唤醒本处理器的协程时处理器线程并没有阻塞，不需要打断
+  if (polling && ProcessorContext::Current() != this) {
+    reactor_.Interrupt();
+  } else {
+    cv_wq_.notify_one();
+  }
+}
+
+//阻塞在epoll_wait中等待IO事件，持有mtx_wq_时检查notified_并设置polling_，
+//与Notify()中持锁设置notified_再检查polling_配合，不会丢失唤醒
+void ClassicContext::WaitIo(std::unique_lock<std::mutex>* lk,
+                            std::chrono::steady_clock::time_point deadline) {
+  if (notified_ || stop_) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  int timeout_ms = 0;
+  if (deadline > now) {
+    //向上取整，避免在到期前反复以0超时空转
+    timeout_ms = static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - now + std::chrono::microseconds(999))
+            .count());
+  }
+  polling_ = true;
+  lk->unlock();
+  reactor_.Poll(timeout_ms);
+  lk->lock();
+  polling_ = false;
+}
+
+void ClassicContext::Wakeup(CRoutine* cr) {
+  if (!cr->Notify()) {
+    return;
+  }
+  inbox_.Push(cr);
+  //只有处理器已经在等待时才需要加锁唤醒它
+  if (parked_.load(std::memory_order_seq_cst)) {
+    Notify();
+  }
+}
+
+std::shared_ptr<CRoutine> ClassicContext::GetRoutine(uint64_t crid) {
+  return scheduler_ == nullptr ? nullptr : scheduler_->GetRoutine(crid);
+}
+
+size_t ClassicContext::ReadySize() {
+  std::lock_guard<std::mutex> lk(rq_mtx_);
+  return run_queue_.Size();
+}
+
+CRoutine* ClassicContext::PopReady() {
+  std::lock_guard<std::mutex> lk(rq_mtx_);
+  return run_queue_.Pop();
+}
+
+CRoutine* ClassicContext::Steal() {
+  std::unique_lock<std::mutex> lk(rq_mtx_, std::try_to_lock);
+  if (!lk.owns_lock()) {
+    return nullptr;
+  }
+  return run_queue_.Pop();
+}
+
+CRoutine* ClassicContext::StealFromGroup() {
+  if (group_ == nullptr) {
+    return nullptr;
+  }
+  //从自身的下一个处理器开始轮询，避免所有空闲处理器都去窃取同一个处理器
+  size_t num = group_->size();
+  size_t self = 0;
+  while (self < num && (*group_)[self] != this) {
+    ++self;
+  }
+  for (size_t i = 1; i < num; ++i) {
+    auto victim = (*group_)[(self + i) % num];
+    CRoutine* cr = victim->Steal();
+    if (cr != nullptr) {
+      return cr;
+    }
+  }
+  return nullptr;
+}
+
+//把其他线程唤醒的协程批量移入就绪队列，只加一次锁
+void ClassicContext::DrainInbox() {
+  RoutineList ready;
+  CRoutine* cr = nullptr;
+  while ((cr = inbox_.Pop()) != nullptr) {
+    ready.PushBack(cr);
+  }
+
+  if (ready.Empty()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lk(rq_mtx_);
+  while (!ready.Empty()) {
+    run_queue_.Push(ready.PopFront());
+  }
+}
+
+//推进时间轮，只读取一次时钟，到期的协程一次加锁全部放入就绪队列
+void ClassicContext::AdvanceTimer() {
+  RoutineList ready;
+  timer_wheel_.Advance(std::chrono::steady_clock::now(),
+                       [&ready](CRoutine* cr) {
+                         cr->Wake();
+                         ready.PushBack(cr);
+                       });
+
+  if (ready.Empty()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lk(rq_mtx_);
+  while (!ready.Empty()) {
+    run_queue_.Push(ready.PopFront());
+  }
+}
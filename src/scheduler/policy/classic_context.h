@@ -0,0 +1,99 @@
+#ifndef CYBER_SCHEDULER_POLICY_CLASSIC_CONTEXT_H_
+#define CYBER_SCHEDULER_POLICY_CLASSIC_CONTEXT_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../../common/macros.h"
+#include "../../io/reactor.h"
+#include "../common/routine_inbox.h"
+#include "../common/routine_list.h"
+#include "../common/routine_timing_wheel.h"
+#include "../common/run_queue.h"
+#include "../processor_context.h"
+
+class Scheduler;
+
+//经典模式下的处理器上下文。
+//每个处理器拥有自己的多优先级就绪队列（侵入式链表+优先级位图），选取下一个协程是O(1)的；
+//SLEEP的协程放在处理器私有的时间轮中，到期后直接放入就绪队列；
+//DATA_WAIT/IO_WAIT的协程挂起后不在任何队列中，由Wakeup()在事件到达时放入处理器的收件队列(inbox)，
+//inbox是侵入式的wait-free多生产者单消费者队列，唤醒方不加锁也不会因为队列满而阻塞，
+//处理器选取协程前先把inbox中的协程批量移入就绪队列。
+//IO_WAIT的协程等待在处理器私有的epoll反应器上，有协程在等待IO时处理器空闲时阻塞在epoll_wait中，
+//此时Notify()通过eventfd打断等待。
+//同一分组（group）内的处理器共享协程：本地就绪队列为空时会从同组的其他处理器窃取协程。
+//用完时间片（MaybeYield()）的协程会被降级，类似多级反馈队列，保证交互型的协程不被计算型协程拖慢。
+class ClassicContext : public ProcessorContext {
+ public:
+  ClassicContext(Scheduler* scheduler, const std::string& group_name,
+                 int processor_id);
+
+  CRoutine* NextRoutine() override;
+  void OnRoutineYield(CRoutine* cr) override;
+  void Wait() override;
+  void Notify() override;
+  void Wakeup(CRoutine* cr) override;
+  std::shared_ptr<CRoutine> GetRoutine(uint64_t crid) override;
+  Reactor* GetReactor() override { return &reactor_; }
+
+  //从任意线程把协程放入本处理器的就绪队列
+  void Enqueue(CRoutine* cr);
+  //同组的处理器列表，用于空闲时窃取协程，列表中包含自身
+  void SetGroup(const std::vector<ClassicContext*>* group) { group_ = group; }
+  //用完时间片的协程每次降低一级优先级，在时间片内让出后恢复配置的优先级
+  void set_demote_on_overrun(bool demote) { demote_on_overrun_ = demote; }
+
+  const std::string& group_name() const { return group_name_; }
+  int processor_id() const { return processor_id_; }
+  size_t ReadySize();
+  size_t SleepingSize() const { return timer_wheel_.Size(); }
+  bool Parked() const { return parked_.load(std::memory_order_relaxed); }
+
+ private:
+  CRoutine* PopReady();
+  CRoutine* Steal();
+  CRoutine* StealFromGroup();
+  void DrainInbox();
+  void AdvanceTimer();
+  void WaitIo(std::unique_lock<std::mutex>* lk,
+              std::chrono::steady_clock::time_point deadline);
+
+  //没有任何事件时最长的等待时间
+  static constexpr std::chrono::milliseconds kMaxWaitTime{1000};
+  //有协程在等待IO时，每选取这么多次协程就非阻塞地检查一次epoll，避免IO协程被计算型协程饿死
+  static constexpr uint32_t kIoPollInterval = 16;
+
+  Scheduler* scheduler_ = nullptr;
+  std::string group_name_;
+  int processor_id_ = -1;
+  const std::vector<ClassicContext*>* group_ = nullptr;
+  bool demote_on_overrun_ = true;
+
+  alignas(CACHELINE_SIZE) std::mutex rq_mtx_;
+  RunQueue run_queue_;
+
+  //其他线程唤醒的协程先放入inbox，由本处理器批量取出
+  RoutineInbox inbox_;
+
+  //时间轮只在本处理器线程中访问，不需要加锁
+  alignas(CACHELINE_SIZE) RoutineTimingWheel timer_wheel_;
+  //反应器同样只在本处理器线程中访问（Interrupt()除外）
+  Reactor reactor_;
+  uint32_t io_poll_count_ = 0;
+
+  alignas(CACHELINE_SIZE) std::mutex mtx_wq_;
+  std::condition_variable cv_wq_;
+  bool notified_ = false;
+  //处理器线程阻塞在epoll_wait中，由mtx_wq_保护
+  bool polling_ = false;
+  std::atomic<bool> parked_ = {false};
+};
+
+#endif  // CYBER_SCHEDULER_POLICY_CLASSIC_CONTEXT_H_
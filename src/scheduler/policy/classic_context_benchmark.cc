@@ -0,0 +1,95 @@
+//经典模式下选取下一个协程的耗时对比：
+//1、Apollo原有的实现：按优先级从高到低遍历协程数组，对每个协程Acquire并UpdateState
+//2、当前的实现：多优先级侵入式就绪队列+优先级位图，未就绪的协程挂起后不参与选取
+//10000个协程中只有1%处于就绪状态
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "classic_context.h"
+
+namespace {
+
+constexpr int kRoutineNum = 10000;
+constexpr int kReadyNum = kRoutineNum / 100;
+constexpr int kPickTimes = 1000000;
+
+void Nop() {}
+
+//优先级和就绪的协程都用固定种子随机生成，保证两种实现面对相同的协程分布
+std::vector<std::shared_ptr<CRoutine>> CreateRoutines() {
+  std::mt19937 rng(2023);
+  std::vector<std::shared_ptr<CRoutine>> routines;
+  for (int i = 0; i < kRoutineNum; ++i) {
+    auto cr = CRoutine::Create(Nop);
+    cr->set_id(i);
+    cr->set_priority(rng() % MAX_PRIO);
+    cr->set_state(i < kReadyNum ? RoutineState::READY
+                                : RoutineState::DATA_WAIT);
+    routines.emplace_back(cr);
+  }
+  std::shuffle(routines.begin(), routines.end(), rng);
+  return routines;
+}
+
+CRoutine* LinearScan(
+    std::vector<std::vector<std::shared_ptr<CRoutine>>>& multi_pri_rq) {
+  for (int i = MAX_PRIO - 1; i >= 0; --i) {
+    for (auto& cr : multi_pri_rq[i]) {
+      if (!cr->Acquire()) {
+        continue;
+      }
+      if (cr->UpdateState() == RoutineState::READY) {
+        return cr.get();
+      }
+      cr->Release();
+    }
+  }
+  return nullptr;
+}
+
+double BenchLinearScan() {
+  auto routines = CreateRoutines();
+  std::vector<std::vector<std::shared_ptr<CRoutine>>> multi_pri_rq(MAX_PRIO);
+  for (auto& cr : routines) {
+    multi_pri_rq[cr->priority()].emplace_back(cr);
+  }
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < kPickTimes; ++i) {
+    CRoutine* cr = LinearScan(multi_pri_rq);
+    cr->Release();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - begin).count() /
+         kPickTimes;
+}
+
+double BenchRunQueue() {
+  auto routines = CreateRoutines();
+  ClassicContext ctx(nullptr, "benchmark", 0);
+  for (auto& cr : routines) {
+    ctx.OnRoutineYield(cr.get());
+  }
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < kPickTimes; ++i) {
+    CRoutine* cr = ctx.NextRoutine();
+    cr->Release();
+    ctx.OnRoutineYield(cr);
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - begin).count() /
+         kPickTimes;
+}
+
+}  // namespace
+
+int main() {
+  std::cout << "routines: " << kRoutineNum << " ready: " << kReadyNum
+            << std::endl;
+  std::cout << "linear scan: " << BenchLinearScan() << " ns/pick" << std::endl;
+  std::cout << "run queue:   " << BenchRunQueue() << " ns/pick" << std::endl;
+  return 0;
+}
@@ -0,0 +1,80 @@
+//数据到达到协程被调度执行的延迟。
+//routine_num个协程都处于DATA_WAIT，外部线程每次随机通知其中一个协程并记录通知时间，
+//协程被调度后计算延迟并应答，外部线程收到应答后再发下一个通知。
+//用法：notify_benchmark [routine_num] [rounds]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "scheduler_classic.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<int64_t> notify_time_ns = {0};
+std::atomic<int64_t> latency_ns = {-1};
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Clock::now().time_since_epoch())
+      .count();
+}
+
+void Consumer() {
+  for (;;) {
+    CRoutine::Yield(RoutineState::DATA_WAIT);
+    latency_ns = NowNs() - notify_time_ns;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int routine_num = argc > 1 ? std::atoi(argv[1]) : 10000;
+  int rounds = argc > 2 ? std::atoi(argv[2]) : 20000;
+
+  ClassicGroupConf group;
+  group.name = "notify";
+  group.processor_num = 1;
+  ClassicConf conf;
+  conf.groups.push_back(group);
+  SchedulerClassic sched(conf);
+  std::vector<uint64_t> ids;
+  for (int i = 0; i < routine_num; ++i) {
+    std::string name = "consumer" + std::to_string(i);
+    sched.CreateTask(Consumer, name);
+    ids.push_back(std::hash<std::string>()(name));
+  }
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+
+  std::mt19937 rng(2023);
+  std::vector<int64_t> samples;
+  for (int i = 0; i < rounds; ++i) {
+    latency_ns = -1;
+    notify_time_ns = NowNs();
+    sched.NotifyTask(ids[rng() % ids.size()]);
+    while (latency_ns < 0) {
+      std::this_thread::yield();
+    }
+    samples.push_back(latency_ns);
+  }
+
+  std::sort(samples.begin(), samples.end());
+  auto percentile = [&samples](double p) {
+    return samples[static_cast<size_t>(p * (samples.size() - 1))] / 1000.0;
+  };
+  std::cout << "routines: " << routine_num << " rounds: " << rounds
+            << std::endl;
+  std::cout << "notify to resume us p50: " << percentile(0.5)
+            << " p99: " << percentile(0.99) << " max: " << percentile(1.0)
+            << std::endl;
+  sched.Shutdown();
+  return 0;
+}
@@ -0,0 +1,122 @@
+//高优先级协程和计算型协程（CPU hog）混跑在同一个处理器上时的最坏唤醒延迟。
+//高优先级协程循环Sleep 1ms，记录实际运行时间相对wake_time的延迟；
+//hog协程一直在做计算，三种模式：
+//  none      每算满50ms才Yield一次（没有检查点的长回调）
+//  slice     计算循环中调用MaybeYield()，时间片为slice_us
+//  watchdog  同样调用MaybeYield()但时间片很长，由看门狗在运行超过slice_us时标记抢占
+//用法：preempt_benchmark [none|slice|watchdog] [hog_num] [slice_us] [seconds]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "scheduler_classic.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> quit = {false};
+std::mutex latency_mutex;
+std::vector<int64_t> latencies_us;
+
+//一小段不会被优化掉的计算，大约几百纳秒
+uint64_t Work(uint64_t x) {
+  for (int i = 0; i < 200; ++i) {
+    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+  }
+  return x;
+}
+
+void Hog(const std::string& mode) {
+  volatile uint64_t sink = 0;
+  uint64_t x = 1;
+  if (mode == "watchdog") {
+    CRoutine::GetCurrentRoutine()->set_time_slice(std::chrono::seconds(60));
+  }
+  while (!quit) {
+    if (mode == "none") {
+      auto begin = Clock::now();
+      while (Clock::now() - begin < std::chrono::milliseconds(50)) {
+        x = Work(x);
+      }
+      CRoutine::Yield(RoutineState::READY);
+    } else {
+      x = Work(x);
+      CRoutine::MaybeYield();
+    }
+  }
+  sink = x;
+  (void)sink;
+}
+
+void Probe() {
+  auto cr = CRoutine::GetCurrentRoutine();
+  while (!quit) {
+    cr->Sleep(std::chrono::milliseconds(1));
+    auto late = std::chrono::duration_cast<std::chrono::microseconds>(
+                    Clock::now() - cr->wake_time())
+                    .count();
+    std::lock_guard<std::mutex> lk(latency_mutex);
+    latencies_us.push_back(late);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string mode = argc > 1 ? argv[1] : "slice";
+  int hog_num = argc > 2 ? std::atoi(argv[2]) : 4;
+  int slice_us = argc > 3 ? std::atoi(argv[3]) : 1000;
+  int seconds = argc > 4 ? std::atoi(argv[4]) : 3;
+
+  ClassicGroupConf group;
+  group.name = "bench";
+  group.processor_num = 1;
+  for (int i = 0; i < hog_num; ++i) {
+    ClassicTask task;
+    task.name = "hog" + std::to_string(i);
+    task.prio = 1;
+    task.time_slice_us = static_cast<uint32_t>(slice_us);
+    group.tasks.push_back(task);
+  }
+  group.tasks.push_back({"probe", 10, ""});
+  ClassicConf conf;
+  conf.groups.push_back(group);
+  if (mode == "watchdog") {
+    conf.watchdog_threshold = std::chrono::microseconds(slice_us);
+    conf.watchdog_preempt = true;
+  }
+
+  SchedulerClassic sched(conf);
+  for (int i = 0; i < hog_num; ++i) {
+    sched.CreateTask([mode]() { Hog(mode); }, "hog" + std::to_string(i));
+  }
+  sched.CreateTask(Probe, "probe");
+
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+  quit = true;
+  uint64_t overruns = sched.OverrunCount();
+  sched.Shutdown();
+
+  std::lock_guard<std::mutex> lk(latency_mutex);
+  if (latencies_us.empty()) {
+    std::cout << "mode=" << mode << " no samples" << std::endl;
+    return 0;
+  }
+  std::sort(latencies_us.begin(), latencies_us.end());
+  auto pct = [](double p) {
+    return latencies_us[static_cast<size_t>(p * (latencies_us.size() - 1))];
+  };
+  std::cout << "mode=" << mode << " hogs=" << hog_num
+            << " slice_us=" << slice_us << " samples=" << latencies_us.size()
+            << " p50_us=" << pct(0.5) << " p99_us=" << pct(0.99)
+            << " max_us=" << latencies_us.back()
+            << " watchdog_overruns=" << overruns << std::endl;
+  return 0;
+}
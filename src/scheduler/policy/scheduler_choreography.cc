@@ -0,0 +1,192 @@
+#include "scheduler_choreography.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "../../common/conf_node.h"
+#include "../../common/log.h"
+#include "../common/pin_thread.h"
+
+namespace {
+const char kPoolGroupName[] = "pool";
+
+//key存在但类型不对时报错，不存在时保留默认值
+template <typename T>
+bool GetField(const ConfNode& node, const std::string& key, T* value) {
+  if (!node.Has(key) || node.Get(key, value)) {
+    return true;
+  }
+  AERROR << "invalid value of " << key << ": " << node.Child(key)->value();
+  return false;
+}
+}  // namespace
+
+SchedulerChoreography::SchedulerChoreography(const ChoreographyConf& conf)
+    : conf_(conf) {
+  uint32_t hardware_num = std::max(1u, std::thread::hardware_concurrency());
+  if (conf_.choreography_processor_num == 0) {
+    conf_.choreography_processor_num = hardware_num;
+  }
+  if (conf_.pool_processor_num == 0) {
+    conf_.pool_processor_num = hardware_num;
+  }
+
+  for (auto& task : conf_.tasks) {
+    cr_confs_[task.name] = task;
+  }
+
+  CreateProcessor();
+}
+
+SchedulerChoreography::~SchedulerChoreography() { Shutdown(); }
+
+void SchedulerChoreography::CreateProcessor() {
+  for (uint32_t i = 0; i < conf_.choreography_processor_num; i++) {
+    auto ctx = std::make_shared<ChoreographyContext>(
+        this, static_cast<int>(pctxs_.size()));
+    choreography_ctxs_.emplace_back(ctx.get());
+    pctxs_.emplace_back(ctx);
+  }
+  for (uint32_t i = 0; i < conf_.pool_processor_num; i++) {
+    auto ctx = std::make_shared<ClassicContext>(
+        this, kPoolGroupName, static_cast<int>(pctxs_.size()));
+    ctx->SetGroup(&pool_ctxs_);
+    pool_ctxs_.emplace_back(ctx.get());
+    pctxs_.emplace_back(ctx);
+  }
+
+  //所有上下文创建完成后再启动线程，保证线程池窃取时看到的分组是完整的
+  std::vector<int> cpuset;
+  ParseCpuset(conf_.choreography_cpuset, &cpuset);
+  for (uint32_t i = 0; i < conf_.choreography_processor_num; i++) {
+    auto proc = std::make_shared<Processor>();
+    proc->BindContext(pctxs_[i]);
+    SetSchedAffinity(proc->Thread(), cpuset, conf_.choreography_affinity, i);
+    if (!SetSchedPolicy(proc->Thread(), conf_.choreography_processor_policy,
+                        conf_.choreography_processor_prio)) {
+      realtime_applied_ = false;
+    }
+    processors_.emplace_back(proc);
+  }
+
+  cpuset.clear();
+  ParseCpuset(conf_.pool_cpuset, &cpuset);
+  for (uint32_t i = 0; i < conf_.pool_processor_num; i++) {
+    auto proc = std::make_shared<Processor>();
+    proc->BindContext(pctxs_[conf_.choreography_processor_num + i]);
+    SetSchedAffinity(proc->Thread(), cpuset, conf_.pool_affinity, i);
+    if (!SetSchedPolicy(proc->Thread(), conf_.pool_processor_policy,
+                        conf_.pool_processor_prio)) {
+      realtime_applied_ = false;
+    }
+    processors_.emplace_back(proc);
+  }
+}
+
+bool SchedulerChoreography::DispatchTask(const std::shared_ptr<CRoutine>& cr) {
+  if (!id_cr_.Insert(cr->id(), cr)) {
+    return false;
+  }
+
+  auto conf = cr_confs_.find(cr->name());
+  if (conf != cr_confs_.end()) {
+    cr->set_priority(conf->second.prio);
+    cr->set_processor_id(conf->second.processor);
+  }
+
+  if (cr->priority() >= MAX_PRIO) {
+    AWARN << cr->name() << " prio is greater than MAX_PRIO[ " << MAX_PRIO
+          << " ].";
+    cr->set_priority(MAX_PRIO - 1);
+  }
+
+  //指定了编排处理器的协程放入对应的处理器，其余的在线程池中轮询
+  int pid = cr->processor_id();
+  if (pid >= 0 && static_cast<size_t>(pid) < choreography_ctxs_.size()) {
+    choreography_ctxs_[pid]->Enqueue(cr.get());
+    return true;
+  }
+  if (pid >= 0 && conf != cr_confs_.end()) {
+    AWARN << cr->name() << " processor " << pid
+          << " is out of choreography processors, run in pool.";
+  }
+
+  cr->set_group_name(kPoolGroupName);
+  uint32_t index = next_pool_proc_.fetch_add(1, std::memory_order_relaxed);
+  ClassicContext* ctx = pool_ctxs_[index % pool_ctxs_.size()];
+  cr->set_processor_id(ctx->processor_id());
+  ctx->Enqueue(cr.get());
+  return true;
+}
+
+bool SchedulerChoreography::NotifyProcessor(uint64_t crid) {
+  auto cr = GetRoutine(crid);
+  if (cr == nullptr) {
+    return false;
+  }
+  //编排的协程固定在一个处理器上，线程池中的协程挂起时所在的处理器就是它最后一次运行的处理器
+  int pid = cr->processor_id();
+  if (pid < 0 || static_cast<size_t>(pid) >= pctxs_.size()) {
+    return true;
+  }
+  pctxs_[pid]->Wakeup(cr.get());
+  return true;
+}
+
+bool SchedulerChoreography::LoadConf(const std::string& path,
+                                     ChoreographyConf* conf) {
+  ConfNode root;
+  std::string error;
+  if (!ConfNode::Load(path, &root, &error)) {
+    AERROR << "failed to load " << path << ", " << error;
+    return false;
+  }
+  return ParseConf(root, conf);
+}
+
+bool SchedulerChoreography::ParseConf(const ConfNode& root,
+                                      ChoreographyConf* conf) {
+  const ConfNode* node = &root;
+  if (node->Has("scheduler_conf")) {
+    node = node->Child("scheduler_conf");
+  }
+  if (node->Has("choreography_conf")) {
+    node = node->Child("choreography_conf");
+  }
+
+  ChoreographyConf result;
+  bool ok =
+      GetField(*node, "choreography_processor_num",
+               &result.choreography_processor_num) &&
+      GetField(*node, "choreography_affinity", &result.choreography_affinity) &&
+      GetField(*node, "choreography_cpuset", &result.choreography_cpuset) &&
+      GetField(*node, "choreography_processor_policy",
+               &result.choreography_processor_policy) &&
+      GetField(*node, "choreography_processor_prio",
+               &result.choreography_processor_prio) &&
+      GetField(*node, "pool_processor_num", &result.pool_processor_num) &&
+      GetField(*node, "pool_affinity", &result.pool_affinity) &&
+      GetField(*node, "pool_cpuset", &result.pool_cpuset) &&
+      GetField(*node, "pool_processor_policy",
+               &result.pool_processor_policy) &&
+      GetField(*node, "pool_processor_prio", &result.pool_processor_prio);
+  if (!ok) {
+    return false;
+  }
+
+  for (const ConfNode* task_node : node->Children("tasks")) {
+    ChoreographyTask task;
+    if (!task_node->Get("name", &task.name) || task.name.empty()) {
+      AERROR << "choreography task without name.";
+      return false;
+    }
+    if (!GetField(*task_node, "processor", &task.processor) ||
+        !GetField(*task_node, "prio", &task.prio)) {
+      return false;
+    }
+    result.tasks.push_back(task);
+  }
+
+  *conf = result;
+  return true;
+}
@@ -0,0 +1,78 @@
+#ifndef CYBER_SCHEDULER_POLICY_SCHEDULER_CHOREOGRAPHY_H_
+#define CYBER_SCHEDULER_POLICY_SCHEDULER_CHOREOGRAPHY_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../scheduler.h"
+#include "choreography_context.h"
+#include "classic_context.h"
+
+class ConfNode;
+
+//对应Apollo中cyber/conf/example_sched_choreography.conf里的字段
+struct ChoreographyTask {
+  std::string name;
+  //编排处理器的编号，-1表示不编排，放入线程池
+  int processor = -1;
+  uint32_t prio = 0;
+};
+
+struct ChoreographyConf {
+  //处理器个数为0时取硬件线程数
+  uint32_t choreography_processor_num = 0;
+  std::string choreography_affinity = "range";
+  std::string choreography_cpuset;
+  //"SCHED_OTHER"、"SCHED_RR"或"SCHED_FIFO"
+  std::string choreography_processor_policy = "SCHED_OTHER";
+  int choreography_processor_prio = 0;
+
+  uint32_t pool_processor_num = 0;
+  std::string pool_affinity = "range";
+  std::string pool_cpuset;
+  std::string pool_processor_policy = "SCHED_OTHER";
+  int pool_processor_prio = 0;
+
+  std::vector<ChoreographyTask> tasks;
+};
+
+//编排模式的调度器：主链路上的协程按配置静态绑定到编排处理器（ChoreographyContext），
+//同一个处理器上按配置的优先级执行；没有指定处理器或者没有出现在配置中的协程
+//放入经典模式的线程池（ClassicContext组成的分组，组内互相窃取）。
+//编排处理器的编号为0..choreography_processor_num-1，线程池处理器的编号排在后面。
+class SchedulerChoreography : public Scheduler {
+ public:
+  explicit SchedulerChoreography(const ChoreographyConf& conf = ChoreographyConf());
+  ~SchedulerChoreography() override;
+
+  bool DispatchTask(const std::shared_ptr<CRoutine>& cr) override;
+
+  //从配置文件读取choreography_conf，文件中可以只有choreography_conf，
+  //也可以是Apollo的完整格式scheduler_conf { choreography_conf { ... } }。
+  //格式错误时打印错误并返回false
+  static bool LoadConf(const std::string& path, ChoreographyConf* conf);
+  static bool ParseConf(const ConfNode& root, ChoreographyConf* conf);
+
+  uint32_t ChoreographyProcessorNum() const {
+    return static_cast<uint32_t>(choreography_ctxs_.size());
+  }
+  //实时调度策略是否设置成功，没有配置实时策略时为true
+  bool RealtimeApplied() const { return realtime_applied_; }
+
+ private:
+  bool NotifyProcessor(uint64_t crid) override;
+  void CreateProcessor();
+
+  ChoreographyConf conf_;
+  std::unordered_map<std::string, ChoreographyTask> cr_confs_;
+  //构造之后只读
+  std::vector<ChoreographyContext*> choreography_ctxs_;
+  std::vector<ClassicContext*> pool_ctxs_;
+  std::atomic<uint32_t> next_pool_proc_ = {0};
+  bool realtime_applied_ = true;
+};
+
+#endif  // CYBER_SCHEDULER_POLICY_SCHEDULER_CHOREOGRAPHY_H_
@@ -0,0 +1,220 @@
+#include "scheduler_choreography.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "../../common/conf_node.h"
+#include "../../test_util.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+ChoreographyConf TwoProcessorConf() {
+  ChoreographyConf conf;
+  conf.choreography_processor_num = 2;
+  conf.pool_processor_num = 2;
+  conf.tasks.push_back({"blocker", 0, 5});
+  conf.tasks.push_back({"low", 0, 1});
+  conf.tasks.push_back({"high", 0, 2});
+  conf.tasks.push_back({"second", 1, 1});
+  conf.tasks.push_back({"unpinned", -1, 3});
+  return conf;
+}
+
+//当前协程所在的编排处理器编号，在线程池中运行时返回-1
+int CurrentChoreographyProcessor() {
+  auto ctx = dynamic_cast<ChoreographyContext*>(ProcessorContext::Current());
+  return ctx == nullptr ? -1 : ctx->processor_id();
+}
+
+bool InPool() {
+  auto ctx = dynamic_cast<ClassicContext*>(ProcessorContext::Current());
+  return ctx != nullptr && ctx->group_name() == "pool";
+}
+
+}  // namespace
+
+TEST(SchedulerChoreography, LoadConf) {
+  const char* text = R"(
+    scheduler_conf {
+      choreography_conf {
+        choreography_processor_num: 2
+        choreography_cpuset: "0-1"
+        choreography_processor_policy: "SCHED_FIFO"  # 实时策略
+        choreography_processor_prio: 10
+        pool_processor_num: 3
+        tasks: [
+          { name: "A" processor: 0 prio: 1 },
+          { name: "B" processor: 1 prio: 2 },
+          { name: "E" }
+        ]
+      }
+    }
+  )";
+  char path[] = "/tmp/sched_choreography_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  close(fd);
+  std::ofstream(path) << text;
+  ChoreographyConf conf;
+  bool loaded = SchedulerChoreography::LoadConf(path, &conf);
+  unlink(path);
+  ASSERT_TRUE(loaded);
+  EXPECT_EQ(conf.choreography_processor_num, 2u);
+  EXPECT_EQ(conf.choreography_cpuset, "0-1");
+  EXPECT_EQ(conf.choreography_processor_policy, "SCHED_FIFO");
+  EXPECT_EQ(conf.choreography_processor_prio, 10);
+  EXPECT_EQ(conf.pool_processor_num, 3u);
+  EXPECT_EQ(conf.pool_processor_policy, "SCHED_OTHER");
+  ASSERT_EQ(conf.tasks.size(), 3u);
+  EXPECT_EQ(conf.tasks[1].name, "B");
+  EXPECT_EQ(conf.tasks[1].processor, 1);
+  EXPECT_EQ(conf.tasks[1].prio, 2u);
+  EXPECT_EQ(conf.tasks[2].processor, -1);
+
+  ConfNode root;
+  ASSERT_TRUE(ConfNode::Parse("tasks { processor: 0 }", &root, nullptr));
+  EXPECT_FALSE(SchedulerChoreography::ParseConf(root, &conf));
+  ASSERT_TRUE(ConfNode::Parse("pool_processor_num: -2", &root, nullptr));
+  EXPECT_FALSE(SchedulerChoreography::ParseConf(root, &conf));
+}
+
+TEST(SchedulerChoreography, PinnedAndPooled) {
+  SchedulerChoreography sched(TwoProcessorConf());
+  EXPECT_EQ(sched.ChoreographyProcessorNum(), 2u);
+  EXPECT_EQ(sched.ProcessorNum(), 4u);
+  std::atomic<int> second_proc = {-2};
+  std::atomic<int> unpinned_proc = {-2};
+  std::atomic<int> unknown_proc = {-2};
+  std::atomic<bool> unpinned_in_pool = {false};
+  std::atomic<bool> unknown_in_pool = {false};
+  sched.CreateTask([&]() { second_proc = CurrentChoreographyProcessor(); },
+                   "second");
+  sched.CreateTask(
+      [&]() {
+        unpinned_proc = CurrentChoreographyProcessor();
+        unpinned_in_pool = InPool();
+      },
+      "unpinned");
+  //没有出现在配置中的协程同样进入线程池
+  sched.CreateTask(
+      [&]() {
+        unknown_proc = CurrentChoreographyProcessor();
+        unknown_in_pool = InPool();
+      },
+      "unknown");
+  EXPECT_TRUE(WaitFor([&]() { return sched.TaskNum() == 0; }));
+  EXPECT_EQ(second_proc, 1);
+  EXPECT_EQ(unpinned_proc, -1);
+  EXPECT_TRUE(unpinned_in_pool);
+  EXPECT_EQ(unknown_proc, -1);
+  EXPECT_TRUE(unknown_in_pool);
+}
+
+TEST(SchedulerChoreography, PriorityOnPinnedProcessor) {
+  SchedulerChoreography sched(TwoProcessorConf());
+  std::atomic<bool> started = {false};
+  std::atomic<bool> release = {false};
+  std::atomic<int> order = {0};
+  std::atomic<int> low_order = {-1};
+  std::atomic<int> high_order = {-1};
+  //占住0号编排处理器，其他处理器空闲时也不会窃取编排的协程
+  sched.CreateTask(
+      [&]() {
+        started = true;
+        while (!release) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      },
+      "blocker");
+  ASSERT_TRUE(WaitFor([&]() { return started.load(); }));
+  sched.CreateTask([&]() { low_order = order++; }, "low");
+  sched.CreateTask([&]() { high_order = order++; }, "high");
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(order, 0);
+  release = true;
+  EXPECT_TRUE(WaitFor([&]() { return order == 2; }));
+  EXPECT_EQ(high_order, 0);
+  EXPECT_EQ(low_order, 1);
+}
+
+TEST(SchedulerChoreography, SleepAndNotify) {
+  SchedulerChoreography sched(TwoProcessorConf());
+  std::atomic<int> stage = {0};
+  std::atomic<int> proc = {-2};
+  sched.CreateTask(
+      [&]() {
+        CRoutine::GetCurrentRoutine()->Sleep(std::chrono::milliseconds(10));
+        stage = 1;
+        CRoutine::Yield(RoutineState::DATA_WAIT);
+        proc = CurrentChoreographyProcessor();
+        stage = 2;
+      },
+      "second");
+  ASSERT_TRUE(WaitFor([&]() { return stage == 1; }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(stage, 1);
+  EXPECT_TRUE(sched.NotifyTask(std::hash<std::string>()("second")));
+  EXPECT_TRUE(WaitFor([&]() { return stage == 2; }));
+  EXPECT_EQ(proc, 1);
+}
+
+TEST(SchedulerChoreography, NotifyRacesWithYield) {
+  SchedulerChoreography sched(TwoProcessorConf());
+  std::atomic<bool> quit = {false};
+  std::atomic<int> wakeups = {0};
+  sched.CreateTask(
+      [&]() {
+        while (!quit) {
+          CRoutine::Yield(RoutineState::DATA_WAIT);
+          wakeups++;
+        }
+      },
+      "high");
+  uint64_t crid = std::hash<std::string>()("high");
+  std::vector<std::thread> notifiers;
+  for (int i = 0; i < 4; ++i) {
+    notifiers.emplace_back([&]() {
+      for (int j = 0; j < 10000; ++j) {
+        sched.NotifyTask(crid);
+      }
+    });
+  }
+  for (auto& t : notifiers) {
+    t.join();
+  }
+  EXPECT_LE(wakeups, 40000);
+  int before = wakeups;
+  sched.NotifyTask(crid);
+  EXPECT_TRUE(WaitFor([&]() { return wakeups > before; }));
+  quit = true;
+  sched.NotifyTask(crid);
+  EXPECT_TRUE(WaitFor([&]() { return sched.TaskNum() == 0; }));
+}
+
+//没有CAP_SYS_NICE时SCHED_FIFO设置失败，处理器以SCHED_OTHER继续工作
+TEST(SchedulerChoreography, RealtimePolicyFallback) {
+  auto conf = TwoProcessorConf();
+  conf.choreography_processor_policy = "SCHED_FIFO";
+  conf.choreography_processor_prio = 1000;
+  SchedulerChoreography sched(conf);
+  std::atomic<int> policy = {-1};
+  sched.CreateTask(
+      [&]() {
+        int p = 0;
+        struct sched_param param;
+        pthread_getschedparam(pthread_self(), &p, &param);
+        policy = p;
+      },
+      "second");
+  EXPECT_TRUE(WaitFor([&]() { return sched.TaskNum() == 0; }));
+  EXPECT_EQ(policy, sched.RealtimeApplied() ? SCHED_FIFO : SCHED_OTHER);
+}
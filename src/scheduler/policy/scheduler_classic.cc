@@ -0,0 +1,127 @@
+#include "scheduler_classic.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "../../common/log.h"
+#include "../common/pin_thread.h"
+
+namespace {
+const char kDefaultGroupName[] = "default_grp";
+}  // namespace
+
+SchedulerClassic::SchedulerClassic(const ClassicConf& conf)
+    : classic_conf_(conf) {
+  if (classic_conf_.groups.empty()) {
+    ClassicGroupConf group;
+    group.name = kDefaultGroupName;
+    group.processor_num = std::max(1u, std::thread::hardware_concurrency());
+    classic_conf_.groups.emplace_back(group);
+  }
+
+  for (auto& group : classic_conf_.groups) {
+    for (auto task : group.tasks) {
+      task.group_name = group.name;
+      cr_confs_[task.name] = task;
+    }
+  }
+
+  CreateProcessor();
+
+  if (classic_conf_.watchdog_threshold.count() > 0) {
+    watchdog_.reset(new RoutineWatchdog(classic_conf_.watchdog_threshold,
+                                        classic_conf_.watchdog_preempt));
+    for (auto& proc : processors_) {
+      watchdog_->Watch(proc);
+    }
+    watchdog_->Start();
+  }
+}
+
+SchedulerClassic::~SchedulerClassic() {
+  //先停止看门狗，之后不会再向处理器线程发送信号
+  watchdog_.reset();
+  Shutdown();
+}
+
+void SchedulerClassic::CreateProcessor() {
+  for (auto& group : classic_conf_.groups) {
+    auto& grp = groups_[group.name];
+    grp.reset(new Group());
+    for (uint32_t i = 0; i < group.processor_num; i++) {
+      auto ctx = std::make_shared<ClassicContext>(
+          this, group.name, static_cast<int>(pctxs_.size()));
+      ctx->SetGroup(&grp->contexts);
+      ctx->set_demote_on_overrun(group.demote_on_overrun);
+      grp->contexts.emplace_back(ctx.get());
+      classic_ctxs_.emplace_back(ctx.get());
+      pctxs_.emplace_back(ctx);
+    }
+  }
+
+  //所有上下文创建完成后再启动线程，保证窃取时看到的分组是完整的
+  for (auto& group : classic_conf_.groups) {
+    std::vector<int> cpuset;
+    ParseCpuset(group.cpuset, &cpuset);
+    auto& contexts = groups_[group.name]->contexts;
+    for (uint32_t i = 0; i < contexts.size(); i++) {
+      auto proc = std::make_shared<Processor>();
+      proc->BindContext(pctxs_[contexts[i]->processor_id()]);
+      SetSchedAffinity(proc->Thread(), cpuset, group.affinity, i);
+      processors_.emplace_back(proc);
+    }
+  }
+}
+
+bool SchedulerClassic::DispatchTask(const std::shared_ptr<CRoutine>& cr) {
+  if (!id_cr_.Insert(cr->id(), cr)) {
+    return false;
+  }
+
+  auto conf = cr_confs_.find(cr->name());
+  if (conf != cr_confs_.end()) {
+    cr->set_priority(conf->second.prio);
+    cr->set_group_name(conf->second.group_name);
+    if (conf->second.time_slice_us > 0) {
+      cr->set_time_slice(Duration(conf->second.time_slice_us));
+    }
+  } else {
+    // croutine that not exist in conf
+    cr->set_group_name(classic_conf_.groups[0].name);
+  }
+
+  if (cr->priority() >= MAX_PRIO) {
+    AWARN << cr->name() << " prio is greater than MAX_PRIO[ " << MAX_PRIO
+          << " ].";
+    cr->set_priority(MAX_PRIO - 1);
+  }
+
+  //协程指定的processor_id属于该分组时直接放入对应处理器，否则在分组内轮询
+  auto& grp = groups_[cr->group_name()];
+  ClassicContext* ctx = nullptr;
+  int pid = cr->processor_id();
+  if (pid >= 0 && static_cast<size_t>(pid) < classic_ctxs_.size() &&
+      classic_ctxs_[pid]->group_name() == cr->group_name()) {
+    ctx = classic_ctxs_[pid];
+  } else {
+    uint32_t index = grp->next_proc.fetch_add(1, std::memory_order_relaxed);
+    ctx = grp->contexts[index % grp->contexts.size()];
+    cr->set_processor_id(ctx->processor_id());
+  }
+
+  ctx->Enqueue(cr.get());
+  return true;
+}
+
+bool SchedulerClassic::NotifyProcessor(uint64_t crid) {
+  auto cr = GetRoutine(crid);
+  if (cr == nullptr) {
+    return false;
+  }
+  //协程挂起时所在的处理器就是它最后一次运行的处理器
+  int pid = cr->processor_id();
+  if (pid >= 0 && static_cast<size_t>(pid) < classic_ctxs_.size()) {
+    classic_ctxs_[pid]->Wakeup(cr.get());
+  }
+  return true;
+}
@@ -0,0 +1,76 @@
+#ifndef CYBER_SCHEDULER_POLICY_SCHEDULER_CLASSIC_H_
+#define CYBER_SCHEDULER_POLICY_SCHEDULER_CLASSIC_H_
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../scheduler.h"
+#include "../common/routine_watchdog.h"
+#include "classic_context.h"
+
+//对应Apollo中cyber/conf/example_sched_classic.conf里的字段
+struct ClassicTask {
+  std::string name;
+  uint32_t prio = 0;
+  std::string group_name;
+  //每次运行的时间片（微秒），0表示使用CRoutine::kDefaultTimeSlice
+  uint32_t time_slice_us = 0;
+};
+
+struct ClassicGroupConf {
+  std::string name;
+  uint32_t processor_num = 1;
+  //"range"或者"1to1"
+  std::string affinity = "range";
+  //形如"0-7,16-23"，为空时不设置亲和性
+  std::string cpuset;
+  //用完时间片的协程是否降级
+  bool demote_on_overrun = true;
+  std::vector<ClassicTask> tasks;
+};
+
+struct ClassicConf {
+  std::vector<ClassicGroupConf> groups;
+  //协程一次运行超过这个时间时看门狗记一次超时，0表示不启用看门狗
+  std::chrono::microseconds watchdog_threshold{0};
+  //看门狗是否向超时的处理器线程发送SIGURG（Processor::kPreemptSignal）标记抢占。
+  //这会为整个进程安装SIGURG的处理函数，所以默认关闭，只记录超时次数
+  bool watchdog_preempt = false;
+};
+
+//经典模式的调度器：按分组创建处理器，并根据配置设置线程的cpu亲和性；
+//分发协程时根据配置设置协程的优先级和分组，再放入分组内某个处理器的就绪队列
+class SchedulerClassic : public Scheduler {
+ public:
+  //groups为空时创建一个默认分组，处理器个数为硬件线程数
+  explicit SchedulerClassic(const ClassicConf& conf = ClassicConf());
+  ~SchedulerClassic() override;
+
+  bool DispatchTask(const std::shared_ptr<CRoutine>& cr) override;
+  //看门狗发现的超时次数，没有启用看门狗时为0
+  uint64_t OverrunCount() const {
+    return watchdog_ ? watchdog_->OverrunCount() : 0;
+  }
+
+ private:
+  struct Group {
+    std::vector<ClassicContext*> contexts;
+    std::atomic<uint32_t> next_proc = {0};
+  };
+
+  bool NotifyProcessor(uint64_t crid) override;
+  void CreateProcessor();
+
+  ClassicConf classic_conf_;
+  std::unordered_map<std::string, ClassicTask> cr_confs_;
+  //构造之后只读，多线程分发时不需要加锁
+  std::unordered_map<std::string, std::unique_ptr<Group>> groups_;
+  std::vector<ClassicContext*> classic_ctxs_;
+  std::unique_ptr<RoutineWatchdog> watchdog_;
+};
+
+#endif  // CYBER_SCHEDULER_POLICY_SCHEDULER_CLASSIC_H_
@@ -0,0 +1,242 @@
+#include "scheduler_classic.h"
+
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "../../test_util.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+volatile sig_atomic_t user_sigurg = 0;
+void CountSigurg(int) { user_sigurg = user_sigurg + 1; }
+
+}  // namespace
+
+TEST(SchedulerClassic, RunToFinish) {
+  SchedulerClassic sched;
+  std::atomic<int> count = {0};
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(sched.CreateTask([&count]() { count++; },
+                                 "task" + std::to_string(i)));
+  }
+  EXPECT_TRUE(WaitFor([&]() { return count == 100; }));
+  EXPECT_TRUE(WaitFor([&]() { return sched.TaskNum() == 0; }));
+}
+
+TEST(SchedulerClassic, HighPriorityFirst) {
+  SchedulerClassic sched(SingleProcessorConf());
+  std::atomic<bool> started = {false};
+  std::atomic<bool> release = {false};
+  std::atomic<int> order = {0};
+  std::atomic<int> low_order = {-1};
+  std::atomic<int> high_order = {-1};
+  //先占住唯一的处理器，保证后面两个协程同时处于就绪队列中
+  sched.CreateTask(
+      [&]() {
+        started = true;
+        while (!release) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      },
+      "blocker");
+  ASSERT_TRUE(WaitFor([&]() { return started.load(); }));
+  sched.CreateTask([&]() { low_order = order++; }, "low");
+  sched.CreateTask([&]() { high_order = order++; }, "high");
+  release = true;
+  EXPECT_TRUE(WaitFor([&]() { return order == 2; }));
+  EXPECT_EQ(high_order, 0);
+  EXPECT_EQ(low_order, 1);
+}
+
+TEST(SchedulerClassic, SleepAndNotify) {
+  SchedulerClassic sched(SingleProcessorConf());
+  std::atomic<int> stage = {0};
+  auto begin = std::chrono::steady_clock::now();
+  sched.CreateTask(
+      [&]() {
+        CRoutine::GetCurrentRoutine()->Sleep(std::chrono::milliseconds(20));
+        stage = 1;
+        CRoutine::Yield(RoutineState::DATA_WAIT);
+        stage = 2;
+      },
+      "waiter");
+  ASSERT_TRUE(WaitFor([&]() { return stage == 1; }));
+  EXPECT_GE(std::chrono::steady_clock::now() - begin,
+            std::chrono::milliseconds(20));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(stage, 1);
+  EXPECT_TRUE(sched.NotifyTask(std::hash<std::string>()("waiter")));
+  EXPECT_TRUE(WaitFor([&]() { return stage == 2; }));
+}
+
+TEST(SchedulerClassic, RemoveWaitingTask) {
+  SchedulerClassic sched(SingleProcessorConf());
+  std::atomic<bool> waiting = {false};
+  sched.CreateTask(
+      [&]() {
+        waiting = true;
+        CRoutine::Yield(RoutineState::DATA_WAIT);
+      },
+      "waiter");
+  ASSERT_TRUE(WaitFor([&]() { return waiting.load(); }));
+  //同名的协程还没有结束，不能重复分发
+  EXPECT_FALSE(sched.CreateTask([]() {}, "waiter"));
+  EXPECT_TRUE(sched.RemoveTask("waiter"));
+  EXPECT_TRUE(WaitFor([&]() { return sched.TaskNum() == 0; }));
+  EXPECT_FALSE(sched.RemoveTask("waiter"));
+}
+
+TEST(SchedulerClassic, StealWithinGroup) {
+  ClassicGroupConf group;
+  group.name = "group0";
+  group.processor_num = 2;
+  ClassicConf conf;
+  conf.groups.push_back(group);
+  SchedulerClassic sched(conf);
+  std::atomic<int> count = {0};
+  for (int i = 0; i < 10; ++i) {
+    auto cr = CRoutine::Create([&count]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      count++;
+    });
+    cr->set_id(i);
+    cr->set_name("pinned" + std::to_string(i));
+    cr->set_processor_id(0);
+    EXPECT_TRUE(sched.DispatchTask(cr));
+  }
+  EXPECT_TRUE(WaitFor([&]() { return count == 10; }));
+}
+
+TEST(SchedulerClassic, NotifyRacesWithYield) {
+  SchedulerClassic sched(SingleProcessorConf());
+  std::atomic<bool> quit = {false};
+  std::atomic<int> wakeups = {0};
+  sched.CreateTask(
+      [&]() {
+        while (!quit) {
+          CRoutine::Yield(RoutineState::DATA_WAIT);
+          wakeups++;
+        }
+      },
+      "racer");
+  uint64_t crid = std::hash<std::string>()("racer");
+  std::vector<std::thread> notifiers;
+  for (int i = 0; i < 4; ++i) {
+    notifiers.emplace_back([&]() {
+      for (int j = 0; j < 10000; ++j) {
+        sched.NotifyTask(crid);
+      }
+    });
+  }
+  for (auto& t : notifiers) {
+    t.join();
+  }
+  //多次通知可以合并，但不能比通知的次数多，也不能丢失最后一次通知
+  EXPECT_LE(wakeups, 40000);
+  int before = wakeups;
+  sched.NotifyTask(crid);
+  EXPECT_TRUE(WaitFor([&]() { return wakeups > before; }));
+  quit = true;
+  sched.NotifyTask(crid);
+  EXPECT_TRUE(WaitFor([&]() { return sched.TaskNum() == 0; }));
+}
+
+TEST(SchedulerClassic, MaybeYieldBoundsLatency) {
+  auto conf = SingleProcessorConf();
+  conf.groups[0].tasks[0].time_slice_us = 1000;
+  SchedulerClassic sched(conf);
+  std::atomic<bool> quit = {false};
+  std::atomic<int> demoted_prio = {-1};
+  //计算型协程从不主动让出，只在循环里调用MaybeYield()
+  sched.CreateTask(
+      [&]() {
+        while (!quit) {
+          if (CRoutine::MaybeYield()) {
+            demoted_prio = CRoutine::GetCurrentRoutine()->priority();
+          }
+        }
+      },
+      "low");
+  std::atomic<int> rounds = {0};
+  std::atomic<int64_t> max_late_us = {0};
+  sched.CreateTask(
+      [&]() {
+        auto cr = CRoutine::GetCurrentRoutine();
+        for (int i = 0; i < 20; ++i) {
+          cr->Sleep(std::chrono::milliseconds(2));
+          auto late = std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - cr->wake_time())
+                          .count();
+          if (late > max_late_us) {
+            max_late_us = late;
+          }
+          rounds++;
+        }
+      },
+      "high");
+  EXPECT_TRUE(WaitFor([&]() { return rounds == 20; }));
+  //时间片为1ms，留出虚拟机调度抖动的余量
+  EXPECT_LT(max_late_us, 50000);
+  EXPECT_EQ(demoted_prio, 0);
+  quit = true;
+  EXPECT_TRUE(WaitFor([&]() { return sched.TaskNum() == 0; }));
+}
+
+TEST(SchedulerClassic, WatchdogPreemptsOverrun) {
+  auto conf = SingleProcessorConf();
+  conf.watchdog_threshold = std::chrono::milliseconds(5);
+  conf.watchdog_preempt = true;
+  SchedulerClassic sched(conf);
+  std::atomic<bool> preempted = {false};
+  sched.CreateTask(
+      [&]() {
+        //时间片足够长，只有看门狗的标记能让MaybeYield()让出
+        CRoutine::GetCurrentRoutine()->set_time_slice(std::chrono::seconds(60));
+        auto begin = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - begin <
+               std::chrono::seconds(5)) {
+          if (CRoutine::MaybeYield()) {
+            preempted = true;
+            break;
+          }
+        }
+      },
+      "hog");
+  EXPECT_TRUE(WaitFor([&]() { return sched.TaskNum() == 0; }));
+  EXPECT_TRUE(preempted);
+  EXPECT_GE(sched.OverrunCount(), 1u);
+}
+
+//只有watchdog_preempt时才安装SIGURG的处理函数，安装后其他来源的SIGURG仍然交给原来的处理函数
+TEST(SchedulerClassic, WatchdogSignalIsOptInAndChained) {
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = &CountSigurg;
+  sigemptyset(&sa.sa_mask);
+  ASSERT_EQ(sigaction(SIGURG, &sa, nullptr), 0);
+
+  struct sigaction current;
+  auto conf = SingleProcessorConf();
+  conf.watchdog_threshold = std::chrono::milliseconds(5);
+  {
+    SchedulerClassic sched(conf);
+    ASSERT_EQ(sigaction(SIGURG, nullptr, &current), 0);
+    EXPECT_FALSE(current.sa_flags & SA_SIGINFO);
+    EXPECT_EQ(current.sa_handler, &CountSigurg);
+  }
+
+  conf.watchdog_preempt = true;
+  SchedulerClassic sched(conf);
+  ASSERT_EQ(sigaction(SIGURG, nullptr, &current), 0);
+  EXPECT_TRUE(current.sa_flags & SA_SIGINFO);
+  user_sigurg = 0;
+  kill(getpid(), SIGURG);
+  EXPECT_TRUE(WaitFor([]() { return user_sigurg == 1; }));
+}
@@ -0,0 +1,139 @@
+#include "shard_context.h"
+
+#include <thread>
+#include <utility>
+
+thread_local ShardContext* ShardContext::current_ = nullptr;
+constexpr std::chrono::microseconds ShardContext::kMailboxFullRetry;
+
+ShardContext::ShardContext(Scheduler* scheduler, int core, uint32_t poll_batch)
+    : ChoreographyContext(scheduler, core),
+      owner_(scheduler),
+      core_(core),
+      poll_batch_(poll_batch > 0 ? poll_batch : 1) {
+  external_.Init();
+}
+
+void ShardContext::Connect(std::vector<ShardMailbox*> inbound,
+                           std::vector<ShardMailbox*> outbound,
+                           std::vector<ShardContext*> peers) {
+  inbound_ = std::move(inbound);
+  outbound_ = std::move(outbound);
+  peers_ = std::move(peers);
+  staged_.resize(peers_.size());
+}
+
+CRoutine* ShardContext::NextRoutine() {
+  current_ = this;
+  if (cyber_unlikely(stop_.load(std::memory_order_relaxed))) {
+    return nullptr;
+  }
+  Poll();
+  return ChoreographyContext::NextRoutine();
+}
+
+void ShardContext::Wait() {
+  //协程中发出的任务在协程让出之后才写入邮箱
+  Flush();
+  if (HasStaged()) {
+    //目标核的邮箱满了，它取走邮件时不会通知发送方，只能定时重试
+    std::this_thread::sleep_for(kMailboxFullRetry);
+    return;
+  }
+  ChoreographyContext::Wait();
+}
+
+void ShardContext::Send(int core, ShardTask task) {
+  if (core == core_) {
+    local_.emplace_back(std::move(task));
+  } else {
+    staged_[core].emplace_back(std::move(task));
+  }
+}
+
+void ShardContext::PostExternal(ShardTask task) {
+  external_.Enqueue(std::move(task));
+  //先计数再检查Parked()，与Wait()中先声明parked_再检查HasPendingWork()配合，不会丢失唤醒。
+  //Parked()是relaxed读，seq_cst的fetch_add不能阻止它在ARM上提前，和Flush()一样需要一次全屏障
+  external_num_.fetch_add(1, std::memory_order_seq_cst);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (Parked()) {
+    Notify();
+  }
+}
+
+void ShardContext::Poll() {
+  for (size_t i = 0; i < inbound_.size(); ++i) {
+    if (inbound_[i] != nullptr) {
+      inbound_[i]->DequeueBatch(poll_batch_, [](ShardTask& task) { task(); });
+    }
+  }
+
+  uint64_t external_num = external_num_.load(std::memory_order_acquire);
+  if (external_num > 0) {
+    uint64_t num = 0;
+    ShardTask task;
+    while (num < poll_batch_ && num < external_num && external_.Dequeue(&task)) {
+      ++num;
+      task();
+    }
+    external_num_.fetch_sub(num, std::memory_order_relaxed);
+  }
+
+  if (!local_.empty()) {
+    //任务中可能再发给自己，先交换出来
+    running_local_.swap(local_);
+    for (auto& task : running_local_) {
+      task();
+    }
+    running_local_.clear();
+  }
+
+  Flush();
+}
+
+//把发送缓冲中的任务写入各个目标核的邮箱，每个目标核只检查一次是否需要唤醒
+void ShardContext::Flush() {
+  for (size_t core = 0; core < staged_.size(); ++core) {
+    auto& staged = staged_[core];
+    if (staged.empty()) {
+      continue;
+    }
+    size_t sent = 0;
+    while (sent < staged.size() &&
+           outbound_[core]->Enqueue(std::move(staged[sent]))) {
+      ++sent;
+    }
+    staged.erase(staged.begin(), staged.begin() + sent);
+    if (sent == 0) {
+      continue;
+    }
+    //邮箱的tail_是release store，和目标核Wait()中parked_的seq_cst store之间需要一次全屏障
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (peers_[core]->Parked()) {
+      peers_[core]->Notify();
+    }
+  }
+}
+
+bool ShardContext::HasStaged() const {
+  for (auto& staged : staged_) {
+    if (!staged.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ShardContext::HasPendingWork() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!local_.empty() || external_num_.load(std::memory_order_relaxed) > 0) {
+    return true;
+  }
+  for (auto mailbox : inbound_) {
+    if (mailbox != nullptr && !mailbox->Empty()) {
+      return true;
+    }
+  }
+  return false;
+}
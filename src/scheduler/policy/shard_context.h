@@ -0,0 +1,79 @@
+#ifndef CYBER_SCHEDULER_POLICY_SHARD_CONTEXT_H_
+#define CYBER_SCHEDULER_POLICY_SHARD_CONTEXT_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "../../spsc_queue.h"
+#include "../../unbounded_queue.h"
+#include "choreography_context.h"
+
+using ShardTask = std::function<void()>;
+using ShardMailbox = SpscQueue<ShardTask>;
+
+//ShardedExecutor中一个核的上下文：在ChoreographyContext（处理器私有、不加锁的协程就绪队列）之上
+//增加核与核之间的邮箱。每一对核(i, j)之间有一个SPSC环形队列，只由核i写、核j读：
+//- Send()只把任务放进本核的发送缓冲，每轮轮询结束时才批量写入目标核的邮箱，
+//  每个目标核最多唤醒一次；邮箱满时留在缓冲里，下一轮再发；
+//- NextRoutine()先按批处理所有收到的邮件，再选取本核的协程，任务在处理器线程上直接运行，
+//  不创建协程，不能阻塞，也不能抛出异常；
+//- 不在任何核上的线程提交的任务放入无界的外部队列（多生产者）。
+class ShardContext : public ChoreographyContext {
+ public:
+  ShardContext(Scheduler* scheduler, int core, uint32_t poll_batch);
+
+  //所有核的上下文都创建之后调用：inbound[i]是核i发给本核的邮箱，outbound[j]是本核发给核j的邮箱，
+  //peers[j]是核j的上下文，下标为自身的位置不使用
+  void Connect(std::vector<ShardMailbox*> inbound,
+               std::vector<ShardMailbox*> outbound,
+               std::vector<ShardContext*> peers);
+
+  CRoutine* NextRoutine() override;
+  void Wait() override;
+
+  //只能在本核的线程上调用
+  void Send(int core, ShardTask task);
+  //可以在任意线程调用
+  void PostExternal(ShardTask task);
+
+  int core() const { return core_; }
+  //所属的执行器
+  const Scheduler* owner() const { return owner_; }
+  //当前线程所在的核，不在任何核上时返回nullptr
+  static ShardContext* Current() { return current_; }
+
+ protected:
+  bool HasPendingWork() override;
+
+ private:
+  void Poll();
+  void Flush();
+  bool HasStaged() const;
+
+  //目标核的邮箱满时，每隔这么久重试一次
+  static constexpr std::chrono::microseconds kMailboxFullRetry{50};
+
+  const Scheduler* owner_ = nullptr;
+  int core_ = -1;
+  uint32_t poll_batch_ = 0;
+
+  std::vector<ShardMailbox*> inbound_;
+  std::vector<ShardMailbox*> outbound_;
+  std::vector<ShardContext*> peers_;
+  //发往各个核、还没有写入邮箱的任务，只在本核线程中访问
+  std::vector<std::deque<ShardTask>> staged_;
+  //发给自己的任务
+  std::vector<ShardTask> local_;
+  std::vector<ShardTask> running_local_;
+  UnboundedQueue<ShardTask> external_;
+  //外部队列中的任务个数，轮询时先检查它，外部队列为空时不访问队列
+  std::atomic<uint64_t> external_num_ = {0};
+
+  static thread_local ShardContext* current_;
+};
+
+#endif  // CYBER_SCHEDULER_POLICY_SHARD_CONTEXT_H_
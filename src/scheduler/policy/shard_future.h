@@ -0,0 +1,141 @@
+#ifndef CYBER_SCHEDULER_POLICY_SHARD_FUTURE_H_
+#define CYBER_SCHEDULER_POLICY_SHARD_FUTURE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+//返回void的任务的结果类型
+struct ShardVoid {};
+
+template <typename T>
+struct ShardValue {
+  using type = T;
+};
+template <>
+struct ShardValue<void> {
+  using type = ShardVoid;
+};
+
+template <typename F>
+using ShardResultOf =
+    typename ShardValue<typename std::result_of<F()>::type>::type;
+
+template <typename F>
+typename std::enable_if<!std::is_void<typename std::result_of<F()>::type>::value,
+                        ShardResultOf<F>>::type
+InvokeShardTask(F& f) {
+  return f();
+}
+
+template <typename F>
+typename std::enable_if<std::is_void<typename std::result_of<F()>::type>::value,
+                        ShardVoid>::type
+InvokeShardTask(F& f) {
+  f();
+  return ShardVoid();
+}
+
+//SubmitTo()的结果。结果由一个线程写入一次，回调由一个线程设置一次，
+//两者通过flags_上的一次fetch_or交接：后到的一方负责调用回调，不需要锁。
+template <typename T>
+class ShardState {
+ public:
+  explicit ShardState(std::shared_ptr<const std::atomic<bool>> stopped)
+      : stopped_(std::move(stopped)) {}
+
+  void Complete(T value) {
+    value_ = std::move(value);
+    if (flags_.fetch_or(kReady, std::memory_order_acq_rel) & kCallback) {
+      callback_(value_);
+    }
+  }
+
+  void SetCallback(std::function<void(const T&)> callback) {
+    callback_ = std::move(callback);
+    if (flags_.fetch_or(kCallback, std::memory_order_acq_rel) & kReady) {
+      callback_(value_);
+    }
+  }
+
+  bool Ready() const {
+    return flags_.load(std::memory_order_acquire) & kReady;
+  }
+  //执行器已经析构，还没有完成的任务不会再执行
+  bool Stopped() const { return stopped_->load(std::memory_order_acquire); }
+  //Ready()之后才能读取
+  const T& value() const { return value_; }
+
+ private:
+  static constexpr uint32_t kReady = 1;
+  static constexpr uint32_t kCallback = 2;
+
+  std::atomic<uint32_t> flags_ = {0};
+  T value_;
+  std::function<void(const T&)> callback_;
+  std::shared_ptr<const std::atomic<bool>> stopped_;
+};
+
+//ShardedExecutor::SubmitTo()返回的句柄，类似std::future，返回void的任务对应ShardFuture<ShardVoid>。
+//- 在核线程上发起的请求，结果经反向邮箱送回发起的核，在那里写入结果、调用回调，
+//  所以核线程上应当用Then()串联后续处理，不能用Get()阻塞（阻塞的核收不到自己的邮箱）；
+//- 在其他线程上发起的请求，目标核执行完直接写入结果，用Get()等待。
+template <typename T>
+class ShardFuture {
+ public:
+  ShardFuture() {}
+  explicit ShardFuture(std::shared_ptr<ShardState<T>> state)
+      : state_(std::move(state)) {}
+
+  //执行器已经停止或者核编号越界时返回的future是无效的
+  bool Valid() const { return state_ != nullptr; }
+  bool Ready() const { return state_ != nullptr && state_->Ready(); }
+
+  //等待结果，value可以为nullptr。执行器析构时任务还没有完成，返回false。
+  //先让出CPU重试，之后以50us为间隔睡眠，只能在核线程以外调用
+  bool Get(T* value) {
+    if (state_ == nullptr) {
+      return false;
+    }
+    uint32_t retry_times = 0;
+    while (!state_->Ready()) {
+      if (state_->Stopped()) {
+        //停止前刚好完成的任务仍然返回结果
+        if (!state_->Ready()) {
+          return false;
+        }
+        break;
+      }
+      if (++retry_times < kMaxYieldTimes) {
+        std::this_thread::yield();
+      } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+      }
+    }
+    if (value != nullptr) {
+      *value = state_->value();
+    }
+    return true;
+  }
+
+  //结果就绪后调用f(const T&)，每个future只能设置一次。
+  //已经就绪时在当前线程立即调用，否则由写入结果的线程调用
+  template <typename F>
+  void Then(F&& f) {
+    if (state_ != nullptr) {
+      state_->SetCallback(std::forward<F>(f));
+    }
+  }
+
+ private:
+  static constexpr uint32_t kMaxYieldTimes = 64;
+
+  std::shared_ptr<ShardState<T>> state_;
+};
+
+#endif  // CYBER_SCHEDULER_POLICY_SHARD_FUTURE_H_
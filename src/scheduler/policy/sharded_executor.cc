@@ -0,0 +1,99 @@
+#include "sharded_executor.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "../../common/log.h"
+#include "../common/pin_thread.h"
+
+ShardedExecutor::ShardedExecutor(const ShardedExecutorConf& conf)
+    : conf_(conf), stopped_(std::make_shared<std::atomic<bool>>(false)) {
+  if (conf_.core_num == 0) {
+    conf_.core_num = std::max(1u, std::thread::hardware_concurrency());
+  }
+  uint32_t core_num = conf_.core_num;
+
+  for (uint32_t i = 0; i < core_num; ++i) {
+    auto ctx = std::make_shared<ShardContext>(this, static_cast<int>(i),
+                                              conf_.poll_batch);
+    shards_.emplace_back(ctx.get());
+    pctxs_.emplace_back(ctx);
+  }
+
+  mailboxes_.resize(core_num * core_num);
+  for (uint32_t from = 0; from < core_num; ++from) {
+    for (uint32_t to = 0; to < core_num; ++to) {
+      if (from == to) {
+        continue;
+      }
+      auto& mailbox = mailboxes_[from * core_num + to];
+      mailbox.reset(new ShardMailbox());
+      if (!mailbox->Init(conf_.mailbox_size)) {
+        AERROR << "mailbox init failed, size: " << conf_.mailbox_size;
+      }
+    }
+  }
+  for (uint32_t core = 0; core < core_num; ++core) {
+    std::vector<ShardMailbox*> inbound(core_num, nullptr);
+    std::vector<ShardMailbox*> outbound(core_num, nullptr);
+    for (uint32_t peer = 0; peer < core_num; ++peer) {
+      inbound[peer] = mailboxes_[peer * core_num + core].get();
+      outbound[peer] = mailboxes_[core * core_num + peer].get();
+    }
+    shards_[core]->Connect(std::move(inbound), std::move(outbound), shards_);
+  }
+
+  //所有邮箱连接完成后再启动线程
+  std::vector<int> cpuset;
+  ParseCpuset(conf_.cpuset, &cpuset);
+  for (uint32_t i = 0; i < core_num; ++i) {
+    auto proc = std::make_shared<Processor>();
+    proc->BindContext(pctxs_[i]);
+    SetSchedAffinity(proc->Thread(), cpuset, "1to1", i);
+    SetSchedPolicy(proc->Thread(), conf_.policy, conf_.prio);
+    processors_.emplace_back(proc);
+  }
+}
+
+ShardedExecutor::~ShardedExecutor() {
+  stopped_->store(true, std::memory_order_release);
+  Shutdown();
+}
+
+int ShardedExecutor::CurrentCore() const {
+  ShardContext* shard = CurrentShard();
+  return shard == nullptr ? -1 : shard->core();
+}
+
+bool ShardedExecutor::DispatchTask(const std::shared_ptr<CRoutine>& cr) {
+  if (!id_cr_.Insert(cr->id(), cr)) {
+    return false;
+  }
+
+  if (cr->priority() >= MAX_PRIO) {
+    AWARN << cr->name() << " prio is greater than MAX_PRIO[ " << MAX_PRIO
+          << " ].";
+    cr->set_priority(MAX_PRIO - 1);
+  }
+
+  int pid = cr->processor_id();
+  if (pid < 0 || static_cast<size_t>(pid) >= shards_.size()) {
+    uint32_t index = next_core_.fetch_add(1, std::memory_order_relaxed);
+    pid = static_cast<int>(index % shards_.size());
+    cr->set_processor_id(pid);
+  }
+  shards_[pid]->Enqueue(cr.get());
+  return true;
+}
+
+bool ShardedExecutor::NotifyProcessor(uint64_t crid) {
+  auto cr = GetRoutine(crid);
+  if (cr == nullptr) {
+    return false;
+  }
+  int pid = cr->processor_id();
+  if (pid >= 0 && static_cast<size_t>(pid) < shards_.size()) {
+    shards_[pid]->Wakeup(cr.get());
+  }
+  return true;
+}
@@ -0,0 +1,99 @@
+#ifndef CYBER_SCHEDULER_POLICY_SHARDED_EXECUTOR_H_
+#define CYBER_SCHEDULER_POLICY_SHARDED_EXECUTOR_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../scheduler.h"
+#include "shard_context.h"
+#include "shard_future.h"
+
+struct ShardedExecutorConf {
+  //核（处理器线程）的个数，0表示取硬件线程数
+  uint32_t core_num = 0;
+  //形如"0-7"，第i个核绑定到cpuset中的第i个cpu上，为空时不设置亲和性
+  std::string cpuset;
+  //"SCHED_OTHER"、"SCHED_RR"或"SCHED_FIFO"，没有权限时保持SCHED_OTHER
+  std::string policy = "SCHED_OTHER";
+  int prio = 0;
+  //每对核之间邮箱的容量
+  uint64_t mailbox_size = 1024;
+  //每轮轮询从每个邮箱最多取出的任务数
+  uint32_t poll_batch = 64;
+};
+
+//thread-per-core的执行器：每个核一个绑定的处理器线程，拥有自己的协程和任务，核之间不共享数据，
+//只通过核i→核j的SPSC邮箱矩阵通信（见ShardContext）。
+//- SubmitTo(core, fn)把fn交给指定的核执行，返回ShardFuture。在核上发起时，
+//  请求经邮箱[self][core]送达，结果经反向邮箱[core][self]送回发起的核；
+//- 协程通过CreateTask/DispatchTask放到processor_id()指定的核上（越界时轮询分配），
+//  之后一直在这个核上运行，和这个核上的任务交替执行。
+class ShardedExecutor : public Scheduler {
+ public:
+  explicit ShardedExecutor(const ShardedExecutorConf& conf = ShardedExecutorConf());
+  ~ShardedExecutor() override;
+
+  bool DispatchTask(const std::shared_ptr<CRoutine>& cr) override;
+
+  //fn在目标核的处理器线程上直接执行，不能阻塞，也不能抛出异常。
+  //core越界或者执行器已经停止时返回无效的future
+  template <typename F>
+  auto SubmitTo(uint32_t core, F&& f) -> ShardFuture<ShardResultOf<F>>;
+
+  uint32_t CoreNum() const { return static_cast<uint32_t>(shards_.size()); }
+  //当前线程所在的本执行器的核，不在本执行器的核上时返回-1
+  int CurrentCore() const;
+
+ private:
+  bool NotifyProcessor(uint64_t crid) override;
+  ShardContext* CurrentShard() const;
+
+  ShardedExecutorConf conf_;
+  std::vector<ShardContext*> shards_;
+  //mailboxes_[from * core_num + to]，对角线上为空
+  std::vector<std::unique_ptr<ShardMailbox>> mailboxes_;
+  std::atomic<uint32_t> next_core_ = {0};
+  //ShardFuture::Get()据此判断不会再有结果
+  std::shared_ptr<std::atomic<bool>> stopped_;
+};
+
+inline ShardContext* ShardedExecutor::CurrentShard() const {
+  ShardContext* shard = ShardContext::Current();
+  return shard != nullptr && shard->owner() == this ? shard : nullptr;
+}
+
+template <typename F>
+auto ShardedExecutor::SubmitTo(uint32_t core, F&& f)
+    -> ShardFuture<ShardResultOf<F>> {
+  using R = ShardResultOf<F>;
+  if (core >= shards_.size() || stop_.load(std::memory_order_relaxed)) {
+    return ShardFuture<R>();
+  }
+  auto state = std::make_shared<ShardState<R>>(stopped_);
+  ShardFuture<R> future(state);
+  typename std::decay<F>::type func(std::forward<F>(f));
+
+  ShardContext* origin = CurrentShard();
+  if (origin == nullptr) {
+    //外部线程没有邮箱，由目标核执行完直接写入结果
+    shards_[core]->PostExternal([state, func]() mutable {
+      state->Complete(InvokeShardTask(func));
+    });
+    return future;
+  }
+
+  int from = origin->core();
+  ShardContext* target = shards_[core];
+  origin->Send(core, [state, func, from, target]() mutable {
+    R result = InvokeShardTask(func);
+    target->Send(from, [state, result]() mutable {
+      state->Complete(std::move(result));
+    });
+  });
+  return future;
+}
+
+#endif  // CYBER_SCHEDULER_POLICY_SHARDED_EXECUTOR_H_
@@ -0,0 +1,153 @@
+//核与核之间请求/应答的吞吐量：ShardedExecutor vs 共享队列的ThreadPool。
+//每个请求是一个很小的计算（返回参数加1），每个发起方同时保持window个未完成的请求。
+//- sharded：core_num个核，每个核轮流向其他核发请求，应答经反向邮箱回到本核，在回调里发下一个；
+//- sharded-external：core_num个外部线程通过SubmitTo()+Get()向各个核发请求；
+//- thread_pool：core_num个工作线程共享一个BoundedQueue，core_num个外部线程Enqueue()+get()。
+//用法：sharded_executor_benchmark [core_num] [requests_per_core] [window]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../thread_pool.h"
+#include "sharded_executor.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void Report(const std::string& name, uint64_t requests, Clock::duration cost) {
+  double seconds = std::chrono::duration<double>(cost).count();
+  std::cout << name << ": " << requests << " requests, " << seconds
+            << " s, " << requests / seconds / 1e6 << " M req/s" << std::endl;
+}
+
+//每个核上的发起方，只在自己的核上访问
+struct Client {
+  uint32_t core = 0;
+  int sent = 0;
+  int received = 0;
+};
+
+void SendNext(ShardedExecutor* executor, Client* client, int requests,
+              std::atomic<uint32_t>* finished) {
+  uint32_t core_num = executor->CoreNum();
+  int i = client->sent++;
+  uint32_t target =
+      (client->core + 1 + i % (core_num - 1)) % core_num;
+  executor->SubmitTo(target, [i]() { return i + 1; })
+      .Then([executor, client, requests, finished](const int&) {
+        if (++client->received == requests) {
+          finished->fetch_add(1);
+        } else if (client->sent < requests) {
+          SendNext(executor, client, requests, finished);
+        }
+      });
+}
+
+void RunSharded(uint32_t core_num, int requests, int window) {
+  ShardedExecutorConf conf;
+  conf.core_num = core_num;
+  ShardedExecutor executor(conf);
+  std::vector<Client> clients(core_num);
+  std::atomic<uint32_t> finished = {0};
+  auto begin = Clock::now();
+  for (uint32_t core = 0; core < core_num; ++core) {
+    clients[core].core = core;
+    Client* client = &clients[core];
+    executor.SubmitTo(core, [&executor, client, requests, window, &finished]() {
+      for (int i = 0; i < window && client->sent < requests; ++i) {
+        SendNext(&executor, client, requests, &finished);
+      }
+    });
+  }
+  while (finished.load() < core_num) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  Report("sharded", static_cast<uint64_t>(core_num) * requests,
+         Clock::now() - begin);
+}
+
+template <typename Future, typename Submit>
+void RunClient(int requests, int window, Submit submit) {
+  std::deque<Future> pending;
+  for (int i = 0; i < requests; ++i) {
+    if (static_cast<int>(pending.size()) == window) {
+      pending.front().get();
+      pending.pop_front();
+    }
+    pending.push_back(submit(i));
+  }
+  while (!pending.empty()) {
+    pending.front().get();
+    pending.pop_front();
+  }
+}
+
+//ShardFuture::Get()的参数是输出指针，包装成std::future的用法
+struct ExternalFuture {
+  ShardFuture<int> future;
+  void get() {
+    int value = 0;
+    future.Get(&value);
+  }
+};
+
+void RunShardedExternal(uint32_t core_num, int requests, int window) {
+  ShardedExecutorConf conf;
+  conf.core_num = core_num;
+  ShardedExecutor executor(conf);
+  auto begin = Clock::now();
+  std::vector<std::thread> clients;
+  for (uint32_t c = 0; c < core_num; ++c) {
+    clients.emplace_back([&executor, core_num, requests, window, c]() {
+      RunClient<ExternalFuture>(requests, window, [&](int i) {
+        uint32_t target = (c + i) % core_num;
+        return ExternalFuture{executor.SubmitTo(target, [i]() { return i + 1; })};
+      });
+    });
+  }
+  for (auto& t : clients) {
+    t.join();
+  }
+  Report("sharded-external", static_cast<uint64_t>(core_num) * requests,
+         Clock::now() - begin);
+}
+
+void RunThreadPool(uint32_t core_num, int requests, int window) {
+  ThreadPool pool(core_num, 65536);
+  auto begin = Clock::now();
+  std::vector<std::thread> clients;
+  for (uint32_t c = 0; c < core_num; ++c) {
+    clients.emplace_back([&pool, requests, window]() {
+      RunClient<std::future<int>>(requests, window, [&](int i) {
+        return pool.Enqueue([i]() { return i + 1; });
+      });
+    });
+  }
+  for (auto& t : clients) {
+    t.join();
+  }
+  Report("thread_pool", static_cast<uint64_t>(core_num) * requests,
+         Clock::now() - begin);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  uint32_t core_num = argc > 1 ? std::atoi(argv[1]) : 4;
+  int requests = argc > 2 ? std::atoi(argv[2]) : 20000;
+  int window = argc > 3 ? std::atoi(argv[3]) : 64;
+  core_num = std::max(2u, core_num);
+  std::cout << "cores: " << core_num << " requests per core: " << requests
+            << " window: " << window << std::endl;
+  RunSharded(core_num, requests, window);
+  RunShardedExternal(core_num, requests, window);
+  RunThreadPool(core_num, requests, window);
+  return 0;
+}
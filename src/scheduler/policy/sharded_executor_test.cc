@@ -0,0 +1,143 @@
+#include "sharded_executor.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "../../test_util.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+ShardedExecutorConf Conf(uint32_t core_num, uint64_t mailbox_size = 1024) {
+  ShardedExecutorConf conf;
+  conf.core_num = core_num;
+  conf.mailbox_size = mailbox_size;
+  return conf;
+}
+
+}  // namespace
+
+TEST(ShardedExecutor, SubmitFromExternalThread) {
+  ShardedExecutor executor(Conf(3));
+  EXPECT_EQ(executor.CoreNum(), 3u);
+  EXPECT_EQ(executor.CurrentCore(), -1);
+  for (uint32_t core = 0; core < 3; ++core) {
+    auto future = executor.SubmitTo(core, [&executor]() {
+      return executor.CurrentCore();
+    });
+    ASSERT_TRUE(future.Valid());
+    int value = -1;
+    EXPECT_TRUE(future.Get(&value));
+    EXPECT_EQ(value, static_cast<int>(core));
+  }
+  std::atomic<bool> ran = {false};
+  auto done = executor.SubmitTo(1, [&ran]() { ran = true; });
+  EXPECT_TRUE(done.Get(nullptr));
+  EXPECT_TRUE(ran);
+  EXPECT_FALSE(executor.SubmitTo(3, []() { return 0; }).Valid());
+}
+
+//核0向核1发请求，结果经反向邮箱回到核0，回调在核0上执行
+TEST(ShardedExecutor, ResponseReturnsToOrigin) {
+  ShardedExecutor executor(Conf(2));
+  std::atomic<int> served_on = {-1};
+  std::atomic<int> callback_on = {-1};
+  std::atomic<int> result = {0};
+  executor.SubmitTo(0, [&]() {
+    executor
+        .SubmitTo(1,
+                  [&]() {
+                    served_on = executor.CurrentCore();
+                    return 42;
+                  })
+        .Then([&](const int& value) {
+          callback_on = executor.CurrentCore();
+          result = value;
+        });
+  });
+  EXPECT_TRUE(WaitFor([&]() { return result == 42; }));
+  EXPECT_EQ(served_on, 1);
+  EXPECT_EQ(callback_on, 0);
+}
+
+//邮箱只有4个槽位，每个核一次发出很多请求，多出来的留在发送缓冲里陆续发出
+TEST(ShardedExecutor, AllToAllWithSmallMailboxes) {
+  constexpr uint32_t kCores = 4;
+  constexpr int kRequests = 5000;
+  ShardedExecutor executor(Conf(kCores, 4));
+  std::atomic<int> responses = {0};
+  std::atomic<int> errors = {0};
+  for (uint32_t core = 0; core < kCores; ++core) {
+    executor.SubmitTo(core, [&, core]() {
+      for (int i = 0; i < kRequests; ++i) {
+        uint32_t target = (core + 1 + i % (kCores - 1)) % kCores;
+        executor.SubmitTo(target, [i]() { return i * 2; })
+            .Then([&, i, core](const int& value) {
+              if (value != i * 2 ||
+                  executor.CurrentCore() != static_cast<int>(core)) {
+                errors++;
+              }
+              responses++;
+            });
+      }
+    });
+  }
+  EXPECT_TRUE(WaitFor([&]() { return responses == kCores * kRequests; }));
+  EXPECT_EQ(errors, 0);
+}
+
+TEST(ShardedExecutor, RoutinesStayOnTheirCore) {
+  ShardedExecutor executor(Conf(2));
+  std::atomic<int> wrong_core = {0};
+  std::atomic<int> rounds = {0};
+  auto cr = CRoutine::Create([&]() {
+    for (int i = 0; i < 5; ++i) {
+      if (executor.CurrentCore() != 1) {
+        wrong_core++;
+      }
+      rounds++;
+      CRoutine::Yield(RoutineState::DATA_WAIT);
+    }
+  });
+  cr->set_id(100);
+  cr->set_name("pinned");
+  cr->set_processor_id(1);
+  ASSERT_TRUE(executor.DispatchTask(cr));
+  for (int i = 1; i < 5; ++i) {
+    ASSERT_TRUE(WaitFor([&]() { return rounds == i; }));
+    executor.NotifyTask(100);
+  }
+  EXPECT_TRUE(WaitFor([&]() { return rounds == 5; }));
+  executor.NotifyTask(100);
+  EXPECT_TRUE(WaitFor([&]() { return executor.TaskNum() == 0; }));
+  EXPECT_EQ(wrong_core, 0);
+}
+
+//析构时还没有执行的任务被丢弃，等待它的Get()返回false而不是一直阻塞
+TEST(ShardedExecutor, PendingFutureFailsAfterDestruction) {
+  ShardFuture<int> dropped;
+  std::atomic<bool> started = {false};
+  std::atomic<bool> release = {false};
+  std::thread releaser;
+  {
+    ShardedExecutor executor(Conf(1));
+    executor.SubmitTo(0, [&]() {
+      started = true;
+      while (!release) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+    ASSERT_TRUE(WaitFor([&]() { return started.load(); }));
+    dropped = executor.SubmitTo(0, []() { return 1; });
+    //析构函数停止处理器之后才放行第一个任务，第二个任务不会再执行
+    releaser = std::thread([&release]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      release = true;
+    });
+  }
+  releaser.join();
+  EXPECT_TRUE(dropped.Valid());
+  EXPECT_FALSE(dropped.Get(nullptr));
+}
@@ -0,0 +1,93 @@
+//大量协程周期性Sleep时的唤醒精度和调度器CPU占用。
+//每个协程循环Sleep随机的1~2秒，记录实际被唤醒的时间相对wake_time的延迟；
+//调度器只有一个处理器，统计预热之后整个进程的CPU时间占墙上时间的比例。
+//用法：sleep_benchmark [routine_num] [seconds]
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "scheduler_classic.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::mutex latency_mutex;
+std::vector<int64_t> latencies_us;
+std::atomic<bool> recording = {false};
+
+double ProcessCpuSeconds() {
+  timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void SleepLoop(uint64_t seed) {
+  std::minstd_rand rng(static_cast<uint32_t>(seed) + 1);
+  for (;;) {
+    auto cr = CRoutine::GetCurrentRoutine();
+    cr->Sleep(std::chrono::microseconds(1000000 + rng() % 1000000));
+    auto late = Clock::now() - cr->wake_time();
+    if (recording) {
+      std::lock_guard<std::mutex> lk(latency_mutex);
+      latencies_us.push_back(
+          std::chrono::duration_cast<std::chrono::microseconds>(late).count());
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int routine_num = argc > 1 ? std::atoi(argv[1]) : 100000;
+  int seconds = argc > 2 ? std::atoi(argv[2]) : 10;
+
+  ClassicGroupConf group;
+  group.name = "sleep";
+  group.processor_num = 1;
+  ClassicConf conf;
+  conf.groups.push_back(group);
+  SchedulerClassic sched(conf);
+  for (int i = 0; i < routine_num; ++i) {
+    sched.CreateTask([i]() { SleepLoop(i); }, "sleep" + std::to_string(i));
+  }
+
+  //等所有协程都进入第一次Sleep之后再开始统计
+  std::this_thread::sleep_for(std::chrono::seconds(3));
+  recording = true;
+  double cpu_begin = ProcessCpuSeconds();
+  auto wall_begin = Clock::now();
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+  double cpu = ProcessCpuSeconds() - cpu_begin;
+  double wall =
+      std::chrono::duration<double>(Clock::now() - wall_begin).count();
+  recording = false;
+
+  std::vector<int64_t> samples;
+  {
+    std::lock_guard<std::mutex> lk(latency_mutex);
+    samples.swap(latencies_us);
+  }
+  std::sort(samples.begin(), samples.end());
+  auto percentile = [&samples](double p) {
+    return samples.empty() ? 0
+                           : samples[static_cast<size_t>(p * (samples.size() - 1))];
+  };
+  std::cout << "routines: " << routine_num << " wakeups: " << samples.size()
+            << std::endl;
+  std::cout << "wake latency us p50: " << percentile(0.5)
+            << " p99: " << percentile(0.99) << " max: " << percentile(1.0)
+            << std::endl;
+  std::cout << "cpu usage: " << cpu / wall * 100 << "%" << std::endl;
+  sched.Shutdown();
+  return 0;
+}
@@ -0,0 +1,131 @@
+//多个外部线程跨线程唤醒协程的吞吐量和延迟。
+//routine_num个协程都在一个处理器上以DATA_WAIT挂起，producer_num个线程各自负责其中一部分协程，
+//不停地通过ProcessorContext::Wakeup()唤醒已经挂起的协程并记录唤醒时间（和DataNotifier的用法一致），
+//协程被调度后计算延迟并再次挂起。
+//用法：wakeup_benchmark [producer_num=4] [routine_num=256] [seconds=3]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "scheduler_classic.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Clock::now().time_since_epoch())
+      .count();
+}
+
+struct Slot {
+  std::atomic<CRoutine*> cr = {nullptr};
+  std::atomic<ProcessorContext*> ctx = {nullptr};
+  //0表示协程已经处理完上一次唤醒，可以再次唤醒
+  std::atomic<int64_t> wake_ns = {0};
+};
+
+std::atomic<bool> quit = {false};
+std::atomic<uint64_t> wakeups = {0};
+std::mutex latency_mutex;
+std::vector<int64_t> latencies_ns;
+
+void Waiter(Slot* slot) {
+  std::vector<int64_t> local;
+  slot->ctx = ProcessorContext::Current();
+  slot->cr = CRoutine::GetCurrentRoutine();
+  while (!quit) {
+    CRoutine::Yield(RoutineState::DATA_WAIT);
+    int64_t wake_ns = slot->wake_ns.load(std::memory_order_acquire);
+    if (wake_ns == 0) {
+      continue;
+    }
+    //每个协程只采样一部分，避免记录本身影响结果
+    if (local.size() < 4096) {
+      local.push_back(NowNs() - wake_ns);
+    }
+    wakeups.fetch_add(1, std::memory_order_relaxed);
+    slot->wake_ns.store(0, std::memory_order_release);
+  }
+  std::lock_guard<std::mutex> lk(latency_mutex);
+  latencies_ns.insert(latencies_ns.end(), local.begin(), local.end());
+}
+
+void Producer(Slot* slots, int begin, int end) {
+  while (!quit) {
+    for (int i = begin; i < end; ++i) {
+      CRoutine* cr = slots[i].cr.load(std::memory_order_acquire);
+      if (cr == nullptr ||
+          slots[i].wake_ns.load(std::memory_order_acquire) != 0) {
+        continue;
+      }
+      slots[i].wake_ns.store(NowNs(), std::memory_order_release);
+      slots[i].ctx.load()->Wakeup(cr);
+    }
+    //单核机器上让出CPU，避免生产者把处理器线程饿死
+    std::this_thread::yield();
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int producer_num = argc > 1 ? std::atoi(argv[1]) : 4;
+  int routine_num = argc > 2 ? std::atoi(argv[2]) : 256;
+  int seconds = argc > 3 ? std::atoi(argv[3]) : 3;
+
+  ClassicGroupConf group;
+  group.name = "bench";
+  group.processor_num = 1;
+  ClassicConf conf;
+  conf.groups.push_back(group);
+  SchedulerClassic sched(conf);
+
+  std::unique_ptr<Slot[]> slots(new Slot[routine_num]);
+  for (int i = 0; i < routine_num; ++i) {
+    Slot* slot = &slots[i];
+    sched.CreateTask([slot]() { Waiter(slot); }, "waiter" + std::to_string(i));
+  }
+
+  std::vector<std::thread> producers;
+  int per_producer = (routine_num + producer_num - 1) / producer_num;
+  for (int p = 0; p < producer_num; ++p) {
+    int begin = std::min(routine_num, p * per_producer);
+    int end = std::min(routine_num, begin + per_producer);
+    producers.emplace_back(Producer, slots.get(), begin, end);
+  }
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+  quit = true;
+  for (auto& t : producers) {
+    t.join();
+  }
+  uint64_t total = wakeups.load();
+  //唤醒所有协程让它们看到quit退出
+  for (int i = 0; i < routine_num; ++i) {
+    if (slots[i].cr.load() != nullptr) {
+      slots[i].ctx.load()->Wakeup(slots[i].cr.load());
+    }
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  sched.Shutdown();
+
+  std::lock_guard<std::mutex> lk(latency_mutex);
+  std::sort(latencies_ns.begin(), latencies_ns.end());
+  auto pct = [](double p) {
+    return latencies_ns.empty()
+               ? 0
+               : latencies_ns[static_cast<size_t>(p * (latencies_ns.size() - 1))];
+  };
+  std::cout << "producers=" << producer_num << " routines=" << routine_num
+            << " wakeups/s=" << total / seconds << " p50_ns=" << pct(0.5)
+            << " p99_ns=" << pct(0.99) << " max_ns=" << pct(1.0) << std::endl;
+  return 0;
+}
@@ -0,0 +1,139 @@
+#include "processor.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../common/log.h"
+#include "../common/macros.h"
+
+thread_local ProcessorContext* ProcessorContext::current_ = nullptr;
+
+namespace {
+//信号处理函数通过它找到被打断的处理器
+thread_local Processor* current_processor = nullptr;
+//安装之前的处理函数，安装之后只在信号处理函数中读取
+struct sigaction previous_action;
+std::mutex install_mutex;
+
+//转交给原来的处理函数，默认动作和忽略都不需要处理（SIGURG的默认动作就是忽略）
+void ForwardSignal(int signo, siginfo_t* info, void* ucontext) {
+  if (previous_action.sa_flags & SA_SIGINFO) {
+    if (previous_action.sa_sigaction != nullptr) {
+      previous_action.sa_sigaction(signo, info, ucontext);
+    }
+  } else if (previous_action.sa_handler != SIG_DFL &&
+             previous_action.sa_handler != SIG_IGN) {
+    previous_action.sa_handler(signo);
+  }
+}
+}  // namespace
+
+constexpr int Processor::kPreemptSignal;
+
+Processor::~Processor() { Stop(); }
+
+void Processor::Run() {
+  ProcessorContext::SetCurrent(context_.get());
+  current_processor = this;
+  while (cyber_likely(running_.load())) {
+    if (cyber_likely(context_ != nullptr)) {
+      auto croutine = context_->NextRoutine();
+      if (croutine) {
+        uint64_t seq = resume_seq_.load(std::memory_order_relaxed);
+        resume_seq_.store(seq + 1, std::memory_order_relaxed);
+        croutine->Resume();
+        resume_seq_.store(seq + 2, std::memory_order_relaxed);
+        croutine->Release();
+        //Release之后再交还给上下文，保证协程被重新放入就绪队列时已经可以被其他处理器Acquire
+        context_->OnRoutineYield(croutine);
+      } else {
+        context_->Wait();
+      }
+    } else {
+      std::unique_lock<std::mutex> lk(mtx_ctx_);
+      cv_ctx_.wait_for(lk, std::chrono::milliseconds(10));
+    }
+  }
+}
+
+void Processor::Stop() {
+  if (!running_.exchange(false)) {
+    return;
+  }
+
+  if (context_) {
+    context_->Shutdown();
+  }
+
+  cv_ctx_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void Processor::BindContext(const std::shared_ptr<ProcessorContext>& context) {
+  context_ = context;
+  std::call_once(thread_flag_, [this]() {
+    running_.store(true);
+    thread_ = std::thread(&Processor::Run, this);
+  });
+}
+
+void Processor::Preempt(uint64_t seq) {
+  if (!running_.load() || !thread_.joinable()) {
+    return;
+  }
+  preempt_seq_.store(seq, std::memory_order_relaxed);
+  pthread_kill(thread_.native_handle(), kPreemptSignal);
+}
+
+void Processor::InstallPreemptHandler() {
+  std::lock_guard<std::mutex> lk(install_mutex);
+  struct sigaction current;
+  if (sigaction(kPreemptSignal, nullptr, &current) != 0) {
+    AERROR << "query preempt signal handler failed, errno: " << errno;
+    return;
+  }
+  if ((current.sa_flags & SA_SIGINFO) &&
+      current.sa_sigaction == &Processor::HandlePreemptSignal) {
+    return;
+  }
+  //先保存原来的处理函数再安装，信号处理函数里读到的一定是完整的
+  previous_action = current;
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_sigaction = &Processor::HandlePreemptSignal;
+  sa.sa_flags = SA_RESTART | SA_SIGINFO;
+  sigemptyset(&sa.sa_mask);
+  if (sigaction(kPreemptSignal, &sa, nullptr) != 0) {
+    AERROR << "install preempt signal handler failed, errno: " << errno;
+  }
+}
+
+//运行在被打断的处理器线程上，只读写原子变量和线程局部变量。
+//Preempt()用pthread_kill发送，si_code为SI_TKILL且si_pid为本进程，其余的SIGURG交给原来的处理函数
+void Processor::HandlePreemptSignal(int signo, siginfo_t* info,
+                                    void* ucontext) {
+  if (info == nullptr || info->si_code != SI_TKILL ||
+      info->si_pid != getpid()) {
+    int saved_errno = errno;
+    ForwardSignal(signo, info, ucontext);
+    errno = saved_errno;
+    return;
+  }
+  Processor* proc = current_processor;
+  if (proc == nullptr) {
+    return;
+  }
+  //信号到达前那次Resume已经结束时忽略，避免误伤下一个协程
+  if (proc->resume_seq_.load(std::memory_order_relaxed) !=
+      proc->preempt_seq_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  CRoutine* cr = CRoutine::GetCurrentRoutine();
+  if (cr != nullptr) {
+    cr->RequestPreempt();
+  }
+}
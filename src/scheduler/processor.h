@@ -0,0 +1,59 @@
+#ifndef CYBER_SCHEDULER_PROCESSOR_H_
+#define CYBER_SCHEDULER_PROCESSOR_H_
+
+#include <signal.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "processor_context.h"
+
+//Processor对线程进行了封装，其Run函数里的while循环不断通过context_->NextRoutine()
+//获取协程并运行，具体的调度策略由绑定的ProcessorContext决定
+class Processor {
+ public:
+  Processor() {}
+  ~Processor();
+
+  void Run();
+  void Stop();
+  void BindContext(const std::shared_ptr<ProcessorContext>& context);
+  std::thread* Thread() { return &thread_; }
+
+  //看门狗使用：每次Resume前后各加1，奇数表示正在运行协程，值不变表示一直在运行同一次Resume
+  uint64_t ResumeSeq() const { return resume_seq_.load(std::memory_order_relaxed); }
+  //向处理器线程发送kPreemptSignal，若它仍在运行序号为seq的那次Resume，
+  //信号处理函数标记当前协程在下一个MaybeYield()处让出
+  void Preempt(uint64_t seq);
+  //安装kPreemptSignal的处理函数，只在启用了看门狗抢占（ClassicConf::watchdog_preempt）时调用。
+  //原来的处理函数被保存下来，不是本进程pthread_kill发来的信号（比如带外数据到达时内核发的SIGURG）
+  //转交给它处理；安装之后又被其他代码替换掉时，再次调用会重新安装并链接到新的处理函数
+  static void InstallPreemptHandler();
+
+  //SIGURG默认被忽略，误发也不会影响进程
+  static constexpr int kPreemptSignal = SIGURG;
+
+ private:
+  Processor(const Processor&) = delete;
+  Processor& operator=(const Processor&) = delete;
+
+  static void HandlePreemptSignal(int signo, siginfo_t* info, void* ucontext);
+
+  std::shared_ptr<ProcessorContext> context_;
+
+  std::condition_variable cv_ctx_;
+  std::once_flag thread_flag_;
+  std::mutex mtx_ctx_;
+  std::thread thread_;
+
+  std::atomic<bool> running_ = {false};
+
+  //resume_seq_只由处理器线程写；preempt_seq_由看门狗在发送信号前写入
+  std::atomic<uint64_t> resume_seq_ = {0};
+  std::atomic<uint64_t> preempt_seq_ = {0};
+};
+
+#endif  // CYBER_SCHEDULER_PROCESSOR_H_
@@ -0,0 +1,52 @@
+#ifndef CYBER_SCHEDULER_PROCESSOR_CONTEXT_H_
+#define CYBER_SCHEDULER_PROCESSOR_CONTEXT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "../croutine/croutine.h"
+
+class Reactor;
+
+//处理器（线程）的调度上下文，不同的调度策略（经典/编排）通过重载下面的接口实现不同的调度方式
+class ProcessorContext {
+ public:
+  virtual ~ProcessorContext() {}
+
+  virtual void Shutdown() {
+    stop_.store(true);
+    Notify();
+  }
+
+  //取出下一个可以运行的协程，没有可运行的协程时返回nullptr
+  virtual CRoutine* NextRoutine() = 0;
+  //协程Resume返回之后调用，根据协程当前的状态决定将其放回就绪队列、
+  //放入等待队列还是交给调度器回收
+  virtual void OnRoutineYield(CRoutine* cr) = 0;
+  //没有可运行的协程时，处理器线程在这里等待
+  virtual void Wait() = 0;
+  //唤醒在Wait()中等待的处理器线程
+  virtual void Notify() = 0;
+  //可以在任意线程调用：通知挂起在本处理器上的协程（DATA_WAIT/IO_WAIT）有新的事件，
+  //协程已经挂起时直接放回本处理器的就绪队列，并在处理器空闲等待时唤醒它
+  virtual void Wakeup(CRoutine* cr) = 0;
+  //按id取得协程的强引用，协程已经结束并被回收时返回nullptr。
+  //其他线程唤醒协程时用它保证Wakeup()期间协程不会被析构
+  virtual std::shared_ptr<CRoutine> GetRoutine(uint64_t crid) = 0;
+  //本处理器的IO反应器（epoll），协程在这里等待fd就绪（IO_WAIT）；不支持时返回nullptr
+  virtual Reactor* GetReactor() { return nullptr; }
+
+  //当前线程正在运行的处理器上下文，不在处理器线程中时为nullptr。
+  //协程挂起前可以记录下来，之后由其他线程通过Wakeup()唤醒
+  static ProcessorContext* Current() { return current_; }
+  static void SetCurrent(ProcessorContext* context) { current_ = context; }
+
+ protected:
+  std::atomic<bool> stop_ = {false};
+
+ private:
+  static thread_local ProcessorContext* current_;
+};
+
+#endif  // CYBER_SCHEDULER_PROCESSOR_CONTEXT_H_
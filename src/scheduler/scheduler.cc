@@ -0,0 +1,96 @@
+#include "scheduler.h"
+
+#include <functional>
+#include <utility>
+
+#include "../common/epoch.h"
+#include "../common/macros.h"
+#include "../common/trace_recorder.h"
+
+bool Scheduler::CreateTask(RoutineFunc func, const std::string& name) {
+  if (cyber_unlikely(stop_.load())) {
+    return false;
+  }
+  return CreateTask(CRoutine::Create(std::move(func)), name);
+}
+
+bool Scheduler::CreateTask(const std::shared_ptr<CRoutine>& cr,
+                           const std::string& name) {
+  if (cyber_unlikely(stop_.load())) {
+    return false;
+  }
+  cr->set_id(std::hash<std::string>()(name));
+  cr->set_name(name);
+  TraceRecorder::Instance()->RegisterName(cr->id(), name);
+  return DispatchTask(cr);
+}
+
+bool Scheduler::NotifyTask(uint64_t crid) {
+  if (cyber_unlikely(stop_.load())) {
+    return true;
+  }
+  return NotifyProcessor(crid);
+}
+
+bool Scheduler::RemoveTask(const std::string& name) {
+  return RemoveCRoutine(std::hash<std::string>()(name));
+}
+
+bool Scheduler::RemoveCRoutine(uint64_t crid) {
+  auto cr = GetRoutine(crid);
+  if (cr == nullptr) {
+    return false;
+  }
+  cr->Stop();
+  return NotifyProcessor(crid);
+}
+
+void Scheduler::ReleaseRoutine(uint64_t crid) {
+  if (id_cr_.Erase(crid)) {
+    TraceRecorder::Instance()->UnregisterName(crid);
+  }
+}
+
+std::shared_ptr<CRoutine> Scheduler::GetRoutine(uint64_t crid) {
+  std::shared_ptr<CRoutine> cr;
+  id_cr_.Get(crid, &cr);
+  return cr;
+}
+
+size_t Scheduler::TaskNum() { return id_cr_.Size(); }
+
+std::vector<RoutineStatistics> Scheduler::GetRoutineStatistics() {
+  std::vector<RoutineStatistics> stats;
+  stats.reserve(id_cr_.Size());
+  id_cr_.ForEach([&stats](uint64_t, const std::shared_ptr<CRoutine>& cr) {
+    stats.emplace_back(cr->GetStatistics());
+  });
+  return stats;
+}
+
+void Scheduler::Shutdown() {
+  if (cyber_unlikely(stop_.exchange(true))) {
+    return;
+  }
+
+  //Processor::Stop()先让线程退出循环再停止上下文。如果先停止所有上下文，还没有被join的处理器
+  //会在Wait()中立即返回、空转，实时策略（SCHED_FIFO）的处理器会一直占着CPU，直到被内核限流
+  for (auto& proc : processors_) {
+    proc->Stop();
+  }
+  processors_.clear();
+
+  std::vector<uint64_t> ids;
+  id_cr_.ForEach([&ids](uint64_t crid, const std::shared_ptr<CRoutine>&) {
+    ids.push_back(crid);
+  });
+  id_cr_.Clear();
+  for (auto crid : ids) {
+    TraceRecorder::Instance()->UnregisterName(crid);
+  }
+  //处理器线程退出时留下的批和刚刚清空的协程在这里回收，
+  //Epoch推进两次后才能释放，否则协程栈要等到之后某个线程攒满一批才归还
+  for (int i = 0; i < 3; ++i) {
+    Epoch::Instance()->Collect();
+  }
+}
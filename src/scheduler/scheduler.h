@@ -0,0 +1,57 @@
+#ifndef CYBER_SCHEDULER_SCHEDULER_H_
+#define CYBER_SCHEDULER_SCHEDULER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../concurrent_hash_map.h"
+#include "../croutine/croutine.h"
+#include "processor.h"
+#include "processor_context.h"
+
+//调度器基类，负责维护协程id到协程实例的映射以及处理器（线程）的生命周期，
+//具体的分发策略由SchedulerClassic等子类实现
+class Scheduler {
+ public:
+  virtual ~Scheduler() {}
+
+  //用函数体创建协程并分发，协程id由名字哈希得到
+  bool CreateTask(RoutineFunc func, const std::string& name);
+  //分发已经创建好的协程（例如无栈协程StacklessRoutine），协程id同样由名字哈希得到
+  bool CreateTask(const std::shared_ptr<CRoutine>& cr, const std::string& name);
+  virtual bool DispatchTask(const std::shared_ptr<CRoutine>& cr) = 0;
+  //通知协程有新的数据，处于DATA_WAIT/IO_WAIT的协程会被重新调度
+  bool NotifyTask(uint64_t crid);
+  //停止协程，协程在下一次被调度时结束并被回收
+  bool RemoveTask(const std::string& name);
+  bool RemoveCRoutine(uint64_t crid);
+
+  //由处理器在协程结束(FINISHED)后调用，释放调度器持有的协程实例
+  void ReleaseRoutine(uint64_t crid);
+  //按id取得协程实例，协程不存在（已经结束并被释放）时返回nullptr
+  std::shared_ptr<CRoutine> GetRoutine(uint64_t crid);
+
+  void Shutdown();
+  uint32_t ProcessorNum() const { return static_cast<uint32_t>(processors_.size()); }
+  size_t TaskNum();
+  //所有存活协程的运行统计快照，需要以CYBER_ROUTINE_STATISTICS编译
+  std::vector<RoutineStatistics> GetRoutineStatistics();
+
+ protected:
+  Scheduler() {}
+  virtual bool NotifyProcessor(uint64_t crid) = 0;
+
+  //协程的id和协程实例的映射。按id查找协程不加锁，不同id的增删也不会互相阻塞；
+  //删除的协程由Epoch延迟析构
+  ConcurrentHashMap<std::shared_ptr<CRoutine>> id_cr_;
+
+  std::vector<std::shared_ptr<ProcessorContext>> pctxs_;
+  std::vector<std::shared_ptr<Processor>> processors_;
+
+  std::atomic<bool> stop_ = {false};
+};
+
+#endif  // CYBER_SCHEDULER_SCHEDULER_H_
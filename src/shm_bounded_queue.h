@@ -0,0 +1,557 @@
+#ifndef CYBER_BASE_SHM_BOUNDED_QUEUE_H_
+#define CYBER_BASE_SHM_BOUNDED_QUEUE_H_
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include "common/log.h"
+#include "common/macros.h"
+#include "common/trace_recorder.h"
+
+//共享内存中的原子变量要求是无锁的，否则不同进程之间不能互相看到
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "shared memory queue needs address-free atomics");
+
+//进程间共享的futex等待/唤醒（不带FUTEX_PRIVATE_FLAG）
+inline int ShmFutexWait(std::atomic<uint32_t>* word, uint32_t expected,
+                        int timeout_ms) {
+  timespec ts;
+  ts.tv_sec = timeout_ms / 1000;
+  ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+  return static_cast<int>(syscall(SYS_futex, reinterpret_cast<uint32_t*>(word),
+                                  FUTEX_WAIT, expected, &ts, nullptr, 0));
+}
+
+inline void ShmFutexWakeAll(std::atomic<uint32_t>* word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX,
+          nullptr, nullptr, 0);
+}
+
+//放在POSIX命名共享内存里的有界多生产者多消费者队列，可以在多个进程之间传递消息。
+//共享内存中只有下标和槽位，没有指针，各进程映射到不同的地址也能使用；
+//元素按值拷贝，必须是平凡可拷贝的类型。
+//每个槽位带一个序号（Vyukov的有界队列）：生产者在序号等于tail时占用槽位，写完后把序号加一；
+//消费者在序号等于head+1时取走元素，再把序号推进一圈。
+//每个进程在共享内存里登记一个peer，记下自己正在入队/出队的位置；
+//进程在入队或出队的中途崩溃时，等待超时的一方会把它没完成的槽位修复掉，队列不会永久卡住。
+//peer按队列对象登记，只有一个入队位置和一个出队位置：同一个对象最多一个线程入队、一个线程出队，
+//更多的线程要各自Open一个对象（调试版本中第二个线程入队/出队时打印错误并终止进程）。
+//peer表只有kMaxPeers项，所有进程的对象共用。
+template <typename T>
+class ShmBoundedQueue {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "ShmBoundedQueue element must be trivially copyable");
+
+ public:
+  using value_type = T;
+  using size_type = uint64_t;
+
+  static constexpr uint32_t kMaxPeers = 64;
+
+ public:
+  ShmBoundedQueue() {}
+  ShmBoundedQueue& operator=(const ShmBoundedQueue& other) = delete;
+  ShmBoundedQueue(const ShmBoundedQueue& other) = delete;
+  ~ShmBoundedQueue();
+  //创建新的共享内存队列，size向上取整为2的幂（至少为2）；同名的共享内存已经存在时失败
+  bool Create(const std::string& name, uint64_t size);
+  //打开其他进程创建的队列。fork出来的子进程要重新Open，不能沿用父进程的对象
+  bool Open(const std::string& name);
+  static bool Unlink(const std::string& name);
+
+  bool Enqueue(const T& element);
+  bool WaitEnqueue(const T& element);
+  bool Dequeue(T* element);
+  bool WaitDequeue(T* element);
+  uint64_t Size();
+  bool Empty();
+  //只打断本进程的等待
+  void BreakAllWait();
+  //等待的超时时间，超时后检查并修复崩溃进程留下的槽位
+  void SetWaitTimeout(int timeout_ms) { wait_timeout_ms_ = timeout_ms; }
+  //修复已经退出的进程在入队/出队中途留下的槽位，返回修复的槽位数
+  uint64_t RecoverDeadPeers();
+  uint64_t Head() { return header_->head.load(); }
+  uint64_t Tail() { return header_->tail.load(); }
+
+ private:
+  friend class ShmBoundedQueueTester;
+
+  static constexpr uint64_t kMagic = 0x4359424552534d51ULL;  // "CYBERSMQ"
+  //peer不在入队/出队中
+  static constexpr uint64_t kIdle = ~0ULL;
+  //peer正在抢占位置，还不知道抢到的是哪一个
+  static constexpr uint64_t kClaiming = ~0ULL - 1;
+  //槽位序号的最高位：生产者崩溃后被修复的槽位，里面没有有效数据，消费者直接跳过。
+  //作废和生产者的发布都是序号上的CAS（pos -> pos+1），只有一方能成功
+  static constexpr uint64_t kAbandoned = 1ULL << 63;
+
+  struct Peer {
+    std::atomic<int32_t> pid;
+    std::atomic<uint64_t> enq_pos;
+    std::atomic<uint64_t> deq_pos;
+  };
+
+  struct Header {
+    uint64_t magic;
+    uint64_t slot_size;
+    uint64_t capacity;
+    std::atomic<uint32_t> ready;
+    alignas(CACHELINE_SIZE) std::atomic<uint64_t> head;
+    alignas(CACHELINE_SIZE) std::atomic<uint64_t> tail;
+    //每次入队加一，等待数据的消费者在上面futex等待
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> enq_futex;
+    std::atomic<uint32_t> enq_waiters;
+    //每次出队加一，等待空位的生产者在上面futex等待
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> deq_futex;
+    std::atomic<uint32_t> deq_waiters;
+    alignas(CACHELINE_SIZE) Peer peers[kMaxPeers];
+  };
+
+  struct Slot {
+    std::atomic<uint64_t> seq;
+    T value;
+  };
+
+  static uint64_t HeaderBytes() {
+    return (sizeof(Header) + CACHELINE_SIZE - 1) / CACHELINE_SIZE *
+           CACHELINE_SIZE;
+  }
+  static bool Alive(int32_t pid) {
+    return pid != 0 && (kill(pid, 0) == 0 || errno != ESRCH);
+  }
+
+  bool Map(int fd, uint64_t bytes);
+  bool Attach();
+  Slot& GetSlot(uint64_t pos) {
+    return slots_[pos & (header_->capacity - 1)];
+  }
+  //pos是否可能属于一个还活着的peer
+  bool OwnedByLivePeer(uint64_t pos, bool enqueue);
+  //调试版本中检查入队/出队只在第一次调用它的线程上进行
+  void CheckOwner(std::atomic<std::thread::id>* owner, const char* op);
+
+  Header* header_ = nullptr;
+  Slot* slots_ = nullptr;
+  Peer* peer_ = nullptr;
+  uint64_t mapped_bytes_ = 0;
+  int wait_timeout_ms_ = 100;
+  std::atomic<bool> break_all_wait_ = {false};
+#ifndef NDEBUG
+  std::atomic<std::thread::id> enq_owner_ = {std::thread::id()};
+  std::atomic<std::thread::id> deq_owner_ = {std::thread::id()};
+#endif
+};
+
+template <typename T>
+constexpr uint32_t ShmBoundedQueue<T>::kMaxPeers;
+template <typename T>
+constexpr uint64_t ShmBoundedQueue<T>::kMagic;
+template <typename T>
+constexpr uint64_t ShmBoundedQueue<T>::kIdle;
+template <typename T>
+constexpr uint64_t ShmBoundedQueue<T>::kAbandoned;
+template <typename T>
+constexpr uint64_t ShmBoundedQueue<T>::kClaiming;
+
+template <typename T>
+ShmBoundedQueue<T>::~ShmBoundedQueue() {
+  if (header_ == nullptr) {
+    return;
+  }
+  BreakAllWait();
+  if (peer_ != nullptr) {
+    peer_->pid.store(0, std::memory_order_release);
+  }
+  munmap(header_, mapped_bytes_);
+}
+
+template <typename T>
+bool ShmBoundedQueue<T>::Create(const std::string& name, uint64_t size) {
+  if (header_ != nullptr || size == 0) {
+    return false;
+  }
+  //只有一个槽位时分不清满和空，至少两个
+  uint64_t capacity = 2;
+  while (capacity < size) {
+    capacity <<= 1;
+  }
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    AERROR << "shm_open " << name << " failed: " << strerror(errno);
+    return false;
+  }
+  uint64_t bytes = HeaderBytes() + capacity * sizeof(Slot);
+  if (ftruncate(fd, static_cast<off_t>(bytes)) != 0 || !Map(fd, bytes)) {
+    AERROR << "map " << name << " failed: " << strerror(errno);
+    close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+  close(fd);
+  //ftruncate出来的内存全为0，这里只需要设置非0的字段
+  header_ = new (header_) Header();
+  header_->magic = kMagic;
+  header_->slot_size = sizeof(Slot);
+  header_->capacity = capacity;
+  header_->head.store(0, std::memory_order_relaxed);
+  header_->tail.store(0, std::memory_order_relaxed);
+  for (auto& peer : header_->peers) {
+    peer.pid.store(0, std::memory_order_relaxed);
+    peer.enq_pos.store(kIdle, std::memory_order_relaxed);
+    peer.deq_pos.store(kIdle, std::memory_order_relaxed);
+  }
+  for (uint64_t i = 0; i < capacity; ++i) {
+    new (&slots_[i]) Slot();
+    slots_[i].seq.store(i, std::memory_order_relaxed);
+  }
+  header_->ready.store(1, std::memory_order_release);
+  return Attach();
+}
+
+template <typename T>
+bool ShmBoundedQueue<T>::Open(const std::string& name) {
+  if (header_ != nullptr) {
+    return false;
+  }
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd < 0) {
+    AERROR << "shm_open " << name << " failed: " << strerror(errno);
+    return false;
+  }
+  //创建者可能还没有ftruncate完
+  struct stat st = {};
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (fstat(fd, &st) == 0 &&
+         static_cast<uint64_t>(st.st_size) < HeaderBytes() &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (static_cast<uint64_t>(st.st_size) < HeaderBytes() ||
+      !Map(fd, static_cast<uint64_t>(st.st_size))) {
+    close(fd);
+    return false;
+  }
+  close(fd);
+  while (header_->ready.load(std::memory_order_acquire) == 0 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (header_->ready.load(std::memory_order_acquire) == 0 ||
+      header_->magic != kMagic || header_->slot_size != sizeof(Slot) ||
+      HeaderBytes() + header_->capacity * sizeof(Slot) > mapped_bytes_) {
+    AERROR << "shared memory " << name << " is not a compatible queue";
+    munmap(header_, mapped_bytes_);
+    header_ = nullptr;
+    return false;
+  }
+  return Attach();
+}
+
+template <typename T>
+inline bool ShmBoundedQueue<T>::Unlink(const std::string& name) {
+  return shm_unlink(name.c_str()) == 0;
+}
+
+template <typename T>
+bool ShmBoundedQueue<T>::Map(int fd, uint64_t bytes) {
+  void* addr =
+      mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    return false;
+  }
+  mapped_bytes_ = bytes;
+  header_ = static_cast<Header*>(addr);
+  slots_ = reinterpret_cast<Slot*>(static_cast<char*>(addr) + HeaderBytes());
+  return true;
+}
+
+template <typename T>
+bool ShmBoundedQueue<T>::Attach() {
+  int32_t pid = getpid();
+  for (int round = 0; round < 2; ++round) {
+    for (auto& peer : header_->peers) {
+      int32_t expected = 0;
+      if (peer.pid.compare_exchange_strong(expected, pid,
+                                           std::memory_order_acq_rel)) {
+        peer.enq_pos.store(kIdle, std::memory_order_relaxed);
+        peer.deq_pos.store(kIdle, std::memory_order_relaxed);
+        peer_ = &peer;
+        return true;
+      }
+    }
+    //peer表满了，先清理掉已经退出的进程
+    RecoverDeadPeers();
+  }
+  AERROR << "too many processes attached to the shared memory queue";
+  return false;
+}
+
+template <typename T>
+bool ShmBoundedQueue<T>::Enqueue(const T& element) {
+#ifndef NDEBUG
+  CheckOwner(&enq_owner_, "enqueue");
+#endif
+  uint64_t pos = 0;
+  for (;;) {
+    peer_->enq_pos.store(kClaiming, std::memory_order_seq_cst);
+    pos = header_->tail.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    for (;;) {
+      slot = &GetSlot(pos);
+      uint64_t seq = slot->seq.load(std::memory_order_acquire) & ~kAbandoned;
+      int64_t diff = static_cast<int64_t>(seq - pos);
+      if (diff == 0) {
+        if (header_->tail.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        //队列已满
+        peer_->enq_pos.store(kIdle, std::memory_order_release);
+        return false;
+      } else {
+        pos = header_->tail.load(std::memory_order_relaxed);
+      }
+    }
+    peer_->enq_pos.store(pos, std::memory_order_relaxed);
+    slot->value = element;
+    //用CAS发布：本进程被误判为已退出（例如pid被复用的检查出错）时，槽位可能已经被作废，
+    //这时数据不会被读到，换一个位置重新入队
+    uint64_t expected = pos;
+    bool published = slot->seq.compare_exchange_strong(
+        expected, pos + 1, std::memory_order_release, std::memory_order_relaxed);
+    peer_->enq_pos.store(kIdle, std::memory_order_release);
+    if (cyber_likely(published)) {
+      break;
+    }
+  }
+  CYBER_TRACE(QUEUE_ENQUEUE, reinterpret_cast<uint64_t>(header_),
+              static_cast<uint32_t>(pos));
+
+  header_->enq_futex.fetch_add(1, std::memory_order_seq_cst);
+  if (header_->enq_waiters.load(std::memory_order_seq_cst) != 0) {
+    ShmFutexWakeAll(&header_->enq_futex);
+  }
+  return true;
+}
+
+template <typename T>
+bool ShmBoundedQueue<T>::Dequeue(T* element) {
+#ifndef NDEBUG
+  CheckOwner(&deq_owner_, "dequeue");
+#endif
+  for (;;) {
+    peer_->deq_pos.store(kClaiming, std::memory_order_seq_cst);
+    uint64_t pos = header_->head.load(std::memory_order_relaxed);
+    uint64_t seq = 0;
+    Slot* slot = nullptr;
+    for (;;) {
+      slot = &GetSlot(pos);
+      seq = slot->seq.load(std::memory_order_acquire);
+      int64_t diff = static_cast<int64_t>((seq & ~kAbandoned) - (pos + 1));
+      if (diff == 0) {
+        //抢到之后序号在本进程归还之前不会再变，这里读到的作废标记就是最终的
+        if (header_->head.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        //队列为空，或者最前面的槽位还没写完
+        peer_->deq_pos.store(kIdle, std::memory_order_release);
+        return false;
+      } else {
+        pos = header_->head.load(std::memory_order_relaxed);
+      }
+    }
+    peer_->deq_pos.store(pos, std::memory_order_relaxed);
+    bool abandoned = (seq & kAbandoned) != 0;
+    if (!abandoned) {
+      *element = slot->value;
+    }
+    slot->seq.store(pos + header_->capacity, std::memory_order_release);
+    peer_->deq_pos.store(kIdle, std::memory_order_release);
+
+    header_->deq_futex.fetch_add(1, std::memory_order_seq_cst);
+    if (header_->deq_waiters.load(std::memory_order_seq_cst) != 0) {
+      ShmFutexWakeAll(&header_->deq_futex);
+    }
+    if (!abandoned) {
+      CYBER_TRACE(QUEUE_DEQUEUE, reinterpret_cast<uint64_t>(header_),
+                  static_cast<uint32_t>(pos));
+      return true;
+    }
+  }
+}
+
+//等待方先登记再读futex的值，然后重试一次；对方在这之后完成的操作一定会改变futex的值，
+//所以不会丢失唤醒。超时后检查有没有崩溃的进程把队列卡住
+template <typename T>
+bool ShmBoundedQueue<T>::WaitEnqueue(const T& element) {
+  while (!break_all_wait_) {
+    if (Enqueue(element)) {
+      return true;
+    }
+    header_->deq_waiters.fetch_add(1, std::memory_order_seq_cst);
+    uint32_t value = header_->deq_futex.load(std::memory_order_seq_cst);
+    bool done = Enqueue(element);
+    if (!done && !break_all_wait_) {
+      if (ShmFutexWait(&header_->deq_futex, value, wait_timeout_ms_) != 0 &&
+          errno == ETIMEDOUT) {
+        RecoverDeadPeers();
+      }
+    }
+    header_->deq_waiters.fetch_sub(1, std::memory_order_seq_cst);
+    if (done) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename T>
+bool ShmBoundedQueue<T>::WaitDequeue(T* element) {
+  while (!break_all_wait_) {
+    if (Dequeue(element)) {
+      return true;
+    }
+    header_->enq_waiters.fetch_add(1, std::memory_order_seq_cst);
+    uint32_t value = header_->enq_futex.load(std::memory_order_seq_cst);
+    bool done = Dequeue(element);
+    if (!done && !break_all_wait_) {
+      if (ShmFutexWait(&header_->enq_futex, value, wait_timeout_ms_) != 0 &&
+          errno == ETIMEDOUT) {
+        RecoverDeadPeers();
+      }
+    }
+    header_->enq_waiters.fetch_sub(1, std::memory_order_seq_cst);
+    if (done) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename T>
+void ShmBoundedQueue<T>::CheckOwner(std::atomic<std::thread::id>* owner,
+                                    const char* op) {
+  std::thread::id self = std::this_thread::get_id();
+  std::thread::id expected;
+  if (owner->compare_exchange_strong(expected, self,
+                                     std::memory_order_relaxed) ||
+      expected == self) {
+    return;
+  }
+  //两个线程共用一个peer时，其中一个的位置会被覆盖，修复时可能作废它正在写的槽位
+  AERROR << "ShmBoundedQueue " << op << " from a second thread on the same "
+         << "object; Open one queue object per thread";
+  std::abort();
+}
+
+template <typename T>
+bool ShmBoundedQueue<T>::OwnedByLivePeer(uint64_t pos, bool enqueue) {
+  for (auto& peer : header_->peers) {
+    int32_t pid = peer.pid.load(std::memory_order_acquire);
+    if (pid == 0) {
+      continue;
+    }
+    uint64_t owned = enqueue ? peer.enq_pos.load(std::memory_order_seq_cst)
+                             : peer.deq_pos.load(std::memory_order_seq_cst);
+    //正在抢占的peer可能已经抢到了pos但还没来得及登记
+    if ((owned == pos || owned == kClaiming) && Alive(pid)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename T>
+uint64_t ShmBoundedQueue<T>::RecoverDeadPeers() {
+  uint64_t repaired = 0;
+  uint64_t capacity = header_->capacity;
+  uint64_t head = header_->head.load(std::memory_order_seq_cst);
+  uint64_t tail = header_->tail.load(std::memory_order_seq_cst);
+  //[head, tail)中还没写完的槽位：生产者抢到位置后崩溃了
+  for (uint64_t pos = head; pos != tail; ++pos) {
+    Slot& slot = GetSlot(pos);
+    if (slot.seq.load(std::memory_order_acquire) != pos ||
+        OwnedByLivePeer(pos, true)) {
+      continue;
+    }
+    //生产者在检查之后发布了数据时CAS失败，槽位保持有效
+    uint64_t expected = pos;
+    if (slot.seq.compare_exchange_strong(expected, (pos + 1) | kAbandoned,
+                                         std::memory_order_release)) {
+      repaired++;
+      AWARN << "recovered slot " << pos << " left by a dead producer";
+    }
+  }
+  //[head - capacity, head)中还没归还的槽位：消费者抢到位置后崩溃了
+  uint64_t begin = head > capacity ? head - capacity : 0;
+  for (uint64_t pos = begin; pos != head; ++pos) {
+    Slot& slot = GetSlot(pos);
+    uint64_t expected = slot.seq.load(std::memory_order_acquire);
+    if ((expected & ~kAbandoned) != pos + 1 || OwnedByLivePeer(pos, false)) {
+      continue;
+    }
+    if (slot.seq.compare_exchange_strong(expected, pos + capacity,
+                                         std::memory_order_release)) {
+      repaired++;
+      AWARN << "recovered slot " << pos << " left by a dead consumer";
+    }
+  }
+  //修复完之后再释放已经退出的进程的peer
+  for (auto& peer : header_->peers) {
+    int32_t pid = peer.pid.load(std::memory_order_acquire);
+    if (pid != 0 && !Alive(pid)) {
+      peer.enq_pos.store(kIdle, std::memory_order_relaxed);
+      peer.deq_pos.store(kIdle, std::memory_order_relaxed);
+      peer.pid.compare_exchange_strong(pid, 0, std::memory_order_acq_rel);
+    }
+  }
+  if (repaired != 0) {
+    ShmFutexWakeAll(&header_->enq_futex);
+    ShmFutexWakeAll(&header_->deq_futex);
+  }
+  return repaired;
+}
+
+template <typename T>
+inline uint64_t ShmBoundedQueue<T>::Size() {
+  uint64_t head = header_->head.load(std::memory_order_acquire);
+  uint64_t tail = header_->tail.load(std::memory_order_acquire);
+  return tail > head ? tail - head : 0;
+}
+
+template <typename T>
+inline bool ShmBoundedQueue<T>::Empty() {
+  return Size() == 0;
+}
+
+template <typename T>
+inline void ShmBoundedQueue<T>::BreakAllWait() {
+  break_all_wait_ = true;
+  //其他进程的等待者也会被唤醒，它们检查自己的标志后继续等待
+  ShmFutexWakeAll(&header_->enq_futex);
+  ShmFutexWakeAll(&header_->deq_futex);
+}
+
+#endif  // CYBER_BASE_SHM_BOUNDED_QUEUE_H_
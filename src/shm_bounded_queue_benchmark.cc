@@ -0,0 +1,221 @@
+//跨进程传递消息：ShmBoundedQueue和Unix域套接字（socketpair）对比
+//1、往返延迟：父进程发一条消息，子进程收到后原样发回，统计中位数和p99
+//2、吞吐量：子进程连续发送64字节的消息，父进程接收
+//用法：shm_bounded_queue_benchmark [messages]
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "shm_bounded_queue.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kRoundTrips = 20000;
+constexpr uint64_t kCapacity = 1024;
+
+struct Message {
+  uint64_t seq;
+  uint64_t payload[7];
+};
+
+double Seconds(Clock::time_point begin) {
+  return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+void PrintLatency(const char* name, std::vector<double>* samples) {
+  std::sort(samples->begin(), samples->end());
+  printf("%-12s round trip  median %8.2f us  p99 %8.2f us\n", name,
+         (*samples)[samples->size() / 2],
+         (*samples)[samples->size() * 99 / 100]);
+}
+
+bool WriteAll(int fd, const void* data, size_t size) {
+  auto ptr = static_cast<const char*>(data);
+  while (size > 0) {
+    ssize_t n = write(fd, ptr, size);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    ptr += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool ReadAll(int fd, void* data, size_t size) {
+  auto ptr = static_cast<char*>(data);
+  while (size > 0) {
+    ssize_t n = read(fd, ptr, size);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    ptr += n;
+    size -= n;
+  }
+  return true;
+}
+
+//两个方向各一个队列
+void ShmLatency() {
+  std::string name = "/cyber_shm_bench_" + std::to_string(getpid());
+  ShmBoundedQueue<Message> request;
+  ShmBoundedQueue<Message> response;
+  if (!request.Create(name + "_req", kCapacity) ||
+      !response.Create(name + "_resp", kCapacity)) {
+    return;
+  }
+  pid_t pid = fork();
+  if (pid == 0) {
+    ShmBoundedQueue<Message> in;
+    ShmBoundedQueue<Message> out;
+    if (!in.Open(name + "_req") || !out.Open(name + "_resp")) {
+      _exit(1);
+    }
+    Message msg;
+    for (int i = 0; i < kRoundTrips; ++i) {
+      in.WaitDequeue(&msg);
+      out.WaitEnqueue(msg);
+    }
+    _exit(0);
+  }
+  std::vector<double> samples;
+  Message msg = {};
+  for (int i = 0; i < kRoundTrips; ++i) {
+    msg.seq = i;
+    auto begin = Clock::now();
+    request.WaitEnqueue(msg);
+    response.WaitDequeue(&msg);
+    samples.push_back(Seconds(begin) * 1e6);
+  }
+  waitpid(pid, nullptr, 0);
+  ShmBoundedQueue<Message>::Unlink(name + "_req");
+  ShmBoundedQueue<Message>::Unlink(name + "_resp");
+  PrintLatency("shm queue", &samples);
+}
+
+void SocketLatency() {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+    return;
+  }
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    Message msg;
+    for (int i = 0; i < kRoundTrips; ++i) {
+      if (!ReadAll(fds[1], &msg, sizeof(msg)) ||
+          !WriteAll(fds[1], &msg, sizeof(msg))) {
+        _exit(1);
+      }
+    }
+    _exit(0);
+  }
+  close(fds[1]);
+  std::vector<double> samples;
+  Message msg = {};
+  for (int i = 0; i < kRoundTrips; ++i) {
+    msg.seq = i;
+    auto begin = Clock::now();
+    WriteAll(fds[0], &msg, sizeof(msg));
+    ReadAll(fds[0], &msg, sizeof(msg));
+    samples.push_back(Seconds(begin) * 1e6);
+  }
+  waitpid(pid, nullptr, 0);
+  close(fds[0]);
+  PrintLatency("unix socket", &samples);
+}
+
+void ShmThroughput(uint64_t messages) {
+  std::string name = "/cyber_shm_bench_" + std::to_string(getpid());
+  ShmBoundedQueue<Message> queue;
+  if (!queue.Create(name, kCapacity)) {
+    return;
+  }
+  auto begin = Clock::now();
+  pid_t pid = fork();
+  if (pid == 0) {
+    ShmBoundedQueue<Message> out;
+    if (!out.Open(name)) {
+      _exit(1);
+    }
+    Message msg = {};
+    for (uint64_t i = 0; i < messages; ++i) {
+      msg.seq = i;
+      out.WaitEnqueue(msg);
+    }
+    _exit(0);
+  }
+  Message msg;
+  uint64_t sum = 0;
+  for (uint64_t i = 0; i < messages; ++i) {
+    queue.WaitDequeue(&msg);
+    sum += msg.seq;
+  }
+  double seconds = Seconds(begin);
+  waitpid(pid, nullptr, 0);
+  ShmBoundedQueue<Message>::Unlink(name);
+  printf("%-12s throughput %8.2f M msgs/s (%.3f s, %llu)\n", "shm queue",
+         messages / seconds / 1e6, seconds,
+         static_cast<unsigned long long>(sum));
+}
+
+void SocketThroughput(uint64_t messages) {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+    return;
+  }
+  auto begin = Clock::now();
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    Message msg = {};
+    for (uint64_t i = 0; i < messages; ++i) {
+      msg.seq = i;
+      if (!WriteAll(fds[1], &msg, sizeof(msg))) {
+        _exit(1);
+      }
+    }
+    _exit(0);
+  }
+  close(fds[1]);
+  Message msg;
+  uint64_t sum = 0;
+  for (uint64_t i = 0; i < messages; ++i) {
+    ReadAll(fds[0], &msg, sizeof(msg));
+    sum += msg.seq;
+  }
+  double seconds = Seconds(begin);
+  waitpid(pid, nullptr, 0);
+  close(fds[0]);
+  printf("%-12s throughput %8.2f M msgs/s (%.3f s, %llu)\n", "unix socket",
+         messages / seconds / 1e6, seconds,
+         static_cast<unsigned long long>(sum));
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  uint64_t messages = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+  printf("%zu-byte messages between two processes\n", sizeof(Message));
+  ShmLatency();
+  SocketLatency();
+  ShmThroughput(messages);
+  SocketThroughput(messages);
+  return 0;
+}
@@ -0,0 +1,284 @@
+#include "shm_bounded_queue.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+//模拟进程在入队/出队中途崩溃：只抢占位置，不写数据也不归还槽位
+class ShmBoundedQueueTester {
+ public:
+  template <typename T>
+  static uint64_t ClaimEnqueue(ShmBoundedQueue<T>* queue) {
+    queue->peer_->enq_pos.store(ShmBoundedQueue<T>::kClaiming);
+    uint64_t pos = queue->header_->tail.fetch_add(1);
+    queue->peer_->enq_pos.store(pos);
+    return pos;
+  }
+
+  template <typename T>
+  static uint64_t ClaimDequeue(ShmBoundedQueue<T>* queue) {
+    queue->peer_->deq_pos.store(ShmBoundedQueue<T>::kClaiming);
+    uint64_t pos = queue->header_->head.fetch_add(1);
+    queue->peer_->deq_pos.store(pos);
+    return pos;
+  }
+};
+
+namespace {
+
+std::string QueueName() {
+  return "/cyber_shm_queue_test_" + std::to_string(getpid());
+}
+
+//等待子进程退出，返回退出码
+int WaitChild(pid_t pid) {
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+}  // namespace
+
+TEST(ShmBoundedQueue, CreateOpenFifo) {
+  std::string name = QueueName();
+  ShmBoundedQueue<int> writer;
+  ASSERT_TRUE(writer.Create(name, 10));
+  //同名的队列不能重复创建
+  ShmBoundedQueue<int> duplicate;
+  EXPECT_FALSE(duplicate.Create(name, 10));
+  ShmBoundedQueue<int> reader;
+  ASSERT_TRUE(reader.Open(name));
+  ShmBoundedQueue<int>::Unlink(name);
+
+  int value = 0;
+  EXPECT_FALSE(reader.Dequeue(&value));
+  //容量向上取整为16
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_TRUE(writer.Enqueue(i));
+  }
+  EXPECT_FALSE(writer.Enqueue(16));
+  EXPECT_EQ(reader.Size(), 16u);
+  for (int i = 0; i < 16; ++i) {
+    ASSERT_TRUE(reader.Dequeue(&value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_TRUE(reader.Empty());
+}
+
+TEST(ShmBoundedQueue, ForkedProducers) {
+  constexpr int kProducers = 3;
+  constexpr int kPerProducer = 20000;
+  std::string name = QueueName();
+  ShmBoundedQueue<int> queue;
+  ASSERT_TRUE(queue.Create(name, 64));
+  std::vector<pid_t> children;
+  for (int p = 0; p < kProducers; ++p) {
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      ShmBoundedQueue<int> child;
+      if (!child.Open(name)) {
+        _exit(1);
+      }
+      for (int i = 0; i < kPerProducer; ++i) {
+        if (!child.WaitEnqueue(p * kPerProducer + i)) {
+          _exit(2);
+        }
+      }
+      _exit(0);
+    }
+    children.push_back(pid);
+  }
+  //每个生产者自己的数据必须按顺序到达
+  std::vector<int> next(kProducers, 0);
+  int value = 0;
+  for (int i = 0; i < kProducers * kPerProducer; ++i) {
+    ASSERT_TRUE(queue.WaitDequeue(&value));
+    int producer = value / kPerProducer;
+    ASSERT_EQ(value % kPerProducer, next[producer]);
+    next[producer]++;
+  }
+  for (pid_t pid : children) {
+    EXPECT_EQ(WaitChild(pid), 0);
+  }
+  //子进程都Open之后才能删除名字
+  ShmBoundedQueue<int>::Unlink(name);
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(ShmBoundedQueue, RecoverDeadProducer) {
+  std::string name = QueueName();
+  ShmBoundedQueue<int> queue;
+  ASSERT_TRUE(queue.Create(name, 4));
+  queue.SetWaitTimeout(20);
+  EXPECT_TRUE(queue.Enqueue(1));
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    ShmBoundedQueue<int> child;
+    if (!child.Open(name)) {
+      _exit(1);
+    }
+    ShmBoundedQueueTester::ClaimEnqueue(&child);
+    _exit(0);
+  }
+  EXPECT_EQ(WaitChild(pid), 0);
+  ShmBoundedQueue<int>::Unlink(name);
+  EXPECT_TRUE(queue.Enqueue(3));
+
+  int value = 0;
+  ASSERT_TRUE(queue.Dequeue(&value));
+  EXPECT_EQ(value, 1);
+  //崩溃的生产者占着队头，修复之前后面的数据出不来
+  EXPECT_FALSE(queue.Dequeue(&value));
+  //等待超时后自动修复
+  ASSERT_TRUE(queue.WaitDequeue(&value));
+  EXPECT_EQ(value, 3);
+  EXPECT_EQ(queue.RecoverDeadPeers(), 0u);
+  //修复的槽位可以继续使用
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.Enqueue(i));
+  }
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.Dequeue(&value));
+    EXPECT_EQ(value, i);
+  }
+}
+
+TEST(ShmBoundedQueue, RecoverDeadConsumer) {
+  std::string name = QueueName();
+  ShmBoundedQueue<int> queue;
+  ASSERT_TRUE(queue.Create(name, 2));
+  EXPECT_TRUE(queue.Enqueue(1));
+  EXPECT_TRUE(queue.Enqueue(2));
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    ShmBoundedQueue<int> child;
+    if (!child.Open(name)) {
+      _exit(1);
+    }
+    ShmBoundedQueueTester::ClaimDequeue(&child);
+    _exit(0);
+  }
+  EXPECT_EQ(WaitChild(pid), 0);
+  ShmBoundedQueue<int>::Unlink(name);
+
+  int value = 0;
+  ASSERT_TRUE(queue.Dequeue(&value));
+  EXPECT_EQ(value, 2);
+  //崩溃的消费者没有归还槽位，下一个要写的槽位还被占着
+  EXPECT_FALSE(queue.Enqueue(3));
+  EXPECT_EQ(queue.RecoverDeadPeers(), 1u);
+  EXPECT_TRUE(queue.Enqueue(3));
+  EXPECT_TRUE(queue.Enqueue(4));
+  ASSERT_TRUE(queue.Dequeue(&value));
+  EXPECT_EQ(value, 3);
+  ASSERT_TRUE(queue.Dequeue(&value));
+  EXPECT_EQ(value, 4);
+}
+
+//所有进程都活着时，并发的修复不能作废任何一条正在发布的消息
+TEST(ShmBoundedQueue, RecoverNeverDropsLiveMessages) {
+  std::string name = QueueName();
+  ShmBoundedQueue<uint64_t> queue;
+  ASSERT_TRUE(queue.Create(name, 8));
+  //peer记录的是每个队列对象正在操作的位置，每个线程各自Open一个对象
+  ShmBoundedQueue<uint64_t> producers[2];
+  ShmBoundedQueue<uint64_t> recoverer;
+  for (auto& producer : producers) {
+    ASSERT_TRUE(producer.Open(name));
+  }
+  ASSERT_TRUE(recoverer.Open(name));
+  ShmBoundedQueue<uint64_t>::Unlink(name);
+
+  const uint64_t kItems = 100000;
+  std::atomic<bool> stop = {false};
+  std::atomic<uint64_t> repaired = {0};
+  std::thread recover([&]() {
+    while (!stop) {
+      repaired += recoverer.RecoverDeadPeers();
+    }
+  });
+  std::vector<std::thread> threads;
+  for (auto& producer : producers) {
+    threads.emplace_back([&producer, kItems]() {
+      for (uint64_t i = 1; i <= kItems; ++i) {
+        EXPECT_TRUE(producer.WaitEnqueue(i));
+      }
+    });
+  }
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  uint64_t value = 0;
+  while (count < 2 * kItems && queue.WaitDequeue(&value)) {
+    ++count;
+    sum += value;
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  stop = true;
+  recover.join();
+  EXPECT_EQ(repaired, 0u);
+  EXPECT_EQ(count, 2 * kItems);
+  EXPECT_EQ(sum, kItems * (kItems + 1));
+}
+
+TEST(ShmBoundedQueue, BreakAllWait) {
+  std::string name = QueueName();
+  ShmBoundedQueue<int> queue;
+  ASSERT_TRUE(queue.Create(name, 1));
+  ShmBoundedQueue<int>::Unlink(name);
+  //同一个对象只能有一个线程入队，填满队列也在等待的线程里进行
+  std::thread waiter([&]() {
+    EXPECT_TRUE(queue.Enqueue(1));
+    EXPECT_TRUE(queue.Enqueue(2));
+    EXPECT_FALSE(queue.WaitEnqueue(3));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  queue.BreakAllWait();
+  waiter.join();
+}
+
+//一个线程入队、另一个线程出队可以共用一个对象，它们使用peer中不同的位置
+TEST(ShmBoundedQueue, OneProducerAndOneConsumerThreadShareObject) {
+  std::string name = QueueName();
+  ShmBoundedQueue<int> queue;
+  ASSERT_TRUE(queue.Create(name, 4));
+  ShmBoundedQueue<int>::Unlink(name);
+  std::thread producer([&]() {
+    for (int i = 0; i < 1000; ++i) {
+      EXPECT_TRUE(queue.WaitEnqueue(i));
+    }
+  });
+  int value = 0;
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(queue.WaitDequeue(&value));
+    EXPECT_EQ(value, i);
+  }
+  producer.join();
+}
+
+#ifndef NDEBUG
+//两个线程在同一个对象上入队会互相覆盖peer中登记的位置，调试版本直接终止
+TEST(ShmBoundedQueueDeathTest, SecondEnqueueThreadAborts) {
+  testing::GTEST_FLAG(death_test_style) = "threadsafe";
+  EXPECT_DEATH(
+      {
+        std::string name = QueueName();
+        ShmBoundedQueue<int> queue;
+        queue.Create(name, 4);
+        ShmBoundedQueue<int>::Unlink(name);
+        queue.Enqueue(1);
+        std::thread([&queue]() { queue.Enqueue(2); }).join();
+      },
+      "second thread");
+}
+#endif
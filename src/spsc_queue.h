@@ -0,0 +1,176 @@
+#ifndef CYBER_BASE_SPSC_QUEUE_H_
+#define CYBER_BASE_SPSC_QUEUE_H_
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#include "common/macros.h"
+
+//单生产者单消费者的有界环形队列，Init/Enqueue/Dequeue的用法和BoundedQueue一致，
+//用于两个固定线程之间的单向通道（例如ShardedExecutor中核与核之间的邮箱）。
+//BoundedQueue要支持多个生产者和消费者，每次入队出队都要CAS，入队还要按顺序提交commit_；
+//只有一个生产者和一个消费者时这些都不需要：
+//- 生产者只写tail_，消费者只写head_，都是普通的release store，没有RMW指令；
+//- 双方各自缓存对方的下标，只有缓存的值显示队列满/空时才重新读取对方的下标，
+//  大部分操作不会访问对方写的缓存行；
+//- DequeueBatch()一次处理多个元素，最后只写一次head_。
+//不能在多个线程中同时入队，也不能在多个线程中同时出队。
+template <typename T>
+class SpscQueue {
+ public:
+  using value_type = T;
+  using size_type = uint64_t;
+
+  SpscQueue() {}
+  SpscQueue& operator=(const SpscQueue& other) = delete;
+  SpscQueue(const SpscQueue& other) = delete;
+  ~SpscQueue();
+
+  //容量向上取整为2的幂
+  bool Init(uint64_t size);
+  bool Enqueue(const T& element);
+  bool Enqueue(T&& element);
+  bool Dequeue(T* element);
+  //依次取出最多max个元素并调用f(T&)，返回处理的个数。
+  //所有元素处理完才写回head_，f中不能再对本队列出队
+  template <typename F>
+  uint64_t DequeueBatch(uint64_t max, F&& f);
+  //生产者或消费者调用时是准确的，其他线程调用时只是近似值
+  uint64_t Size() const;
+  bool Empty() const;
+  uint64_t Capacity() const { return capacity_; }
+
+  //C++14的new不保证按alignas(CACHELINE_SIZE)对齐，在堆上创建时由这里分配对齐的内存
+  static void* operator new(std::size_t size) {
+    void* mem = nullptr;
+    if (posix_memalign(&mem, CACHELINE_SIZE, size) != 0) {
+      throw std::bad_alloc();
+    }
+    return mem;
+  }
+  static void operator delete(void* mem) { std::free(mem); }
+
+ private:
+  template <typename U>
+  bool Push(U&& element);
+
+  //消费者写head_，读cached_tail_
+  alignas(CACHELINE_SIZE) std::atomic<uint64_t> head_ = {0};
+  uint64_t cached_tail_ = 0;
+  //生产者写tail_，读cached_head_
+  alignas(CACHELINE_SIZE) std::atomic<uint64_t> tail_ = {0};
+  uint64_t cached_head_ = 0;
+  alignas(CACHELINE_SIZE) uint64_t capacity_ = 0;
+  uint64_t mask_ = 0;
+  T* pool_ = nullptr;
+};
+
+template <typename T>
+SpscQueue<T>::~SpscQueue() {
+  if (pool_) {
+    for (uint64_t i = 0; i < capacity_; ++i) {
+      pool_[i].~T();
+    }
+    std::free(pool_);
+  }
+}
+
+template <typename T>
+bool SpscQueue<T>::Init(uint64_t size) {
+  if (pool_ != nullptr || size == 0) {
+    return false;
+  }
+  capacity_ = 1;
+  while (capacity_ < size) {
+    capacity_ <<= 1;
+  }
+  mask_ = capacity_ - 1;
+  pool_ = reinterpret_cast<T*>(std::calloc(capacity_, sizeof(T)));
+  if (pool_ == nullptr) {
+    return false;
+  }
+  for (uint64_t i = 0; i < capacity_; ++i) {
+    new (&(pool_[i])) T();
+  }
+  return true;
+}
+
+template <typename T>
+template <typename U>
+bool SpscQueue<T>::Push(U&& element) {
+  uint64_t tail = tail_.load(std::memory_order_relaxed);
+  if (tail - cached_head_ == capacity_) {
+    cached_head_ = head_.load(std::memory_order_acquire);
+    if (tail - cached_head_ == capacity_) {
+      return false;
+    }
+  }
+  pool_[tail & mask_] = std::forward<U>(element);
+  tail_.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+bool SpscQueue<T>::Enqueue(const T& element) {
+  return Push(element);
+}
+
+template <typename T>
+bool SpscQueue<T>::Enqueue(T&& element) {
+  return Push(std::move(element));
+}
+
+template <typename T>
+bool SpscQueue<T>::Dequeue(T* element) {
+  uint64_t head = head_.load(std::memory_order_relaxed);
+  if (head == cached_tail_) {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+    if (head == cached_tail_) {
+      return false;
+    }
+  }
+  *element = std::move(pool_[head & mask_]);
+  head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+template <typename F>
+uint64_t SpscQueue<T>::DequeueBatch(uint64_t max, F&& f) {
+  uint64_t head = head_.load(std::memory_order_relaxed);
+  if (head == cached_tail_) {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+    if (head == cached_tail_) {
+      return 0;
+    }
+  }
+  uint64_t num = std::min(max, cached_tail_ - head);
+  for (uint64_t i = 0; i < num; ++i) {
+    //移出槽位，元素持有的资源在f之后释放，不会留在队列里
+    T element(std::move(pool_[(head + i) & mask_]));
+    f(element);
+  }
+  head_.store(head + num, std::memory_order_release);
+  return num;
+}
+
+template <typename T>
+inline uint64_t SpscQueue<T>::Size() const {
+  //先读head_：tail_只增不减，后读到的tail_不会小于head_
+  uint64_t head = head_.load(std::memory_order_acquire);
+  return tail_.load(std::memory_order_acquire) - head;
+}
+
+template <typename T>
+inline bool SpscQueue<T>::Empty() const {
+  return Size() == 0;
+}
+
+#endif  // CYBER_BASE_SPSC_QUEUE_H_
@@ -0,0 +1,73 @@
+#include "spsc_queue.h"
+
+#include <memory>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+TEST(SpscQueue, FullAndEmpty) {
+  SpscQueue<int> queue;
+  ASSERT_TRUE(queue.Init(3));
+  EXPECT_EQ(queue.Capacity(), 4u);
+  EXPECT_TRUE(queue.Empty());
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.Enqueue(i));
+  }
+  EXPECT_FALSE(queue.Enqueue(4));
+  EXPECT_EQ(queue.Size(), 4u);
+  int value = -1;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.Dequeue(&value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(queue.Dequeue(&value));
+  EXPECT_FALSE(queue.Init(8));
+}
+
+TEST(SpscQueue, DequeueBatchReleasesElements) {
+  SpscQueue<std::shared_ptr<int>> queue;
+  ASSERT_TRUE(queue.Init(8));
+  auto value = std::make_shared<int>(7);
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(queue.Enqueue(value));
+  }
+  EXPECT_EQ(value.use_count(), 6);
+  int sum = 0;
+  EXPECT_EQ(queue.DequeueBatch(3, [&sum](std::shared_ptr<int>& v) { sum += *v; }),
+            3u);
+  EXPECT_EQ(sum, 21);
+  //取出的元素不会留在槽位里
+  EXPECT_EQ(value.use_count(), 3);
+  EXPECT_EQ(queue.DequeueBatch(10, [](std::shared_ptr<int>&) {}), 2u);
+  EXPECT_EQ(queue.DequeueBatch(10, [](std::shared_ptr<int>&) {}), 0u);
+  EXPECT_EQ(value.use_count(), 1);
+}
+
+TEST(SpscQueue, ProducerConsumerKeepsOrder) {
+  constexpr uint64_t kMessages = 1000000;
+  SpscQueue<uint64_t> queue;
+  ASSERT_TRUE(queue.Init(64));
+  std::thread producer([&queue]() {
+    for (uint64_t i = 0; i < kMessages;) {
+      if (queue.Enqueue(i)) {
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint64_t expected = 0;
+  uint64_t errors = 0;
+  while (expected < kMessages) {
+    uint64_t num = queue.DequeueBatch(16, [&](uint64_t& value) {
+      errors += value != expected;
+      ++expected;
+    });
+    if (num == 0) {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  EXPECT_EQ(errors, 0u);
+  EXPECT_TRUE(queue.Empty());
+}
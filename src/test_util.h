@@ -0,0 +1,34 @@
+#ifndef CYBER_BASE_TEST_UTIL_H_
+#define CYBER_BASE_TEST_UTIL_H_
+
+#include <chrono>
+#include <thread>
+
+#include "scheduler/policy/scheduler_classic.h"
+
+//单元测试共用的辅助函数，只在*_test.cc中包含
+
+//每隔1ms检查一次pred，满足或者超时后返回pred()的结果
+template <typename Pred>
+bool WaitFor(Pred pred,
+             std::chrono::milliseconds timeout = std::chrono::seconds(1)) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!pred() && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return pred();
+}
+
+//只有一个处理器的经典调度器配置，"low"和"high"两个任务的优先级分别为1和10
+inline ClassicConf SingleProcessorConf() {
+  ClassicGroupConf group;
+  group.name = "group0";
+  group.processor_num = 1;
+  group.tasks.push_back({"low", 1, ""});
+  group.tasks.push_back({"high", 10, ""});
+  ClassicConf conf;
+  conf.groups.push_back(group);
+  return conf;
+}
+
+#endif  // CYBER_BASE_TEST_UTIL_H_
@@ -75,7 +75,9 @@ inline ThreadPool::ThreadPool(std::size_t threads, std::size_t max_task_num)
       while (!stop_) {
         std::function<void()> task;
         if (task_queue_.WaitDequeue(&task)) {
+          CYBER_TRACE(TASK_START, reinterpret_cast<uint64_t>(this));
           task();
+          CYBER_TRACE(TASK_END, reinterpret_cast<uint64_t>(this));
         }
       }
     });
@@ -0,0 +1,703 @@
+//所有并发原语的统一基准测试，结果可以输出成JSON，并和保存的基线比较：
+//- queue/<策略>：threads个生产者和threads个消费者，消费者用对应的WaitStrategy等待，
+//  延迟是元素从入队到出队的时间
+//- thread_pool：threads个工作线程，一个线程提交空任务，延迟是从提交到开始执行的时间
+//- rwlock/read<比例>：threads个线程按比例加读锁或写锁，延迟是一次加锁+解锁的时间
+//- pq/multiqueue、pq/locked_heap：threads个线程交替插入随机键和取最小键，
+//  对比MultiQueue（2×threads个堆）和互斥锁保护的std::priority_queue，延迟是一次插入或取出的时间
+//- croutine/create：threads个线程创建并销毁协程
+//- croutine/switch：threads个线程各自Resume一个不停Yield的协程，一次操作是一次Resume+Yield
+//每个用例运行固定的时长，每隔kSampleEvery次操作记录一次延迟。
+//用法：
+//  bench_suite [--filter=子串] [--threads=1,2,4,8] [--duration_ms=300] [--json=文件]
+//  bench_suite --compare <baseline.json> <current.json> [--threshold=0.1]
+//              [--latency_threshold=0.5]
+//--json=-时JSON写到标准输出，表格写到标准错误。
+//以CYBER_CONTENTION_PROFILE编译时，queue和rwlock用例结束后把队列或锁的竞争统计写到标准错误。
+//比较模式下，吞吐量下降超过threshold或者p99延迟上升超过latency_threshold的用例记为回退，
+//有回退时退出码为1。
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../atomic_rw_lock.h"
+#include "../bounded_queue.h"
+#include "../common/contention_profiler.h"
+#include "../common/tsc_clock.h"
+#include "../croutine/croutine.h"
+#include "../multi_queue.h"
+#include "../thread_pool.h"
+
+namespace {
+
+constexpr uint64_t kSampleEvery = 16;
+constexpr uint64_t kQueueSize = 1024;
+
+struct Options {
+  std::string filter;
+  std::vector<int> threads = {1, 2, 4, 8};
+  int duration_ms = 300;
+  std::string json;
+};
+
+struct Result {
+  std::string name;
+  int threads = 0;
+  uint64_t ops = 0;
+  double seconds = 0;
+  double ops_per_sec = 0;
+  double p50_ns = 0;
+  double p90_ns = 0;
+  double p99_ns = 0;
+  double p999_ns = 0;
+};
+
+//每个线程一个，只在自己的线程里追加，结束后合并
+class LatencySamples {
+ public:
+  void Add(uint64_t ticks) { ticks_.push_back(ticks); }
+  void Merge(const LatencySamples& other) {
+    ticks_.insert(ticks_.end(), other.ticks_.begin(), other.ticks_.end());
+  }
+  //填写result中的各个分位数
+  void Fill(Result* result) {
+    if (ticks_.empty()) {
+      return;
+    }
+    std::sort(ticks_.begin(), ticks_.end());
+    double ns_per_tick = TscClock::NsPerTick();
+    auto at = [&](double q) {
+      size_t index = static_cast<size_t>(q * (ticks_.size() - 1));
+      return ticks_[index] * ns_per_tick;
+    };
+    result->p50_ns = at(0.5);
+    result->p90_ns = at(0.9);
+    result->p99_ns = at(0.99);
+    result->p999_ns = at(0.999);
+  }
+
+ private:
+  std::vector<uint64_t> ticks_;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point begin) {
+  return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+void Finish(Result* result, uint64_t ops, double seconds,
+            std::vector<LatencySamples>* samples) {
+  result->ops = ops;
+  result->seconds = seconds;
+  result->ops_per_sec = seconds > 0 ? ops / seconds : 0;
+  LatencySamples all;
+  for (auto& s : *samples) {
+    all.Merge(s);
+  }
+  all.Fill(result);
+}
+
+//用例里的队列或锁析构之前调用，此时它是唯一登记着的对象
+void DumpContention() {
+  CYBER_CONTENTION(fputs(ContentionProfiler::Instance()->Dump(1).c_str(), stderr));
+}
+
+std::string InstanceName(const Result& result) {
+  return result.name + "/" + std::to_string(result.threads);
+}
+
+//元素是入队时的tsc，消费者据此计算入队到出队的延迟
+Result RunQueue(const std::string& name,
+                const std::function<WaitStrategy*()>& strategy, int threads,
+                int duration_ms) {
+  Result result;
+  result.name = name;
+  result.threads = threads;
+  BoundedQueue<uint64_t> queue;
+  queue.Init(kQueueSize, strategy());
+  queue.SetName(InstanceName(result));
+  std::atomic<bool> stop = {false};
+  std::atomic<uint64_t> received = {0};
+  std::vector<LatencySamples> samples(threads);
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < threads; ++i) {
+    consumers.emplace_back([&, i]() {
+      uint64_t count = 0;
+      uint64_t ts = 0;
+      while (queue.WaitDequeue(&ts)) {
+        if (++count % kSampleEvery == 0) {
+          samples[i].Add(TscClock::Now() - ts);
+        }
+      }
+      //BreakAllWait之后把剩下的取完
+      while (queue.Dequeue(&ts)) {
+        ++count;
+      }
+      received += count;
+    });
+  }
+  auto begin = Clock::now();
+  std::vector<std::thread> producers;
+  for (int i = 0; i < threads; ++i) {
+    producers.emplace_back([&]() {
+      while (!stop.load(std::memory_order_relaxed)) {
+        if (!queue.Enqueue(TscClock::Now())) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+  stop = true;
+  for (auto& t : producers) {
+    t.join();
+  }
+  queue.BreakAllWait();
+  for (auto& t : consumers) {
+    t.join();
+  }
+  Finish(&result, received.load(), Seconds(begin), &samples);
+  DumpContention();
+  return result;
+}
+
+//ThreadPool在任务队列满时会丢弃任务，提交者控制在途任务数不超过队列容量的一半
+Result RunThreadPool(int threads, int duration_ms) {
+  constexpr uint64_t kMaxTasks = 1024;
+  Result result;
+  result.name = "thread_pool";
+  result.threads = threads;
+  std::atomic<uint64_t> executed = {0};
+  std::vector<LatencySamples> samples(1);
+  //只有一个提交者，样本在执行任务的线程里计算、在提交者的线程里记录会引入同步，
+  //这里让任务把延迟写进按序号索引的环形数组，由提交者在结束后统一收集
+  std::vector<std::atomic<uint64_t>> latency(kMaxTasks);
+  uint64_t submitted = 0;
+  auto begin = Clock::now();
+  {
+    ThreadPool pool(threads, kMaxTasks);
+    auto deadline = begin + std::chrono::milliseconds(duration_ms);
+    while (Clock::now() < deadline) {
+      if (submitted - executed.load(std::memory_order_acquire) >=
+          kMaxTasks / 2) {
+        std::this_thread::yield();
+        continue;
+      }
+      uint64_t seq = submitted++;
+      uint64_t ts = TscClock::Now();
+      pool.Enqueue([&executed, &latency, seq, ts]() {
+        if (seq % kSampleEvery == 0) {
+          latency[seq / kSampleEvery % kMaxTasks].store(
+              TscClock::Now() - ts, std::memory_order_relaxed);
+        }
+        executed.fetch_add(1, std::memory_order_release);
+      });
+    }
+    while (executed.load(std::memory_order_acquire) < submitted) {
+      std::this_thread::yield();
+    }
+  }
+  double seconds = Seconds(begin);
+  for (auto& value : latency) {
+    uint64_t ticks = value.load(std::memory_order_relaxed);
+    if (ticks != 0) {
+      samples[0].Add(ticks);
+    }
+  }
+  Finish(&result, executed.load(), seconds, &samples);
+  return result;
+}
+
+Result RunRWLock(int read_percent, int threads, int duration_ms) {
+  Result result;
+  result.name = "rwlock/read" + std::to_string(read_percent);
+  result.threads = threads;
+  AtomicRWLock lock;
+  lock.SetName(InstanceName(result));
+  uint64_t shared = 0;
+  std::atomic<bool> stop = {false};
+  std::atomic<uint64_t> total = {0};
+  std::vector<LatencySamples> samples(threads);
+  std::vector<std::thread> workers;
+  auto begin = Clock::now();
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([&, i]() {
+      std::minstd_rand rng(i + 1);
+      uint64_t ops = 0;
+      uint64_t sink = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        bool read = static_cast<int>(rng() % 100) < read_percent;
+        bool sample = ++ops % kSampleEvery == 0;
+        uint64_t start = sample ? TscClock::Now() : 0;
+        if (read) {
+          ReadLockGuard<AtomicRWLock> guard(lock);
+          sink += shared;
+        } else {
+          WriteLockGuard<AtomicRWLock> guard(lock);
+          shared++;
+        }
+        if (sample) {
+          samples[i].Add(TscClock::Now() - start);
+        }
+      }
+      total += ops;
+      volatile uint64_t keep = sink;
+      (void)keep;
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+  stop = true;
+  for (auto& t : workers) {
+    t.join();
+  }
+  Finish(&result, total.load(), Seconds(begin), &samples);
+  DumpContention();
+  return result;
+}
+
+//互斥锁保护的小顶堆，作为MultiQueue的对照
+class LockedHeap {
+ public:
+  void Push(uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    heap_.push(key);
+  }
+  bool TryPop(uint64_t* key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (heap_.empty()) {
+      return false;
+    }
+    *key = heap_.top();
+    heap_.pop();
+    return true;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>>
+      heap_;
+};
+
+//先放入kPrefill个元素，之后每个线程交替插入和取出，队列大小基本不变
+template <typename Queue>
+Result RunPriorityQueue(const std::string& name, Queue* queue, int threads,
+                        int duration_ms) {
+  constexpr int kPrefill = 4096;
+  Result result;
+  result.name = name;
+  result.threads = threads;
+  std::minstd_rand prefill_rng(1);
+  for (int i = 0; i < kPrefill; ++i) {
+    queue->Push(prefill_rng());
+  }
+  std::atomic<bool> stop = {false};
+  std::atomic<uint64_t> total = {0};
+  std::vector<LatencySamples> samples(threads);
+  std::vector<std::thread> workers;
+  auto begin = Clock::now();
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([&, i]() {
+      std::minstd_rand rng(i + 1);
+      uint64_t ops = 0;
+      uint64_t key = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        bool sample = ++ops % kSampleEvery == 0;
+        uint64_t start = sample ? TscClock::Now() : 0;
+        if (ops % 2 == 0) {
+          queue->Push(rng());
+        } else {
+          queue->TryPop(&key);
+        }
+        if (sample) {
+          samples[i].Add(TscClock::Now() - start);
+        }
+      }
+      total += ops;
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+  stop = true;
+  for (auto& t : workers) {
+    t.join();
+  }
+  Finish(&result, total.load(), Seconds(begin), &samples);
+  return result;
+}
+
+Result RunCRoutineCreate(int threads, int duration_ms) {
+  Result result;
+  result.name = "croutine/create";
+  result.threads = threads;
+  std::atomic<bool> stop = {false};
+  std::atomic<uint64_t> total = {0};
+  std::vector<LatencySamples> samples(threads);
+  std::vector<std::thread> workers;
+  auto begin = Clock::now();
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([&, i]() {
+      uint64_t ops = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        bool sample = ++ops % kSampleEvery == 0;
+        uint64_t start = sample ? TscClock::Now() : 0;
+        {
+          auto cr = CRoutine::Create([]() {});
+          cr->set_name("bench");
+        }
+        if (sample) {
+          samples[i].Add(TscClock::Now() - start);
+        }
+      }
+      total += ops;
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+  stop = true;
+  for (auto& t : workers) {
+    t.join();
+  }
+  Finish(&result, total.load(), Seconds(begin), &samples);
+  return result;
+}
+
+Result RunCRoutineSwitch(int threads, int duration_ms) {
+  Result result;
+  result.name = "croutine/switch";
+  result.threads = threads;
+  std::atomic<bool> stop = {false};
+  std::atomic<uint64_t> total = {0};
+  std::vector<LatencySamples> samples(threads);
+  std::vector<std::thread> workers;
+  auto begin = Clock::now();
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([&, i]() {
+      bool done = false;
+      auto cr = CRoutine::Create([&done]() {
+        while (!done) {
+          CRoutine::Yield(RoutineState::READY);
+        }
+      });
+      uint64_t ops = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        bool sample = ++ops % kSampleEvery == 0;
+        uint64_t start = sample ? TscClock::Now() : 0;
+        cr->Resume();
+        if (sample) {
+          samples[i].Add(TscClock::Now() - start);
+        }
+      }
+      done = true;
+      cr->Resume();
+      total += ops;
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+  stop = true;
+  for (auto& t : workers) {
+    t.join();
+  }
+  Finish(&result, total.load(), Seconds(begin), &samples);
+  return result;
+}
+
+struct Case {
+  std::string name;
+  std::function<Result(int threads, int duration_ms)> run;
+};
+
+std::vector<Case> AllCases() {
+  std::vector<Case> cases;
+  std::vector<std::pair<std::string, std::function<WaitStrategy*()>>>
+      strategies = {
+          {"block", []() { return new BlockWaitStrategy(); }},
+          {"timeout_block", []() { return new TimeoutBlockWaitStrategy(10); }},
+          {"sleep", []() { return new SleepWaitStrategy(); }},
+          {"yield", []() { return new YieldWaitStrategy(); }},
+          {"busy_spin", []() { return new BusySpinWaitStrategy(); }},
+      };
+  for (auto& strategy : strategies) {
+    std::string name = "queue/" + strategy.first;
+    auto create = strategy.second;
+    cases.push_back({name, [name, create](int threads, int duration_ms) {
+                       return RunQueue(name, create, threads, duration_ms);
+                     }});
+  }
+  cases.push_back({"thread_pool", RunThreadPool});
+  for (int read_percent : {100, 90, 50}) {
+    cases.push_back({"rwlock/read" + std::to_string(read_percent),
+                     [read_percent](int threads, int duration_ms) {
+                       return RunRWLock(read_percent, threads, duration_ms);
+                     }});
+  }
+  cases.push_back({"pq/multiqueue", [](int threads, int duration_ms) {
+                     MultiQueue<uint64_t> queue(2 * threads);
+                     return RunPriorityQueue("pq/multiqueue", &queue, threads,
+                                             duration_ms);
+                   }});
+  cases.push_back({"pq/locked_heap", [](int threads, int duration_ms) {
+                     LockedHeap queue;
+                     return RunPriorityQueue("pq/locked_heap", &queue, threads,
+                                             duration_ms);
+                   }});
+  cases.push_back({"croutine/create", RunCRoutineCreate});
+  cases.push_back({"croutine/switch", RunCRoutineSwitch});
+  return cases;
+}
+
+void PrintHeader(FILE* out) {
+  fprintf(out, "%-20s %7s %14s %10s %10s %10s %10s\n", "name", "threads",
+          "ops/s", "p50 ns", "p90 ns", "p99 ns", "p999 ns");
+}
+
+void PrintResult(FILE* out, const Result& r) {
+  fprintf(out, "%-20s %7d %14.0f %10.0f %10.0f %10.0f %10.0f\n",
+          r.name.c_str(), r.threads, r.ops_per_sec, r.p50_ns, r.p90_ns,
+          r.p99_ns, r.p999_ns);
+}
+
+//每个用例单独一行，比较模式按行解析
+std::string ToJson(const std::vector<Result>& results,
+                   const Options& options) {
+  std::ostringstream os;
+  os << "{\n";
+  os << "  \"context\": {\"cpus\": " << std::thread::hardware_concurrency()
+     << ", \"duration_ms\": " << options.duration_ms
+     << ", \"sample_every\": " << kSampleEvery << "},\n";
+  os << "  \"benchmarks\": [\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    char line[512];
+    snprintf(line, sizeof(line),
+             "    {\"name\": \"%s\", \"threads\": %d, \"ops\": %llu, "
+             "\"seconds\": %.6f, \"ops_per_sec\": %.1f, \"p50_ns\": %.1f, "
+             "\"p90_ns\": %.1f, \"p99_ns\": %.1f, \"p999_ns\": %.1f}%s\n",
+             r.name.c_str(), r.threads,
+             static_cast<unsigned long long>(r.ops), r.seconds,
+             r.ops_per_sec, r.p50_ns, r.p90_ns, r.p99_ns, r.p999_ns,
+             i + 1 == results.size() ? "" : ",");
+    os << line;
+  }
+  os << "  ]\n}\n";
+  return os.str();
+}
+
+bool FindField(const std::string& object, const std::string& key,
+               std::string* value) {
+  std::string pattern = "\"" + key + "\":";
+  size_t pos = object.find(pattern);
+  if (pos == std::string::npos) {
+    return false;
+  }
+  pos = object.find_first_not_of(' ', pos + pattern.size());
+  if (pos == std::string::npos) {
+    return false;
+  }
+  if (object[pos] == '"') {
+    size_t end = object.find('"', pos + 1);
+    if (end == std::string::npos) {
+      return false;
+    }
+    *value = object.substr(pos + 1, end - pos - 1);
+  } else {
+    size_t end = object.find_first_of(",}", pos);
+    *value = object.substr(pos, end - pos);
+  }
+  return true;
+}
+
+//读取本工具写出的JSON：benchmarks数组里每个用例是一个不含嵌套的对象
+bool ReadJson(const std::string& path, std::vector<Result>* results) {
+  std::ifstream in(path);
+  if (!in) {
+    fprintf(stderr, "open %s failed\n", path.c_str());
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  std::string text = buffer.str();
+  size_t pos = text.find("\"benchmarks\"");
+  if (pos == std::string::npos) {
+    fprintf(stderr, "%s has no benchmarks\n", path.c_str());
+    return false;
+  }
+  while ((pos = text.find('{', pos)) != std::string::npos) {
+    size_t end = text.find('}', pos);
+    if (end == std::string::npos) {
+      break;
+    }
+    std::string object = text.substr(pos, end - pos + 1);
+    pos = end + 1;
+    Result r;
+    std::string value;
+    if (!FindField(object, "name", &r.name)) {
+      continue;
+    }
+    if (FindField(object, "threads", &value)) {
+      r.threads = atoi(value.c_str());
+    }
+    if (FindField(object, "ops_per_sec", &value)) {
+      r.ops_per_sec = atof(value.c_str());
+    }
+    if (FindField(object, "p50_ns", &value)) {
+      r.p50_ns = atof(value.c_str());
+    }
+    if (FindField(object, "p99_ns", &value)) {
+      r.p99_ns = atof(value.c_str());
+    }
+    results->push_back(r);
+  }
+  return true;
+}
+
+int Compare(const std::string& baseline_path, const std::string& current_path,
+            double threshold, double latency_threshold) {
+  std::vector<Result> baseline;
+  std::vector<Result> current;
+  if (!ReadJson(baseline_path, &baseline) ||
+      !ReadJson(current_path, &current)) {
+    return 2;
+  }
+  std::map<std::pair<std::string, int>, Result> base_map;
+  for (auto& r : baseline) {
+    base_map[{r.name, r.threads}] = r;
+  }
+  int regressions = 0;
+  printf("%-20s %7s %14s %14s %9s %10s %10s %9s\n", "name", "threads",
+         "base ops/s", "ops/s", "change", "base p99", "p99", "change");
+  for (auto& r : current) {
+    auto it = base_map.find({r.name, r.threads});
+    if (it == base_map.end()) {
+      printf("%-20s %7d %14s %14.0f   (new)\n", r.name.c_str(), r.threads,
+             "-", r.ops_per_sec);
+      continue;
+    }
+    const Result& b = it->second;
+    double throughput_change =
+        b.ops_per_sec > 0 ? r.ops_per_sec / b.ops_per_sec - 1 : 0;
+    double latency_change = b.p99_ns > 0 ? r.p99_ns / b.p99_ns - 1 : 0;
+    bool regressed =
+        throughput_change < -threshold || latency_change > latency_threshold;
+    printf("%-20s %7d %14.0f %14.0f %+8.1f%% %10.0f %10.0f %+8.1f%%%s\n",
+           r.name.c_str(), r.threads, b.ops_per_sec, r.ops_per_sec,
+           throughput_change * 100, b.p99_ns, r.p99_ns, latency_change * 100,
+           regressed ? "  REGRESSION" : "");
+    regressions += regressed;
+    base_map.erase(it);
+  }
+  for (auto& entry : base_map) {
+    printf("%-20s %7d   (missing)\n", entry.first.first.c_str(),
+           entry.first.second);
+  }
+  printf("%d regression(s)\n", regressions);
+  return regressions == 0 ? 0 : 1;
+}
+
+bool StartsWith(const std::string& arg, const std::string& prefix,
+                std::string* value) {
+  if (arg.compare(0, prefix.size(), prefix) != 0) {
+    return false;
+  }
+  *value = arg.substr(prefix.size());
+  return true;
+}
+
+int Usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s [--filter=substr] [--threads=1,2,4,8] "
+          "[--duration_ms=300] [--json=file|-]\n"
+          "       %s --compare <baseline.json> <current.json> "
+          "[--threshold=0.1] [--latency_threshold=0.5]\n",
+          argv0, argv0);
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc > 1 && strcmp(argv[1], "--compare") == 0) {
+    if (argc < 4) {
+      return Usage(argv[0]);
+    }
+    double threshold = 0.1;
+    double latency_threshold = 0.5;
+    for (int i = 4; i < argc; ++i) {
+      std::string value;
+      if (StartsWith(argv[i], "--threshold=", &value)) {
+        threshold = atof(value.c_str());
+      } else if (StartsWith(argv[i], "--latency_threshold=", &value)) {
+        latency_threshold = atof(value.c_str());
+      } else {
+        return Usage(argv[0]);
+      }
+    }
+    return Compare(argv[2], argv[3], threshold, latency_threshold);
+  }
+
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string value;
+    if (StartsWith(argv[i], "--filter=", &value)) {
+      options.filter = value;
+    } else if (StartsWith(argv[i], "--threads=", &value)) {
+      options.threads.clear();
+      std::stringstream ss(value);
+      std::string item;
+      while (std::getline(ss, item, ',')) {
+        options.threads.push_back(atoi(item.c_str()));
+      }
+    } else if (StartsWith(argv[i], "--duration_ms=", &value)) {
+      options.duration_ms = atoi(value.c_str());
+    } else if (StartsWith(argv[i], "--json=", &value)) {
+      options.json = value;
+    } else {
+      return Usage(argv[0]);
+    }
+  }
+
+  //JSON写到标准输出时，表格改写到标准错误
+  FILE* table = options.json == "-" ? stderr : stdout;
+  PrintHeader(table);
+  fflush(table);
+  std::vector<Result> results;
+  for (auto& c : AllCases()) {
+    if (c.name.find(options.filter) == std::string::npos) {
+      continue;
+    }
+    for (int threads : options.threads) {
+      results.push_back(c.run(threads, options.duration_ms));
+      PrintResult(table, results.back());
+      fflush(table);
+    }
+  }
+
+  if (!options.json.empty()) {
+    std::string json = ToJson(results, options);
+    if (options.json == "-") {
+      fputs(json.c_str(), stdout);
+    } else {
+      std::ofstream out(options.json);
+      if (!out || !(out << json)) {
+        fprintf(stderr, "write %s failed\n", options.json.c_str());
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
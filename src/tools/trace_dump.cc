@@ -0,0 +1,30 @@
+//把TraceRecorder::Dump()导出的二进制文件离线转换为Chrome trace event格式的JSON，
+//转换结果可以用chrome://tracing或者Perfetto UI（ui.perfetto.dev）打开。
+//用法：trace_dump <trace.bin> <trace.json>
+#include <iostream>
+
+#include "../common/trace_recorder.h"
+
+int main(int argc, char* argv[]) {
+  if (argc != 3) {
+    std::cerr << "usage: " << argv[0] << " <trace.bin> <trace.json>"
+              << std::endl;
+    return 1;
+  }
+  TraceFile trace;
+  if (!ReadTraceFile(argv[1], &trace)) {
+    std::cerr << "read " << argv[1] << " failed" << std::endl;
+    return 1;
+  }
+  size_t events = 0;
+  for (auto& thread : trace.threads) {
+    events += thread.events.size();
+  }
+  if (!WriteChromeTrace(trace, argv[2])) {
+    std::cerr << "write " << argv[2] << " failed" << std::endl;
+    return 1;
+  }
+  std::cout << trace.threads.size() << " threads, " << events << " events"
+            << std::endl;
+  return 0;
+}
@@ -0,0 +1,481 @@
+#ifndef CYBER_BASE_UNBOUNDED_QUEUE_H_
+#define CYBER_BASE_UNBOUNDED_QUEUE_H_
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "common/epoch.h"
+#include "common/macros.h"
+#include "common/trace_recorder.h"
+#include "wait_strategy.h"
+
+//无界的多生产者多消费者无锁队列，接口和BoundedQueue一致。
+//队列由固定大小的段（segment）串成链表：入队者在尾段上fetch_add取得槽位，
+//尾段写满时挂上一个新段；出队者在头段上fetch_add取得槽位，头段取空后摘下。
+//摘下的段等到全局epoch推进两次、没有线程还能访问它时放回段池，稳定状态下入队出队都不会分配内存；
+//段池最多缓存max_pooled个段，流量尖峰过去之后多出来的段会还给系统。
+template <typename T>
+class UnboundedQueue {
+ public:
+  using value_type = T;
+  using size_type = uint64_t;
+
+  static constexpr uint64_t kDefaultSegmentSize = 1024;
+  static constexpr uint64_t kDefaultMaxPooled = 4;
+
+ public:
+  UnboundedQueue() {}
+  UnboundedQueue& operator=(const UnboundedQueue& other) = delete;
+  UnboundedQueue(const UnboundedQueue& other) = delete;
+  ~UnboundedQueue();
+  bool Init();
+  bool Init(WaitStrategy* strategy);
+  //segment_size: 每个段的槽位数；max_pooled: 段池最多缓存的空闲段个数
+  bool Init(uint64_t segment_size, uint64_t max_pooled, WaitStrategy* strategy);
+  //队列没有容量上限，只有内存分配失败时才返回false
+  bool Enqueue(const T& element);
+  bool Enqueue(T&& element);
+  bool WaitEnqueue(const T& element) { return Enqueue(element); }
+  bool WaitEnqueue(T&& element) { return Enqueue(std::move(element)); }
+  bool Dequeue(T* element);
+  bool WaitDequeue(T* element);
+  //并发修改时只是一个近似值
+  uint64_t Size();
+  bool Empty();
+  void SetWaitStrategy(WaitStrategy* WaitStrategy);
+  void BreakAllWait();
+  //已经分配、还没有还给系统的段数，包括队列中的、等待回收的和段池中的
+  uint64_t SegmentCount() const;
+  //上面这些段占用的内存字节数
+  uint64_t MemoryFootprint() const;
+
+ private:
+  enum SlotState : uint32_t {
+    kEmpty = 0,
+    kFull,
+    //出队者先到了，生产者还没写完，这个槽位作废，生产者换下一个槽位
+    kTaken,
+  };
+
+  struct Slot {
+    std::atomic<uint32_t> state = {kEmpty};
+    T value;
+  };
+
+  struct Segment {
+    alignas(CACHELINE_SIZE) std::atomic<uint64_t> enq_idx = {0};
+    alignas(CACHELINE_SIZE) std::atomic<uint64_t> deq_idx = {0};
+    alignas(CACHELINE_SIZE) std::atomic<Segment*> next = {nullptr};
+    //从链表上摘下时的全局epoch
+    uint64_t retired_epoch = 0;
+    Slot* slots = nullptr;
+  };
+
+  //空闲段的缓存和等待回收的段。摘下的段按摘下的顺序排队，记下摘下时的全局epoch，
+  //全局epoch推进两次之后没有线程还能访问它，就可以重置后重新使用。
+  //段由队列自己回收而不是交给Epoch::Retire：Epoch攒满一批（64个）才回收，
+  //段池装不下这么多，稳定状态下会一直分配和释放段。
+  class SegmentPool {
+   public:
+    SegmentPool(uint64_t segment_size, uint64_t max_pooled)
+        : segment_size_(segment_size), max_pooled_(max_pooled) {}
+
+    ~SegmentPool() {
+      FreeList(free_);
+      FreeList(retired_head_);
+    }
+
+    Segment* Acquire() {
+      Segment* segment = PopFree();
+      if (segment == nullptr) {
+        Reclaim();
+        segment = PopFree();
+      }
+      if (segment == nullptr) {
+        return Allocate();
+      }
+      Reset(segment);
+      return segment;
+    }
+
+    //没有被其他线程看到过的段，直接放回段池
+    void Release(Segment* segment) {
+      Lock();
+      segment = PushFree(segment);
+      Unlock();
+      if (segment != nullptr) {
+        Free(segment);
+      }
+    }
+
+    //段已经从链表上摘下，但可能还有线程在访问它
+    void Retire(Segment* segment) {
+      //摘下段的写必须先于读取全局epoch
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      segment->retired_epoch = Epoch::Instance()->GlobalEpoch();
+      segment->next.store(nullptr, std::memory_order_relaxed);
+      Lock();
+      if (retired_tail_ == nullptr) {
+        retired_head_ = segment;
+      } else {
+        retired_tail_->next.store(segment, std::memory_order_relaxed);
+      }
+      retired_tail_ = segment;
+      Unlock();
+      Reclaim();
+    }
+
+    //尝试推进全局epoch，把已经安全的段放回段池，段池装满后多出来的段还给系统
+    void Reclaim() {
+      Epoch* epoch = Epoch::Instance();
+      epoch->TryAdvance();
+      uint64_t now = epoch->GlobalEpoch();
+      Segment* overflow = nullptr;
+      Lock();
+      while (retired_head_ != nullptr &&
+             retired_head_->retired_epoch + 2 <= now) {
+        Segment* segment = retired_head_;
+        retired_head_ = segment->next.load(std::memory_order_relaxed);
+        if (retired_head_ == nullptr) {
+          retired_tail_ = nullptr;
+        }
+        segment = PushFree(segment);
+        if (segment != nullptr) {
+          segment->next.store(overflow, std::memory_order_relaxed);
+          overflow = segment;
+        }
+      }
+      Unlock();
+      FreeList(overflow);
+    }
+
+    void Free(Segment* segment) {
+      for (uint64_t i = 0; i < segment_size_; ++i) {
+        segment->slots[i].~Slot();
+      }
+      segment->~Segment();
+      free(segment);
+      allocated_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    uint64_t SegmentSize() const { return segment_size_; }
+    uint64_t Allocated() const {
+      return allocated_.load(std::memory_order_relaxed);
+    }
+    uint64_t SegmentBytes() const {
+      return HeaderBytes() + segment_size_ * sizeof(Slot);
+    }
+
+   private:
+    static constexpr uint64_t HeaderBytes() {
+      return (sizeof(Segment) + CACHELINE_SIZE - 1) / CACHELINE_SIZE *
+             CACHELINE_SIZE;
+    }
+
+    Segment* Allocate() {
+      void* memory = nullptr;
+      if (posix_memalign(&memory, CACHELINE_SIZE, SegmentBytes()) != 0) {
+        return nullptr;
+      }
+      auto segment = new (memory) Segment();
+      segment->slots = reinterpret_cast<Slot*>(static_cast<char*>(memory) +
+                                               HeaderBytes());
+      for (uint64_t i = 0; i < segment_size_; ++i) {
+        new (&segment->slots[i]) Slot();
+      }
+      allocated_.fetch_add(1, std::memory_order_relaxed);
+      return segment;
+    }
+
+    Segment* PopFree() {
+      Lock();
+      Segment* segment = free_;
+      if (segment != nullptr) {
+        free_ = segment->next.load(std::memory_order_relaxed);
+        --pooled_;
+      }
+      Unlock();
+      return segment;
+    }
+
+    //调用者持有锁。段池已满时返回segment，由调用者在锁外释放
+    Segment* PushFree(Segment* segment) {
+      if (pooled_ >= max_pooled_) {
+        return segment;
+      }
+      segment->next.store(free_, std::memory_order_relaxed);
+      free_ = segment;
+      ++pooled_;
+      return nullptr;
+    }
+
+    void FreeList(Segment* segment) {
+      while (segment != nullptr) {
+        Segment* next = segment->next.load(std::memory_order_relaxed);
+        Free(segment);
+        segment = next;
+      }
+    }
+
+    //出队时元素已经被移走，放弃的槽位也已经清空，这里只需要重置状态和下标
+    void Reset(Segment* segment) {
+      uint64_t used = segment->enq_idx.load(std::memory_order_relaxed);
+      if (used > segment_size_) {
+        used = segment_size_;
+      }
+      for (uint64_t i = 0; i < used; ++i) {
+        segment->slots[i].state.store(kEmpty, std::memory_order_relaxed);
+      }
+      segment->enq_idx.store(0, std::memory_order_relaxed);
+      segment->deq_idx.store(0, std::memory_order_relaxed);
+      segment->next.store(nullptr, std::memory_order_relaxed);
+    }
+
+    void Lock() {
+      while (lock_.test_and_set(std::memory_order_acquire)) {
+      }
+    }
+    void Unlock() { lock_.clear(std::memory_order_release); }
+
+    const uint64_t segment_size_;
+    const uint64_t max_pooled_;
+    std::atomic<uint64_t> allocated_ = {0};
+    std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+    Segment* free_ = nullptr;
+    uint64_t pooled_ = 0;
+    //等待回收的段，按摘下的先后排列，retired_epoch单调不减
+    Segment* retired_head_ = nullptr;
+    Segment* retired_tail_ = nullptr;
+  };
+
+  template <typename U>
+  bool Push(U&& element);
+  //生产者的槽位被作废时把元素取回来，换一个槽位重试
+  static void TakeBack(const T&, T* slot) { *slot = T(); }
+  static void TakeBack(T&& element, T* slot) { element = std::move(*slot); }
+
+  alignas(CACHELINE_SIZE) std::atomic<Segment*> head_ = {nullptr};
+  alignas(CACHELINE_SIZE) std::atomic<Segment*> tail_ = {nullptr};
+  alignas(CACHELINE_SIZE) uint64_t segment_size_ = 0;
+  std::unique_ptr<SegmentPool> pool_;
+  std::unique_ptr<WaitStrategy> wait_strategy_ = nullptr;
+  std::atomic<bool> break_all_wait_ = {false};
+};
+
+template <typename T>
+constexpr uint64_t UnboundedQueue<T>::kDefaultSegmentSize;
+template <typename T>
+constexpr uint64_t UnboundedQueue<T>::kDefaultMaxPooled;
+
+template <typename T>
+UnboundedQueue<T>::~UnboundedQueue() {
+  if (wait_strategy_) {
+    BreakAllWait();
+  }
+  if (pool_ == nullptr) {
+    return;
+  }
+  //析构时已经没有其他线程访问队列，链表上的段直接释放，等待回收的段和段池由pool_释放
+  Segment* segment = head_.load(std::memory_order_acquire);
+  while (segment != nullptr) {
+    Segment* next = segment->next.load(std::memory_order_acquire);
+    pool_->Free(segment);
+    segment = next;
+  }
+}
+
+template <typename T>
+inline bool UnboundedQueue<T>::Init() {
+  return Init(new SleepWaitStrategy());
+}
+
+template <typename T>
+inline bool UnboundedQueue<T>::Init(WaitStrategy* strategy) {
+  return Init(kDefaultSegmentSize, kDefaultMaxPooled, strategy);
+}
+
+template <typename T>
+bool UnboundedQueue<T>::Init(uint64_t segment_size, uint64_t max_pooled,
+                             WaitStrategy* strategy) {
+  wait_strategy_.reset(strategy);
+  if (pool_ != nullptr || segment_size == 0) {
+    return false;
+  }
+  segment_size_ = segment_size;
+  pool_.reset(new SegmentPool(segment_size, max_pooled));
+  Segment* segment = pool_->Acquire();
+  if (segment == nullptr) {
+    return false;
+  }
+  head_.store(segment, std::memory_order_relaxed);
+  tail_.store(segment, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+bool UnboundedQueue<T>::Enqueue(const T& element) {
+  return Push(element);
+}
+
+template <typename T>
+bool UnboundedQueue<T>::Enqueue(T&& element) {
+  return Push(std::move(element));
+}
+
+template <typename T>
+template <typename U>
+bool UnboundedQueue<T>::Push(U&& element) {
+  EpochGuard guard;
+  for (;;) {
+    Segment* tail = tail_.load(std::memory_order_acquire);
+    uint64_t idx = tail->enq_idx.fetch_add(1, std::memory_order_acq_rel);
+    if (cyber_likely(idx < segment_size_)) {
+      Slot& slot = tail->slots[idx];
+      slot.value = std::forward<U>(element);
+      uint32_t expected = kEmpty;
+      if (cyber_likely(slot.state.compare_exchange_strong(
+              expected, kFull, std::memory_order_release,
+              std::memory_order_relaxed))) {
+        CYBER_TRACE(QUEUE_ENQUEUE, reinterpret_cast<uint64_t>(this),
+                    static_cast<uint32_t>(idx));
+        wait_strategy_->NotifyOne();
+        return true;
+      }
+      TakeBack(std::forward<U>(element), &slot.value);
+      continue;
+    }
+
+    //尾段已经写满
+    if (tail != tail_.load(std::memory_order_acquire)) {
+      continue;
+    }
+    Segment* next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail_.compare_exchange_strong(tail, next, std::memory_order_acq_rel);
+      continue;
+    }
+    //新段的第一个槽位直接放入元素，挂上去就等于入队成功
+    Segment* segment = pool_->Acquire();
+    if (cyber_unlikely(segment == nullptr)) {
+      return false;
+    }
+    segment->slots[0].value = std::forward<U>(element);
+    segment->slots[0].state.store(kFull, std::memory_order_relaxed);
+    segment->enq_idx.store(1, std::memory_order_relaxed);
+    Segment* expected = nullptr;
+    if (tail->next.compare_exchange_strong(expected, segment,
+                                           std::memory_order_acq_rel)) {
+      tail_.compare_exchange_strong(tail, segment, std::memory_order_acq_rel);
+      CYBER_TRACE(QUEUE_ENQUEUE, reinterpret_cast<uint64_t>(this), 0);
+      wait_strategy_->NotifyOne();
+      return true;
+    }
+    //别的生产者抢先挂上了新段，这个段没有被其他线程看到过，直接放回段池
+    TakeBack(std::forward<U>(element), &segment->slots[0].value);
+    pool_->Release(segment);
+  }
+}
+
+template <typename T>
+bool UnboundedQueue<T>::Dequeue(T* element) {
+  EpochGuard guard;
+  for (;;) {
+    Segment* head = head_.load(std::memory_order_acquire);
+    uint64_t deq_idx = head->deq_idx.load(std::memory_order_acquire);
+    if (deq_idx >= head->enq_idx.load(std::memory_order_acquire) &&
+        head->next.load(std::memory_order_acquire) == nullptr) {
+      return false;
+    }
+    uint64_t idx = head->deq_idx.fetch_add(1, std::memory_order_acq_rel);
+    if (idx >= segment_size_) {
+      //头段已经取空，摘下它
+      Segment* next = head->next.load(std::memory_order_acquire);
+      if (next == nullptr) {
+        return false;
+      }
+      //尾指针可能还落后在头段上，先帮它前进，保证摘下的段不会再被tail_引用
+      Segment* tail = head;
+      tail_.compare_exchange_strong(tail, next, std::memory_order_acq_rel);
+      if (head_.compare_exchange_strong(head, next,
+                                        std::memory_order_acq_rel)) {
+        pool_->Retire(head);
+      }
+      continue;
+    }
+    Slot& slot = head->slots[idx];
+    uint32_t state = slot.state.exchange(kTaken, std::memory_order_acq_rel);
+    if (state != kFull) {
+      //生产者拿到了槽位但还没写完，作废这个槽位
+      continue;
+    }
+    *element = std::move(slot.value);
+    CYBER_TRACE(QUEUE_DEQUEUE, reinterpret_cast<uint64_t>(this),
+                static_cast<uint32_t>(idx));
+    return true;
+  }
+}
+
+template <typename T>
+bool UnboundedQueue<T>::WaitDequeue(T* element) {
+  while (!break_all_wait_) {
+    if (Dequeue(element)) {
+      return true;
+    }
+    //等待时不在epoch临界区内，不会阻碍段的回收
+    if (wait_strategy_->EmptyWait()) {
+      continue;
+    }
+    // wait timeout
+    break;
+  }
+  return false;
+}
+
+template <typename T>
+uint64_t UnboundedQueue<T>::Size() {
+  EpochGuard guard;
+  uint64_t size = 0;
+  for (Segment* segment = head_.load(std::memory_order_acquire);
+       segment != nullptr;
+       segment = segment->next.load(std::memory_order_acquire)) {
+    uint64_t enq = segment->enq_idx.load(std::memory_order_acquire);
+    uint64_t deq = segment->deq_idx.load(std::memory_order_acquire);
+    enq = enq < segment_size_ ? enq : segment_size_;
+    deq = deq < segment_size_ ? deq : segment_size_;
+    size += enq > deq ? enq - deq : 0;
+  }
+  return size;
+}
+
+template <typename T>
+inline bool UnboundedQueue<T>::Empty() {
+  return Size() == 0;
+}
+
+template <typename T>
+inline void UnboundedQueue<T>::SetWaitStrategy(WaitStrategy* strategy) {
+  wait_strategy_.reset(strategy);
+}
+
+template <typename T>
+inline void UnboundedQueue<T>::BreakAllWait() {
+  break_all_wait_ = true;
+  wait_strategy_->BreakAllWait();
+}
+
+template <typename T>
+inline uint64_t UnboundedQueue<T>::SegmentCount() const {
+  return pool_ == nullptr ? 0 : pool_->Allocated();
+}
+
+template <typename T>
+inline uint64_t UnboundedQueue<T>::MemoryFootprint() const {
+  return pool_ == nullptr ? 0 : pool_->Allocated() * pool_->SegmentBytes();
+}
+
+#endif  // CYBER_BASE_UNBOUNDED_QUEUE_H_
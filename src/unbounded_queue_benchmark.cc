@@ -0,0 +1,161 @@
+//UnboundedQueue和BoundedQueue在相同负载下的吞吐量，以及流量尖峰前后UnboundedQueue的内存占用。
+//两种队列都用非阻塞的Enqueue/Dequeue，失败时让出CPU后重试，排除等待策略的影响。
+//用法：unbounded_queue_benchmark [messages]
+#include <malloc.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "unbounded_queue.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint64_t kBoundedCapacity = 1 << 16;
+
+double RssMb() {
+  long pages = 0;
+  long resident = 0;
+  FILE* f = fopen("/proc/self/statm", "r");
+  if (f == nullptr) {
+    return 0;
+  }
+  if (fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+    resident = 0;
+  }
+  fclose(f);
+  return resident * sysconf(_SC_PAGESIZE) / 1024.0 / 1024.0;
+}
+
+//每轮最多跑kDeadline，超时后按已经收到的消息数计算吞吐量并标记*
+constexpr auto kDeadline = std::chrono::seconds(5);
+
+struct Result {
+  double mmsg_per_second;
+  bool timeout;
+};
+
+template <typename Queue>
+Result Run(Queue* queue, int producers, int consumers, uint64_t messages) {
+  uint64_t per_producer = messages / producers;
+  uint64_t total = per_producer * producers;
+  std::atomic<uint64_t> received = {0};
+  std::atomic<bool> stop = {false};
+  std::vector<std::thread> threads;
+  auto begin = Clock::now();
+  for (int c = 0; c < consumers; ++c) {
+    threads.emplace_back([&]() {
+      uint64_t value = 0;
+      while (received.load(std::memory_order_relaxed) < total &&
+             !stop.load(std::memory_order_relaxed)) {
+        if (queue->Dequeue(&value)) {
+          received.fetch_add(1, std::memory_order_relaxed);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&]() {
+      for (uint64_t i = 0; i < per_producer; ++i) {
+        while (!queue->Enqueue(i)) {
+          if (stop.load(std::memory_order_relaxed)) {
+            return;
+          }
+          std::this_thread::yield();
+        }
+        if (stop.load(std::memory_order_relaxed)) {
+          return;
+        }
+      }
+    });
+  }
+  while (received.load() < total && Clock::now() - begin < kDeadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  double seconds =
+      std::chrono::duration<double>(Clock::now() - begin).count();
+  uint64_t done = received.load();
+  stop = true;
+  for (auto& t : threads) {
+    t.join();
+  }
+  return {done / seconds / 1e6, done < total};
+}
+
+void Throughput(uint64_t messages) {
+  printf("%-10s %16s %16s\n", "P x C", "bounded Mmsg/s",
+         "unbounded Mmsg/s");
+  const int configs[][2] = {{1, 1}, {2, 2}, {4, 4}, {8, 1}, {1, 8}};
+  for (auto& config : configs) {
+    BoundedQueue<uint64_t> bounded;
+    bounded.Init(kBoundedCapacity);
+    UnboundedQueue<uint64_t> unbounded;
+    unbounded.Init();
+    Result b = Run(&bounded, config[0], config[1], messages);
+    Result u = Run(&unbounded, config[0], config[1], messages);
+    printf("%2d x %-5d %15.2f%c %15.2f%c\n", config[0], config[1],
+           b.mmsg_per_second, b.timeout ? '*' : ' ', u.mmsg_per_second,
+           u.timeout ? '*' : ' ');
+  }
+}
+
+//一次性积压messages个元素，然后全部取走
+void Spike(uint64_t messages) {
+  printf("\nspike of %llu messages\n",
+         static_cast<unsigned long long>(messages));
+  double rss_begin = RssMb();
+  {
+    UnboundedQueue<uint64_t> queue;
+    queue.Init();
+    for (uint64_t i = 0; i < messages; ++i) {
+      queue.Enqueue(i);
+    }
+    printf("unbounded at peak:   %8.2f MB in %llu segments, rss %+.2f MB\n",
+           queue.MemoryFootprint() / 1024.0 / 1024.0,
+           static_cast<unsigned long long>(queue.SegmentCount()),
+           RssMb() - rss_begin);
+    uint64_t value = 0;
+    while (queue.Dequeue(&value)) {
+    }
+    for (int i = 0; i < 3; ++i) {
+      Epoch::Instance()->Collect();
+    }
+    malloc_trim(0);
+    printf("unbounded drained:   %8.2f MB in %llu segments, rss %+.2f MB\n",
+           queue.MemoryFootprint() / 1024.0 / 1024.0,
+           static_cast<unsigned long long>(queue.SegmentCount()),
+           RssMb() - rss_begin);
+  }
+  //能扛住同样尖峰的BoundedQueue必须按峰值分配，尖峰过后内存也不会还回去
+  BoundedQueue<uint64_t> bounded;
+  bounded.Init(messages);
+  for (uint64_t i = 0; i < messages; ++i) {
+    bounded.Enqueue(i);
+  }
+  uint64_t value = 0;
+  while (bounded.Dequeue(&value)) {
+  }
+  malloc_trim(0);
+  printf("bounded drained:     %8.2f MB, rss %+.2f MB\n",
+         (messages + 2) * sizeof(uint64_t) / 1024.0 / 1024.0,
+         RssMb() - rss_begin);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  uint64_t messages = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+  Throughput(messages);
+  Spike(messages);
+  return 0;
+}
@@ -0,0 +1,181 @@
+#include "unbounded_queue.h"
+
+#include <malloc.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+//测试进程里所有的posix_memalign和operator new都经过这里计数
+std::atomic<uint64_t> allocations = {0};
+
+}  // namespace
+
+extern "C" int posix_memalign(void** memptr, size_t alignment, size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void* memory = memalign(alignment, size);
+  if (memory == nullptr) {
+    return ENOMEM;
+  }
+  *memptr = memory;
+  return 0;
+}
+
+void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void* memory = malloc(size == 0 ? 1 : size);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+
+TEST(UnboundedQueue, FifoAcrossSegments) {
+  UnboundedQueue<int> queue;
+  ASSERT_TRUE(queue.Init(4, 2, new SleepWaitStrategy()));
+  int value = 0;
+  EXPECT_FALSE(queue.Dequeue(&value));
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(queue.Enqueue(i));
+  }
+  EXPECT_EQ(queue.Size(), 100u);
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(queue.Dequeue(&value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(queue.Dequeue(&value));
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(UnboundedQueue, MoveOnlyElements) {
+  UnboundedQueue<std::unique_ptr<int>> queue;
+  ASSERT_TRUE(queue.Init(2, 1, new SleepWaitStrategy()));
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(queue.Enqueue(std::unique_ptr<int>(new int(i))));
+  }
+  std::unique_ptr<int> value;
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(queue.Dequeue(&value));
+    EXPECT_EQ(*value, i);
+  }
+}
+
+TEST(UnboundedQueue, MultiProducerMultiConsumer) {
+  constexpr int kProducers = 4;
+  constexpr int kConsumers = 4;
+  constexpr int kPerProducer = 50000;
+  UnboundedQueue<int> queue;
+  ASSERT_TRUE(queue.Init(64, 4, new YieldWaitStrategy()));
+  std::vector<std::atomic<int>> seen(kProducers * kPerProducer);
+  for (auto& s : seen) {
+    s = 0;
+  }
+  std::atomic<int> received = {0};
+  std::vector<std::thread> threads;
+  for (int c = 0; c < kConsumers; ++c) {
+    threads.emplace_back([&]() {
+      int value = 0;
+      while (received.load() < kProducers * kPerProducer) {
+        if (queue.Dequeue(&value)) {
+          seen[value]++;
+          received++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int p = 0; p < kProducers; ++p) {
+    threads.emplace_back([&queue, p]() {
+      for (int i = 0; i < kPerProducer; ++i) {
+        queue.Enqueue(p * kPerProducer + i);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (auto& s : seen) {
+    ASSERT_EQ(s.load(), 1);
+  }
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(UnboundedQueue, SegmentsRecycledAfterSpike) {
+  UnboundedQueue<int> queue;
+  ASSERT_TRUE(queue.Init(8, 2, new SleepWaitStrategy()));
+  int value = 0;
+  //稳定状态：段在队列和段池之间循环，不会持续增长
+  for (int round = 0; round < 1000; ++round) {
+    for (int i = 0; i < 16; ++i) {
+      queue.Enqueue(i);
+    }
+    for (int i = 0; i < 16; ++i) {
+      ASSERT_TRUE(queue.Dequeue(&value));
+    }
+  }
+  //队列中最多两个段，段池中两个，加上最后摘下、还没到安全epoch的一个
+  EXPECT_LE(queue.SegmentCount(), 5u);
+
+  //尖峰：段数随积压增长，取空之后多余的段还给系统
+  for (int i = 0; i < 8 * 100; ++i) {
+    queue.Enqueue(i);
+  }
+  EXPECT_GE(queue.SegmentCount(), 100u);
+  while (queue.Dequeue(&value)) {
+  }
+  //队列中的一个段，段池中的两个，加上最后摘下的一个
+  EXPECT_LE(queue.SegmentCount(), 4u);
+}
+
+//稳定状态下入队出队不分配内存，摘下的段在队列里回收，不用等Epoch攒满一批
+TEST(UnboundedQueue, NoAllocationInSteadyState) {
+  UnboundedQueue<uint64_t> queue;
+  ASSERT_TRUE(queue.Init(64, UnboundedQueue<uint64_t>::kDefaultMaxPooled,
+                         new SleepWaitStrategy()));
+  uint64_t value = 0;
+  auto run = [&queue, &value](int rounds) {
+    for (int round = 0; round < rounds; ++round) {
+      for (uint64_t i = 0; i < 200; ++i) {
+        queue.Enqueue(i);
+      }
+      for (uint64_t i = 0; i < 200; ++i) {
+        ASSERT_TRUE(queue.Dequeue(&value));
+        ASSERT_EQ(value, i);
+      }
+    }
+  };
+  run(100);
+  uint64_t before = allocations.load();
+  run(10000);
+  EXPECT_EQ(allocations.load() - before, 0u);
+  EXPECT_LE(queue.SegmentCount(), 5u + 1u);
+}
+
+TEST(UnboundedQueue, WaitDequeueReturnsElementAndBreaks) {
+  UnboundedQueue<int> queue;
+  ASSERT_TRUE(queue.Init(new SleepWaitStrategy(1000)));
+  int value = 0;
+  std::thread consumer([&]() {
+    EXPECT_TRUE(queue.WaitDequeue(&value));
+    EXPECT_FALSE(queue.WaitDequeue(&value));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  queue.Enqueue(42);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  queue.BreakAllWait();
+  consumer.join();
+  EXPECT_EQ(value, 42);
+}
@@ -1,33 +1,111 @@
+#ifndef CYBER_BASE_WAIT_STRATEGY_H_
+#define CYBER_BASE_WAIT_STRATEGY_H_
+
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <cstdlib>
 #include <mutex>
 #include <thread>
 
+#include "common/trace_recorder.h"
+
 class WaitStrategy {
  public:
   virtual void NotifyOne() {}
+  //一份数据有多个等待者都要看到（比如BroadcastRing）时使用
+  virtual void NotifyAll() {}
   virtual void BreakAllWait() {}
   virtual bool EmptyWait() = 0;
   virtual ~WaitStrategy() {}
 };
 
+//调用者先检查队列，为空时才调用EmptyWait()，这两步之间到达的通知不能丢掉。
+//通知记为许可（pending_），等待者取走一个许可才返回；没有等待者时也留下一个许可，
+//刚检查完队列、还没有进入等待的线程会直接返回再检查一次。
+//许可最多和等待者一样多（至少一个），没人等待时大量入队也只会多出一次空转
+class WaitPermits {
+ public:
+  void NotifyOne() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (pending_ < std::max<uint64_t>(waiters_, 1)) {
+        ++pending_;
+      }
+    }
+    cv_.notify_one();
+  }
+
+  void NotifyAll() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_ = std::max<uint64_t>(pending_, std::max<uint64_t>(waiters_, 1));
+    }
+    cv_.notify_all();
+  }
+
+  void BreakAllWait() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      break_all_wait_ = true;
+    }
+    cv_.notify_all();
+  }
+
+  //等到一个许可，被BreakAllWait()打断时也返回
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++waiters_;
+    cv_.wait(lock, [this]() { return Ready(); });
+    --waiters_;
+    Take();
+  }
+
+  //超时返回false
+  bool WaitFor(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++waiters_;
+    bool woken = cv_.wait_for(lock, timeout, [this]() { return Ready(); });
+    --waiters_;
+    if (woken) {
+      Take();
+    }
+    return woken;
+  }
+
+ private:
+  bool Ready() const { return pending_ > 0 || break_all_wait_; }
+  void Take() {
+    if (pending_ > 0) {
+      --pending_;
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  uint64_t pending_ = 0;
+  uint64_t waiters_ = 0;
+  bool break_all_wait_ = false;
+};
+
 class BlockWaitStrategy : public WaitStrategy {
  public:
   BlockWaitStrategy() {}
-  void NotifyOne() override { cv_.notify_one(); }
+  void NotifyOne() override { permits_.NotifyOne(); }
+  void NotifyAll() override { permits_.NotifyAll(); }
 
   bool EmptyWait() override {
-    std::unique_lock<std::mutex> lock(mutex_);
-    cv_.wait(lock);
+    CYBER_TRACE(WAIT_PARK, reinterpret_cast<uint64_t>(this));
+    permits_.Wait();
+    CYBER_TRACE(WAIT_UNPARK, reinterpret_cast<uint64_t>(this), 1);
     return true;
   }
 
-  void BreakAllWait() override { cv_.notify_all(); }
+  void BreakAllWait() override { permits_.BreakAllWait(); }
 
  private:
-  std::mutex mutex_;
-  std::condition_variable cv_;
+  WaitPermits permits_;
 };
 
 class SleepWaitStrategy : public WaitStrategy {
@@ -47,7 +125,7 @@ class SleepWaitStrategy : public WaitStrategy {
 
  private:
   uint64_t sleep_time_us_ = 10000;
-};     
+};
 
 class YieldWaitStrategy : public WaitStrategy {
  public:
@@ -70,24 +148,28 @@ class TimeoutBlockWaitStrategy : public WaitStrategy {
   explicit TimeoutBlockWaitStrategy(uint64_t timeout)
       : time_out_(std::chrono::milliseconds(timeout)) {}
 
-  void NotifyOne() override { cv_.notify_one(); }
+  void NotifyOne() override { permits_.NotifyOne(); }
+  void NotifyAll() override { permits_.NotifyAll(); }
 
   bool EmptyWait() override {
-    std::unique_lock<std::mutex> lock(mutex_);
-    if (cv_.wait_for(lock, time_out_) == std::cv_status::timeout) {
+    CYBER_TRACE(WAIT_PARK, reinterpret_cast<uint64_t>(this));
+    if (!permits_.WaitFor(time_out_)) {
+      CYBER_TRACE(WAIT_UNPARK, reinterpret_cast<uint64_t>(this), 0);
       return false;
     }
+    CYBER_TRACE(WAIT_UNPARK, reinterpret_cast<uint64_t>(this), 1);
     return true;
   }
 
-  void BreakAllWait() override { cv_.notify_all(); }
+  void BreakAllWait() override { permits_.BreakAllWait(); }
 
   void SetTimeout(uint64_t timeout) {
     time_out_ = std::chrono::milliseconds(timeout);
   }
 
  private:
-  std::mutex mutex_;
-  std::condition_variable cv_;
+  WaitPermits permits_;
   std::chrono::milliseconds time_out_;
-};
\ No newline at end of file
+};
+
+#endif  // CYBER_BASE_WAIT_STRATEGY_H_
@@ -0,0 +1,68 @@
+#include "wait_strategy.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "bounded_queue.h"
+#include "thread_pool.h"
+
+//检查队列为空之后、进入等待之前到达的通知留下许可，等待者直接返回
+TEST(WaitStrategy, NotifyBeforeWaitIsNotLost) {
+  BlockWaitStrategy block;
+  block.NotifyOne();
+  auto waiter = std::async(std::launch::async, [&block]() {
+    return block.EmptyWait();
+  });
+  ASSERT_EQ(waiter.wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+  EXPECT_TRUE(waiter.get());
+
+  TimeoutBlockWaitStrategy timeout(5000);
+  timeout.NotifyOne();
+  auto begin = std::chrono::steady_clock::now();
+  EXPECT_TRUE(timeout.EmptyWait());
+  EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(1));
+}
+
+//没有等待者时的多次通知只留下一个许可，之后的等待要等新的通知或者超时
+TEST(WaitStrategy, PermitsDoNotAccumulate) {
+  TimeoutBlockWaitStrategy strategy(20);
+  for (int i = 0; i < 100; ++i) {
+    strategy.NotifyOne();
+  }
+  EXPECT_TRUE(strategy.EmptyWait());
+  EXPECT_FALSE(strategy.EmptyWait());
+}
+
+TEST(WaitStrategy, BreakAllWaitReleasesWaiters) {
+  BlockWaitStrategy strategy;
+  std::vector<std::future<bool>> waiters;
+  for (int i = 0; i < 4; ++i) {
+    waiters.push_back(std::async(std::launch::async, [&strategy]() {
+      return strategy.EmptyWait();
+    }));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  strategy.BreakAllWait();
+  for (auto& waiter : waiters) {
+    ASSERT_EQ(waiter.wait_for(std::chrono::seconds(5)),
+              std::future_status::ready);
+  }
+}
+
+//线程池的worker在BlockWaitStrategy上等待，每个任务都投递在worker刚取空队列的时候，
+//之前这里会丢失通知，任务一直留在队列里
+TEST(WaitStrategy, ThreadPoolNeverStrandsTasks) {
+  ThreadPool pool(2);
+  for (int round = 0; round < 20000; ++round) {
+    auto future = pool.Enqueue([]() {});
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(5)),
+              std::future_status::ready)
+        << "round " << round;
+  }
+}